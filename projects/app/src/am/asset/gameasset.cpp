@@ -1,6 +1,7 @@
 #include "gameasset.h"
 
 #include "workspace.h"
+#include "am/system/datamgr.h"
 #include "am/system/datetime.h"
 #include "am/xml/doc.h"
 
@@ -21,6 +22,12 @@ void rageam::asset::AssetBase::SetNewPath(ConstWString newPath, bool updateWorks
 	}
 }
 
+rage::pgRscChunkCache* rageam::asset::AssetBase::GetChunkCache()
+{
+	static rage::pgRscChunkCache cache(DataManager::GetResourceCacheFolder());
+	return &cache;
+}
+
 bool rageam::asset::AssetBase::LoadConfig(bool temp)
 {
 	static Logger logger("asset_config");
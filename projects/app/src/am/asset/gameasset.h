@@ -62,7 +62,8 @@ namespace rageam::asset
 		void SetNewPath(ConstWString newPath, bool updateWorkspace = false);
 
 		// Compiles asset into file. If path is null, GetCompilePath() is used.
-		virtual bool CompileToFile(ConstWString filePath = nullptr) = 0;
+		// Compression profile is used only by resource assets.
+		virtual bool CompileToFile(ConstWString filePath = nullptr, const zLibCompressionProfile& compressionProfile = {}) = 0;
 		// Looks up for new and deleted asset source files.
 		virtual void Refresh() = 0;
 		// Gets current asset format version (not related to game resource version).
@@ -81,6 +82,9 @@ namespace rageam::asset
 		// Useful when some data needs to be set only on config creation
 		bool HasSavedConfig() const { return m_HasSavedConfig; }
 
+		// Shared cache of compressed resource chunks, makes recompiling slightly changed asset much faster
+		static rage::pgRscChunkCache* GetChunkCache();
+
 		// Hash of directory path
 		u32 GetHashKey() const { return m_HashKey; }
 		// Gets full path to asset directory 'x:/assets/adder.itd'
@@ -182,7 +186,7 @@ namespace rageam::asset
 		GameRscAsset(const file::WPath& path) : GameAsset<TGameFormat>(path) {}
 		GameRscAsset(const GameRscAsset& other) = default;
 
-		bool CompileToFile(ConstWString filePath = nullptr) override
+		bool CompileToFile(ConstWString filePath = nullptr, const zLibCompressionProfile& compressionProfile = {}) override
 		{
 			AM_TRACEF(L"Compiling game asset %ls", this->GetDirectoryPath());
 
@@ -199,6 +203,9 @@ namespace rageam::asset
 			this->ReportProgress(L"- Compiling resource", 0);
 
 			rage::pgRscCompiler compiler;
+			compiler.ParallelCompression = true;
+			compiler.CompressionProfile = compressionProfile;
+			compiler.ChunkCache = AssetBase::GetChunkCache();
 			compiler.CompileCallback = [this](ConstWString message, double progress)
 				{
 					this->ReportProgress(message, progress);
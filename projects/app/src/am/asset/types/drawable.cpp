@@ -5,6 +5,7 @@
 #include "am/file/iterator.h"
 #include "am/graphics/buffereditor.h"
 #include "am/graphics/geomprimitives.h"
+#include "am/graphics/meshoptimizer.h"
 #include "am/graphics/meshsplitter.h"
 #include "rage/grcore/effectmgr.h"
 #include "am/xml/iterator.h"
@@ -595,6 +596,7 @@ void rageam::asset::DrawableTune::Serialize(XmlHandle& node) const
 
 	XML_SET_CHILD_VALUE_ATTR_IGNORE_DEF(node, BoundingBox);
 	XML_SET_CHILD_VALUE_ATTR_IGNORE_DEF(node, BoundingSphere);
+	XML_SET_CHILD_VALUE_ATTR_IGNORE_DEF(node, OptimizeGeometry);
 
 	Nodes.Serialize(node);
 	Materials.Serialize(node);
@@ -607,6 +609,8 @@ void rageam::asset::DrawableTune::Deserialize(const XmlHandle& node)
 	xLodThreshold.GetValue(lodThreshold);
 	lodThreshold.ToArray(LodThreshold);
 
+	XML_GET_CHILD_VALUE_ATTR(node, OptimizeGeometry);
+
 	Nodes.Deserialize(node);
 	Materials.Deserialize(node);
 }
@@ -644,6 +648,7 @@ void rageam::asset::DrawableAsset::PrepareForConversion()
 	CacheEffects();
 	m_NodeToModel.Resize(nodeCount);
 	m_NodeToBone.Resize(nodeCount);
+	m_MeshSplitter = std::make_unique<graphics::MeshSplitter>();
 	m_EmbedDict = nullptr;
 
 	CompiledDrawableMap = std::make_unique<DrawableAssetMap>();
@@ -657,6 +662,7 @@ void rageam::asset::DrawableAsset::CleanUpConversion()
 	m_EffectCache.Destroy();
 	m_NodeToModel.Destroy();
 	m_NodeToBone.Destroy();
+	m_MeshSplitter = nullptr;
 	m_EmbedDict = nullptr;
 }
 
@@ -695,9 +701,27 @@ rageam::List<rageam::asset::DrawableAsset::SplittedGeometry> rageam::asset::Draw
 		sceneVertexBuffer.SetBlendIndices(remappedBlendIndices.get(), DXGI_FORMAT_R32G32B32A32_FLOAT);
 	}
 
+	// Triangle order affects blending result, it can be changed only for depth tested buckets
+	bool optimizeGeometry = m_DrawableTune.OptimizeGeometry;
+	bool reorderTriangles = material.DrawBucket == rage::RB_OPAQUE || material.DrawBucket == rage::RB_CUTOUT;
+	const graphics::VertexAttribute* positionAttr = decl.FindAttribute(graphics::POSITION, 0);
+	if (optimizeGeometry && (!positionAttr || positionAttr->Format != DXGI_FORMAT_R32G32B32_FLOAT))
+	{
+		AM_WARNINGF("DrawableAsset::ConvertSceneGeometry() -> Effect '%s' has no float3 position, skipping geometry optimization.",
+			material.Effect.GetCStr());
+		optimizeGeometry = false;
+	}
+
 	// Creates grmGeometry from given vertex data and adds it in geometries list
-	auto addGeometry = [&decl, &geometries](pVoid vertices, pVoid indices, u32 vertexCount, u32 indexCount, const rage::spdAABB& bb)
+	auto addGeometry = [&](pVoid vertices, pVoid indices, u32 vertexCount, u32 indexCount, const rage::spdAABB& bb)
 		{
+			if (optimizeGeometry)
+			{
+				vertexCount = graphics::MeshOptimizer::Optimize(
+					static_cast<char*>(vertices), vertexCount, decl.Stride, positionAttr->Offset,
+					static_cast<u16*>(indices), indexCount, reorderTriangles);
+			}
+
 			// Create geometry & set vertex data
 			rage::grmVertexData vertexData;
 			vertexData.Vertices = vertices;
@@ -723,14 +747,20 @@ rageam::List<rageam::asset::DrawableAsset::SplittedGeometry> rageam::asset::Draw
 	if (indices.Format == DXGI_FORMAT_R16_UINT)
 	{
 		rage::spdAABB bound = sceneGeometry->GetAABB();
-		addGeometry(sceneVertexBuffer.GetBuffer(), indices.Buffer, totalVertexCount, totalIndexCount, bound);
+
+		// Scene index buffer is read only, optimizer needs a copy
+		List<u16> indicesCopy(static_cast<const u16*>(indices.Buffer), static_cast<const u16*>(indices.Buffer) + totalIndexCount);
+		addGeometry(sceneVertexBuffer.GetBuffer(), indicesCopy.GetItems(), totalVertexCount, totalIndexCount, bound);
 	}
 	else
 	{
 		AM_ASSERT(indices.Format == DXGI_FORMAT_R32_UINT, "Unsupported index buffer format %s", Enum::GetName(indices.Format));
 
-		auto splitVertices = graphics::MeshSplitter::Split(
-			sceneVertexBuffer.GetBuffer(), decl.Stride, (u32*)indices.Buffer, totalIndexCount);
+		// Triangles are grouped spatially if there's position, so every chunk gets compact bounding box
+		u32 positionOffset = positionAttr && positionAttr->Format == DXGI_FORMAT_R32G32B32_FLOAT ? positionAttr->Offset : graphics::MeshSplitter::NO_POSITION;
+		auto splitVertices = m_MeshSplitter->Split(
+			static_cast<const char*>(sceneVertexBuffer.GetBuffer()), totalVertexCount, decl.Stride, positionOffset,
+			static_cast<const u32*>(indices.Buffer), totalIndexCount);
 
 		for (const graphics::MeshChunk& chunk : splitVertices)
 		{
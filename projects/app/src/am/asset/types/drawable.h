@@ -15,6 +15,7 @@
 #include "game/drawable.h"
 #include "am/types.h"
 #include "am/graphics/geomprimitives.h"
+#include "am/graphics/meshsplitter.h"
 #include "drawablemap.h"
 
 #include <any>
@@ -351,6 +352,8 @@ namespace rageam::asset
 		// bool			  AutoGenerateLods = false;
 
 		float			  LodThreshold[MAX_LOD] = { 30, 60, 90, 120 };
+		// Reorders geometry triangles and vertices for better vertex cache use and less overdraw, see graphics::MeshOptimizer
+		bool			  OptimizeGeometry = true;
 		AABB			  BoundingBox;
 		Sphere			  BoundingSphere;
 		NodeTuneGroup     Nodes;
@@ -409,6 +412,8 @@ namespace rageam::asset
 		// Key is SceneNode index
 		List<rage::grmModel*>		m_NodeToModel;
 		List<rage::crBoneData*>		m_NodeToBone;
+		// Scratch buffers are reused for every geometry that needs splitting
+		amUPtr<graphics::MeshSplitter> m_MeshSplitter;
 
 		int m_BoundCounter = 0;
 
@@ -417,9 +422,10 @@ namespace rageam::asset
 		void PrepareForConversion();
 		void CleanUpConversion();
 
-		// Performs three things:
+		// Performs four things:
 		// - Composes vertex buffer for given vertex declaration
 		// - Splits vertices to satisfy 16 bit index limit
+		// - Optimizes vertex and index order of every split geometry (if enabled in tune)
 		// - Creates grmGeometry from processed vertex data
 		List<SplittedGeometry> ConvertSceneGeometry(const graphics::SceneGeometry* sceneGeometry, bool skinned) const;
 
@@ -27,11 +27,11 @@ bool rageam::ui::AssetAsyncCompiler::ProcessNewRequest()
 
 	// We had either no active task or active task just finished, in either
 	// case we can process new request
-	file::WPath requestPath = m_CompileRequests.front();
+	CompileRequest request = m_CompileRequests.front();
 	m_CompileRequests.pop();
 
 	// Load the asset from requested path
-	m_ActiveAsset = asset::AssetFactory::LoadFromPath(requestPath);
+	m_ActiveAsset = asset::AssetFactory::LoadFromPath(request.Path);
 	if (!m_ActiveAsset)
 		return false;
 
@@ -45,10 +45,10 @@ bool rageam::ui::AssetAsyncCompiler::ProcessNewRequest()
 	};
 
 	// Start the background compilation task
-	m_ActiveCompileTask = BackgroundWorker::Run([this]
+	m_ActiveCompileTask = BackgroundWorker::Run([this, profile = request.CompressionProfile]
 	{
-		return m_ActiveAsset->CompileToFile();
-	}, L"Compile %ls", requestPath.GetCStr());
+		return m_ActiveAsset->CompileToFile(nullptr, profile);
+	}, L"Compile %ls", request.Path.GetCStr());
 
 	// Finally, open UI dialog
 	ImGui::OpenPopup(SAVE_POPUP_NAME);
@@ -108,7 +108,7 @@ rageam::ui::AssetAsyncCompiler::~AssetAsyncCompiler()
 		m_ActiveCompileTask->Wait();
 }
 
-void rageam::ui::AssetAsyncCompiler::CompileAsync(ConstWString assetPath)
+void rageam::ui::AssetAsyncCompiler::CompileAsync(ConstWString assetPath, const zLibCompressionProfile& compressionProfile)
 {
-	m_CompileRequests.push(assetPath);
+	m_CompileRequests.push({ assetPath, compressionProfile });
 }
@@ -26,12 +26,18 @@ namespace rageam::ui
 	{
 		static constexpr ConstString SAVE_POPUP_NAME = "Exporting...##ASSET_SAVE_MODAL_DIALOG";
 
+		struct CompileRequest
+		{
+			file::WPath				Path;
+			zLibCompressionProfile	CompressionProfile;
+		};
+
 		std::mutex              m_ProgressMutex;
 		double                  m_Progress = 0;
 		List<string>            m_ProgressMessages;
 		BackgroundTaskPtr       m_ActiveCompileTask;
 		asset::AssetPtr			m_ActiveAsset;
-		std::queue<file::WPath> m_CompileRequests;
+		std::queue<CompileRequest> m_CompileRequests;
 
 		// Returns FALSE if there's no active task
 		bool ProcessActiveRequest();
@@ -42,6 +48,7 @@ namespace rageam::ui
 	public:
 		~AssetAsyncCompiler() override;
 
-		void CompileAsync(ConstWString assetPath);
+		// Compression profile is passed to resource compiler, fast profile is preferred for iterating in editor
+		void CompileAsync(ConstWString assetPath, const zLibCompressionProfile& compressionProfile = {});
 	};
 }
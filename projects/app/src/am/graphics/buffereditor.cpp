@@ -23,6 +23,34 @@ void rageam::graphics::VertexBufferEditor::SetData(u32 vertexIndex, const Vertex
 	memcpy(dest, in, attribute->SizeInBytes);
 }
 
+bool rageam::graphics::VertexBufferEditor::SetAttributeData(
+	VertexSemantic semantic, u32 semanticIndex, const void* in, DXGI_FORMAT inFormat, u32 inStride)
+{
+	const VertexAttribute* attr = m_Decl.FindAttribute(semantic, semanticIndex);
+	AM_ASSERTS(attr != nullptr);
+
+	const char* src = static_cast<const char*>(in);
+	char* dst = m_Buffer + attr->Offset;
+	if (attr->Format == inFormat)
+	{
+		VertexConvert::Copy(src, inStride, dst, m_Decl.Stride, m_VertexCount, attr->SizeInBytes);
+	}
+	else
+	{
+		VertexConvertFn convertFn = VertexConvert::Find(inFormat, attr->Format);
+		if (!convertFn)
+		{
+			AM_ERRF("VertexBufferEditor() -> Can't convert %s from '%s' to '%s'!",
+				FormatSemanticName(semantic, semanticIndex), Enum::GetName(inFormat), Enum::GetName(attr->Format));
+			return false;
+		}
+		convertFn(src, inStride, dst, m_Decl.Stride, m_VertexCount);
+	}
+
+	SetSemantic(semantic, semanticIndex);
+	return true;
+}
+
 bool rageam::graphics::VertexBufferEditor::CanConvertColor(DXGI_FORMAT toFormat, DXGI_FORMAT inFormat) const
 {
 	if (toFormat == inFormat)
@@ -205,6 +233,14 @@ void rageam::graphics::VertexBufferEditor::SetColor(u32 semanticIndex, pVoid col
 	}
 
 	u32 inStride = DXGI::BytesPerPixel(inFormat);
+
+	// Batched kernel if there's one, otherwise convert vertices one by one
+	if (attr->Format == inFormat || VertexConvert::Find(inFormat, attr->Format))
+	{
+		SetAttributeData(COLOR, semanticIndex, colors, inFormat, inStride);
+		return;
+	}
+
 	for (u32 i = 0; i < m_VertexCount; i++)
 	{
 		char* inColor = static_cast<char*>(colors) + static_cast<size_t>(inStride * i);
@@ -8,6 +8,8 @@
 #pragma once
 
 #include "scene.h"
+#include "vertexbufferiterator.h"
+#include "vertexconvert.h"
 #include "vertexdeclaration.h"
 #include "am/system/enum.h"
 #include "rage/grcore/fvf.h"
@@ -37,6 +39,10 @@ namespace rageam::graphics
 		// For matching data formats
 		void SetData(u32 vertexIndex, const VertexAttribute* attribute, DXGI_FORMAT format, pVoid in) const;
 
+		// Copies or converts (using VertexConvert kernel) attribute data for all vertices at once,
+		// returns false if there's no kernel to convert from given format to attribute format
+		bool SetAttributeData(VertexSemantic semantic, u32 semanticIndex, const void* in, DXGI_FORMAT inFormat, u32 inStride);
+
 		// 'toFormat' is the format of color attribute in this vertex buffer,
 		// 'inFormat' is format of input color that we have to convert to 'toFormat' and set
 		void ConvertAndSetColor(u32 vertexIndex, const VertexAttribute* attribute, DXGI_FORMAT toFormat, DXGI_FORMAT inFormat, pVoid in) const
@@ -50,12 +56,13 @@ namespace rageam::graphics
 			// float[4] to u32
 			if (inFormat == DXGI_FORMAT_R32G32B32A32_FLOAT && toFormat == DXGI_FORMAT_R8G8B8A8_UNORM)
 			{
+				// Same rounding as in batched VertexConvert kernel
 				rage::Vector4 in_Vec4 = *static_cast<rage::Vector4*>(in);
 				u32 out_u32 =
-					(u32)(in_Vec4.X * 255) << 0 |
-					(u32)(in_Vec4.Y * 255) << 8 |
-					(u32)(in_Vec4.Z * 255) << 16 |
-					(u32)(in_Vec4.W * 255) << 24;
+					(u32)VertexConvert::FloatToUnorm8(in_Vec4.X) << 0 |
+					(u32)VertexConvert::FloatToUnorm8(in_Vec4.Y) << 8 |
+					(u32)VertexConvert::FloatToUnorm8(in_Vec4.Z) << 16 |
+					(u32)VertexConvert::FloatToUnorm8(in_Vec4.W) << 24;
 				SetAttributeAt(vertexIndex, attribute->Offset, out_u32);
 				return;
 			}
@@ -231,61 +238,37 @@ namespace rageam::graphics
 		// Unpacks texcoord coordinates from given array to TEXCOORD with specified semantic index
 		void SetTexcords(u32 semanticIndex, const rage::Vector2* uvs)
 		{
-			const VertexAttribute* attr = m_Decl.FindAttribute(TEXCOORD, semanticIndex);
-			for (u32 i = 0; i < m_VertexCount; i++)
-				SetAttributeAt(i, attr->Offset, uvs[i]);
-			SetSemantic(TEXCOORD, semanticIndex);
+			SetAttributeData(TEXCOORD, semanticIndex, uvs, DXGI_FORMAT_R32G32_FLOAT, sizeof(rage::Vector2));
 		}
 
 		// Unpacks position coordinates from given array to POSITION0
 		void SetPositions(const rage::Vector3* positions)
 		{
-			const VertexAttribute* attr = m_Decl.FindAttribute(POSITION, 0);
-			for (u32 i = 0; i < m_VertexCount; i++)
-				SetAttributeAt(i, attr->Offset, positions[i]);
-			SetSemantic(POSITION, 0);
+			SetAttributeData(POSITION, 0, positions, DXGI_FORMAT_R32G32B32_FLOAT, sizeof(rage::Vector3));
 		}
 
-		// Unpacks position coordinates from given vectorized array to POSITION0
+		// Unpacks position coordinates from given vectorized array to POSITION0, W is ignored
 		void SetPositions(const rage::Vec3V* positions)
 		{
-			const VertexAttribute* attr = m_Decl.FindAttribute(POSITION, 0);
-			for (u32 i = 0; i < m_VertexCount; i++)
-			{
-				rage::Vector3 position = positions[i]; // Convert vectorized to scalar
-				SetAttributeAt(i, attr->Offset, position);
-			}
-			SetSemantic(POSITION, 0);
+			SetAttributeData(POSITION, 0, positions, DXGI_FORMAT_R32G32B32_FLOAT, sizeof(rage::Vec3V));
 		}
 
 		// Unpacks normal coordinates from given array to NORMAL0
 		void SetNormals(const rage::Vector3* normals)
 		{
-			const VertexAttribute* attr = m_Decl.FindAttribute(NORMAL, 0);
-			for (u32 i = 0; i < m_VertexCount; i++)
-				SetAttributeAt(i, attr->Offset, normals[i]);
-			SetSemantic(NORMAL, 0);
+			SetAttributeData(NORMAL, 0, normals, DXGI_FORMAT_R32G32B32_FLOAT, sizeof(rage::Vector3));
 		}
 
-		// Unpacks normal coordinates from given vectorized array to NORMAL0
+		// Unpacks normal coordinates from given vectorized array to NORMAL0, W is ignored
 		void SetNormals(const rage::Vec3V* normals)
 		{
-			const VertexAttribute* attr = m_Decl.FindAttribute(NORMAL, 0);
-			for (u32 i = 0; i < m_VertexCount; i++)
-			{
-				rage::Vector3 normal = normals[i]; // Convert vectorized to scalar
-				SetAttributeAt(i, attr->Offset, normal);
-			}
-			SetSemantic(NORMAL, 0);
+			SetAttributeData(NORMAL, 0, normals, DXGI_FORMAT_R32G32B32_FLOAT, sizeof(rage::Vec3V));
 		}
 
 		// Unpacks tangent coordinates from given array to TANGENT0
 		void SetTangents(const rage::Vector4* tangents)
 		{
-			const VertexAttribute* attr = m_Decl.FindAttribute(TANGENT, 0);
-			for (u32 i = 0; i < m_VertexCount; i++)
-				SetAttributeAt(i, attr->Offset, tangents[i]);
-			SetSemantic(TANGENT, 0);
+			SetAttributeData(TANGENT, 0, tangents, DXGI_FORMAT_R32G32B32A32_FLOAT, sizeof(rage::Vector4));
 		}
 
 		// Sets single color for all vertices
@@ -300,18 +283,23 @@ namespace rageam::graphics
 		// Unpacks & converts skin blend indices to BLENDINDICES with semantic 0
 		void SetBlendIndices(pVoid indices, DXGI_FORMAT inFormat);
 
+		// Gets range over attribute in every vertex, attribute type must match format
+		template<typename T>
+		VertexBufferRange<T> GetAttributeRange(VertexSemantic semantic, u32 semanticIndex) const
+		{
+			const VertexAttribute* attr = m_Decl.FindAttribute(semantic, semanticIndex);
+			AM_ASSERTS(attr != nullptr);
+			return VertexBufferRange<T>(VertexBufferIterator<T>(m_Buffer, m_Decl.Stride, attr->Offset), m_VertexCount);
+		}
+
 		// Computes min & max values from POSITION0 coordinates
 		void ComputeMinMax_Position(rage::Vec3V& min, rage::Vec3V& max) const
 		{
 			min = rage::S_MAX;
 			max = rage::S_MIN;
 
-			u32 offset = m_Decl.FindAttribute(POSITION, 0)->Offset;
-
-			for (u32 i = 0; i < m_VertexCount; i++)
+			for (const rage::Vector3& pos : GetAttributeRange<const rage::Vector3>(POSITION, 0))
 			{
-				const rage::Vector3& pos = Attribute<rage::Vector3>(i, offset);
-
 				rage::Vec3V posV(pos);
 				min = posV.Min(min);
 				max = posV.Max(max);
@@ -164,15 +164,18 @@ void rageam::graphics::ImageCompressor::CompressBlocks(const EncoderState& encod
 	}
 }
 
-void rageam::graphics::ImageCompressor::CompressMipRegion(const EncoderState& encoderState, const Region& region)
+void rageam::graphics::ImageCompressor::CompressMipRegion(const Region& region)
 {
 	EASY_FUNCTION("");
 
+	const EncoderState& encoderState = *region.State;
+	const MipState& mip = *region.Mip;
+
 	char* srcPixels = region.SrcPixels;
 	char* dstPixels = region.DstPixels;
 
-	int blockCountX = encoderState.BlockCountX;
-	int regionCount = encoderState.RegionBlocksCount;
+	int blockCountX = mip.BlockCountX;
+	int regionCount = region.BlockRowCount;
 
 	const CompressedImageInfo& encodeInfo = encoderState.EncodeInfo;
 
@@ -225,7 +228,7 @@ void rageam::graphics::ImageCompressor::CompressMipRegion(const EncoderState& en
 
 							if (encodeInfo.AlphaTestCoverage)
 							{
-								float scaledAlpha = static_cast<float>(pixels[i].A) * encoderState.AlphaCoverageScale;
+								float scaledAlpha = static_cast<float>(pixels[i].A) * mip.AlphaCoverageScale;
 								if (scaledAlpha > 255.0f) scaledAlpha = 255.0f;
 								pixels[i].A = static_cast<u8>(scaledAlpha);
 							}
@@ -233,7 +236,7 @@ void rageam::graphics::ImageCompressor::CompressMipRegion(const EncoderState& en
 					}
 
 					// Shift to next row
-					srcBlockPixels += encoderState.SrcRowPitch;
+					srcBlockPixels += mip.SrcRowPitch;
 					dstBlockPixels += IMAGE_BC_BLOCK_ROW_PITCH;
 				}
 
@@ -257,7 +260,7 @@ void rageam::graphics::ImageCompressor::CompressMipRegion(const EncoderState& en
 		}
 
 		// We compressed all 4x4 pixel blocks, move to next block row 4 lines below
-		srcPixels += static_cast<size_t>(4 * encoderState.SrcRowPitch);
+		srcPixels += static_cast<size_t>(4 * mip.SrcRowPitch);
 
 		if (encoderState.Token)
 		{
@@ -267,26 +270,20 @@ void rageam::graphics::ImageCompressor::CompressMipRegion(const EncoderState& en
 	}
 }
 
-void rageam::graphics::ImageCompressor::CompressMip(EncoderState& imgEncData)
+void rageam::graphics::ImageCompressor::CompressMip(const EncoderState& encoderState, const MipState& mip)
 {
 	EASY_FUNCTION();
 
-	ImageInfo imgInfo = imgEncData.Image->GetInfo();
-
-	char* srcPixels = imgEncData.Image->GetPixelDataBytes();
-	char* dstPixels = imgEncData.DstPixels;
+	char* srcPixels = mip.Image->GetPixelDataBytes();
+	char* dstPixels = mip.DstPixels;
 
-	int blockCountY = imgEncData.BlockCountY;
+	int blockCountY = mip.BlockCountY;
 
 	// Small image, process on main thread
 	if (blockCountY < IMAGE_BC_MULTITHREAD_MIN_REGION_SIZE)
 	{
-		imgEncData.RegionBlocksCount = blockCountY;
-
-		Region& regEncData = imgEncData.Regions[0];
-		regEncData.SrcPixels = srcPixels;
-		regEncData.DstPixels = dstPixels;
-		CompressMipRegion(imgEncData, regEncData);
+		Region region = { &encoderState, &mip, srcPixels, dstPixels, blockCountY };
+		CompressMipRegion(region);
 		return;
 	}
 
@@ -294,27 +291,27 @@ void rageam::graphics::ImageCompressor::CompressMip(EncoderState& imgEncData)
 	int regionCount = blockCountY / IMAGE_BC_MULTITHREAD_MIN_REGION_SIZE;
 	regionCount = MIN(regionCount, IMAGE_BC_MULTITHREAD_MAX_REGIONS);
 	int regionBlocksCount = blockCountY / regionCount; // We have to recompute size after clamping count
-	int regionPixelRows = imgInfo.Height / regionCount;
-
-	imgEncData.RegionBlocksCount = regionBlocksCount;
 
 	// Create background task for every region
+	Region regions[IMAGE_BC_MULTITHREAD_MAX_REGIONS];
 	amPtr<BackgroundTask> regionTasks[IMAGE_BC_MULTITHREAD_MAX_REGIONS];
 
-	u32 srcRegionSlicePitch = imgEncData.SrcRowPitch * regionPixelRows;
-	u32 dstRegionSlicePitch = imgEncData.DstRowPitch * regionBlocksCount;
+	u32 srcRegionSlicePitch = mip.SrcRowPitch * regionBlocksCount * 4;
+	u32 dstRegionSlicePitch = mip.DstRowPitch * regionBlocksCount;
 
 	BackgroundWorker::Push(sm_RegionWorker);
 
 	for (int i = 0; i < regionCount; i++)
 	{
-		Region& regEncData = imgEncData.Regions[i];
-		regEncData.SrcPixels = srcPixels;
-		regEncData.DstPixels = dstPixels;
+		// Last region also takes remaining rows that didn't divide evenly
+		int blockRowCount = i == regionCount - 1 ? blockCountY - i * regionBlocksCount : regionBlocksCount;
+
+		Region& region = regions[i];
+		region = { &encoderState, &mip, srcPixels, dstPixels, blockRowCount };
 
-		regionTasks[i] = BackgroundWorker::Run([&]
+		regionTasks[i] = BackgroundWorker::Run([&region]
 			{
-				CompressMipRegion(imgEncData, regEncData);
+				CompressMipRegion(region);
 				return true;
 			});
 
@@ -331,6 +328,57 @@ void rageam::graphics::ImageCompressor::CompressMip(EncoderState& imgEncData)
 	BackgroundWorker::Pop();
 }
 
+void rageam::graphics::ImageCompressor::CompressTiles(const EncoderState* const* encoderStates, int stateCount)
+{
+	EASY_FUNCTION();
+
+	// Flat list of tiles, every tile is a few whole block rows of single mip.
+	// Unlike regions, small mips and small images are distributed between threads too
+	List<Region> tiles;
+	for (int i = 0; i < stateCount; i++)
+	{
+		const EncoderState& encoderState = *encoderStates[i];
+		for (int k = 0; k < encoderState.MipCount; k++)
+		{
+			const MipState& mip = encoderState.Mips[k];
+
+			int tileBlockRows = MAX(1, IMAGE_BC_TILE_BLOCK_COUNT / mip.BlockCountX);
+			char* srcPixels = mip.Image->GetPixelDataBytes();
+			char* dstPixels = mip.DstPixels;
+			for (int blockY = 0; blockY < mip.BlockCountY; blockY += tileBlockRows)
+			{
+				int blockRowCount = MIN(tileBlockRows, mip.BlockCountY - blockY);
+				tiles.Add({ &encoderState, &mip, srcPixels, dstPixels, blockRowCount });
+
+				srcPixels += static_cast<size_t>(mip.SrcRowPitch) * blockRowCount * 4;
+				dstPixels += static_cast<size_t>(mip.DstRowPitch) * blockRowCount;
+			}
+		}
+	}
+
+	// Nothing to distribute
+	if (tiles.GetSize() == 1)
+	{
+		CompressMipRegion(tiles[0]);
+		return;
+	}
+
+	Tasks tileTasks;
+	tileTasks.Reserve(tiles.GetSize());
+
+	BackgroundWorker::Push(sm_RegionWorker);
+	for (const Region& tile : tiles)
+	{
+		tileTasks.Emplace(BackgroundWorker::Run([&tile]
+			{
+				CompressMipRegion(tile);
+				return true;
+			}));
+	}
+	BackgroundWorker::WaitFor(tileTasks);
+	BackgroundWorker::Pop();
+}
+
 rageam::graphics::CompressedImageInfo rageam::graphics::ImageCompressor::GetInfoAndHash(
 	const ImageInfo& imgInfo,
 	const ImageCompressorOptions& options,
@@ -447,11 +495,18 @@ rageam::graphics::CompressedImageInfo rageam::graphics::ImageCompressor::GetInfo
 	return encodeInfo;
 }
 
-rageam::graphics::ImagePtr rageam::graphics::ImageCompressor::Compress(
-	const ImagePtr& img, const ImageCompressorOptions& options, const u32* pixelHashOverride, CompressedImageInfo* outCompInfo, ImageCompressorToken* token)
+bool rageam::graphics::ImageCompressor::PrepareToCompress(ImageCompressorRequest& request, EncoderState& encoderState)
 {
 	EASY_FUNCTION();
 
+	const ImagePtr& img = request.Image;
+	const ImageCompressorOptions& options = request.Options;
+	const u32* pixelHashOverride = request.PixelHashOverride;
+	CompressedImageInfo* outCompInfo = request.OutCompInfo;
+	ImageCompressorToken* token = request.Token;
+
+	request.Result = nullptr;
+
 	if (token) token->Reset();
 
 	u32 cacheHash;
@@ -465,24 +520,25 @@ rageam::graphics::ImagePtr rageam::graphics::ImageCompressor::Compress(
 
 	if (outCompInfo) *outCompInfo = encodeInfo;
 
-	ImageInfo& encodedImageInfo = encodeInfo.ImageInfo;
 	ImageInfo imageInfo = img->GetInfo();
 
 	// Attempt to retrieve image from cache
 	ImageCache* cache = ImageCache::GetInstance();
-	amPtr<Image> compressedImage = cache->GetFromCache(cacheHash, &encodeInfo.UV2);
-	if (compressedImage)
-		return compressedImage;
+	request.Result = cache->GetFromCache(cacheHash, &encodeInfo.UV2);
+	if (request.Result)
+		return false;
 
 	// Previously we needed only metadata to locate image in cache, now we need pixel data too to compress it
 	if (!img->EnsurePixelDataLoaded())
 	{
 		AM_ERRF("ImageCompressor::Compress() -> Failed to load image pixel data!");
-		return nullptr;
+		return false;
 	}
 
 	// Image was not in cache, compress it. We compute compress time to cache only expensive images
-	Timer timer = Timer::StartNew();
+	encoderState.CompressTimer = Timer::StartNew();
+	encoderState.CacheHash = cacheHash;
+	encoderState.UV2 = encodeInfo.UV2;
 
 	// Image can be converted to RGBA + rescaled, we hold separate pointer
 	ImagePtr preparedImage = img;
@@ -506,6 +562,7 @@ rageam::graphics::ImagePtr rageam::graphics::ImageCompressor::Compress(
 		u32 unusedHash; // We must ignore this hash because we use one from non-padded image
 		encodeInfo = GetInfoAndHash(
 			imageInfo, options, unusedHash, pixelHashOverride, preparedImage->GetPixelData().Data(), preparedImage->ComputeSlicePitch());
+		encoderState.UV2 = uv2;
 
 		if (outCompInfo)
 		{
@@ -517,39 +574,41 @@ rageam::graphics::ImagePtr rageam::graphics::ImageCompressor::Compress(
 		}
 	}
 
+	const ImageInfo& encodedImageInfo = encodeInfo.ImageInfo;
+
 	// Now that we know image is not in cache, we can resize it (size depends on options.MaxResolution)
 	int mipCount = encodedImageInfo.MipCount;
-	int compWidth = encodeInfo.ImageInfo.Width;
-	int compHeight = encodeInfo.ImageInfo.Height;
+	int compWidth = encodedImageInfo.Width;
+	int compHeight = encodedImageInfo.Height;
 	bool needResizeImage = compWidth != imageInfo.Width || compHeight != imageInfo.Height;
 	preparedImage = needResizeImage ? preparedImage->Resize(compWidth, compHeight) : preparedImage;
 
 	// Skip encoders initialization for RGBA
-	EncoderState encoderState = {};
 	encoderState.Token = token;
+	encoderState.EncodeInfo = encodeInfo;
+	encoderState.MipCount = mipCount;
 	if (options.Format != BlockFormat_None)
 	{
 		encoderState.SrcPixelPitch = ImagePixelFormatBitsPerPixel[imageInfo.PixelFormat] / 8;
-		encoderState.EncodeInfo = encodeInfo;
 		encoderState.ImageInfo = imageInfo;
 		encoderState.EncoderImpl = encodeInfo.EncoderImpl;
+		encoderState.DstPixelFormat = encodedImageInfo.PixelFormat;
 
 		if (encodeInfo.EncoderImpl == BlockCompressorImpl::None)
 		{
 			if (outCompInfo) *outCompInfo = {};
 			AM_ERRF("ImageCompressor::Compress() -> Encoder was not resolved to any implementation, returning NULL.");
-			return nullptr;
+			return false;
 		}
 
 		// Initialize block encoders
-		static bool s_CompressorsInitialized = false;
-		if (!s_CompressorsInitialized)
-		{
-			ispc::bc7e_compress_block_init();
-			rgbcx::init();
-			icbc::init();
-			s_CompressorsInitialized = true;
-		}
+		static std::once_flag s_CompressorsInitialized;
+		std::call_once(s_CompressorsInitialized, []
+			{
+				ispc::bc7e_compress_block_init();
+				rgbcx::init();
+				icbc::init();
+			});
 
 		if (options.Format == BlockFormat_BC1 || options.Format == BlockFormat_BC4)
 			encoderState.DstPixelPitch = IMAGE_BC_1_4_BLOCK_SIZE;
@@ -576,9 +635,9 @@ rageam::graphics::ImagePtr rageam::graphics::ImageCompressor::Compress(
 	}
 
 	// Allocate continuous block of memory for all mip maps
-	u32 encodedDataSize = ImageComputeTotalSizeWithMips(compWidth, compHeight, mipCount, encodedImageInfo.PixelFormat);
-	PixelDataOwner encodedDataOwner = PixelDataOwner::AllocateWithSize(encodedDataSize);
-	pChar encodedPixels = encodedDataOwner.Data()->Bytes;
+	encoderState.EncodedDataSize = ImageComputeTotalSizeWithMips(compWidth, compHeight, mipCount, encodedImageInfo.PixelFormat);
+	encoderState.EncodedData = PixelDataOwner::AllocateWithSize(encoderState.EncodedDataSize);
+	pChar encodedPixels = encoderState.EncodedData.Data()->Bytes;
 
 	// Compute total amount of rows for progress report
 	if (encoderState.Token)
@@ -590,7 +649,8 @@ rageam::graphics::ImagePtr rageam::graphics::ImageCompressor::Compress(
 		}
 	}
 
-	// We compress every mip layer by downsampling image by factor of 2 every time
+	// We prepare every mip layer by downsampling image by factor of 2 every time,
+	// actual compression of all mips happens later at once
 	ImageInfo mipInfo;
 	for (int i = 0; i < mipCount; i++)
 	{
@@ -598,6 +658,9 @@ rageam::graphics::ImagePtr rageam::graphics::ImageCompressor::Compress(
 		ImagePtr  mipImage = preparedImage;
 		mipInfo = mipImage->GetInfo();
 
+		MipState& mip = encoderState.Mips[i];
+		mip.AlphaCoverageScale = 1.0f;
+
 		u32 encodedMipSlicePitch = ImageComputeSlicePitch(mipInfo.Width, mipInfo.Height, encodedImageInfo.PixelFormat);
 
 		// Compute scaling factor to preserve alpha coverage
@@ -610,11 +673,10 @@ rageam::graphics::ImagePtr rageam::graphics::ImageCompressor::Compress(
 			if (i == 0)
 			{
 				encoderState.DesiredAlphaCoverage = alphaCoverage;
-				encoderState.AlphaCoverageScale = 1.0f;
 			}
 			else
 			{
-				encoderState.AlphaCoverageScale = ImageAlphaTestFindBestScaleRGBA(
+				mip.AlphaCoverageScale = ImageAlphaTestFindBestScaleRGBA(
 					mipImage->GetPixelDataBytes(), mipInfo.Width, mipInfo.Height, encodeInfo.AlphaTestThreshold,
 					encoderState.DesiredAlphaCoverage);
 			}
@@ -629,14 +691,12 @@ rageam::graphics::ImagePtr rageam::graphics::ImageCompressor::Compress(
 
 		if (options.Format != BlockFormat_None)
 		{
-			encoderState.Image = mipImage;
-			encoderState.DstPixels = encodedPixels;
-			encoderState.DstPixelFormat = encodeInfo.ImageInfo.PixelFormat;
-			encoderState.SrcRowPitch = ImageComputeRowPitch(mipInfo.Width, mipInfo.PixelFormat);
-			encoderState.DstRowPitch = ImageComputeRowPitch(mipInfo.Width, encodedImageInfo.PixelFormat);
-			encoderState.BlockCountX = mipInfo.Width / 4;
-			encoderState.BlockCountY = mipInfo.Height / 4;
-			CompressMip(encoderState);
+			mip.Image = mipImage;
+			mip.DstPixels = encodedPixels;
+			mip.SrcRowPitch = ImageComputeRowPitch(mipInfo.Width, mipInfo.PixelFormat);
+			mip.DstRowPitch = ImageComputeRowPitch(mipInfo.Width, encodedImageInfo.PixelFormat);
+			mip.BlockCountX = mipInfo.Width / 4;
+			mip.BlockCountY = mipInfo.Height / 4;
 		}
 		else
 		{
@@ -648,30 +708,98 @@ rageam::graphics::ImagePtr rageam::graphics::ImageCompressor::Compress(
 				ImageCutoutAlphaRGBA(encodedPixels, mipInfo.Width, mipInfo.Height, encodeInfo.CutoutAlphaThreshold);
 			// First mip doesn't require alpha scaling
 			if (i != 0 && encodeInfo.AlphaTestCoverage)
-				ImageScaleAlphaRGBA(encodedPixels, mipInfo.Width, mipInfo.Height, encoderState.AlphaCoverageScale);
+				ImageScaleAlphaRGBA(encodedPixels, mipInfo.Width, mipInfo.Height, mip.AlphaCoverageScale);
 		}
 
 		if (token && token->Canceled)
-			return nullptr;
+			return false;
 
 		// Move to next compressed mip map pixel data
 		encodedPixels += encodedMipSlicePitch;
 
 		// Downsample to next mip map
-		preparedImage = preparedImage->Resize(mipInfo.Width / 2, mipInfo.Height / 2, options.MipFilter);
+		if (i + 1 < mipCount)
+			preparedImage = preparedImage->Resize(mipInfo.Width / 2, mipInfo.Height / 2, options.MipFilter);
 	}
 
+	return true;
+}
+
+void rageam::graphics::ImageCompressor::FinishCompression(ImageCompressorRequest& request, EncoderState& encoderState)
+{
+	if (request.Token && request.Token->Canceled)
+		return;
+
 	// Create DDS image from compressed pixel data
-	ImagePtr compImage = std::make_shared<Image>(encodedDataOwner, encodedImageInfo);
+	ImagePtr compImage = std::make_shared<Image>(encoderState.EncodedData, encoderState.EncodeInfo.ImageInfo);
 
 	// See if image compression took long enough to compress it
-	timer.Stop();
-	if (cache->ShouldStore(timer.GetElapsedMilliseconds()))
+	encoderState.CompressTimer.Stop();
+	ImageCache* cache = ImageCache::GetInstance();
+	if (cache->ShouldStore(encoderState.CompressTimer.GetElapsedMilliseconds()))
 	{
-		cache->Cache(compImage, cacheHash, encodedDataSize, ImageCacheEntryFlags_StoreInFileSystem, outCompInfo->UV2);
+		cache->Cache(compImage, encoderState.CacheHash, encoderState.EncodedDataSize, ImageCacheEntryFlags_StoreInFileSystem, encoderState.UV2);
 	}
 
-	return compImage;
+	request.Result = compImage;
+}
+
+rageam::graphics::ImagePtr rageam::graphics::ImageCompressor::Compress(
+	const ImagePtr& img, const ImageCompressorOptions& options, const u32* pixelHashOverride, CompressedImageInfo* outCompInfo, ImageCompressorToken* token)
+{
+	ImageCompressorRequest request;
+	request.Image = img;
+	request.Options = options;
+	request.PixelHashOverride = pixelHashOverride;
+	request.OutCompInfo = outCompInfo;
+	request.Token = token;
+	CompressBatch(&request, 1);
+	return request.Result;
+}
+
+void rageam::graphics::ImageCompressor::CompressBatch(ImageCompressorRequest* requests, int requestCount)
+{
+	EASY_FUNCTION();
+
+	// Encoder state is quite large, allocate it on heap
+	List<amUPtr<EncoderState>> encoderStates;
+	List<ImageCompressorRequest*> pendingRequests;
+	List<const EncoderState*> statesToEncode;
+	for (int i = 0; i < requestCount; i++)
+	{
+		ImageCompressorRequest& request = requests[i];
+		amUPtr<EncoderState> encoderState = std::make_unique<EncoderState>();
+		if (!PrepareToCompress(request, *encoderState))
+			continue;
+
+		if (request.Options.Format != BlockFormat_None)
+			statesToEncode.Add(encoderState.get());
+		pendingRequests.Add(&request);
+		encoderStates.Emplace(std::move(encoderState));
+	}
+
+	if (sm_WorkMode == ImageCompressorWorkMode_Tiles)
+	{
+		if (statesToEncode.Any())
+			CompressTiles(statesToEncode.GetItems(), statesToEncode.GetSize());
+	}
+	else
+	{
+		for (const EncoderState* encoderState : statesToEncode)
+		{
+			for (int i = 0; i < encoderState->MipCount; i++)
+			{
+				if (encoderState->Token && encoderState->Token->Canceled)
+					break;
+				CompressMip(*encoderState, encoderState->Mips[i]);
+			}
+		}
+	}
+
+	for (u32 i = 0; i < pendingRequests.GetSize(); i++)
+	{
+		FinishCompression(*pendingRequests[i], *encoderStates[i]);
+	}
 }
 
 rageam::graphics::ImagePtr rageam::graphics::ImageCompressor::Decompress(const ImagePtr& img, int mipIndex)
@@ -720,7 +848,11 @@ void rageam::graphics::ImageCompressor::DecompressBlock(const char* inBlock, cha
 
 void rageam::graphics::ImageCompressor::InitClass()
 {
-	sm_RegionWorker = new BackgroundWorker("Img BC", IMAGE_BC_MULTITHREAD_MAX_REGIONS);
+	// Tiles are distributed between all cores, regions need at least IMAGE_BC_MULTITHREAD_MAX_REGIONS threads
+	SYSTEM_INFO sysInfo;
+	GetSystemInfo(&sysInfo);
+	int threadCount = MAX(IMAGE_BC_MULTITHREAD_MAX_REGIONS, static_cast<int>(sysInfo.dwNumberOfProcessors));
+	sm_RegionWorker = new BackgroundWorker("Img BC", threadCount);
 }
 
 void rageam::graphics::ImageCompressor::ShutdownClass()
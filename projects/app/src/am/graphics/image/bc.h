@@ -8,6 +8,7 @@
 #pragma once
 
 #include "image.h"
+#include "am/system/timer.h"
 
 #ifdef AM_IMAGE_USE_AVX2
 #include <bc7e_ispc_avx2.h>
@@ -26,6 +27,7 @@ namespace rageam::graphics
 	// BC - Block compression
 	// Encoded / Enc - same as compressed
 	// Region / Reg - part of image defined by pixel row range
+	// Tile - region of fixed block count, used to distribute all mips of image between threads
 
 	// https://en.wikipedia.org/wiki/S3_Texture_Compression
 
@@ -195,46 +197,90 @@ namespace rageam::graphics
 	};
 	using ImageCompressorTokenPtr = ImageCompressorToken*;
 
+	enum ImageCompressorWorkMode
+	{
+		ImageCompressorWorkMode_Regions,	// Every mip is split on up to IMAGE_BC_MULTITHREAD_MAX_REGIONS row ranges, mips are compressed one by one
+		ImageCompressorWorkMode_Tiles,		// Single flat list of fixed-size block tiles spanning all mips (and images in batch)
+	};
+
+	// Approximate number of 4x4 blocks in single tile job, tile is always made of whole block rows
+	static constexpr int IMAGE_BC_TILE_BLOCK_COUNT = 512;
+
+	// Single image in ImageCompressor::CompressBatch
+	struct ImageCompressorRequest
+	{
+		ImagePtr				Image;
+		ImageCompressorOptions	Options;
+		const u32*				PixelHashOverride = nullptr;
+		CompressedImageInfo*	OutCompInfo = nullptr;
+		ImageCompressorToken*	Token = nullptr;
+		// Set by compressor, NULL if compression failed or was canceled
+		ImagePtr				Result;
+	};
+
 	/**
 	 * \brief BC Image encoder with internal caching.
 	 */
 	class ImageCompressor
 	{
+		struct EncoderState;
+
+		// Prepared (resized, post-processed) mip map and its destination in compressed buffer
+		struct MipState
+		{
+			ImagePtr	Image;
+			pChar		DstPixels;
+			u32			SrcRowPitch;
+			u32			DstRowPitch;
+			int			BlockCountX;
+			int			BlockCountY;
+			float		AlphaCoverageScale;
+		};
+
+		// Range of block rows in single mip
 		struct Region
 		{
-			pChar SrcPixels;
-			pChar DstPixels;
+			const EncoderState*	State;
+			const MipState*		Mip;
+			pChar				SrcPixels;
+			pChar				DstPixels;
+			int					BlockRowCount;
 		};
 
-		// Note: the way this struct is designed, only one mip allowed to be compressed at the time!
-		// No multithreaded mip compression is possible
+		// All mip maps are prepared before compression starts, so any number of
+		// mips (and images) can be compressed in parallel
 		struct EncoderState
 		{
 			ImageCompressorTokenPtr				Token;
-			ImagePtr							Image;
 			ImageInfo							ImageInfo;
 			CompressedImageInfo					EncodeInfo;
-			// Pointer to compressed pixel data buffer
-			pChar								DstPixels;
 			ImagePixelFormat					DstPixelFormat;
 			u32									SrcPixelPitch;
 			u32									DstPixelPitch;
-			u32									SrcRowPitch;
-			u32									DstRowPitch;
 			BlockCompressorImpl					EncoderImpl;
-			// Storage for all regions shared by parallel threads
-			Region								Regions[IMAGE_BC_MULTITHREAD_MAX_REGIONS];
-			int									BlockCountX;
-			int									BlockCountY;
-			int									RegionBlocksCount;
+			MipState							Mips[IMAGE_MAX_MIP_MAPS];
+			int									MipCount;
 			float								DesiredAlphaCoverage;
-			float								AlphaCoverageScale;
 			ispc::bc7e_compress_block_params	bc7enc_rdo_params;
+			// Compressed pixel data of all mips
+			PixelDataOwner						EncodedData;
+			u32									EncodedDataSize;
+			u32									CacheHash;
+			Vec2S								UV2;
+			Timer								CompressTimer;
 		};
 
 		static void CompressBlocks(const EncoderState& encoderState, int numBlocks, char* dstBlocks, char* srcBlocks);
-		static void CompressMipRegion(const EncoderState& encoderState, const Region& region);
-		static void CompressMip(EncoderState& imgEncData);
+		static void CompressMipRegion(const Region& region);
+		static void CompressMip(const EncoderState& encoderState, const MipState& mip);
+		// Splits mips of all given images on tiles and compresses them on region worker in one go
+		static void CompressTiles(const EncoderState* const* encoderStates, int stateCount);
+
+		// Looks up image in cache and prepares all mip maps for compression,
+		// returns False if there's nothing to compress (image was cached or an error occurred) and result is already set
+		static bool PrepareToCompress(ImageCompressorRequest& request, EncoderState& encoderState);
+		// Creates image from compressed pixel data and stores it in the cache
+		static void FinishCompression(ImageCompressorRequest& request, EncoderState& encoderState);
 
 		// Does not perform actual compression but only computes metadata of (potential) compressed image
 		// NOTE: Either pixelHashOverride or pixelData must be provided!
@@ -250,6 +296,7 @@ namespace rageam::graphics
 		// - Need more threads
 		// - Scenario when all system worker threads are used would cause deadlock
 		static BackgroundWorker* sm_RegionWorker;
+		static inline ImageCompressorWorkMode sm_WorkMode = ImageCompressorWorkMode_Tiles;
 
 	public:
 		// Compresses given image with given options and returns newly created image
@@ -262,6 +309,13 @@ namespace rageam::graphics
 			CompressedImageInfo* outCompInfo = nullptr,
 			ImageCompressorToken* token = nullptr);
 
+		// Compresses multiple images at once, tiles of all images are distributed between threads together.
+		// This is preferred over calling ::Compress on every image if images are small
+		static void CompressBatch(ImageCompressorRequest* requests, int requestCount);
+
+		static void SetWorkMode(ImageCompressorWorkMode mode) { sm_WorkMode = mode; }
+		static ImageCompressorWorkMode GetWorkMode() { return sm_WorkMode; }
+
 		// Decodes BC pixels to RGBA
 		// If given image format is already RGBA32, a reference to original pixel data will be returned
 		static ImagePtr Decompress(const ImagePtr& img, int mipIndex = 0);
@@ -8,6 +8,7 @@
 #include "helpers/dx11.h"
 #include "imagecache.h"
 #include "bc.h"
+#include "mipchain.h"
 
 #include <webp/decode.h>
 #include <webp/encode.h>
@@ -1043,7 +1044,8 @@ void rageam::graphics::ImageResize(
 	ImagePixelFormat fmt,
 	int xFrom, int yFrom,
 	int xTo, int yTo,
-	bool hasAlphaPixels)
+	bool hasAlphaPixels,
+	bool gammaCorrect)
 {
 	EASY_FUNCTION();
 
@@ -1081,7 +1083,10 @@ void rageam::graphics::ImageResize(
 	default: AM_UNREACHABLE("ResizeImagePixels() -> Pixel format '%s' is not supported.", Enum::GetName(fmt));
 	}
 
-	stbir_resize(src, xFrom, yFrom, 0, dst, xTo, yTo, 0, irPixelLayout, STBIR_TYPE_UINT8, STBIR_EDGE_CLAMP, irFilter);
+	// Alpha is kept linear in sRGB mode
+	stbir_datatype irDataType = gammaCorrect ? STBIR_TYPE_UINT8_SRGB : STBIR_TYPE_UINT8;
+
+	stbir_resize(src, xFrom, yFrom, 0, dst, xTo, yTo, 0, irPixelLayout, irDataType, STBIR_EDGE_CLAMP, irFilter);
 }
 
 char* rageam::graphics::ImageGetPixel(char* pixelData, int x, int y, int width, ImagePixelFormat fmt)
@@ -1956,7 +1961,7 @@ amPtr<rageam::graphics::Image> rageam::graphics::Image::ConvertPixelFormat(Image
 	return ImageFactory::Create(dataOwner, formatTo, m_Width, m_Height);
 }
 
-amPtr<rageam::graphics::Image> rageam::graphics::Image::GenerateMipMaps(ResizeFilter mipFilter)
+amPtr<rageam::graphics::Image> rageam::graphics::Image::GenerateMipMaps(ResizeFilter mipFilter, bool gammaCorrect)
 {
 	// Image already have mip maps or mips can't be generated (bc formats are loss and meant to be encoded only once)
 	if (ImageIsCompressedFormat(m_PixelFormat) || m_MipCount > 1)
@@ -1975,34 +1980,29 @@ amPtr<rageam::graphics::Image> rageam::graphics::Image::GenerateMipMaps(ResizeFi
 
 	PixelDataOwner mipPixelData = PixelDataOwner::AllocateForImage(m_Width, m_Height, m_PixelFormat, mipCount);
 	char* mipPixelBytes = mipPixelData.Data()->Bytes;
-	// We store pointer to previous mip to generate mip from it and not from the largest mip
-	char* prevMipPixelBytes = GetPixelDataBytes();
 
-	int mipWidth = m_Width;
-	int mipHeight = m_Height;
-	int prevMipWidth = m_Width;
-	int prevMipHeight = m_Height;
+	// Copy the first mip and generate the rest from it, every mip is downsampled from the previous one
+	memcpy(mipPixelBytes, GetPixelDataBytes(), ComputeSlicePitch());
+	ImageMipChain::Generate(mipPixelBytes, mipFilter, m_PixelFormat, m_Width, m_Height, mipCount, hasAlphaPixels, gammaCorrect);
 
-	for (int i = 0; i < mipCount; i++)
-	{
-		u32 slicePitch = ImageComputeSlicePitch(mipWidth, mipHeight, m_PixelFormat);
+	return std::make_shared<Image>(mipPixelData, m_PixelFormat, m_Width, m_Height, mipCount);
+}
 
-		// Downsample previous mip map by 2x factor, for the first mip map
-		// new/previous sizes will match and pixel data will be simply copied over
-		ImageResize(
-			mipPixelBytes, prevMipPixelBytes, mipFilter, m_PixelFormat,
-			prevMipWidth, prevMipHeight, mipWidth, mipHeight, hasAlphaPixels);
+amPtr<rageam::graphics::Image> rageam::graphics::Image::GenerateNextMip(ResizeFilter mipFilter, bool gammaCorrect)
+{
+	EASY_FUNCTION();
 
-		prevMipPixelBytes = mipPixelBytes;
-		prevMipWidth = mipWidth;
-		prevMipHeight = mipHeight;
+	int newWidth = m_Width / 2;
+	int newHeight = m_Height / 2;
 
-		mipPixelBytes += slicePitch;
-		mipWidth /= 2;
-		mipHeight /= 2;
-	}
+	// Other filters are expensive enough to be worth caching
+	if (!gammaCorrect && !ImageMipChain::CanUseFastPath(mipFilter, m_PixelFormat, m_Width, m_Height))
+		return Resize(newWidth, newHeight, mipFilter);
 
-	return std::make_shared<Image>(mipPixelData, m_PixelFormat, m_Width, m_Height, mipCount);
+	PixelDataOwner mipData = PixelDataOwner::AllocateForImage(newWidth, newHeight, m_PixelFormat);
+	ImageMipChain::Downsample(mipData.Data()->Bytes, GetPixelDataBytes(), mipFilter, m_PixelFormat, m_Width, m_Height, ScanAlpha(), gammaCorrect);
+
+	return ImageFactory::Create(mipData, m_PixelFormat, newWidth, newHeight, false);
 }
 
 amPtr<rageam::graphics::Image> rageam::graphics::Image::FitMaximumResolution(int maximumResolution, ResizeFilter filter)
@@ -2043,7 +2043,7 @@ bool rageam::graphics::Image::CreateDX11Resource(
 	// Attempt to retrieve view from cache
 	// TODO: Hash is not ideal because two options still may produce the same view
 	u32 viewHash;
-	viewHash = DataHash(m_PixelData.Data()->Bytes, ComputeTotalSizeWithMips());
+	viewHash = rage::atDataHash64To32(m_PixelData.Data()->Bytes, ComputeTotalSizeWithMips());
 	viewHash = DataHash(&options, sizeof ImageDX11ResourceOptions, viewHash);
 	amComPtr<ID3D11ShaderResourceView> cachedView;
 	amComPtr<ID3D11Texture2D> cachedTex;
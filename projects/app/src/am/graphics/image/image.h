@@ -222,9 +222,10 @@ namespace rageam::graphics
 
 	// Low level function to resize array of image pixels
 	// Images without alpha are faster to process because alpha channel is processed separately and can be ignored
+	// If gamma correct is set, color channels are filtered in linear space (pixels are assumed to be sRGB)
 	void ImageResize(
 		pVoid dst, pVoid src, ResizeFilter filter, ImagePixelFormat fmt,
-		int xFrom, int yFrom, int xTo, int yTo, bool hasAlphaPixels);
+		int xFrom, int yFrom, int xTo, int yTo, bool hasAlphaPixels, bool gammaCorrect = false);
 
 	// Only for non-compressed formats
 	char* ImageGetPixel(char* pixelData, int x, int y, int width, ImagePixelFormat fmt);
@@ -420,7 +421,10 @@ namespace rageam::graphics
 		// If format matches current, shallow clone is returned
 		amPtr<Image> ConvertPixelFormat(ImagePixelFormat formatTo) const;
 		// Will return existing pixel data if image already have more than 1 mip map or pixels are block compressed
-		amPtr<Image> GenerateMipMaps(ResizeFilter mipFilter = ResizeFilter_Box);
+		amPtr<Image> GenerateMipMaps(ResizeFilter mipFilter = ResizeFilter_Box, bool gammaCorrect = false);
+		// Downsamples image by factor of 2 (see ImageMipChain), unlike Resize result is not cached
+		// for box and triangle filters because it is cheaper to downsample image again than to hash it
+		amPtr<Image> GenerateNextMip(ResizeFilter mipFilter = ResizeFilter_Box, bool gammaCorrect = false);
 		// Makes sure that image resolution is smaller equal to given constraint,
 		// If maximumResolution is set to 0, shallow clone is returned
 		amPtr<Image> FitMaximumResolution(int maximumResolution, ResizeFilter filter = ResizeFilter_Box);
@@ -3,7 +3,6 @@
 #include "am/file/fileutils.h"
 #include "am/system/datamgr.h"
 #include "am/xml/doc.h"
-#include "am/xml/iterator.h"
 #include "helpers/format.h"
 #include "bc.h"
 
@@ -14,15 +13,16 @@
 rageam::HashValue rageam::graphics::ImageCache::ComputeImageHash(ImagePixelData imageData, u32 imageDataSize, const CompressedImageInfo& compInfo) const
 {
 	EASY_FUNCTION();
-	u32 hash;
-	hash = rage::atDataHash(imageData, imageDataSize);
-	hash = rage::atDataHash(&compInfo, sizeof CompressedImageInfo, hash);
-	return hash;
+	// Pixel data is hashed with fast SIMD hash, cache keys are not game related
+	u64 hash;
+	hash = rage::atDataHash64(imageData, imageDataSize);
+	hash = rage::atDataHash64(&compInfo, sizeof CompressedImageInfo, hash);
+	return static_cast<u32>(hash) ^ static_cast<u32>(hash >> 32);
 }
 
 rageam::HashValue rageam::graphics::ImageCache::ComputeImageHash(ImagePixelData imageData, u32 imageDataSize) const
 {
-	return rage::atDataHash(imageData, imageDataSize);
+	return rage::atDataHash64To32(imageData, imageDataSize);
 }
 
 void rageam::graphics::ImageCache::SaveSettings(const file::WPath& path, const Settings& settings) const
@@ -106,35 +106,354 @@ void rageam::graphics::ImageCache::LoadSettings()
 	}
 }
 
-bool rageam::graphics::ImageCache::GetInfoFromCachedImagePath(const file::WPath& path, u32& hash, u32& imageSize) const
+template<typename TEntry>
+void rageam::graphics::ImageCache::LruPushFront(HashSet<TEntry>& entries, LruList& list, u32 hash)
 {
-	file::WPath fileName = path.GetFileNameWithoutExtension();
-	hash = 0;
-	imageSize = 0;
-	return swscanf_s(fileName.GetCStr(), L"%u_%u", &hash, &imageSize) > 0;
+	TEntry& entry = entries.GetAt(hash);
+	if (list.Count == 0)
+	{
+		list.Tail = hash;
+	}
+	else
+	{
+		entry.Lru.Next = list.Head;
+		entries.GetAt(list.Head).Lru.Prev = hash;
+	}
+	list.Head = hash;
+	list.Count++;
+}
+
+template<typename TEntry>
+void rageam::graphics::ImageCache::LruRemove(HashSet<TEntry>& entries, LruList& list, u32 hash)
+{
+	// Head and tail are compared instead of using 'null' link value because any hash is valid
+	TEntry& entry = entries.GetAt(hash);
+	if (list.Head == hash)	list.Head = entry.Lru.Next;
+	else					entries.GetAt(entry.Lru.Prev).Lru.Next = entry.Lru.Next;
+	if (list.Tail == hash)	list.Tail = entry.Lru.Prev;
+	else					entries.GetAt(entry.Lru.Next).Lru.Prev = entry.Lru.Prev;
+	list.Count--;
+}
+
+void rageam::graphics::ImageCache::DeleteLegacyCache() const
+{
+	file::WPath listPath = m_CacheDirectory / LEGACY_CACHE_LIST_NAME;
+	if (!IsFileExists(listPath))
+		return;
+
+	AM_DEBUGF(L"ImageCache -> Removing cache in legacy format from '%ls'", m_CacheDirectory.GetCStr());
+
+	// Images were stored as '{hash}_{size}.{ext}'
+	WIN32_FIND_DATAW findData;
+	HANDLE findHandle = FindFirstFileW(m_CacheDirectory / L"*_*.*", &findData);
+	if (findHandle != INVALID_HANDLE_VALUE)
+	{
+		do
+		{
+			u32 hash, imageSize;
+			if (swscanf_s(findData.cFileName, L"%u_%u.", &hash, &imageSize) == 2)
+				DeleteFileW(m_CacheDirectory / findData.cFileName);
+		} while (FindNextFileW(findHandle, &findData));
+		FindClose(findHandle);
+	}
+
+	DeleteFileW(listPath);
+}
+
+bool rageam::graphics::ImageCache::OpenPack(bool truncate)
+{
+	m_PackFile = CreateFileW(GetPackPath(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, NULL,
+		truncate ? CREATE_ALWAYS : OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (m_PackFile == INVALID_HANDLE_VALUE)
+	{
+		AM_ERRF(L"ImageCache::OpenPack() -> Failed to open pack file '%ls'", GetPackPath().GetCStr());
+		return false;
+	}
+
+	LARGE_INTEGER packSize;
+	GetFileSizeEx(m_PackFile, &packSize);
+	m_PackSize = packSize.QuadPart;
+
+	// Index is always written from scratch, only alive entries are added in LRU order
+	m_IndexFile = _wfopen(GetIndexPath(), L"wb");
+	if (!m_IndexFile)
+	{
+		AM_ERRF(L"ImageCache::OpenPack() -> Failed to open index file '%ls'", GetIndexPath().GetCStr());
+		ClosePack();
+		return false;
+	}
+
+	IndexHeader header;
+	header.Magic = INDEX_MAGIC;
+	header.Version = INDEX_VERSION;
+	fwrite(&header, sizeof(IndexHeader), 1, m_IndexFile);
+
+	// Oldest entries go first, so when index is loaded back order will be preserved
+	for (u32 hash = m_LruFS.Tail, i = 0; i < m_LruFS.Count; i++)
+	{
+		const CacheEntry& entry = m_Entries.GetAt(hash);
+		AppendIndexRecord(IndexRecordType_Add, entry);
+		hash = entry.Lru.Prev;
+	}
+	fflush(m_IndexFile);
+
+	return true;
+}
+
+void rageam::graphics::ImageCache::ClosePack()
+{
+	// Views that are still mapped keep section alive, so it's safe to close mapping handle here
+	if (m_PackMapping)
+	{
+		CloseHandle(m_PackMapping);
+		m_PackMapping = NULL;
+		m_PackMappingSize = 0;
+	}
+
+	if (m_PackFile != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle(m_PackFile);
+		m_PackFile = INVALID_HANDLE_VALUE;
+	}
+
+	if (m_IndexFile)
+	{
+		fclose(m_IndexFile);
+		m_IndexFile = nullptr;
+	}
+}
+
+void rageam::graphics::ImageCache::AppendIndexRecord(IndexRecordType type, const CacheEntry& entry) const
+{
+	if (!m_IndexFile)
+		return;
+
+	IndexRecord record = {};
+	record.Type = type;
+	record.Hash = entry.Hash;
+	record.Offset = entry.PackOffset;
+	record.Size = entry.ImageSize;
+	record.Info = entry.Info;
+	record.UV2 = entry.ImagePaddingUV2;
+	fwrite(&record, sizeof(IndexRecord), 1, m_IndexFile);
+}
+
+bool rageam::graphics::ImageCache::LoadIndex()
+{
+	file::WPath indexPath = GetIndexPath();
+	file::WPath packPath = GetPackPath();
+	if (!IsFileExists(indexPath) || !IsFileExists(packPath))
+		return false;
+
+	WIN32_FILE_ATTRIBUTE_DATA packAttributes;
+	if (!GetFileAttributesExW(packPath, GetFileExInfoStandard, &packAttributes))
+		return false;
+	u64 packSize = static_cast<u64>(packAttributes.nFileSizeHigh) << 32 | packAttributes.nFileSizeLow;
+
+	FILE* indexFile = _wfopen(indexPath, L"rb");
+	if (!indexFile)
+		return false;
+
+	IndexHeader header;
+	if (fread(&header, sizeof(IndexHeader), 1, indexFile) != 1 || header.Magic != INDEX_MAGIC || header.Version != INDEX_VERSION)
+	{
+		AM_WARNINGF("ImageCache::LoadIndex() -> Index header is invalid, cache will be reset.");
+		fclose(indexFile);
+		return false;
+	}
+
+	// Records are replayed in order they were written, so the last added entry is the newest one.
+	// Partially written record at the end (if app was closed while writing) is simply ignored
+	IndexRecord record;
+	while (fread(&record, sizeof(IndexRecord), 1, indexFile) == 1)
+	{
+		if (m_Entries.ContainsAt(record.Hash))
+		{
+			LruRemove(m_Entries, m_LruFS, record.Hash);
+			m_SizeFs -= m_Entries.GetAt(record.Hash).ImageSize;
+			m_Entries.RemoveAt(record.Hash);
+		}
+
+		if (record.Type != IndexRecordType_Add)
+			continue;
+
+		u32 dataSize = ImageComputeTotalSizeWithMips(record.Info.Width, record.Info.Height, record.Info.MipCount, record.Info.PixelFormat);
+		if (record.Offset % PACK_ENTRY_ALIGNMENT != 0 || record.Offset + dataSize > packSize)
+		{
+			AM_WARNINGF("ImageCache::LoadIndex() -> Entry %x points outside of pack, skipping.", record.Hash);
+			continue;
+		}
+
+		CacheEntry entry = {};
+		entry.Hash = record.Hash;
+		entry.Info = record.Info;
+		entry.ImageSize = record.Size;
+		entry.PackOffset = record.Offset;
+		entry.ImagePaddingUV2 = record.UV2;
+		entry.Flags = ImageCacheEntryFlags_StoreInFileSystem;
+		m_Entries.EmplaceAt(record.Hash, std::move(entry));
+		LruPushFront(m_Entries, m_LruFS, record.Hash);
+		m_SizeFs += record.Size;
+	}
+	fclose(indexFile);
+
+	// Anything that is not referenced by alive entry is dead space
+	u64 aliveSize = 0;
+	for (const CacheEntry& entry : m_Entries)
+		aliveSize += ImageComputeTotalSizeWithMips(entry.Info.Width, entry.Info.Height, entry.Info.MipCount, entry.Info.PixelFormat);
+	m_PackSize = packSize;
+	m_PackDeadSize = packSize - MIN(aliveSize, packSize);
+
+	return true;
 }
 
-rageam::file::WPath rageam::graphics::ImageCache::GetCachedImagePath(u32 hash, u32 imageSize, ImageFileKind kind) const
+void rageam::graphics::ImageCache::CompactPack()
 {
-	file::WPath path = m_CacheDirectory / String::FormatTemp(L"%u_%u", hash, imageSize);
-	if (kind != ImageKind_None)
+	AM_DEBUGF("ImageCache::CompactPack() -> Compacting pack, %s alive and %s dead",
+		FormatSize(m_PackSize - m_PackDeadSize), FormatSize(m_PackDeadSize));
+
+	file::WPath packPath = GetPackPath();
+	file::WPath compactPackPath = packPath;
+	compactPackPath += L".tmp";
+
+	HANDLE srcFile = CreateFileW(packPath, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	HANDLE dstFile = CreateFileW(compactPackPath, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (srcFile == INVALID_HANDLE_VALUE || dstFile == INVALID_HANDLE_VALUE)
+	{
+		AM_ERRF(L"ImageCache::CompactPack() -> Failed to open pack files.");
+		if (srcFile != INVALID_HANDLE_VALUE) CloseHandle(srcFile);
+		if (dstFile != INVALID_HANDLE_VALUE) CloseHandle(dstFile);
+		return;
+	}
+
+	// Entries are written from oldest to newest, the same way they were added originally
+	List<char> buffer;
+	u64 dstOffset = 0;
+	bool success = true;
+	for (u32 hash = m_LruFS.Tail, i = 0; i < m_LruFS.Count && success; i++)
 	{
-		path += L".";
-		path += ImageKindToFileExtensionW[kind];
+		CacheEntry& entry = m_Entries.GetAt(hash);
+		u32 dataSize = ImageComputeTotalSizeWithMips(entry.Info.Width, entry.Info.Height, entry.Info.MipCount, entry.Info.PixelFormat);
+		u32 alignedSize = static_cast<u32>((dataSize + PACK_ENTRY_ALIGNMENT - 1) & ~(PACK_ENTRY_ALIGNMENT - 1));
+		buffer.Resize(alignedSize);
+		memset(buffer.GetItems() + dataSize, 0, alignedSize - dataSize);
+
+		LARGE_INTEGER srcOffset;
+		srcOffset.QuadPart = static_cast<LONGLONG>(entry.PackOffset);
+		DWORD bytesRead, bytesWritten;
+		success =
+			SetFilePointerEx(srcFile, srcOffset, NULL, FILE_BEGIN) &&
+			ReadFile(srcFile, buffer.GetItems(), dataSize, &bytesRead, NULL) && bytesRead == dataSize &&
+			WriteFile(dstFile, buffer.GetItems(), alignedSize, &bytesWritten, NULL) && bytesWritten == alignedSize;
+
+		entry.PackOffset = dstOffset;
+		dstOffset += alignedSize;
+		hash = entry.Lru.Prev;
+	}
+	CloseHandle(srcFile);
+	CloseHandle(dstFile);
+
+	if (!success || !MoveFileExW(compactPackPath, packPath, MOVEFILE_REPLACE_EXISTING))
+	{
+		// Offsets were already changed, the only option left is to drop everything
+		AM_ERRF(L"ImageCache::CompactPack() -> Failed to compact pack, cache will be reset.");
+		DeleteFileW(compactPackPath);
+		DeleteFileW(packPath);
+		m_Entries.Destroy();
+		m_LruFS = {};
+		m_SizeFs = 0;
 	}
-	return path;
+	m_PackDeadSize = 0;
 }
 
-void rageam::graphics::ImageCache::MoveImageToFileSystem(CacheEntry& entry, u32 hash) const
+bool rageam::graphics::ImageCache::WriteToPack(CacheEntry& entry)
 {
-	// We don't need image kind here because file extension will be set by save function
-	file::WPath cachedImagePath = GetCachedImagePath(hash, entry.ImageSize, ImageKind_DDS);
+	if (entry.PackOffset != PACK_INVALID_OFFSET)
+		return true;
 
-	// We don't actually remove images from file system cache when loading to ram,
-	// writing file is more expensive than deleting it when it is surely not needed anymore
-	if (!IsFileExists(cachedImagePath) && !ImageFactory::SaveImage(entry.Image, cachedImagePath))
+	if (m_PackFile == INVALID_HANDLE_VALUE)
+		return false;
+
+	u32 dataSize = entry.Image->ComputeTotalSizeWithMips();
+	u64 offset = (m_PackSize + PACK_ENTRY_ALIGNMENT - 1) & ~(PACK_ENTRY_ALIGNMENT - 1);
+	u32 paddingSize = static_cast<u32>(offset - m_PackSize);
+
+	static constexpr char padding[PACK_ENTRY_ALIGNMENT] = {};
+	LARGE_INTEGER packEnd;
+	packEnd.QuadPart = static_cast<LONGLONG>(m_PackSize);
+	DWORD bytesWritten;
+	bool success =
+		SetFilePointerEx(m_PackFile, packEnd, NULL, FILE_BEGIN) &&
+		WriteFile(m_PackFile, padding, paddingSize, &bytesWritten, NULL) &&
+		WriteFile(m_PackFile, entry.Image->GetPixelDataBytes(), dataSize, &bytesWritten, NULL) && bytesWritten == dataSize;
+	if (!success)
 	{
-		AM_ERRF(L"ImageCache::Cache() -> Failed to store image in file system '%ls'", cachedImagePath.GetCStr());
+		AM_ERRF("ImageCache::WriteToPack() -> Failed to write image (hash: %x; size: %s) to pack", entry.Hash, FormatSize(dataSize));
+		// Anything that was written partially will be dead space
+		LARGE_INTEGER packSize;
+		if (GetFileSizeEx(m_PackFile, &packSize))
+		{
+			m_PackDeadSize += packSize.QuadPart - m_PackSize;
+			m_PackSize = packSize.QuadPart;
+		}
+		return false;
+	}
+
+	entry.PackOffset = offset;
+	m_PackSize = offset + dataSize;
+	return true;
+}
+
+rageam::graphics::ImagePtr rageam::graphics::ImageCache::MapFromPack(const CacheEntry& entry)
+{
+	u32 dataSize = ImageComputeTotalSizeWithMips(entry.Info.Width, entry.Info.Height, entry.Info.MipCount, entry.Info.PixelFormat);
+	u64 dataEnd = entry.PackOffset + dataSize;
+	if (dataEnd > m_PackSize)
+		return nullptr;
+
+	// Mapping only covers file size at the moment it was created, data that was appended later is not visible
+	if (dataEnd > m_PackMappingSize)
+	{
+		if (m_PackMapping)
+			CloseHandle(m_PackMapping);
+		m_PackMapping = CreateFileMappingW(m_PackFile, NULL, PAGE_READONLY, 0, 0, NULL);
+		m_PackMappingSize = m_PackMapping ? m_PackSize : 0;
+		if (!m_PackMapping)
+		{
+			AM_ERRF("ImageCache::MapFromPack() -> Failed to create pack file mapping, error: %u", GetLastError());
+			return nullptr;
+		}
+	}
+
+	// View offset must be aligned to allocation granularity
+	u64 viewOffset = entry.PackOffset - entry.PackOffset % m_AllocationGranularity;
+	u64 viewSize = dataEnd - viewOffset;
+
+	// Copy-on-write view, some image operations modify pixel data in place and that must not reach the pack
+	char* view = static_cast<char*>(MapViewOfFile(
+		m_PackMapping, FILE_MAP_COPY, static_cast<DWORD>(viewOffset >> 32), static_cast<DWORD>(viewOffset), viewSize));
+	if (!view)
+	{
+		AM_ERRF("ImageCache::MapFromPack() -> Failed to map view of pack, error: %u", GetLastError());
+		return nullptr;
+	}
+
+	PixelDataOwner pixelData = PixelDataOwner::CreateOwned(view + (entry.PackOffset - viewOffset));
+	pixelData.DeleteFn = [view](pVoid) { UnmapViewOfFile(view); };
+	return std::make_shared<Image>(pixelData, entry.Info);
+}
+
+void rageam::graphics::ImageCache::MoveImageToFileSystem(CacheEntry& entry)
+{
+	// Images that were mapped from pack are already there, in this case we only mark entry as the newest one
+	if (WriteToPack(entry))
+	{
+		AppendIndexRecord(IndexRecordType_Add, entry);
+		if (m_IndexFile) fflush(m_IndexFile);
+	}
+	else
+	{
+		AM_ERRF(L"ImageCache::Cache() -> Failed to store image (hash: %x) in file system", entry.Hash);
 	}
 
 	// This does not guarantee that image will be unloaded from RAM, it still may be referenced somewhere
@@ -146,8 +465,8 @@ void rageam::graphics::ImageCache::CleanUpOldEntriesToFitBudget()
 	// Move oldest image from ram to file system (or just unload if fs cache is not needed)
 	while (m_SizeRam > m_Settings.MemoryStoreBudget)
 	{
-		u32 hash = m_NewToOldEntriesRAM.Last();
-		m_NewToOldEntriesRAM.RemoveLast();
+		u32 hash = m_LruRAM.Tail;
+		LruRemove(m_Entries, m_LruRAM, hash);
 
 		CacheEntry& entry = m_Entries.GetAt(hash);
 
@@ -155,11 +474,18 @@ void rageam::graphics::ImageCache::CleanUpOldEntriesToFitBudget()
 
 		if (entry.Flags & ImageCacheEntryFlags_StoreInFileSystem)
 		{
-			MoveImageToFileSystem(entry, hash);
-			m_SizeFs += entry.ImageSize;
-			m_NewToOldEntriesFS.Insert(0, hash);
-			IMAGE_CACHE_LOG("ImageCache::Cache() -> Image (hash: %x; size: %x or %s) was unloaded from memory to file",
-				hash, entry.ImageSize, FormatSize(entry.ImageSize));
+			MoveImageToFileSystem(entry);
+			if (entry.PackOffset != PACK_INVALID_OFFSET)
+			{
+				m_SizeFs += entry.ImageSize;
+				LruPushFront(m_Entries, m_LruFS, hash);
+				IMAGE_CACHE_LOG("ImageCache::Cache() -> Image (hash: %x; size: %x or %s) was unloaded from memory to file",
+					hash, entry.ImageSize, FormatSize(entry.ImageSize));
+			}
+			else
+			{
+				m_Entries.RemoveAt(hash);
+			}
 		}
 		else
 		{
@@ -169,26 +495,20 @@ void rageam::graphics::ImageCache::CleanUpOldEntriesToFitBudget()
 		}
 	}
 
-	// Note that we don't actually remove the file, see comment in MoveImageToFileSystem
+	// Pixel data stays in pack as dead space until the next compaction
 	while (m_SizeFs > m_Settings.FileSystemStoreBudget)
 	{
-		u32 hash = m_NewToOldEntriesFS.Last();
-		m_NewToOldEntriesFS.RemoveLast();
+		u32 hash = m_LruFS.Tail;
+		LruRemove(m_Entries, m_LruFS, hash);
 
 		CacheEntry& entry = m_Entries.GetAt(hash);
 		m_SizeFs -= entry.ImageSize;
+		m_PackDeadSize += ImageComputeTotalSizeWithMips(entry.Info.Width, entry.Info.Height, entry.Info.MipCount, entry.Info.PixelFormat);
+		AppendIndexRecord(IndexRecordType_Remove, entry);
+		if (m_IndexFile) fflush(m_IndexFile);
 
-		file::WPath oldImagePath = GetCachedImagePath(hash, entry.ImageSize, entry.ImageKind);
-		if (!DeleteFileW(oldImagePath))
-		{
-			AM_WARNINGF("ImageCache::Cache() -> Image (hash: %x; size: %x or %s) failed to remove from file system",
-				hash, entry.ImageSize, FormatSize(entry.ImageSize));
-		}
-		else
-		{
-			IMAGE_CACHE_LOG("ImageCache::Cache() -> Image (hash: %x; size: %x or %s) was removed from file system",
-				hash, entry.ImageSize, FormatSize(entry.ImageSize));
-		}
+		IMAGE_CACHE_LOG("ImageCache::Cache() -> Image (hash: %x; size: %x or %s) was removed from file system",
+			hash, entry.ImageSize, FormatSize(entry.ImageSize));
 
 		m_Entries.RemoveAt(hash);
 	}
@@ -206,56 +526,38 @@ rageam::graphics::ImageCache::ImageCache()
 	AM_ASSERT(CreateDirectoryW(m_CacheDirectory, NULL) != ERROR_PATH_NOT_FOUND,
 		L"ImageCompressorCache::LoadSettings() -> Failed to create cache directory '%ls'", m_CacheDirectory.GetCStr());
 
-	file::WPath listPath = m_CacheDirectory / CACHE_LIST_NAME;
-	// First load, no cache list is stored
-	if (!IsFileExists(listPath))
-		return;
-
-	// Load images from file system
-	try
-	{
-		XmlDoc xCacheList;
-		xCacheList.LoadFromFile(listPath);
-		XmlHandle xRoot = xCacheList.Root();
-
-		u32 totalSize;
-		xRoot.GetAttribute("TotalSize", totalSize);
+	SYSTEM_INFO systemInfo;
+	GetSystemInfo(&systemInfo);
+	m_AllocationGranularity = systemInfo.dwAllocationGranularity;
 
-		for (const XmlHandle& item : XmlIterator(xRoot, "Item"))
-		{
-			ConstString fileName = item.GetText();
-			file::WPath filePath = m_CacheDirectory / file::PathConverter::Utf8ToWide(fileName);
+	DeleteLegacyCache();
 
-			u32 hash, imageSize;
-			ImageFileKind imageKind = ImageFactory::GetImageKindFromPath(filePath);
-
-			if (imageKind == ImageKind_None || !GetInfoFromCachedImagePath(filePath, hash, imageSize))
-			{
-				AM_ERRF(L"Cache -> File name is invalid '%ls'", filePath.GetCStr());
-				continue;
-			}
-
-			CacheEntry entry = {};
-			entry.ImageKind = imageKind;
-			entry.ImageSize = imageSize;
-			entry.Flags |= ImageCacheEntryFlags_StoreInFileSystem;
-
-			m_Entries.EmplaceAt(hash, std::move(entry));
-			m_NewToOldEntriesFS.Add(hash);
-		}
-
-		m_SizeFs = totalSize;
+	// Only index is read on startup, pixel data is mapped from pack on demand
+	bool truncatePack = false;
+	// Pack without alive entries is truncated right away, there's nothing to compact
+	if (!LoadIndex() || m_Entries.GetNumUsedSlots() == 0)
+	{
+		m_Entries.Destroy();
+		m_LruFS = {};
+		m_SizeFs = 0;
+		truncatePack = true;
+	}
 
-		// Budget was lower since last load images don't fit anymore...
-		if (m_SizeFs > m_Settings.FileSystemStoreBudget)
-		{
-			CleanUpOldEntriesToFitBudget();
-		}
+	// Budget was lower since last load images don't fit anymore...
+	if (m_SizeFs > m_Settings.FileSystemStoreBudget)
+	{
+		CleanUpOldEntriesToFitBudget();
 	}
-	catch (const XmlException& ex)
+
+	u64 aliveSize = 0;
+	for (const CacheEntry& entry : m_Entries)
+		aliveSize += ImageComputeTotalSizeWithMips(entry.Info.Width, entry.Info.Height, entry.Info.MipCount, entry.Info.PixelFormat);
+	if (!truncatePack && m_PackDeadSize > aliveSize && m_PackDeadSize > PACK_COMPACT_MIN_DEAD_SIZE)
 	{
-		ex.Print();
+		CompactPack();
 	}
+
+	OpenPack(truncatePack);
 }
 
 rageam::graphics::ImageCache::~ImageCache()
@@ -276,43 +578,18 @@ rageam::graphics::ImageCache::~ImageCache()
 	AM_ASSERT(sizeFs == m_SizeFs, "ImageCache~ -> Fs size doesn't match (expected: %llu, actual: %llu)", sizeFs, m_SizeFs);
 #endif
 
-	// Store all images in file system
-	for (u32 hash : m_NewToOldEntriesRAM)
+	// Store all images in file system, from oldest to newest to preserve order in index
+	for (u32 hash = m_LruRAM.Tail, i = 0; i < m_LruRAM.Count; i++)
 	{
 		CacheEntry& entry = m_Entries.GetAt(hash);
-
-		if (entry.Flags & ImageCacheEntryFlags_StoreInFileSystem)
+		if ((entry.Flags & ImageCacheEntryFlags_StoreInFileSystem) && WriteToPack(entry))
 		{
-			MoveImageToFileSystem(entry, hash);
-			m_SizeFs += entry.ImageSize;
-			m_SizeRam -= entry.ImageSize;
-			m_NewToOldEntriesFS.Insert(0, hash);
+			AppendIndexRecord(IndexRecordType_Add, entry);
 		}
-
-		entry.Image = nullptr;
+		hash = entry.Lru.Prev;
 	}
 
-	// We keep list to easily search for cached files and preserve new/old order
-	XmlDoc xCacheList("CacheList");
-	XmlHandle xRoot = xCacheList.Root();
-	xRoot.SetAttribute("Version", CACHE_LIST_VERSION);
-	xRoot.SetAttribute("TotalSize", m_SizeFs); // To see if budget lowered and we need clean up on loading
-	for (u32 hash : m_NewToOldEntriesFS)
-	{
-		CacheEntry& entry = m_Entries.GetAt(hash);
-		file::WPath entryPath = GetCachedImagePath(hash, entry.ImageSize, entry.ImageKind);
-		entryPath = entryPath.GetFileName();
-		xRoot.AddChild("Item", file::PathConverter::WideToUtf8(entryPath));
-	}
-	try
-	{
-		file::WPath listPath = m_CacheDirectory / CACHE_LIST_NAME;
-		xCacheList.SaveToFile(listPath);
-	}
-	catch (const XmlException& ex)
-	{
-		ex.Print();
-	}
+	ClosePack();
 }
 
 rageam::graphics::ImagePtr rageam::graphics::ImageCache::GetFromCache(u32 hash, Vec2S* outUV2)
@@ -327,53 +604,41 @@ rageam::graphics::ImagePtr rageam::graphics::ImageCache::GetFromCache(u32 hash,
 
 	entry->LastAccessTime = ImGui::GetTime();
 
-	// Image was unloaded to file system before, load it now
+	// Image was unloaded to file system before, map it now
 	if (!entry->Image)
 	{
-		file::WPath cachedImagePath = GetCachedImagePath(hash, entry->ImageSize, entry->ImageKind);
-
-		// Load without using cache here or it will cause recursion...
-		entry->Image = ImageFactory::LoadFromPath(cachedImagePath, false, false);
+		entry->Image = MapFromPack(*entry);
 
-		// Remove hash entry from file system history
-		for (u32 i = 0; i < m_NewToOldEntriesFS.GetSize(); i++)
-		{
-			if (m_NewToOldEntriesFS[i] == hash)
-			{
-				m_NewToOldEntriesFS.RemoveAt(i);
-				break;
-			}
-		}
+		LruRemove(m_Entries, m_LruFS, hash);
 		m_SizeFs -= entry->ImageSize;
 
-		// Add image back to ram if it was loaded successfully
+		// Add image back to ram if it was mapped successfully
 		if (entry->Image)
 		{
 			m_SizeRam += entry->ImageSize;
-			m_NewToOldEntriesRAM.Insert(0, hash);
+			LruPushFront(m_Entries, m_LruRAM, hash);
 		}
 		else
 		{
-			AM_ERRF("ImageCache::GetFromCache() -> Failed to reload image from file system...");
+			AM_ERRF("ImageCache::GetFromCache() -> Failed to map image from pack...");
+			m_PackDeadSize += ImageComputeTotalSizeWithMips(entry->Info.Width, entry->Info.Height, entry->Info.MipCount, entry->Info.PixelFormat);
+			AppendIndexRecord(IndexRecordType_Remove, *entry);
 			m_Entries.RemoveAt(hash);
 			return nullptr;
 		}
 
 		// Image was loaded from file system to memory, revalidate budget
-		CleanUpOldEntriesToFitBudget();
+		ImagePtr image = entry->Image;
+		if (outUV2) *outUV2 = entry->ImagePaddingUV2;
+		CleanUpOldEntriesToFitBudget(); // Entry might be moved back to file system, don't access it after this
+		return image;
 	}
+
 	// Image was already loaded, we have to update it's position in history list
-	else if (m_NewToOldEntriesFS.Any() && m_NewToOldEntriesFS.First() != hash)
+	if (m_LruRAM.Head != hash)
 	{
-		for (u32 i = 0; i < m_NewToOldEntriesFS.GetSize(); i++)
-		{
-			if (m_NewToOldEntriesFS[i] == hash)
-			{
-				m_NewToOldEntriesFS.RemoveAt(i);
-				m_NewToOldEntriesFS.Insert(0, hash);
-				break;
-			}
-		}
+		LruRemove(m_Entries, m_LruRAM, hash);
+		LruPushFront(m_Entries, m_LruRAM, hash);
 	}
 
 	if (outUV2) *outUV2 = entry->ImagePaddingUV2;
@@ -416,19 +681,41 @@ void rageam::graphics::ImageCache::Cache(const ImagePtr& image, u32 hash, u32 im
 		return;
 	}
 
+	// Replacing existing entry, pixel data in pack (if there's any) becomes dead
+	CacheEntry* existingEntry = m_Entries.TryGetAt(hash);
+	if (existingEntry)
+	{
+		if (existingEntry->Image)
+		{
+			LruRemove(m_Entries, m_LruRAM, hash);
+			m_SizeRam -= existingEntry->ImageSize;
+		}
+		else
+		{
+			LruRemove(m_Entries, m_LruFS, hash);
+			m_SizeFs -= existingEntry->ImageSize;
+		}
+
+		if (existingEntry->PackOffset != PACK_INVALID_OFFSET)
+		{
+			m_PackDeadSize += ImageComputeTotalSizeWithMips(
+				existingEntry->Info.Width, existingEntry->Info.Height, existingEntry->Info.MipCount, existingEntry->Info.PixelFormat);
+			AppendIndexRecord(IndexRecordType_Remove, *existingEntry);
+		}
+	}
+
 	CacheEntry entry;
 	entry.Hash = hash;
 	entry.Image = image;
+	entry.Info = image->GetInfo();
 	entry.ImageSize = imageSize;
-	entry.ImageKind = ImageIsCompressedFormat(image->GetPixelFormat()) ? ImageKind_DDS : ImageKind_PNG;
 	entry.Flags = entryFlags;
 	entry.ImagePaddingUV2 = uv2;
 	entry.LastAccessTime = ImGui::GetTime();
 	m_Entries.EmplaceAt(hash, std::move(entry));
 
 	m_SizeRam += imageSize;
-	m_NewToOldEntriesRAM.Remove(hash);
-	m_NewToOldEntriesRAM.Insert(0, hash);
+	LruPushFront(m_Entries, m_LruRAM, hash);
 
 	CleanUpOldEntriesToFitBudget();
 }
@@ -439,19 +726,20 @@ void rageam::graphics::ImageCache::CacheDX11(u32 hash, const amComPtr<ID3D11Shad
 
 	IMAGE_CACHE_LOG("ImageCache::CacheDX11() -> Adding to cache, hash: %x", hash);
 
+	if (m_EntriesDX11.ContainsAt(hash))
+		LruRemove(m_EntriesDX11, m_LruDX11, hash);
+
 	CacheEntryDX11 entry;
 	entry.View = view;
 	entry.Tex = tex;
 	entry.PaddingUV2 = uv2;
-
-	m_NewToOldEntriesDX11.Remove(hash);
-	m_NewToOldEntriesDX11.Insert(0, hash);
 	m_EntriesDX11.EmplaceAt(hash, std::move(entry));
+	LruPushFront(m_EntriesDX11, m_LruDX11, hash);
 
-	if (m_NewToOldEntriesDX11.GetSize() > m_Settings.MaxDX11Views)
+	if (m_LruDX11.Count > m_Settings.MaxDX11Views)
 	{
-		u32 oldestHash = m_NewToOldEntriesDX11.Last();
-		m_NewToOldEntriesDX11.RemoveLast();
+		u32 oldestHash = m_LruDX11.Tail;
+		LruRemove(m_EntriesDX11, m_LruDX11, oldestHash);
 		m_EntriesDX11.RemoveAt(oldestHash);
 	}
 }
@@ -489,7 +777,7 @@ void rageam::graphics::ImageCache::DeleteOldEntries()
 		IMAGE_CACHE_LOG("ImageCache::DeleteOldEntries() -> Removing %u", entry.Hash);
 
 		m_SizeRam -= entry.ImageSize;
-		m_NewToOldEntriesRAM.Remove(entry.Hash);
+		LruRemove(m_Entries, m_LruRAM, entry.Hash);
 		m_Entries.RemoveAt(entry.Hash);
 	}
 }
@@ -498,19 +786,20 @@ void rageam::graphics::ImageCache::Clear()
 {
 	std::unique_lock lock(m_Mutex);
 
-	for (u32 fsHash : m_NewToOldEntriesFS)
-	{
-		CacheEntry& fsEntry = m_Entries.GetAt(fsHash);
-		file::WPath fsPath = GetCachedImagePath(fsHash, fsEntry.ImageSize, fsEntry.ImageKind);
-		DeleteFileW(fsPath);
-	}
-
 	m_EntriesDX11.Destroy();
 	m_Entries.Destroy();
-	m_NewToOldEntriesRAM.Destroy();
-	m_NewToOldEntriesFS.Destroy();
+	m_LruRAM = {};
+	m_LruFS = {};
+	m_LruDX11 = {};
 	m_SizeRam = 0;
 	m_SizeFs = 0;
+
+	ClosePack();
+	DeleteFileW(GetIndexPath());
+	// Pack can't be deleted while images mapped from it are still alive, in this case it will be compacted on the next startup
+	bool truncatePack = DeleteFileW(GetPackPath()) || GetLastError() == ERROR_FILE_NOT_FOUND;
+	OpenPack(truncatePack);
+	m_PackDeadSize = m_PackSize;
 }
 
 rageam::graphics::ImageCacheState rageam::graphics::ImageCache::GetState()
@@ -522,8 +811,8 @@ rageam::graphics::ImageCacheState rageam::graphics::ImageCache::GetState()
 	state.SizeRamBudget = m_Settings.MemoryStoreBudget;
 	state.SizeFsUsed = m_SizeFs;
 	state.SizeFsBudget = m_Settings.FileSystemStoreBudget;
-	state.ImageCountRam = m_NewToOldEntriesRAM.GetSize();
-	state.ImageCountFs = m_NewToOldEntriesFS.GetSize();
-	state.DX11ViewCount = m_NewToOldEntriesDX11.GetSize();
+	state.ImageCountRam = m_LruRAM.Count;
+	state.ImageCountFs = m_LruFS.Count;
+	state.DX11ViewCount = m_LruDX11.Count;
 	return state;
 }
@@ -2,6 +2,7 @@
 
 #include "image.h"
 #include "am/system/singleton.h"
+#include "helpers/fourcc.h"
 
 namespace rageam::graphics
 {
@@ -37,6 +38,8 @@ namespace rageam::graphics
 
 	/**
 	 * \brief Two level image cache - in memory and in file system.
+	 * File system level is a single pack file with pixel data of all entries and append-only binary index,
+	 * entries are memory-mapped from pack on access, so no decoding or copying is involved.
 	 */
 	class ImageCache : public Singleton<ImageCache>
 	{
@@ -45,21 +48,43 @@ namespace rageam::graphics
 		static constexpr u32 DEFAULT_TIME_TO_CACHE_THRESHOLD = 25;						// Milliseconds
 		static constexpr u32 DEFAULT_DX11_VIEWS_MAX = 50;
 		static constexpr u32 SETTINGS_VERSION = 0;
-		static constexpr u32 CACHE_LIST_VERSION = 0;
 		static constexpr ConstWString DEFAULT_CACHE_DIRECTORY_NAME = L"CompressorCache";
-		static constexpr ConstWString CACHE_LIST_NAME = L"List.xml";
+		static constexpr ConstWString LEGACY_CACHE_LIST_NAME = L"List.xml"; // Cache with image per file and xml list
+		static constexpr ConstWString PACK_NAME = L"Images.pack";
+		static constexpr ConstWString INDEX_NAME = L"Images.idx";
+		static constexpr u32 INDEX_MAGIC = FOURCC('I', 'M', 'C', 'I');
+		static constexpr u32 INDEX_VERSION = 0;
+		static constexpr u64 PACK_ENTRY_ALIGNMENT = 64;		// Mapped pixel data is aligned for SIMD
+		static constexpr u64 PACK_COMPACT_MIN_DEAD_SIZE = 64ull * 1024ull * 1024ull; // Pack is compacted on startup if there's more dead space than alive
+		static constexpr u64 PACK_INVALID_OFFSET = u64(-1);
 		static constexpr double TEMP_MIN_INACTIVITY_TIME = 60.0f;	// Temp textures are removed 60 seconds after they're accessed last time
 		static constexpr double TEMP_DELETE_INTERVAL = 10.0f;		// Every 10 seconds
 
+		// Entries are linked by hash, so LRU operations are O(1) and don't depend on entry address
+		struct LruLink
+		{
+			u32 Prev;
+			u32 Next;
+		};
+
+		struct LruList
+		{
+			u32 Head = 0;	// Newest
+			u32 Tail = 0;	// Oldest
+			u32 Count = 0;
+		};
+
 		struct CacheEntry
 		{
 			u32                  Hash;
 			ImagePtr             Image;
+			ImageInfo            Info;				// To create image from mapped pixel data
 			u32                  ImageSize;
-			ImageFileKind        ImageKind;			// We store kind to get file extension when loading image from file system
+			u64                  PackOffset = PACK_INVALID_OFFSET;
 			Vec2S                ImagePaddingUV2;	// In case if image was padded, contains adjusted UV2
 			ImageCacheEntryFlags Flags = ImageCacheEntryFlags_None;
 			double               LastAccessTime = -1.0f;
+			LruLink              Lru;
 		};
 
 		struct CacheEntryDX11
@@ -67,6 +92,29 @@ namespace rageam::graphics
 			amComPtr<ID3D11ShaderResourceView> View;
 			amComPtr<ID3D11Texture2D>		   Tex;
 			Vec2S							   PaddingUV2;
+			LruLink                            Lru;
+		};
+
+		enum IndexRecordType : u32
+		{
+			IndexRecordType_Add,		// Entry was added to pack or became the newest one
+			IndexRecordType_Remove,		// Entry pixel data is dead space now
+		};
+
+		struct IndexHeader
+		{
+			u32 Magic;
+			u32 Version;
+		};
+
+		struct IndexRecord
+		{
+			IndexRecordType	Type;
+			u32				Hash;
+			u64				Offset;
+			u32				Size;
+			ImageInfo		Info;
+			Vec2S			UV2;
 		};
 
 		struct Settings
@@ -82,16 +130,23 @@ namespace rageam::graphics
 		file::WPath				m_CacheDirectory;
 		HashSet<CacheEntry>		m_Entries;
 		HashSet<CacheEntryDX11>	m_EntriesDX11;
-		// Hashes of entries ordered from newest (first) to oldest (last)
-		// Ordered this way because it's easier to remove entries from end than from beginning
-		List<u32>				m_NewToOldEntriesRAM;
-		List<u32>				m_NewToOldEntriesFS;
-		List<u32>				m_NewToOldEntriesDX11;
+		LruList					m_LruRAM;
+		LruList					m_LruFS;
+		LruList					m_LruDX11;
 		u64						m_SizeRam = 0;			// Bytes taken by images in memory
 		u64						m_SizeFs = 0;			// Bytes taken by images in file system
 		double					m_NextTempEntriesDeleteTime = 0.0f;
 		std::mutex				m_Mutex;
 
+		// Pack file and its index
+		HANDLE					m_PackFile = INVALID_HANDLE_VALUE;
+		HANDLE					m_PackMapping = NULL;
+		u64						m_PackMappingSize = 0;	// Mapping must be recreated to access data appended after it was created
+		u64						m_PackSize = 0;
+		u64						m_PackDeadSize = 0;		// Pixel data of removed entries
+		FILE*					m_IndexFile = nullptr;
+		u32						m_AllocationGranularity;
+
 		u32 BytesToMb(u32 bytes) const { return bytes / (1024u * 1024u); }
 		u32 MbToBytes(u32 mb) const { return mb * 1024u * 1024u; }
 
@@ -99,12 +154,30 @@ namespace rageam::graphics
 		// Loads settings from app data and if config does not exist yet, creates new one
 		void LoadSettings();
 
-		bool GetInfoFromCachedImagePath(const file::WPath& path, u32& hash, u32& imageSize) const;
-		// If image kind is none, no extension added
-		file::WPath GetCachedImagePath(u32 hash, u32 imageSize, ImageFileKind kind) const;
+		template<typename TEntry>
+		static void LruPushFront(HashSet<TEntry>& entries, LruList& list, u32 hash);
+		template<typename TEntry>
+		static void LruRemove(HashSet<TEntry>& entries, LruList& list, u32 hash);
+
+		file::WPath GetPackPath() const { return m_CacheDirectory / PACK_NAME; }
+		file::WPath GetIndexPath() const { return m_CacheDirectory / INDEX_NAME; }
+		// Removes images and xml list of the old cache format
+		void DeleteLegacyCache() const;
+		// Reads index and builds file system entries, returns false if either pack or index are missing or invalid
+		bool LoadIndex();
+		// Creates new pack with only alive entries
+		void CompactPack();
+		bool OpenPack(bool truncate);
+		void ClosePack();
+		void AppendIndexRecord(IndexRecordType type, const CacheEntry& entry) const;
+
+		// Writes entry pixel data to the end of pack if it's not there yet
+		bool WriteToPack(CacheEntry& entry);
+		// Creates image from mapped pack view, pixel data is unmapped once image is released
+		ImagePtr MapFromPack(const CacheEntry& entry);
 
 		// Does not account stats
-		void MoveImageToFileSystem(CacheEntry& entry, u32 hash) const;
+		void MoveImageToFileSystem(CacheEntry& entry);
 
 		void CleanUpOldEntriesToFitBudget();
 
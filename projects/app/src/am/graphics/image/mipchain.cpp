@@ -0,0 +1,528 @@
+#include "mipchain.h"
+
+#include "am/system/asserts.h"
+#include "am/system/worker.h"
+
+#include <easy/profiler.h>
+#include <immintrin.h>
+#include <cmath>
+#include <functional>
+
+rageam::BackgroundWorker* rageam::graphics::ImageMipChain::sm_Worker = nullptr;
+
+namespace
+{
+	using namespace rageam;
+	using namespace rageam::graphics;
+
+	// Size of linear -> sRGB table, large enough to map every linear value to correct 8 bit sRGB value (maybe off by one near rounding edge)
+	constexpr int LINEAR_TO_SRGB_SIZE = 1 << 14;
+	// Same threshold that stb uses to check if alpha weighted color can be restored
+	constexpr float MIN_ALPHA = 1.0f / (1 << 20);
+
+	struct GammaTables
+	{
+		float SrgbToLinear[256];				// In [0, 255] range
+		float Identity[256];
+		u8    LinearToSrgb[LINEAR_TO_SRGB_SIZE];
+
+		GammaTables()
+		{
+			for (int i = 0; i < 256; i++)
+			{
+				Identity[i] = static_cast<float>(i);
+				float c = static_cast<float>(i) / 255.0f;
+				float linear = c <= 0.04045f ? c / 12.92f : powf((c + 0.055f) / 1.055f, 2.4f);
+				SrgbToLinear[i] = linear * 255.0f;
+			}
+			for (int i = 0; i < LINEAR_TO_SRGB_SIZE; i++)
+			{
+				float linear = static_cast<float>(i) / static_cast<float>(LINEAR_TO_SRGB_SIZE - 1);
+				float c = linear <= 0.0031308f ? linear * 12.92f : 1.055f * powf(linear, 1.0f / 2.4f) - 0.055f;
+				LinearToSrgb[i] = static_cast<u8>(c * 255.0f + 0.5f);
+			}
+		}
+
+		u8 Encode(float linear) const
+		{
+			float index = linear * (static_cast<float>(LINEAR_TO_SRGB_SIZE - 1) / 255.0f) + 0.5f;
+			index = index > 0.0f ? index : 0.0f;
+			index = index < LINEAR_TO_SRGB_SIZE - 1 ? index : LINEAR_TO_SRGB_SIZE - 1;
+			return LinearToSrgb[static_cast<int>(index)];
+		}
+	};
+
+	const GammaTables& GetGammaTables()
+	{
+		static GammaTables s_Tables;
+		return s_Tables;
+	}
+
+	// Channel count is the same as pixel size, only 8 bit per channel formats are supported
+	bool GetChannels(ImagePixelFormat fmt, int& outChannels, int& outAlphaChannel)
+	{
+		switch (fmt)
+		{
+		case ImagePixelFormat_U32:	outChannels = 4; outAlphaChannel = 3;	return true;
+		case ImagePixelFormat_U24:	outChannels = 3; outAlphaChannel = -1;	return true;
+		case ImagePixelFormat_U16:	outChannels = 2; outAlphaChannel = 1;	return true;
+		case ImagePixelFormat_U8:	outChannels = 1; outAlphaChannel = -1;	return true;
+		case ImagePixelFormat_A8:	outChannels = 1; outAlphaChannel = 0;	return true;
+
+		default: return false;
+		}
+	}
+
+	struct DownsampleParams
+	{
+		const u8* Src;
+		u8*       Dst;
+		int       Width;			// Source size
+		int       Height;
+		int       AlphaChannel;		// -1 if there's no alpha
+		bool      Triangle;
+		bool      WeightAlpha;
+		bool      GammaCorrect;
+	};
+
+	// Source rows / columns and their weights for destination pixel, edges are clamped
+	struct Taps
+	{
+		int   Count;
+		int   Index[4];
+		float Weight[4];
+
+		Taps(int dstIndex, int srcSize, bool triangle)
+		{
+			int center = dstIndex * 2;
+			if (!triangle)
+			{
+				Count = 2;
+				Index[0] = center;
+				Index[1] = center + 1;
+				Weight[0] = Weight[1] = 0.5f;
+				return;
+			}
+
+			// Triangle of radius 2 (in source pixels) sampled at pixel centers gives [1 3 3 1] / 8
+			Count = 4;
+			Index[0] = center > 0 ? center - 1 : 0;
+			Index[1] = center;
+			Index[2] = center + 1;
+			Index[3] = center + 2 < srcSize ? center + 2 : srcSize - 1;
+			Weight[0] = Weight[3] = 0.125f;
+			Weight[1] = Weight[2] = 0.375f;
+		}
+	};
+
+	// Integer 2x2 box without alpha weighting or gamma, rounds to nearest like stb does
+	void DownsampleRowsBoxInt(const DownsampleParams& params, int channels, int dstRowStart, int dstRowEnd)
+	{
+		int dstWidth = params.Width / 2;
+		size_t srcRowPitch = static_cast<size_t>(params.Width) * channels;
+		size_t dstRowPitch = static_cast<size_t>(dstWidth) * channels;
+
+		for (int y = dstRowStart; y < dstRowEnd; y++)
+		{
+			const u8* src0 = params.Src + srcRowPitch * (y * 2);
+			const u8* src1 = src0 + srcRowPitch;
+			u8* dst = params.Dst + dstRowPitch * y;
+
+			int x = 0;
+			if (channels == 4)
+			{
+				const __m128i zero = _mm_setzero_si128();
+				const __m128i two = _mm_set1_epi16(2);
+#ifdef AM_IMAGE_USE_AVX2
+				// Lanes are processed separately, output pixels end up in order 0 1 4 5 | 2 3 6 7 and are permuted back
+				const __m256i zero256 = _mm256_setzero_si256();
+				const __m256i two256 = _mm256_set1_epi16(2);
+				for (; x + 8 <= dstWidth; x += 8)
+				{
+					__m256i a0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src0 + x * 8));
+					__m256i a1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src0 + x * 8 + 32));
+					__m256i b0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src1 + x * 8));
+					__m256i b1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src1 + x * 8 + 32));
+
+					__m256i lo0 = _mm256_add_epi16(_mm256_unpacklo_epi8(a0, zero256), _mm256_unpacklo_epi8(b0, zero256));
+					__m256i hi0 = _mm256_add_epi16(_mm256_unpackhi_epi8(a0, zero256), _mm256_unpackhi_epi8(b0, zero256));
+					__m256i lo1 = _mm256_add_epi16(_mm256_unpacklo_epi8(a1, zero256), _mm256_unpacklo_epi8(b1, zero256));
+					__m256i hi1 = _mm256_add_epi16(_mm256_unpackhi_epi8(a1, zero256), _mm256_unpackhi_epi8(b1, zero256));
+
+					__m256i sum0 = _mm256_add_epi16(_mm256_unpacklo_epi64(lo0, hi0), _mm256_unpackhi_epi64(lo0, hi0));
+					__m256i sum1 = _mm256_add_epi16(_mm256_unpacklo_epi64(lo1, hi1), _mm256_unpackhi_epi64(lo1, hi1));
+					sum0 = _mm256_srli_epi16(_mm256_add_epi16(sum0, two256), 2);
+					sum1 = _mm256_srli_epi16(_mm256_add_epi16(sum1, two256), 2);
+
+					__m256i pixels = _mm256_permute4x64_epi64(_mm256_packus_epi16(sum0, sum1), _MM_SHUFFLE(3, 1, 2, 0));
+					_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + x * 4), pixels);
+				}
+#endif
+				for (; x + 4 <= dstWidth; x += 4)
+				{
+					__m128i a0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src0 + x * 8));
+					__m128i a1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src0 + x * 8 + 16));
+					__m128i b0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src1 + x * 8));
+					__m128i b1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src1 + x * 8 + 16));
+
+					// Vertical sums of source pixels 0 1 | 2 3 | 4 5 | 6 7 in 16 bit
+					__m128i lo0 = _mm_add_epi16(_mm_unpacklo_epi8(a0, zero), _mm_unpacklo_epi8(b0, zero));
+					__m128i hi0 = _mm_add_epi16(_mm_unpackhi_epi8(a0, zero), _mm_unpackhi_epi8(b0, zero));
+					__m128i lo1 = _mm_add_epi16(_mm_unpacklo_epi8(a1, zero), _mm_unpacklo_epi8(b1, zero));
+					__m128i hi1 = _mm_add_epi16(_mm_unpackhi_epi8(a1, zero), _mm_unpackhi_epi8(b1, zero));
+
+					// Horizontal sums, even + odd pixel
+					__m128i sum0 = _mm_add_epi16(_mm_unpacklo_epi64(lo0, hi0), _mm_unpackhi_epi64(lo0, hi0));
+					__m128i sum1 = _mm_add_epi16(_mm_unpacklo_epi64(lo1, hi1), _mm_unpackhi_epi64(lo1, hi1));
+					sum0 = _mm_srli_epi16(_mm_add_epi16(sum0, two), 2);
+					sum1 = _mm_srli_epi16(_mm_add_epi16(sum1, two), 2);
+
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x * 4), _mm_packus_epi16(sum0, sum1));
+				}
+			}
+
+			// Remainder, or every pixel for formats other than RGBA
+			for (int i = x * channels; i < dstWidth * channels; i++)
+			{
+				int srcIndex = (i / channels) * channels * 2 + i % channels;
+				int sum = src0[srcIndex] + src0[srcIndex + channels] + src1[srcIndex] + src1[srcIndex + channels];
+				dst[i] = static_cast<u8>((sum + 2) >> 2);
+			}
+		}
+	}
+
+	// Every channel is decoded in separate lane, unused lanes are zero
+	template<int Channels>
+	__m128 LoadPixel(const u8* pixel)
+	{
+		if constexpr (Channels == 4)
+		{
+			__m128i value = _mm_cvtsi32_si128(*reinterpret_cast<const int*>(pixel));
+			value = _mm_unpacklo_epi16(_mm_unpacklo_epi8(value, _mm_setzero_si128()), _mm_setzero_si128());
+			return _mm_cvtepi32_ps(value);
+		}
+		else if constexpr (Channels == 3) return _mm_setr_ps(pixel[0], pixel[1], pixel[2], 0.0f);
+		else if constexpr (Channels == 2) return _mm_setr_ps(pixel[0], pixel[1], 0.0f, 0.0f);
+		else return _mm_setr_ps(pixel[0], 0.0f, 0.0f, 0.0f);
+	}
+
+	// Same as LoadPixel but every channel is mapped through its own table
+	template<int Channels>
+	__m128 LoadPixel(const u8* pixel, const float* const* tables)
+	{
+		if constexpr (Channels == 4) return _mm_setr_ps(tables[0][pixel[0]], tables[1][pixel[1]], tables[2][pixel[2]], tables[3][pixel[3]]);
+		else if constexpr (Channels == 3) return _mm_setr_ps(tables[0][pixel[0]], tables[1][pixel[1]], tables[2][pixel[2]], 0.0f);
+		else if constexpr (Channels == 2) return _mm_setr_ps(tables[0][pixel[0]], tables[1][pixel[1]], 0.0f, 0.0f);
+		else return _mm_setr_ps(tables[0][pixel[0]], 0.0f, 0.0f, 0.0f);
+	}
+
+	// Decodes source row to float4 vectors and filters it horizontally, color is optionally converted
+	// to linear space and multiplied by alpha / 255
+	template<int Channels, bool GammaCorrect, bool WeightAlpha>
+	void FilterRow(const u8* src, __m128* dst, int width, bool triangle, const float* const* decodeTables, __m128 colorMask)
+	{
+		constexpr int alphaLane = Channels - 1;
+		const __m128 alphaScale = _mm_set1_ps(1.0f / 255.0f);
+		const __m128 one = _mm_set1_ps(1.0f);
+
+		auto decode = [&](int x)
+			{
+				const u8* pixel = src + x * Channels;
+				__m128 value;
+				if constexpr (GammaCorrect) value = LoadPixel<Channels>(pixel, decodeTables);
+				else						value = LoadPixel<Channels>(pixel);
+
+				if constexpr (WeightAlpha)
+				{
+					// Color * alpha / 255, alpha lane is multiplied by 1
+					__m128 alpha = _mm_mul_ps(_mm_shuffle_ps(value, value, _MM_SHUFFLE(alphaLane, alphaLane, alphaLane, alphaLane)), alphaScale);
+					value = _mm_mul_ps(value, _mm_or_ps(_mm_and_ps(colorMask, alpha), _mm_andnot_ps(colorMask, one)));
+				}
+				return value;
+			};
+
+		int dstWidth = width / 2;
+		if (!triangle)
+		{
+			const __m128 half = _mm_set1_ps(0.5f);
+			for (int x = 0; x < dstWidth; x++)
+				dst[x] = _mm_mul_ps(_mm_add_ps(decode(x * 2), decode(x * 2 + 1)), half);
+			return;
+		}
+
+		// [1 3 3 1] / 8, edges are clamped; the last pixel of every footprint is the first one of the next footprint
+		const __m128 outer = _mm_set1_ps(0.125f);
+		const __m128 inner = _mm_set1_ps(0.375f);
+		__m128 left = decode(0);
+		for (int x = 0; x < dstWidth; x++)
+		{
+			__m128 center0 = decode(x * 2);
+			__m128 center1 = decode(x * 2 + 1);
+			__m128 right = x < dstWidth - 1 ? decode(x * 2 + 2) : center1;
+			dst[x] = _mm_add_ps(_mm_mul_ps(_mm_add_ps(left, right), outer), _mm_mul_ps(_mm_add_ps(center0, center1), inner));
+			left = center1;
+		}
+	}
+
+	// Alpha weighted and/or gamma correct filter, both box and triangle, pixels are filtered as float4 vectors.
+	// Every source row is decoded and filtered horizontally once, then filtered rows are combined vertically
+	template<int Channels>
+	void DownsampleRowsFloat(const DownsampleParams& params, int dstRowStart, int dstRowEnd)
+	{
+		// Alpha is always the last channel in formats that have it
+		constexpr int alphaLane = Channels - 1;
+		constexpr int alphaShuffle = _MM_SHUFFLE(alphaLane, alphaLane, alphaLane, alphaLane);
+
+		const GammaTables& gamma = GetGammaTables();
+
+		int width = params.Width;
+		int dstWidth = width / 2;
+		size_t srcRowPitch = static_cast<size_t>(width) * Channels;
+		size_t dstRowPitch = static_cast<size_t>(dstWidth) * Channels;
+		bool hasAlpha = params.AlphaChannel >= 0;
+		AM_DEBUG_ASSERT(!hasAlpha || params.AlphaChannel == alphaLane, "ImageMipChain::Downsample() -> Alpha must be the last channel.");
+		// A8 has no color to weight
+		bool weightAlpha = params.WeightAlpha && Channels > 1 && hasAlpha;
+
+		// Lane masks, all bits set for lanes that are color channels
+		alignas(16) u32 colorLanes[4] = {};
+		for (int i = 0; i < Channels; i++)
+			colorLanes[i] = hasAlpha && i == alphaLane ? 0 : UINT32_MAX;
+		const __m128 colorMask = _mm_load_ps(reinterpret_cast<const float*>(colorLanes));
+		const __m128 one = _mm_set1_ps(1.0f);
+
+		// Color goes through sRGB -> linear table, alpha is kept linear
+		const float* decodeTables[4];
+		for (int i = 0; i < Channels; i++)
+			decodeTables[i] = hasAlpha && i == alphaLane ? gamma.Identity : gamma.SrgbToLinear;
+
+		// Ring of horizontally filtered source rows, triangle filter needs 4 rows and two of them are shared with the next output row
+		List<__m128> filteredRows;
+		filteredRows.Resize(dstWidth * 4);
+		int filteredRowIndices[4] = { -1, -1, -1, -1 };
+
+		auto getFilteredRow = [&](int srcRow)
+			{
+				int slot = srcRow & 3;
+				__m128* filtered = filteredRows.GetItems() + static_cast<size_t>(dstWidth) * slot;
+				if (filteredRowIndices[slot] == srcRow)
+					return filtered;
+				filteredRowIndices[slot] = srcRow;
+
+				const u8* src = params.Src + srcRowPitch * srcRow;
+				if (params.GammaCorrect)
+				{
+					if (weightAlpha) FilterRow<Channels, true, true>(src, filtered, width, params.Triangle, decodeTables, colorMask);
+					else			 FilterRow<Channels, true, false>(src, filtered, width, params.Triangle, decodeTables, colorMask);
+				}
+				else
+				{
+					if (weightAlpha) FilterRow<Channels, false, true>(src, filtered, width, params.Triangle, decodeTables, colorMask);
+					else			 FilterRow<Channels, false, false>(src, filtered, width, params.Triangle, decodeTables, colorMask);
+				}
+				return filtered;
+			};
+
+		for (int y = dstRowStart; y < dstRowEnd; y++)
+		{
+			Taps rowTaps(y, params.Height, params.Triangle);
+			const __m128* rows[4];
+			__m128 rowWeights[4];
+			for (int k = 0; k < rowTaps.Count; k++)
+			{
+				rows[k] = getFilteredRow(rowTaps.Index[k]);
+				rowWeights[k] = _mm_set1_ps(rowTaps.Weight[k]);
+			}
+
+			u8* dst = params.Dst + dstRowPitch * y;
+			for (int x = 0; x < dstWidth; x++)
+			{
+				__m128 sum = _mm_setzero_ps();
+				for (int k = 0; k < rowTaps.Count; k++)
+					sum = _mm_add_ps(sum, _mm_mul_ps(rows[k][x], rowWeights[k]));
+
+				if (weightAlpha)
+				{
+					__m128 alpha = _mm_shuffle_ps(sum, sum, alphaShuffle);
+					if (_mm_cvtss_f32(alpha) * (1.0f / 255.0f) >= MIN_ALPHA)
+					{
+						__m128 scale = _mm_div_ps(_mm_set1_ps(255.0f), alpha);
+						sum = _mm_mul_ps(sum, _mm_or_ps(_mm_and_ps(colorMask, scale), _mm_andnot_ps(colorMask, one)));
+					}
+					else
+					{
+						// Fully transparent, weighted color is lost, filter it again without weighting
+						Taps columnTaps(x, width, params.Triangle);
+						sum = _mm_setzero_ps();
+						for (int ky = 0; ky < rowTaps.Count; ky++)
+						{
+							const u8* src = params.Src + srcRowPitch * rowTaps.Index[ky];
+							for (int kx = 0; kx < columnTaps.Count; kx++)
+							{
+								__m128 weight = _mm_set1_ps(rowTaps.Weight[ky] * columnTaps.Weight[kx]);
+								const u8* pixel = src + columnTaps.Index[kx] * Channels;
+								__m128 value = params.GammaCorrect ? LoadPixel<Channels>(pixel, decodeTables) : LoadPixel<Channels>(pixel);
+								sum = _mm_add_ps(sum, _mm_mul_ps(value, weight));
+							}
+						}
+					}
+				}
+
+				u8* pixel = dst + x * Channels;
+				if (params.GammaCorrect)
+				{
+					alignas(16) float channels[4];
+					_mm_store_ps(channels, sum);
+					for (int i = 0; i < Channels; i++)
+					{
+						if (hasAlpha && i == alphaLane)
+						{
+							float value = channels[i] < 255.0f ? channels[i] : 255.0f;
+							pixel[i] = static_cast<u8>(value + 0.5f);
+						}
+						else
+						{
+							pixel[i] = gamma.Encode(channels[i]);
+						}
+					}
+					continue;
+				}
+
+				// Round half up and clamp, the same as stb
+				sum = _mm_add_ps(_mm_min_ps(_mm_max_ps(sum, _mm_setzero_ps()), _mm_set1_ps(255.0f)), _mm_set1_ps(0.5f));
+				__m128i value = _mm_cvttps_epi32(sum);
+				value = _mm_packus_epi16(_mm_packs_epi32(value, value), value);
+				if constexpr (Channels == 4)
+				{
+					*reinterpret_cast<int*>(pixel) = _mm_cvtsi128_si32(value);
+				}
+				else
+				{
+					int channels = _mm_cvtsi128_si32(value);
+					memcpy(pixel, &channels, Channels);
+				}
+			}
+		}
+	}
+
+	void DownsampleRows(const DownsampleParams& params, int channels, int dstRowStart, int dstRowEnd)
+	{
+		bool needFloat = params.Triangle || params.GammaCorrect || (params.WeightAlpha && channels > 1 && params.AlphaChannel >= 0);
+		if (!needFloat)
+		{
+			DownsampleRowsBoxInt(params, channels, dstRowStart, dstRowEnd);
+			return;
+		}
+
+		switch (channels)
+		{
+		case 4: DownsampleRowsFloat<4>(params, dstRowStart, dstRowEnd); break;
+		case 3: DownsampleRowsFloat<3>(params, dstRowStart, dstRowEnd); break;
+		case 2: DownsampleRowsFloat<2>(params, dstRowStart, dstRowEnd); break;
+		case 1: DownsampleRowsFloat<1>(params, dstRowStart, dstRowEnd); break;
+
+		default: AM_UNREACHABLE("ImageMipChain::Downsample() -> Channel count %i is not supported.", channels);
+		}
+	}
+}
+
+bool rageam::graphics::ImageMipChain::CanUseFastPath(ResizeFilter filter, ImagePixelFormat fmt, int width, int height)
+{
+	int channels, alphaChannel;
+	if (!GetChannels(fmt, channels, alphaChannel))
+		return false;
+
+	if (filter != ResizeFilter_Box && filter != ResizeFilter_Triangle)
+		return false;
+
+	return width >= 2 && height >= 2 && width % 2 == 0 && height % 2 == 0;
+}
+
+void rageam::graphics::ImageMipChain::Downsample(
+	pVoid dst, pConstVoid src, ResizeFilter filter, ImagePixelFormat fmt, int width, int height, bool hasAlphaPixels, bool gammaCorrect)
+{
+	EASY_FUNCTION();
+
+	if (!CanUseFastPath(filter, fmt, width, height))
+	{
+		ImageResize(dst, const_cast<pVoid>(src), filter, fmt, width, height, width / 2, height / 2, hasAlphaPixels, gammaCorrect);
+		return;
+	}
+
+	int channels, alphaChannel;
+	GetChannels(fmt, channels, alphaChannel);
+
+	DownsampleParams params;
+	params.Src = static_cast<const u8*>(src);
+	params.Dst = static_cast<u8*>(dst);
+	params.Width = width;
+	params.Height = height;
+	params.AlphaChannel = alphaChannel;
+	params.Triangle = filter == ResizeFilter_Triangle;
+	params.WeightAlpha = hasAlphaPixels;
+	params.GammaCorrect = gammaCorrect;
+
+	int dstWidth = width / 2;
+	int dstHeight = height / 2;
+	int sliceCount = 1;
+	if (sm_Worker && dstWidth * dstHeight >= PARALLEL_THRESHOLD)
+		sliceCount = std::min(MAX_SLICES, dstHeight / MIN_SLICE_ROWS);
+
+	if (sliceCount <= 1)
+	{
+		DownsampleRows(params, channels, 0, dstHeight);
+		return;
+	}
+
+	// Rows are split evenly between slices, the last one is processed on caller thread
+	auto getSliceStart = [&](int slice) { return dstHeight * slice / sliceCount; };
+
+	SmallList<BackgroundTaskPtr> tasks;
+	BackgroundWorker::Push(sm_Worker);
+	for (int i = 0; i < sliceCount - 1; i++)
+	{
+		int rowStart = getSliceStart(i);
+		int rowEnd = getSliceStart(i + 1);
+		tasks.Emplace(BackgroundWorker::Run([&params, channels, rowStart, rowEnd]
+			{
+				DownsampleRows(params, channels, rowStart, rowEnd);
+				return true;
+			}));
+	}
+	BackgroundWorker::Pop();
+
+	DownsampleRows(params, channels, getSliceStart(sliceCount - 1), dstHeight);
+
+	for (BackgroundTaskPtr& task : tasks)
+		task->Wait();
+}
+
+void rageam::graphics::ImageMipChain::Generate(
+	pVoid pixels, ResizeFilter filter, ImagePixelFormat fmt, int width, int height, int mipCount, bool hasAlphaPixels, bool gammaCorrect)
+{
+	EASY_FUNCTION();
+
+	char* mipPixels = static_cast<char*>(pixels);
+	for (int i = 1; i < mipCount; i++)
+	{
+		char* nextMipPixels = mipPixels + ImageComputeSlicePitch(width, height, fmt);
+		Downsample(nextMipPixels, mipPixels, filter, fmt, width, height, hasAlphaPixels, gammaCorrect);
+
+		mipPixels = nextMipPixels;
+		width /= 2;
+		height /= 2;
+	}
+}
+
+void rageam::graphics::ImageMipChain::InitClass()
+{
+	SYSTEM_INFO sysInfo;
+	GetSystemInfo(&sysInfo);
+	sm_Worker = new BackgroundWorker("Img Mips", static_cast<int>(sysInfo.dwNumberOfProcessors));
+}
+
+void rageam::graphics::ImageMipChain::ShutdownClass()
+{
+	delete sm_Worker;
+	sm_Worker = nullptr;
+}
@@ -0,0 +1,51 @@
+//
+// File: mipchain.h
+//
+// Copyright (C) 2023-2024 ranstar74. All rights violated.
+//
+// Part of "Rage Am" Research Project.
+//
+#pragma once
+
+#include "image.h"
+
+namespace rageam
+{
+	class BackgroundWorker;
+}
+
+namespace rageam::graphics
+{
+	/**
+	 * \brief Generates mip maps by downsampling every mip from the previous one.
+	 * \n Box and triangle filters on images with even dimensions use fused SIMD kernel that filters 2x2 (box)
+	 * or 4x4 (triangle, [1 3 3 1] weights) pixel footprint in a single pass, other filters fall back to ImageResize (stb).
+	 * \n Color is weighted by alpha if image has transparent pixels, the same way stb does it, so transparent pixels don't bleed color.
+	 * \n Gamma correct mode averages color in linear space (alpha is always linear), should be used for sRGB color textures.
+	 * \n Rows of large mips are split across worker threads (see ::InitClass).
+	 */
+	class ImageMipChain
+	{
+		// Mips smaller than this (in output pixels) are processed on caller thread
+		static constexpr int PARALLEL_THRESHOLD = 256 * 256;
+		static constexpr int MAX_SLICES = 16;
+		static constexpr int MIN_SLICE_ROWS = 16;
+
+		static BackgroundWorker* sm_Worker;
+
+	public:
+		// Whether fused kernel can be used, ImageResize is used otherwise
+		static bool CanUseFastPath(ResizeFilter filter, ImagePixelFormat fmt, int width, int height);
+
+		// Downsamples image by factor of 2, destination must have space for (width / 2) x (height / 2) pixels
+		static void Downsample(
+			pVoid dst, pConstVoid src, ResizeFilter filter, ImagePixelFormat fmt, int width, int height, bool hasAlphaPixels, bool gammaCorrect = false);
+
+		// Fills mip maps [1, mipCount) that follow the first mip in continuous pixel buffer
+		static void Generate(
+			pVoid pixels, ResizeFilter filter, ImagePixelFormat fmt, int width, int height, int mipCount, bool hasAlphaPixels, bool gammaCorrect = false);
+
+		static void InitClass();
+		static void ShutdownClass();
+	};
+}
@@ -0,0 +1,367 @@
+#include "meshoptimizer.h"
+
+#include "am/system/asserts.h"
+#include "am/system/ptr.h"
+#include "am/types.h"
+
+#include <algorithm>
+
+namespace
+{
+	struct Position
+	{
+		float X, Y, Z;
+	};
+
+	const Position& GetPosition(const char* vertices, u32 vertexStride, u32 positionOffset, u16 index)
+	{
+		return *reinterpret_cast<const Position*>(vertices + static_cast<size_t>(index) * vertexStride + positionOffset);
+	}
+
+	// FIFO cache, vertex is in cache if less than 'cacheSize' misses happened since it was added
+	struct CacheSimulator
+	{
+		List<u32> Timestamps;
+		u32       Time;
+		u32       CacheSize;
+
+		CacheSimulator(u32 vertexCount, u32 cacheSize)
+		{
+			Timestamps.Resize(vertexCount);
+			CacheSize = cacheSize;
+			Time = cacheSize + 1;
+		}
+
+		// Returns 1 if vertex had to be transformed
+		u32 Access(u16 index)
+		{
+			if (Time - Timestamps[index] <= CacheSize)
+				return 0;
+
+			Timestamps[index] = Time++;
+			return 1;
+		}
+
+		void Flush() { Time += CacheSize + 1; }
+	};
+}
+
+void rageam::graphics::MeshOptimizer::SplitClusters(
+	const u16* indices, u32 vertexCount, u32 cacheSize, float threshold, rage::atArray<Cluster, u32>& clusters)
+{
+	rage::atArray<Cluster, u32> softClusters;
+	softClusters.Reserve(clusters.GetSize());
+
+	CacheSimulator cache(vertexCount, cacheSize);
+	for (const Cluster& hardCluster : clusters)
+	{
+		// Efficiency of the whole cluster is the baseline for splitting it
+		cache.Flush();
+		u32 clusterMisses = 0;
+		for (u32 i = hardCluster.Start * 3; i < hardCluster.End * 3; i++)
+			clusterMisses += cache.Access(indices[i]);
+		float clusterThreshold = threshold * static_cast<float>(clusterMisses) / static_cast<float>(hardCluster.End - hardCluster.Start);
+
+		cache.Flush();
+		u32 start = hardCluster.Start;
+		u32 misses = 0;
+		for (u32 i = hardCluster.Start; i < hardCluster.End; i++)
+		{
+			misses += cache.Access(indices[i * 3 + 0]);
+			misses += cache.Access(indices[i * 3 + 1]);
+			misses += cache.Access(indices[i * 3 + 2]);
+
+			// Prefix is already as good as the whole cluster, it can be moved independently
+			if (static_cast<float>(misses) / static_cast<float>(i + 1 - start) <= clusterThreshold)
+			{
+				softClusters.Add({ start, i + 1, 0.0f });
+				start = i + 1;
+				misses = 0;
+				cache.Flush();
+			}
+		}
+
+		if (start != hardCluster.End)
+			softClusters.Add({ start, hardCluster.End, 0.0f });
+	}
+
+	clusters = std::move(softClusters);
+}
+
+rageam::graphics::VertexCacheStats rageam::graphics::MeshOptimizer::AnalyzeVertexCache(
+	const u16* indices, u32 indexCount, u32 vertexCount, u32 cacheSize)
+{
+	CacheSimulator cache(vertexCount, cacheSize);
+	List<bool> used;
+	used.Resize(vertexCount);
+
+	u32 transformCount = 0;
+	u32 usedCount = 0;
+	for (u32 i = 0; i < indexCount; i++)
+	{
+		u16 index = indices[i];
+		AM_ASSERTS(index < vertexCount);
+
+		transformCount += cache.Access(index);
+		if (!used[index])
+		{
+			used[index] = true;
+			usedCount++;
+		}
+	}
+
+	VertexCacheStats stats;
+	stats.TransformCount = transformCount;
+	stats.ACMR = indexCount >= 3 ? static_cast<float>(transformCount) / static_cast<float>(indexCount / 3) : 0.0f;
+	stats.ATVR = usedCount != 0 ? static_cast<float>(transformCount) / static_cast<float>(usedCount) : 0.0f;
+	return stats;
+}
+
+void rageam::graphics::MeshOptimizer::OptimizeVertexCache(
+	u16* indices, u32 indexCount, u32 vertexCount, u32 cacheSize, rage::atArray<u32, u32>* outClusters)
+{
+	AM_ASSERT(indexCount % 3 == 0, "MeshOptimizer::OptimizeVertexCache() -> Index count %u is not multiple of 3.", indexCount);
+
+	u32 triangleCount = indexCount / 3;
+	if (triangleCount == 0)
+		return;
+
+	if (outClusters)
+	{
+		outClusters->Clear();
+		outClusters->Add(0);
+	}
+
+	// Vertex -> triangle adjacency, stored as ranges in single array
+	List<u32> liveCounts;
+	List<u32> adjacencyOffsets;
+	List<u32> adjacency;
+	liveCounts.Resize(vertexCount);
+	adjacencyOffsets.Resize(vertexCount + 1);
+	adjacency.Resize(indexCount);
+	for (u32 i = 0; i < indexCount; i++)
+	{
+		AM_ASSERTS(indices[i] < vertexCount);
+		liveCounts[indices[i]]++;
+	}
+	for (u32 i = 0; i < vertexCount; i++)
+		adjacencyOffsets[i + 1] = adjacencyOffsets[i] + liveCounts[i];
+	{
+		List<u32> fillOffsets = adjacencyOffsets;
+		for (u32 i = 0; i < indexCount; i++)
+			adjacency[fillOffsets[indices[i]]++] = i / 3;
+	}
+
+	List<u16>  output;
+	List<u16>  deadEndStack;
+	List<bool> emitted;
+	output.Reserve(indexCount);
+	emitted.Resize(triangleCount);
+
+	List<u32> timestamps;
+	timestamps.Resize(vertexCount);
+	u32 time = cacheSize + 1;
+	u32 cursor = 0;
+
+	List<u16> candidates;
+	s32 fanningVertex = 0;
+	while (fanningVertex >= 0)
+	{
+		// Emit all remaining triangles around fanning vertex
+		candidates.Clear();
+		u16 fanning = static_cast<u16>(fanningVertex);
+		for (u32 i = adjacencyOffsets[fanning]; i < adjacencyOffsets[fanning + 1]; i++)
+		{
+			u32 triangle = adjacency[i];
+			if (emitted[triangle])
+				continue;
+
+			for (u32 k = 0; k < 3; k++)
+			{
+				u16 vertex = indices[triangle * 3 + k];
+				output.Add(vertex);
+				deadEndStack.Add(vertex);
+				candidates.Add(vertex);
+				liveCounts[vertex]--;
+				if (time - timestamps[vertex] > cacheSize)
+					timestamps[vertex] = time++;
+			}
+			emitted[triangle] = true;
+		}
+
+		// Pick the oldest candidate that will still be in cache after fanning all its remaining triangles
+		fanningVertex = -1;
+		s32 bestPriority = -1;
+		for (u16 vertex : candidates)
+		{
+			if (liveCounts[vertex] == 0)
+				continue;
+
+			s32 priority = 0;
+			if (time - timestamps[vertex] + 2 * liveCounts[vertex] <= cacheSize)
+				priority = static_cast<s32>(time - timestamps[vertex]);
+			if (priority > bestPriority)
+			{
+				bestPriority = priority;
+				fanningVertex = vertex;
+			}
+		}
+
+		if (fanningVertex >= 0)
+			continue;
+
+		// Dead end, try recently used vertices first and then scan for any vertex with live triangles
+		while (deadEndStack.Any() && fanningVertex < 0)
+		{
+			u16 vertex = deadEndStack.Last();
+			deadEndStack.RemoveLast();
+			if (liveCounts[vertex] > 0)
+				fanningVertex = vertex;
+		}
+		while (fanningVertex < 0 && cursor < vertexCount)
+		{
+			if (liveCounts[cursor] > 0)
+				fanningVertex = static_cast<s32>(cursor);
+			cursor++;
+		}
+
+		// Jumping to unrelated vertex breaks locality, this is where cluster ends
+		u32 emittedCount = output.GetSize() / 3;
+		if (fanningVertex >= 0 && outClusters && outClusters->Last() != emittedCount)
+			outClusters->Add(emittedCount);
+	}
+
+	AM_ASSERTS(output.GetSize() == indexCount);
+	memcpy(indices, output.GetItems(), sizeof(u16) * indexCount);
+}
+
+void rageam::graphics::MeshOptimizer::OptimizeOverdraw(
+	u16* indices, u32 indexCount, const char* vertices, u32 vertexCount, u32 vertexStride, u32 positionOffset,
+	const rage::atArray<u32, u32>& clusterStarts, u32 cacheSize, float threshold)
+{
+	u32 triangleCount = indexCount / 3;
+	if (clusterStarts.GetSize() == 0 || triangleCount == 0)
+		return;
+
+	rage::atArray<Cluster, u32> clusters;
+	clusters.Reserve(clusterStarts.GetSize());
+	for (u32 i = 0; i < clusterStarts.GetSize(); i++)
+	{
+		u32 end = i + 1 < clusterStarts.GetSize() ? clusterStarts[i + 1] : triangleCount;
+		if (end > clusterStarts[i])
+			clusters.Add({ clusterStarts[i], end, 0.0f });
+	}
+	SplitClusters(indices, vertexCount, cacheSize, threshold, clusters);
+
+	// Clusters located further along their normal from mesh center are likely to occlude the others
+	Position meshCenter = {};
+	for (u32 i = 0; i < indexCount; i++)
+	{
+		const Position& pos = GetPosition(vertices, vertexStride, positionOffset, indices[i]);
+		meshCenter.X += pos.X;
+		meshCenter.Y += pos.Y;
+		meshCenter.Z += pos.Z;
+	}
+	meshCenter.X /= static_cast<float>(indexCount);
+	meshCenter.Y /= static_cast<float>(indexCount);
+	meshCenter.Z /= static_cast<float>(indexCount);
+
+	for (Cluster& cluster : clusters)
+	{
+		// Area weighted center and normal, length of cross product is double triangle area
+		Position center = {};
+		Position normal = {};
+		float totalArea = 0.0f;
+		for (u32 i = cluster.Start; i < cluster.End; i++)
+		{
+			const Position& a = GetPosition(vertices, vertexStride, positionOffset, indices[i * 3 + 0]);
+			const Position& b = GetPosition(vertices, vertexStride, positionOffset, indices[i * 3 + 1]);
+			const Position& c = GetPosition(vertices, vertexStride, positionOffset, indices[i * 3 + 2]);
+
+			Position ab = { b.X - a.X, b.Y - a.Y, b.Z - a.Z };
+			Position ac = { c.X - a.X, c.Y - a.Y, c.Z - a.Z };
+			Position cross = { ab.Y * ac.Z - ab.Z * ac.Y, ab.Z * ac.X - ab.X * ac.Z, ab.X * ac.Y - ab.Y * ac.X };
+			float area = sqrtf(cross.X * cross.X + cross.Y * cross.Y + cross.Z * cross.Z);
+
+			center.X += (a.X + b.X + c.X) * area;
+			center.Y += (a.Y + b.Y + c.Y) * area;
+			center.Z += (a.Z + b.Z + c.Z) * area;
+			normal.X += cross.X;
+			normal.Y += cross.Y;
+			normal.Z += cross.Z;
+			totalArea += area;
+		}
+
+		float normalLength = sqrtf(normal.X * normal.X + normal.Y * normal.Y + normal.Z * normal.Z);
+		if (totalArea == 0.0f || normalLength == 0.0f)
+		{
+			cluster.SortKey = 0.0f;
+			continue;
+		}
+
+		float centerScale = 1.0f / (totalArea * 3.0f);
+		cluster.SortKey =
+			((center.X * centerScale - meshCenter.X) * normal.X +
+			 (center.Y * centerScale - meshCenter.Y) * normal.Y +
+			 (center.Z * centerScale - meshCenter.Z) * normal.Z) / normalLength;
+	}
+
+	std::stable_sort(clusters.begin(), clusters.end(), [](const Cluster& lhs, const Cluster& rhs) { return lhs.SortKey > rhs.SortKey; });
+
+	List<u16> sorted;
+	sorted.Reserve(indexCount);
+	for (const Cluster& cluster : clusters)
+	{
+		for (u32 i = cluster.Start * 3; i < cluster.End * 3; i++)
+			sorted.Add(indices[i]);
+	}
+
+	// Soft boundaries keep cache efficiency close, but we don't want to lose more than allowed in any case
+	VertexCacheStats before = AnalyzeVertexCache(indices, indexCount, vertexCount, cacheSize);
+	VertexCacheStats after = AnalyzeVertexCache(sorted.GetItems(), indexCount, vertexCount, cacheSize);
+	if (after.ACMR > before.ACMR * threshold)
+		return;
+
+	memcpy(indices, sorted.GetItems(), sizeof(u16) * indexCount);
+}
+
+u32 rageam::graphics::MeshOptimizer::OptimizeVertexFetch(char* vertices, u32 vertexCount, u32 vertexStride, u16* indices, u32 indexCount)
+{
+	static constexpr u32 NO_REMAP = UINT32_MAX;
+
+	List<u32> remap;
+	remap.Resize(vertexCount);
+	for (u32& index : remap)
+		index = NO_REMAP;
+
+	amUniquePtr<char[]> newVertices = std::make_unique<char[]>(static_cast<size_t>(vertexCount) * vertexStride);
+	u32 newVertexCount = 0;
+	for (u32 i = 0; i < indexCount; i++)
+	{
+		u16 index = indices[i];
+		AM_ASSERTS(index < vertexCount);
+
+		if (remap[index] == NO_REMAP)
+		{
+			memcpy(newVertices.get() + static_cast<size_t>(newVertexCount) * vertexStride,
+				vertices + static_cast<size_t>(index) * vertexStride, vertexStride);
+			remap[index] = newVertexCount++;
+		}
+		indices[i] = static_cast<u16>(remap[index]);
+	}
+
+	memcpy(vertices, newVertices.get(), static_cast<size_t>(newVertexCount) * vertexStride);
+	return newVertexCount;
+}
+
+u32 rageam::graphics::MeshOptimizer::Optimize(
+	char* vertices, u32 vertexCount, u32 vertexStride, u32 positionOffset, u16* indices, u32 indexCount, bool reorderTriangles)
+{
+	if (reorderTriangles)
+	{
+		rage::atArray<u32, u32> clusters;
+		OptimizeVertexCache(indices, indexCount, vertexCount, DEFAULT_CACHE_SIZE, &clusters);
+		OptimizeOverdraw(indices, indexCount, vertices, vertexCount, vertexStride, positionOffset, clusters);
+	}
+	return OptimizeVertexFetch(vertices, vertexCount, vertexStride, indices, indexCount);
+}
@@ -0,0 +1,72 @@
+//
+// File: meshoptimizer.h
+//
+// Copyright (C) 2023-2024 ranstar74. All rights violated.
+//
+// Part of "Rage Am" Research Project.
+//
+#pragma once
+
+#include "common/types.h"
+#include "rage/atl/array.h"
+
+namespace rageam::graphics
+{
+	// Post-transform cache efficiency of index buffer, computed by simulating FIFO cache
+	struct VertexCacheStats
+	{
+		u32   TransformCount;	// Number of vertices that missed the cache
+		float ACMR;				// Average cache miss ratio, transformed vertices per triangle, 0.5 is ideal for large grid
+		float ATVR;				// Average transform to vertex ratio, 1.0 is ideal
+	};
+
+	/**
+	 * \brief Reorders triangles and vertices of 16 bit indexed triangle list for faster rendering on GPU:
+	 * \n 1) Vertex cache - triangles are reordered using 'Tipsify' algorithm to reuse recently transformed vertices;
+	 * \n 2) Overdraw - clusters produced by tipsify are sorted so outward facing ones are drawn first, as long as
+	 * it doesn't make vertex cache efficiency noticeably worse;
+	 * \n 3) Vertex fetch - vertices are reordered in the order of first use in index buffer, unused ones are dropped.
+	 * \n Based on 'Fast Triangle Reordering for Vertex Locality and Reduced Overdraw' by Sander, Nehab and Barczak.
+	 */
+	class MeshOptimizer
+	{
+		// Triangles in range [Start, End)
+		struct Cluster
+		{
+			u32   Start;
+			u32   End;
+			float SortKey;
+		};
+
+		// Hard clusters are ranges between dead-end jumps of tipsify,
+		// they're split further at points where local cache efficiency is already good enough
+		static void SplitClusters(const u16* indices, u32 vertexCount, u32 cacheSize, float threshold, rage::atArray<Cluster, u32>& clusters);
+
+	public:
+		// Typical post-transform cache size of modern GPUs when it is simulated as FIFO
+		static constexpr u32   DEFAULT_CACHE_SIZE = 16;
+		// How much worse ACMR may get from sorting clusters for overdraw
+		static constexpr float DEFAULT_OVERDRAW_THRESHOLD = 1.05f;
+
+		static VertexCacheStats AnalyzeVertexCache(const u16* indices, u32 indexCount, u32 vertexCount, u32 cacheSize = DEFAULT_CACHE_SIZE);
+
+		// Optional cluster starts (in triangles) are written in outClusters, used for overdraw optimization
+		static void OptimizeVertexCache(
+			u16* indices, u32 indexCount, u32 vertexCount, u32 cacheSize = DEFAULT_CACHE_SIZE, rage::atArray<u32, u32>* outClusters = nullptr);
+
+		// Indices must be optimized by OptimizeVertexCache already, with cluster starts given,
+		// positions are float[3] at given offset in every vertex
+		static void OptimizeOverdraw(
+			u16* indices, u32 indexCount, const char* vertices, u32 vertexCount, u32 vertexStride, u32 positionOffset,
+			const rage::atArray<u32, u32>& clusterStarts,
+			u32 cacheSize = DEFAULT_CACHE_SIZE, float threshold = DEFAULT_OVERDRAW_THRESHOLD);
+
+		// Reorders vertices in order of first use and updates indices, returns new vertex count (unused vertices are removed)
+		static u32 OptimizeVertexFetch(char* vertices, u32 vertexCount, u32 vertexStride, u16* indices, u32 indexCount);
+
+		// Performs all three stages, triangle order is preserved if reorderTriangles is false (for e.g. alpha blended geometry),
+		// returns new vertex count
+		static u32 Optimize(
+			char* vertices, u32 vertexCount, u32 vertexStride, u32 positionOffset, u16* indices, u32 indexCount, bool reorderTriangles);
+	};
+}
@@ -0,0 +1,297 @@
+#include "meshsplitter.h"
+
+#include "am/system/asserts.h"
+#include "am/system/worker.h"
+
+#include <algorithm>
+#include <cfloat>
+
+namespace
+{
+	struct Position
+	{
+		float X, Y, Z;
+	};
+
+	const Position& GetPosition(const char* vertices, u32 vertexStride, u32 positionOffset, u32 index)
+	{
+		return *reinterpret_cast<const Position*>(vertices + static_cast<size_t>(index) * vertexStride + positionOffset);
+	}
+
+	// Spreads lower 5 bits so there are two zero bits between every bit
+	u32 SpreadBits5(u32 value)
+	{
+		value &= 0x1F;
+		value = (value | (value << 8)) & 0x100F;
+		value = (value | (value << 4)) & 0x10C3;
+		value = (value | (value << 2)) & 0x1249;
+		return value;
+	}
+
+	// Maps value in range [0, 31] to integer, NaN is mapped to 0
+	u32 QuantizeCell(float value)
+	{
+		value = value > 0.0f ? value : 0.0f;
+		value = value < 31.0f ? value : 31.0f;
+		return static_cast<u32>(value);
+	}
+}
+
+void rageam::graphics::MeshSplitter::RunChunks(u32 count, u32 chunkCount, const std::function<void(u32 chunk, u32 chunkStart, u32 chunkEnd)>& fn)
+{
+	auto getChunkStart = [&](u32 chunk) { return static_cast<u32>(static_cast<u64>(count) * chunk / chunkCount); };
+
+	if (!sm_Worker || chunkCount == 1)
+	{
+		for (u32 i = 0; i < chunkCount; i++)
+			fn(i, getChunkStart(i), getChunkStart(i + 1));
+		return;
+	}
+
+	SmallList<BackgroundTaskPtr> tasks;
+	tasks.Reserve(static_cast<u16>(chunkCount - 1));
+	BackgroundWorker::Push(sm_Worker);
+	for (u32 i = 0; i < chunkCount - 1; i++)
+	{
+		u32 chunkStart = getChunkStart(i);
+		u32 chunkEnd = getChunkStart(i + 1);
+		tasks.Emplace(BackgroundWorker::Run([&fn, i, chunkStart, chunkEnd]
+			{
+				fn(i, chunkStart, chunkEnd);
+				return true;
+			}));
+	}
+	BackgroundWorker::Pop();
+
+	fn(chunkCount - 1, getChunkStart(chunkCount - 1), count);
+
+	for (BackgroundTaskPtr& task : tasks)
+		task->Wait();
+}
+
+void rageam::graphics::MeshSplitter::ComputeCells(u32 triangleCount, u32 positionOffset, u32 chunkCount)
+{
+	// Bounds of all vertices, chunks are merged in fixed order
+	Position chunkMin[SORT_CHUNK_COUNT];
+	Position chunkMax[SORT_CHUNK_COUNT];
+	RunChunks(m_VertexCount, chunkCount, [&](u32 chunk, u32 chunkStart, u32 chunkEnd)
+		{
+			Position min = { FLT_MAX, FLT_MAX, FLT_MAX };
+			Position max = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+			for (u32 i = chunkStart; i < chunkEnd; i++)
+			{
+				const Position& position = GetPosition(m_Vertices, m_VertexStride, positionOffset, i);
+				min = { std::min(min.X, position.X), std::min(min.Y, position.Y), std::min(min.Z, position.Z) };
+				max = { std::max(max.X, position.X), std::max(max.Y, position.Y), std::max(max.Z, position.Z) };
+			}
+			chunkMin[chunk] = min;
+			chunkMax[chunk] = max;
+		});
+
+	Position min = chunkMin[0];
+	Position max = chunkMax[0];
+	for (u32 i = 1; i < chunkCount; i++)
+	{
+		min = { std::min(min.X, chunkMin[i].X), std::min(min.Y, chunkMin[i].Y), std::min(min.Z, chunkMin[i].Z) };
+		max = { std::max(max.X, chunkMax[i].X), std::max(max.Y, chunkMax[i].Y), std::max(max.Z, chunkMax[i].Z) };
+	}
+
+	// Centroids are not divided by 3, bounds are scaled instead
+	constexpr float gridSize = 1 << CELL_BITS;
+	auto getScale = [](float extent) { return extent > 0.0f ? gridSize / (extent * 3.0f) : 0.0f; };
+	Position scale = { getScale(max.X - min.X), getScale(max.Y - min.Y), getScale(max.Z - min.Z) };
+	Position offset = { min.X * 3.0f, min.Y * 3.0f, min.Z * 3.0f };
+
+	m_Cells.Resize(triangleCount);
+	RunChunks(triangleCount, chunkCount, [&](u32 chunk, u32 chunkStart, u32 chunkEnd)
+		{
+			for (u32 i = chunkStart; i < chunkEnd; i++)
+			{
+				const u32* triangle = m_Indices + static_cast<size_t>(i) * 3;
+				const Position& a = GetPosition(m_Vertices, m_VertexStride, positionOffset, triangle[0]);
+				const Position& b = GetPosition(m_Vertices, m_VertexStride, positionOffset, triangle[1]);
+				const Position& c = GetPosition(m_Vertices, m_VertexStride, positionOffset, triangle[2]);
+
+				u32 x = QuantizeCell((a.X + b.X + c.X - offset.X) * scale.X);
+				u32 y = QuantizeCell((a.Y + b.Y + c.Y - offset.Y) * scale.Y);
+				u32 z = QuantizeCell((a.Z + b.Z + c.Z - offset.Z) * scale.Z);
+				m_Cells[i] = static_cast<u16>(SpreadBits5(x) | SpreadBits5(y) << 1 | SpreadBits5(z) << 2);
+			}
+		});
+}
+
+void rageam::graphics::MeshSplitter::SortTriangles(u32 triangleCount, u32 chunkCount)
+{
+	// Counting sort by cell, every chunk scatters its own part of the source so sort is stable
+	List<u32> offsets;
+	offsets.Resize(chunkCount * CELL_COUNT);
+	RunChunks(triangleCount, chunkCount, [&](u32 chunk, u32 chunkStart, u32 chunkEnd)
+		{
+			u32* histogram = offsets.GetItems() + chunk * CELL_COUNT;
+			std::fill_n(histogram, CELL_COUNT, 0);
+			for (u32 i = chunkStart; i < chunkEnd; i++)
+				histogram[m_Cells[i]]++;
+		});
+
+	// Cell-major order, so triangles of the same cell from earlier chunks come first
+	u32 offset = 0;
+	for (u32 cell = 0; cell < CELL_COUNT; cell++)
+	{
+		for (u32 chunk = 0; chunk < chunkCount; chunk++)
+		{
+			u32& count = offsets[chunk * CELL_COUNT + cell];
+			u32 start = offset;
+			offset += count;
+			count = start;
+		}
+	}
+
+	RunChunks(triangleCount, chunkCount, [&](u32 chunk, u32 chunkStart, u32 chunkEnd)
+		{
+			u32* chunkOffsets = offsets.GetItems() + chunk * CELL_COUNT;
+			for (u32 i = chunkStart; i < chunkEnd; i++)
+				m_Triangles[chunkOffsets[m_Cells[i]]++] = i;
+		});
+}
+
+void rageam::graphics::MeshSplitter::PackSegment(Segment& segment)
+{
+	segment.Chunks.Clear();
+	segment.ChunkVertices.Clear();
+	segment.ChunkIndices.Clear();
+
+	if (segment.VertexRemapSize < m_VertexCount)
+	{
+		segment.VertexRemap = std::make_unique<u32[]>(m_VertexCount);
+		segment.VertexRemapSize = m_VertexCount;
+		segment.Stamp = 0;
+	}
+
+	auto nextStamp = [&]
+		{
+			// Stamp wrapped around, old values may match again
+			if (++segment.Stamp == 0)
+			{
+				std::fill_n(segment.VertexRemap.get(), segment.VertexRemapSize, 0);
+				segment.Stamp = 1;
+			}
+		};
+
+	nextStamp();
+	for (u32 i = segment.TriangleStart; i < segment.TriangleEnd; i++)
+	{
+		// Leave space for three new vertices, chunk may end up to two vertices smaller than the limit
+		if (segment.ChunkVertices.GetSize() + 3 > MAX_CHUNK_VERTICES)
+		{
+			FlushChunk(segment);
+			nextStamp();
+		}
+
+		const u32* triangle = m_Indices + static_cast<size_t>(m_Triangles[i]) * 3;
+		for (u32 k = 0; k < 3; k++)
+		{
+			u32 vertex = triangle[k];
+			AM_DEBUG_ASSERT(vertex < m_VertexCount, "MeshSplitter::Split() -> Index %u is out of range (%u vertices)", vertex, m_VertexCount);
+
+			u32& remap = segment.VertexRemap[vertex];
+			if (remap >> 16 != segment.Stamp)
+			{
+				remap = static_cast<u32>(segment.Stamp) << 16 | segment.ChunkVertices.GetSize();
+				segment.ChunkVertices.Add(vertex);
+			}
+			segment.ChunkIndices.Add(static_cast<u16>(remap));
+		}
+	}
+
+	if (segment.ChunkIndices.Any())
+		FlushChunk(segment);
+}
+
+void rageam::graphics::MeshSplitter::FlushChunk(Segment& segment) const
+{
+	u32 vertexCount = segment.ChunkVertices.GetSize();
+	u32 indexCount = segment.ChunkIndices.GetSize();
+
+	char* vertices = new char[static_cast<size_t>(vertexCount) * m_VertexStride];
+	for (u32 i = 0; i < vertexCount; i++)
+	{
+		const char* src = m_Vertices + static_cast<size_t>(segment.ChunkVertices[i]) * m_VertexStride;
+		char* dst = vertices + static_cast<size_t>(i) * m_VertexStride;
+		memcpy(dst, src, m_VertexStride);
+	}
+
+	u16* indices = new u16[indexCount];
+	memcpy(indices, segment.ChunkIndices.GetItems(), sizeof(u16) * indexCount);
+
+	segment.Chunks.Emplace(MeshChunk{ amUPtr<char[]>(vertices), amUPtr<u16[]>(indices), vertexCount, indexCount });
+	segment.ChunkVertices.Clear();
+	segment.ChunkIndices.Clear();
+}
+
+rage::atArray<rageam::graphics::MeshChunk> rageam::graphics::MeshSplitter::Split(
+	const char* vertices, u32 vertexCount, u32 vertexStride, u32 positionOffset, const u32* indices, u32 indexCount)
+{
+	AM_ASSERT(indexCount % 3 == 0, "MeshSplitter::Split() -> Index count %u is not multiple of 3, only triangle lists are supported.", indexCount);
+
+	m_Vertices = vertices;
+	m_VertexCount = vertexCount;
+	m_VertexStride = vertexStride;
+	m_Indices = indices;
+
+	u32 triangleCount = indexCount / 3;
+	// Number of chunks must not depend on worker, result would be different otherwise
+	u32 sortChunkCount = sm_Worker && triangleCount >= PARALLEL_THRESHOLD ? SORT_CHUNK_COUNT : 1;
+	u32 segmentCount = std::clamp(triangleCount / MIN_SEGMENT_TRIANGLES, 1u, MAX_SEGMENTS);
+
+	m_Triangles.Resize(triangleCount);
+	if (positionOffset != NO_POSITION)
+	{
+		ComputeCells(triangleCount, positionOffset, sortChunkCount);
+		SortTriangles(triangleCount, sortChunkCount);
+	}
+	else
+	{
+		for (u32 i = 0; i < triangleCount; i++)
+			m_Triangles[i] = i;
+	}
+
+	RunChunks(triangleCount, segmentCount, [this](u32 chunk, u32 chunkStart, u32 chunkEnd)
+		{
+			Segment& segment = m_Segments[chunk];
+			segment.TriangleStart = chunkStart;
+			segment.TriangleEnd = chunkEnd;
+			PackSegment(segment);
+		});
+
+	// Gather chunks in segment order
+	u16 chunkCount = 0;
+	for (u32 i = 0; i < segmentCount; i++)
+		chunkCount += static_cast<u16>(m_Segments[i].Chunks.GetSize());
+
+	rage::atArray<MeshChunk> chunks;
+	chunks.Reserve(chunkCount);
+	for (u32 i = 0; i < segmentCount; i++)
+	{
+		for (MeshChunk& chunk : m_Segments[i].Chunks)
+			chunks.Emplace(std::move(chunk));
+		m_Segments[i].Chunks.Clear();
+	}
+
+	m_Vertices = nullptr;
+	m_Indices = nullptr;
+
+	return chunks;
+}
+
+void rageam::graphics::MeshSplitter::InitClass()
+{
+	SYSTEM_INFO sysInfo;
+	GetSystemInfo(&sysInfo);
+	sm_Worker = new BackgroundWorker("MeshSplitter", static_cast<int>(sysInfo.dwNumberOfProcessors));
+}
+
+void rageam::graphics::MeshSplitter::ShutdownClass()
+{
+	delete sm_Worker;
+	sm_Worker = nullptr;
+}
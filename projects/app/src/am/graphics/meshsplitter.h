@@ -1,101 +1,111 @@
 //
 // File: meshsplitter.h
 //
-// Copyright (C) 2023 ranstar74. All rights violated.
+// Copyright (C) 2023-2024 ranstar74. All rights violated.
 //
 // Part of "Rage Am" Research Project.
 //
 #pragma once
 
 #include "am/system/ptr.h"
+#include "am/types.h"
 #include "common/types.h"
 #include "rage/atl/array.h"
 
+#include <functional>
+
+namespace rageam
+{
+	class BackgroundWorker;
+}
+
 namespace rageam::graphics
 {
 	struct MeshChunk
 	{
-		amUniquePtr<char>	Vertices;
-		amUniquePtr<u16>	Indices;
+		amUPtr<char[]>	Vertices;
+		amUPtr<u16[]>	Indices;
 
 		u32 VertexCount, IndexCount;
 	};
 
 	/**
-	 * \brief Utility for splitting large meshes (65k+ indices) on chunks that can fit into 16 byte indices,
+	 * \brief Utility for splitting large meshes (65k+ vertices) on chunks that can fit into 16 bit indices,
 	 * this is required by rage vertex buffer as it uses UINT16_t as index type.
+	 * \n Triangles are sorted along morton curve by centroid so every chunk covers compact region of the mesh
+	 * and shares as few vertices with other chunks as possible. Sorted triangles are then split on segments that are
+	 * packed in chunks in parallel, vertices are remapped using flat per-segment tables instead of hash maps.
+	 * \n Scratch buffers are kept between Split calls, reuse single splitter instance for multiple meshes.
 	 */
 	class MeshSplitter
 	{
 	public:
-		static rage::atArray<MeshChunk> Split(pVoid vertices, u32 vtxStride, const u32* indices, u32 idxCount)
+		static constexpr u32 MAX_CHUNK_VERTICES = UINT16_MAX;
+		// Position offset for meshes without float3 position, triangle order is kept as is then
+		static constexpr u32 NO_POSITION = u32(-1);
+
+	private:
+		static constexpr u32 SORT_CHUNK_COUNT = 8;
+		// Triangles are bucketed in 32x32x32 grid cells ordered along morton curve, cells are much smaller than a chunk
+		// on any mesh that needs splitting, so finer sort wouldn't give better chunks and triangles keep source order within cell
+		static constexpr u32 CELL_BITS = 5;
+		static constexpr u32 CELL_COUNT = 1 << CELL_BITS * 3;
+		static constexpr u32 MAX_SEGMENTS = 8;
+		// Every segment ends with partially filled chunk, so they must be large enough to hold many chunks,
+		// this also bounds memory used by remap tables (4 bytes per source vertex for every segment)
+		static constexpr u32 MIN_SEGMENT_TRIANGLES = 0x100000;	// 1M
+		// Below this everything is done on caller thread, task overhead is larger than the work
+		static constexpr u32 PARALLEL_THRESHOLD = 0x10000;		// 64K
+
+		// Packs range of sorted triangles in chunks, everything here is reused between Split calls
+		struct Segment
 		{
-			static constexpr u16 MAX_INDEX = UINT16_MAX;
-
-			u32 totalIndex = 0;
-
-			rage::atArray<MeshChunk> chunks;
-			while (totalIndex < idxCount)
-			{
-				HashSet<u16> oldIndexToNewIndex;
-
-				// We can't use atArray so we have to simulate it's grow behaviour here
-				u32 chunkVerticesCapacity = 4096; // Mesh with 32 bit indices will most likely have a lot of vertices
-				u32 chunkVerticesCount = 0;
-				char* chunkVertices = new char[static_cast<size_t>(chunkVerticesCapacity) * vtxStride];
-
-				rage::atArray<u16, u32> chunkIndices;
-
-				// Pack each chunk until we got to max index
-				u16 chunkIndexCount = 0; // We use it as new index in current chunk
-				u16 chunkIndex = 0;
-				while (totalIndex < idxCount && chunkIndexCount < MAX_INDEX)
-				{
-					u32 oldIndex = indices[totalIndex];
-					u16* existingIndex = oldIndexToNewIndex.TryGetAt(oldIndex);
-					if (existingIndex)
-					{
-						// We already have this index vertex added, simply remap it to next index
-						chunkIndices.Add(*existingIndex);
-					}
-					else
-					{
-						// We got new index unseen before, we have to add both vertex and index
-						chunkIndices.Add(chunkIndex);
-						oldIndexToNewIndex.InsertAt(oldIndex, chunkIndex);
-
-						char* src = static_cast<char*>(vertices) + static_cast<size_t>(oldIndex) * vtxStride;
-						char* dst = chunkVertices + static_cast<size_t>(chunkVerticesCount) * vtxStride;
-						memcpy(dst, src, vtxStride);
-
-						// Grow vertices buffer if out of space
-						chunkVerticesCount++;
-						if (chunkVerticesCount == chunkVerticesCapacity)
-						{
-							chunkVerticesCapacity *= 2;
-							char* newChunkVertices = new char[static_cast<size_t>(chunkVerticesCapacity) * vtxStride];
-							memcpy(newChunkVertices, chunkVertices, static_cast<size_t>(chunkVerticesCount) * vtxStride);
-							delete[] chunkVertices;
-							chunkVertices = newChunkVertices;
-						}
-						chunkIndex++;
-					}
-
-					chunkIndexCount++;
-					totalIndex++;
-				}
-
-				MeshChunk chunk(
-					amUniquePtr<char>(chunkVertices),
-					amUniquePtr<u16>(chunkIndices.MoveBuffer()),
-					chunkVerticesCount, chunkIndexCount);
-				chunks.Emplace(std::move(chunk));
-
-				//AM_DEBUGF("MeshSplitter::Split -> Packed chunk with %u vertices; %u indices; %u indices left",
-				//	chunkVerticesCount, chunkIndexCount, idxCount - totalIndex);
-			}
-
-			return chunks;
-		}
+			// Remap table for every source vertex, chunk stamp in high 16 bits and index in chunk in low 16 bits;
+			// chunk stamp is incremented for every new chunk so table doesn't have to be cleared
+			amUPtr<u32[]>	VertexRemap;
+			u32				VertexRemapSize = 0;
+			u16				Stamp = 0;
+
+			List<u32>		ChunkVertices;	// Source vertex index of every vertex in current chunk
+			List<u16>		ChunkIndices;
+			List<MeshChunk>	Chunks;
+
+			u32				TriangleStart;
+			u32				TriangleEnd;
+		};
+
+		static inline BackgroundWorker* sm_Worker = nullptr;
+
+		const char*	m_Vertices = nullptr;
+		u32			m_VertexCount = 0;
+		u32			m_VertexStride = 0;
+		const u32*	m_Indices = nullptr;
+
+		List<u16>	m_Cells;			// Morton code of cell that contains triangle centroid
+		List<u32>	m_Triangles;		// Triangle indices in sorted order
+		Segment		m_Segments[MAX_SEGMENTS];
+
+		// Invokes function on equal parts of the range, all but the last one are executed on worker threads
+		static void RunChunks(u32 count, u32 chunkCount, const std::function<void(u32 chunk, u32 chunkStart, u32 chunkEnd)>& fn);
+
+		void ComputeCells(u32 triangleCount, u32 positionOffset, u32 chunkCount);
+		void SortTriangles(u32 triangleCount, u32 chunkCount);
+		void PackSegment(Segment& segment);
+		void FlushChunk(Segment& segment) const;
+
+	public:
+		MeshSplitter() = default;
+		MeshSplitter(const MeshSplitter&) = delete;
+		MeshSplitter& operator=(const MeshSplitter&) = delete;
+
+		/**
+		 * \brief Splits 32 bit indexed triangle list on chunks with at most MAX_CHUNK_VERTICES vertices.
+		 * \param positionOffset	Offset of float3 position in vertex, or NO_POSITION to split in source triangle order.
+		 * \remarks Chunk order and contents are the same regardless of whether worker was initialized (see ::InitClass).
+		 */
+		rage::atArray<MeshChunk> Split(const char* vertices, u32 vertexCount, u32 vertexStride, u32 positionOffset, const u32* indices, u32 indexCount);
+
+		static void InitClass();
+		static void ShutdownClass();
 	};
 }
@@ -7,7 +7,81 @@
 //
 #pragma once
 
+#include "common/types.h"
+
+#include <iterator>
+#include <type_traits>
+
 namespace rageam::graphics
 {
-	// TODO: 
+	/**
+	 * \brief Random access iterator over single attribute in interleaved (strided) vertex buffer,
+	 * for e.g. POSITION as rage::Vector3. Use const T for read-only access.
+	 */
+	template<typename T>
+	class VertexBufferIterator
+	{
+		using TChar = std::conditional_t<std::is_const_v<T>, const char, char>;
+
+		TChar* m_Pos = nullptr;
+		u32    m_Stride = 0;
+
+	public:
+		using iterator_category = std::random_access_iterator_tag;
+		using value_type = std::remove_const_t<T>;
+		using difference_type = std::ptrdiff_t;
+		using pointer = T*;
+		using reference = T&;
+
+		VertexBufferIterator() = default;
+		// Offset is attribute offset within the vertex
+		VertexBufferIterator(TChar* buffer, u32 stride, u32 offset = 0) : m_Pos(buffer + offset), m_Stride(stride) {}
+
+		T& operator*() const { return *reinterpret_cast<T*>(m_Pos); }
+		T* operator->() const { return reinterpret_cast<T*>(m_Pos); }
+		T& operator[](difference_type index) const { return *reinterpret_cast<T*>(m_Pos + index * m_Stride); }
+
+		VertexBufferIterator& operator++() { m_Pos += m_Stride; return *this; }
+		VertexBufferIterator& operator--() { m_Pos -= m_Stride; return *this; }
+		VertexBufferIterator operator++(int) { VertexBufferIterator it = *this; m_Pos += m_Stride; return it; }
+		VertexBufferIterator operator--(int) { VertexBufferIterator it = *this; m_Pos -= m_Stride; return it; }
+
+		VertexBufferIterator& operator+=(difference_type count) { m_Pos += count * m_Stride; return *this; }
+		VertexBufferIterator& operator-=(difference_type count) { m_Pos -= count * m_Stride; return *this; }
+		VertexBufferIterator operator+(difference_type count) const { VertexBufferIterator it = *this; return it += count; }
+		VertexBufferIterator operator-(difference_type count) const { VertexBufferIterator it = *this; return it -= count; }
+		friend VertexBufferIterator operator+(difference_type count, const VertexBufferIterator& it) { return it + count; }
+
+		difference_type operator-(const VertexBufferIterator& other) const { return (m_Pos - other.m_Pos) / static_cast<difference_type>(m_Stride); }
+
+		bool operator==(const VertexBufferIterator& other) const { return m_Pos == other.m_Pos; }
+		bool operator!=(const VertexBufferIterator& other) const { return m_Pos != other.m_Pos; }
+		bool operator<(const VertexBufferIterator& other) const { return m_Pos < other.m_Pos; }
+		bool operator>(const VertexBufferIterator& other) const { return m_Pos > other.m_Pos; }
+		bool operator<=(const VertexBufferIterator& other) const { return m_Pos <= other.m_Pos; }
+		bool operator>=(const VertexBufferIterator& other) const { return m_Pos >= other.m_Pos; }
+
+		// Pointer to the attribute of current vertex, for passing into batched conversions (see VertexConvert)
+		TChar* GetPointer() const { return m_Pos; }
+		u32 GetStride() const { return m_Stride; }
+	};
+
+	/**
+	 * \brief Range of attributes in vertex buffer, can be used in range-based for loop.
+	 */
+	template<typename T>
+	class VertexBufferRange
+	{
+		VertexBufferIterator<T> m_Begin;
+		u32                     m_Count;
+
+	public:
+		VertexBufferRange(const VertexBufferIterator<T>& begin, u32 count) : m_Begin(begin), m_Count(count) {}
+
+		VertexBufferIterator<T> begin() const { return m_Begin; }
+		VertexBufferIterator<T> end() const { return m_Begin + m_Count; }
+
+		T& operator[](u32 index) const { return m_Begin[index]; }
+		u32 GetSize() const { return m_Count; }
+	};
 }
@@ -0,0 +1,467 @@
+#include "vertexconvert.h"
+
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <immintrin.h>
+
+// F16C is always available on CPUs with AVX2, MSVC doesn't have separate switch for it
+#if defined(__AVX2__) && (defined(__F16C__) || defined(_MSC_VER))
+#define AM_VERTEX_CONVERT_USE_AVX2
+#endif
+
+namespace
+{
+	using namespace rageam::graphics;
+
+	// Attributes are gathered in temporary buffer, converted with SIMD and then scattered back to strided buffer
+	constexpr u32 BATCH_SIZE = 8;
+
+	// -- Float <-> Half
+
+	// See 'float_to_half_fast3_rtne' & 'half_to_float_fast5' by Fabian Giesen,
+	// scalar VertexConvert::FloatToHalf / HalfToFloat are the same algorithm
+	constexpr u32 HALF_F16_MAX = (127 + 16) << 23;		// All floats >= this round to infinity
+	constexpr u32 HALF_MIN_NORMAL = (127 - 14) << 23;	// Smallest float that yields normalized half
+	constexpr u32 HALF_SUBNORMAL_MAGIC = ((127 - 15) + (23 - 10) + 1) << 23;
+	constexpr u32 HALF_NORMAL_BIAS = 0xFFF - ((127 - 15) << 23);
+	constexpr u32 HALF_TO_FLOAT_MAGIC = (254 - 15) << 23;
+
+	// Output lanes are sign-extended, so signed saturating pack keeps low 16 bits intact
+	__m128i FloatToHalf_SSE2(__m128 value)
+	{
+		__m128  sign = _mm_and_ps(value, _mm_castsi128_ps(_mm_set1_epi32(INT32_MIN)));
+		__m128  abs = _mm_xor_ps(value, sign);
+		__m128i absInt = _mm_castps_si128(abs);
+
+		__m128i isNaN = _mm_castps_si128(_mm_cmpunord_ps(abs, abs));
+		__m128i isRegular = _mm_cmpgt_epi32(_mm_set1_epi32(HALF_F16_MAX), absInt);
+		__m128i infOrNaN = _mm_or_si128(_mm_and_si128(isNaN, _mm_set1_epi32(0x200)), _mm_set1_epi32(0x7C00));
+		__m128i isSubnormal = _mm_cmpgt_epi32(_mm_set1_epi32(HALF_MIN_NORMAL), absInt);
+
+		// Float addition rounds mantissa for us
+		__m128  subnormalSum = _mm_add_ps(abs, _mm_castsi128_ps(_mm_set1_epi32(HALF_SUBNORMAL_MAGIC)));
+		__m128i subnormal = _mm_sub_epi32(_mm_castps_si128(subnormalSum), _mm_set1_epi32(HALF_SUBNORMAL_MAGIC));
+
+		// Rebias exponent and round to nearest even
+		__m128i mantissaOdd = _mm_srai_epi32(_mm_slli_epi32(absInt, 31 - 13), 31);
+		__m128i rounded = _mm_sub_epi32(_mm_add_epi32(absInt, _mm_set1_epi32(HALF_NORMAL_BIAS)), mantissaOdd);
+		__m128i normal = _mm_srli_epi32(rounded, 13);
+
+		__m128i finite = _mm_or_si128(_mm_and_si128(isSubnormal, subnormal), _mm_andnot_si128(isSubnormal, normal));
+		__m128i result = _mm_or_si128(_mm_and_si128(isRegular, finite), _mm_andnot_si128(isRegular, infOrNaN));
+		return _mm_or_si128(result, _mm_srai_epi32(_mm_castps_si128(sign), 16));
+	}
+
+	__m128 HalfToFloat_SSE2(__m128i value)
+	{
+		__m128i expMantissa = _mm_and_si128(value, _mm_set1_epi32(0x7FFF));
+		__m128i sign = _mm_slli_epi32(_mm_xor_si128(value, expMantissa), 16);
+		__m128  scaled = _mm_mul_ps(_mm_castsi128_ps(_mm_slli_epi32(expMantissa, 13)), _mm_castsi128_ps(_mm_set1_epi32(HALF_TO_FLOAT_MAGIC)));
+		__m128i isInfNaN = _mm_cmpgt_epi32(expMantissa, _mm_set1_epi32(0x7BFF));
+		__m128  infNaNExp = _mm_and_ps(_mm_castsi128_ps(isInfNaN), _mm_castsi128_ps(_mm_set1_epi32(255 << 23)));
+		return _mm_or_ps(scaled, _mm_or_ps(_mm_castsi128_ps(sign), infNaNExp));
+	}
+
+	// Count must be multiple of 8
+	void FloatToHalf_Batch(const float* in, u16* out, u32 count)
+	{
+#ifdef AM_VERTEX_CONVERT_USE_AVX2
+		for (u32 i = 0; i < count; i += 8)
+		{
+			__m128i halves = _mm256_cvtps_ph(_mm256_loadu_ps(in + i), _MM_FROUND_TO_NEAREST_INT);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), halves);
+		}
+#else
+		for (u32 i = 0; i < count; i += 8)
+		{
+			__m128i lo = FloatToHalf_SSE2(_mm_loadu_ps(in + i));
+			__m128i hi = FloatToHalf_SSE2(_mm_loadu_ps(in + i + 4));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_packs_epi32(lo, hi));
+		}
+#endif
+	}
+
+	// Count must be multiple of 8
+	void HalfToFloat_Batch(const u16* in, float* out, u32 count)
+	{
+#ifdef AM_VERTEX_CONVERT_USE_AVX2
+		for (u32 i = 0; i < count; i += 8)
+		{
+			__m128i halves = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+			_mm256_storeu_ps(out + i, _mm256_cvtph_ps(halves));
+		}
+#else
+		__m128i zero = _mm_setzero_si128();
+		for (u32 i = 0; i < count; i += 8)
+		{
+			__m128i halves = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+			_mm_storeu_ps(out + i, HalfToFloat_SSE2(_mm_unpacklo_epi16(halves, zero)));
+			_mm_storeu_ps(out + i + 4, HalfToFloat_SSE2(_mm_unpackhi_epi16(halves, zero)));
+		}
+#endif
+	}
+
+	template<u32 N>
+	void FloatToHalf_Kernel(const char* src, u32 srcStride, char* dst, u32 dstStride, u32 count)
+	{
+		float floats[BATCH_SIZE * N];
+		u16   halves[BATCH_SIZE * N];
+
+		u32 i = 0;
+		for (; i + BATCH_SIZE <= count; i += BATCH_SIZE)
+		{
+			for (u32 k = 0; k < BATCH_SIZE; k++)
+				memcpy(floats + k * N, src + static_cast<size_t>(i + k) * srcStride, sizeof(float) * N);
+
+			FloatToHalf_Batch(floats, halves, BATCH_SIZE * N);
+
+			for (u32 k = 0; k < BATCH_SIZE; k++)
+				memcpy(dst + static_cast<size_t>(i + k) * dstStride, halves + k * N, sizeof(u16) * N);
+		}
+
+		for (; i < count; i++)
+		{
+			const float* in = reinterpret_cast<const float*>(src + static_cast<size_t>(i) * srcStride);
+			u16* out = reinterpret_cast<u16*>(dst + static_cast<size_t>(i) * dstStride);
+			for (u32 k = 0; k < N; k++)
+				out[k] = VertexConvert::FloatToHalf(in[k]);
+		}
+	}
+
+	template<u32 N>
+	void HalfToFloat_Kernel(const char* src, u32 srcStride, char* dst, u32 dstStride, u32 count)
+	{
+		u16   halves[BATCH_SIZE * N];
+		float floats[BATCH_SIZE * N];
+
+		u32 i = 0;
+		for (; i + BATCH_SIZE <= count; i += BATCH_SIZE)
+		{
+			for (u32 k = 0; k < BATCH_SIZE; k++)
+				memcpy(halves + k * N, src + static_cast<size_t>(i + k) * srcStride, sizeof(u16) * N);
+
+			HalfToFloat_Batch(halves, floats, BATCH_SIZE * N);
+
+			for (u32 k = 0; k < BATCH_SIZE; k++)
+				memcpy(dst + static_cast<size_t>(i + k) * dstStride, floats + k * N, sizeof(float) * N);
+		}
+
+		for (; i < count; i++)
+		{
+			const u16* in = reinterpret_cast<const u16*>(src + static_cast<size_t>(i) * srcStride);
+			float* out = reinterpret_cast<float*>(dst + static_cast<size_t>(i) * dstStride);
+			for (u32 k = 0; k < N; k++)
+				out[k] = VertexConvert::HalfToFloat(in[k]);
+		}
+	}
+
+	// -- Float <-> UNORM8 / SNORM8
+
+	// 4 lanes of 8 bit values, one vertex per lane
+	template<bool Signed>
+	__m128i FloatToNorm8_SSE2(__m128 a, __m128 b, __m128 c, __m128 d)
+	{
+		auto convert = [](__m128 value)
+			{
+				if constexpr (Signed)
+				{
+					// max returns second operand for NaN, so we have to zero it out explicitly
+					value = _mm_and_ps(value, _mm_cmpord_ps(value, value));
+					value = _mm_max_ps(value, _mm_set1_ps(-1.0f));
+					value = _mm_min_ps(value, _mm_set1_ps(1.0f));
+					return _mm_cvtps_epi32(_mm_mul_ps(value, _mm_set1_ps(127.0f)));
+				}
+				else
+				{
+					value = _mm_max_ps(value, _mm_setzero_ps());
+					value = _mm_min_ps(value, _mm_set1_ps(1.0f));
+					return _mm_cvtps_epi32(_mm_mul_ps(value, _mm_set1_ps(255.0f)));
+				}
+			};
+
+		__m128i ab = _mm_packs_epi32(convert(a), convert(b));
+		__m128i cd = _mm_packs_epi32(convert(c), convert(d));
+		if constexpr (Signed)
+			return _mm_packs_epi16(ab, cd);
+		else
+			return _mm_packus_epi16(ab, cd);
+	}
+
+#ifdef AM_VERTEX_CONVERT_USE_AVX2
+	// 8 lanes of 8 bit values, one vertex per lane
+	template<bool Signed>
+	__m256i FloatToNorm8_AVX2(__m256 a, __m256 b, __m256 c, __m256 d)
+	{
+		auto convert = [](__m256 value)
+			{
+				if constexpr (Signed)
+				{
+					value = _mm256_and_ps(value, _mm256_cmp_ps(value, value, _CMP_ORD_Q));
+					value = _mm256_max_ps(value, _mm256_set1_ps(-1.0f));
+					value = _mm256_min_ps(value, _mm256_set1_ps(1.0f));
+					return _mm256_cvtps_epi32(_mm256_mul_ps(value, _mm256_set1_ps(127.0f)));
+				}
+				else
+				{
+					value = _mm256_max_ps(value, _mm256_setzero_ps());
+					value = _mm256_min_ps(value, _mm256_set1_ps(1.0f));
+					return _mm256_cvtps_epi32(_mm256_mul_ps(value, _mm256_set1_ps(255.0f)));
+				}
+			};
+
+		// Packing works within 128 bit lanes, vertices end up interleaved and have to be permuted back
+		__m256i ab = _mm256_packs_epi32(convert(a), convert(b));
+		__m256i cd = _mm256_packs_epi32(convert(c), convert(d));
+		__m256i packed;
+		if constexpr (Signed)
+			packed = _mm256_packs_epi16(ab, cd);
+		else
+			packed = _mm256_packus_epi16(ab, cd);
+		return _mm256_permutevar8x32_epi32(packed, _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7));
+	}
+#endif
+
+	// Source is float[N], N is 3 or 4, missing component is set to 0
+	template<u32 N, bool Signed>
+	void FloatToNorm8x4_Kernel(const char* src, u32 srcStride, char* dst, u32 dstStride, u32 count)
+	{
+		alignas(32) float floats[BATCH_SIZE * 4] = {};
+		alignas(32) u32   packed[BATCH_SIZE];
+
+		u32 i = 0;
+		for (; i + BATCH_SIZE <= count; i += BATCH_SIZE)
+		{
+			for (u32 k = 0; k < BATCH_SIZE; k++)
+				memcpy(floats + k * 4, src + static_cast<size_t>(i + k) * srcStride, sizeof(float) * N);
+
+#ifdef AM_VERTEX_CONVERT_USE_AVX2
+			__m256i result = FloatToNorm8_AVX2<Signed>(
+				_mm256_load_ps(floats), _mm256_load_ps(floats + 8), _mm256_load_ps(floats + 16), _mm256_load_ps(floats + 24));
+			_mm256_store_si256(reinterpret_cast<__m256i*>(packed), result);
+#else
+			__m128i lo = FloatToNorm8_SSE2<Signed>(
+				_mm_load_ps(floats), _mm_load_ps(floats + 4), _mm_load_ps(floats + 8), _mm_load_ps(floats + 12));
+			__m128i hi = FloatToNorm8_SSE2<Signed>(
+				_mm_load_ps(floats + 16), _mm_load_ps(floats + 20), _mm_load_ps(floats + 24), _mm_load_ps(floats + 28));
+			_mm_store_si128(reinterpret_cast<__m128i*>(packed), lo);
+			_mm_store_si128(reinterpret_cast<__m128i*>(packed + 4), hi);
+#endif
+
+			for (u32 k = 0; k < BATCH_SIZE; k++)
+				memcpy(dst + static_cast<size_t>(i + k) * dstStride, packed + k, sizeof(u32));
+		}
+
+		for (; i < count; i++)
+		{
+			const float* in = reinterpret_cast<const float*>(src + static_cast<size_t>(i) * srcStride);
+			u8* out = reinterpret_cast<u8*>(dst + static_cast<size_t>(i) * dstStride);
+			for (u32 k = 0; k < 4; k++)
+			{
+				float value = k < N ? in[k] : 0.0f;
+				out[k] = Signed ? VertexConvert::FloatToSnorm8(value) : VertexConvert::FloatToUnorm8(value);
+			}
+		}
+	}
+
+	void Unorm8x4ToFloat4_Kernel(const char* src, u32 srcStride, char* dst, u32 dstStride, u32 count)
+	{
+		alignas(16) u32 packed[BATCH_SIZE];
+
+		__m128i zero = _mm_setzero_si128();
+		__m128  max = _mm_set1_ps(255.0f);
+
+		u32 i = 0;
+		for (; i + BATCH_SIZE <= count; i += BATCH_SIZE)
+		{
+			for (u32 k = 0; k < BATCH_SIZE; k++)
+				memcpy(packed + k, src + static_cast<size_t>(i + k) * srcStride, sizeof(u32));
+
+			for (u32 k = 0; k < BATCH_SIZE; k += 4)
+			{
+				__m128i bytes = _mm_load_si128(reinterpret_cast<const __m128i*>(packed + k));
+				__m128i lo = _mm_unpacklo_epi8(bytes, zero);
+				__m128i hi = _mm_unpackhi_epi8(bytes, zero);
+
+				// Division instead of multiplication by reciprocal to match scalar result exactly
+				__m128i vertices[4] =
+				{
+					_mm_unpacklo_epi16(lo, zero), _mm_unpackhi_epi16(lo, zero),
+					_mm_unpacklo_epi16(hi, zero), _mm_unpackhi_epi16(hi, zero),
+				};
+				for (u32 j = 0; j < 4; j++)
+				{
+					__m128 value = _mm_div_ps(_mm_cvtepi32_ps(vertices[j]), max);
+					_mm_storeu_ps(reinterpret_cast<float*>(dst + static_cast<size_t>(i + k + j) * dstStride), value);
+				}
+			}
+		}
+
+		for (; i < count; i++)
+		{
+			const u8* in = reinterpret_cast<const u8*>(src + static_cast<size_t>(i) * srcStride);
+			float* out = reinterpret_cast<float*>(dst + static_cast<size_t>(i) * dstStride);
+			for (u32 k = 0; k < 4; k++)
+				out[k] = static_cast<float>(in[k]) / 255.0f;
+		}
+	}
+
+	// -- Normals
+
+	void Float3ToUnorm10x3_Kernel(const char* src, u32 srcStride, char* dst, u32 dstStride, u32 count)
+	{
+		// Structure of arrays, all 3 components are packed in single lane
+		alignas(32) float x[BATCH_SIZE];
+		alignas(32) float y[BATCH_SIZE];
+		alignas(32) float z[BATCH_SIZE];
+		alignas(32) u32   packed[BATCH_SIZE];
+
+		auto toUnorm10 = [](__m128 value)
+			{
+				value = _mm_add_ps(_mm_mul_ps(value, _mm_set1_ps(0.5f)), _mm_set1_ps(0.5f));
+				value = _mm_max_ps(value, _mm_setzero_ps());
+				value = _mm_min_ps(value, _mm_set1_ps(1.0f));
+				return _mm_cvtps_epi32(_mm_mul_ps(value, _mm_set1_ps(1023.0f)));
+			};
+
+		u32 i = 0;
+		for (; i + BATCH_SIZE <= count; i += BATCH_SIZE)
+		{
+			for (u32 k = 0; k < BATCH_SIZE; k++)
+			{
+				const float* in = reinterpret_cast<const float*>(src + static_cast<size_t>(i + k) * srcStride);
+				x[k] = in[0];
+				y[k] = in[1];
+				z[k] = in[2];
+			}
+
+			for (u32 k = 0; k < BATCH_SIZE; k += 4)
+			{
+				__m128i result = toUnorm10(_mm_load_ps(x + k));
+				result = _mm_or_si128(result, _mm_slli_epi32(toUnorm10(_mm_load_ps(y + k)), 10));
+				result = _mm_or_si128(result, _mm_slli_epi32(toUnorm10(_mm_load_ps(z + k)), 20));
+				_mm_store_si128(reinterpret_cast<__m128i*>(packed + k), result);
+			}
+
+			for (u32 k = 0; k < BATCH_SIZE; k++)
+				memcpy(dst + static_cast<size_t>(i + k) * dstStride, packed + k, sizeof(u32));
+		}
+
+		for (; i < count; i++)
+		{
+			const float* in = reinterpret_cast<const float*>(src + static_cast<size_t>(i) * srcStride);
+			u32 value = VertexConvert::PackNormalUnorm10(in[0], in[1], in[2]);
+			memcpy(dst + static_cast<size_t>(i) * dstStride, &value, sizeof(u32));
+		}
+	}
+
+	struct Kernel
+	{
+		DXGI_FORMAT		InFormat;
+		DXGI_FORMAT		OutFormat;
+		VertexConvertFn Fn;
+	};
+
+	constexpr Kernel s_Kernels[] =
+	{
+		{ DXGI_FORMAT_R32_FLOAT,			DXGI_FORMAT_R16_FLOAT,				FloatToHalf_Kernel<1> },
+		{ DXGI_FORMAT_R32G32_FLOAT,			DXGI_FORMAT_R16G16_FLOAT,			FloatToHalf_Kernel<2> },
+		{ DXGI_FORMAT_R32G32B32A32_FLOAT,	DXGI_FORMAT_R16G16B16A16_FLOAT,		FloatToHalf_Kernel<4> },
+		{ DXGI_FORMAT_R16_FLOAT,			DXGI_FORMAT_R32_FLOAT,				HalfToFloat_Kernel<1> },
+		{ DXGI_FORMAT_R16G16_FLOAT,			DXGI_FORMAT_R32G32_FLOAT,			HalfToFloat_Kernel<2> },
+		{ DXGI_FORMAT_R16G16B16A16_FLOAT,	DXGI_FORMAT_R32G32B32A32_FLOAT,		HalfToFloat_Kernel<4> },
+		{ DXGI_FORMAT_R32G32B32A32_FLOAT,	DXGI_FORMAT_R8G8B8A8_UNORM,			FloatToNorm8x4_Kernel<4, false> },
+		{ DXGI_FORMAT_R32G32B32A32_FLOAT,	DXGI_FORMAT_R8G8B8A8_SNORM,			FloatToNorm8x4_Kernel<4, true> },
+		{ DXGI_FORMAT_R32G32B32_FLOAT,		DXGI_FORMAT_R8G8B8A8_SNORM,			FloatToNorm8x4_Kernel<3, true> },
+		{ DXGI_FORMAT_R8G8B8A8_UNORM,		DXGI_FORMAT_R32G32B32A32_FLOAT,		Unorm8x4ToFloat4_Kernel },
+		{ DXGI_FORMAT_R32G32B32_FLOAT,		DXGI_FORMAT_R10G10B10A2_UNORM,		Float3ToUnorm10x3_Kernel },
+	};
+}
+
+rageam::graphics::VertexConvertFn rageam::graphics::VertexConvert::Find(DXGI_FORMAT inFormat, DXGI_FORMAT outFormat)
+{
+	for (const Kernel& kernel : s_Kernels)
+	{
+		if (kernel.InFormat == inFormat && kernel.OutFormat == outFormat)
+			return kernel.Fn;
+	}
+	return nullptr;
+}
+
+void rageam::graphics::VertexConvert::Copy(const char* src, u32 srcStride, char* dst, u32 dstStride, u32 count, u32 attributeSize)
+{
+	// Tightly packed, single copy is enough
+	if (srcStride == attributeSize && dstStride == attributeSize)
+	{
+		memcpy(dst, src, static_cast<size_t>(count) * attributeSize);
+		return;
+	}
+
+	for (u32 i = 0; i < count; i++)
+		memcpy(dst + static_cast<size_t>(i) * dstStride, src + static_cast<size_t>(i) * srcStride, attributeSize);
+}
+
+u16 rageam::graphics::VertexConvert::FloatToHalf(float value)
+{
+	u32 bits = std::bit_cast<u32>(value);
+	u32 sign = (bits >> 16) & 0x8000;
+	u32 abs = bits & 0x7FFFFFFF;
+
+	// Infinity or NaN
+	if (abs >= HALF_F16_MAX)
+		return static_cast<u16>(sign | (abs > 0x7F800000 ? 0x7E00 : 0x7C00));
+
+	// Subnormal, float addition rounds mantissa
+	if (abs < HALF_MIN_NORMAL)
+	{
+		float sum = std::bit_cast<float>(abs) + std::bit_cast<float>(HALF_SUBNORMAL_MAGIC);
+		return static_cast<u16>(sign | (std::bit_cast<u32>(sum) - HALF_SUBNORMAL_MAGIC));
+	}
+
+	u32 mantissaOdd = (abs >> 13) & 1;
+	abs += HALF_NORMAL_BIAS + mantissaOdd;
+	return static_cast<u16>(sign | (abs >> 13));
+}
+
+float rageam::graphics::VertexConvert::HalfToFloat(u16 value)
+{
+	u32 expMantissa = value & 0x7FFF;
+	u32 sign = static_cast<u32>(value & 0x8000) << 16;
+
+	float scaled = std::bit_cast<float>(expMantissa << 13) * std::bit_cast<float>(HALF_TO_FLOAT_MAGIC);
+	u32 bits = std::bit_cast<u32>(scaled);
+	if (expMantissa > 0x7BFF)
+		bits |= 255 << 23;
+	return std::bit_cast<float>(bits | sign);
+}
+
+u8 rageam::graphics::VertexConvert::FloatToUnorm8(float value)
+{
+	value = value > 0.0f ? value : 0.0f; // Also handles NaN
+	value = value < 1.0f ? value : 1.0f;
+	return static_cast<u8>(nearbyintf(value * 255.0f));
+}
+
+u8 rageam::graphics::VertexConvert::FloatToSnorm8(float value)
+{
+	if (std::isnan(value))
+		value = 0.0f;
+	value = value > -1.0f ? value : -1.0f;
+	value = value < 1.0f ? value : 1.0f;
+	return static_cast<u8>(static_cast<s8>(nearbyintf(value * 127.0f)));
+}
+
+u32 rageam::graphics::VertexConvert::FloatToUnorm10(float value)
+{
+	value = value > 0.0f ? value : 0.0f;
+	value = value < 1.0f ? value : 1.0f;
+	return static_cast<u32>(nearbyintf(value * 1023.0f));
+}
+
+u32 rageam::graphics::VertexConvert::PackNormalUnorm10(float x, float y, float z)
+{
+	return
+		FloatToUnorm10(x * 0.5f + 0.5f) |
+		FloatToUnorm10(y * 0.5f + 0.5f) << 10 |
+		FloatToUnorm10(z * 0.5f + 0.5f) << 20;
+}
@@ -0,0 +1,43 @@
+//
+// File: vertexconvert.h
+//
+// Copyright (C) 2023-2024 ranstar74. All rights violated.
+//
+// Part of "Rage Am" Research Project.
+//
+#pragma once
+
+#include "common/types.h"
+
+#include <dxgiformat.h>
+
+namespace rageam::graphics
+{
+	// Converts 'count' attributes from source to destination format, both buffers are strided (for e.g. attribute in vertex buffer)
+	using VertexConvertFn = void(*)(const char* src, u32 srcStride, char* dst, u32 dstStride, u32 count);
+
+	/**
+	 * \brief Batched conversion of vertex attributes between formats. Kernels use SSE2,
+	 * or AVX2 and F16C if project is compiled with them (--avx2 option).
+	 * \n Scalar functions define exact result of every kernel and are used for the remainder:
+	 * \n - Float to half rounds to nearest even, NaN is converted to quiet NaN;
+	 * \n - Float to UNORM / SNORM clamps value to [0, 1] / [-1, 1] and rounds to nearest even, NaN is converted to 0;
+	 * \n - Float3 to R10G10B10A2_UNORM packs normal (dec3n-like) remapping it from [-1, 1] to [0, 1], alpha is set to 0.
+	 */
+	class VertexConvert
+	{
+	public:
+		// Gets kernel that converts attribute from inFormat to outFormat, NULL if there's no such kernel
+		static VertexConvertFn Find(DXGI_FORMAT inFormat, DXGI_FORMAT outFormat);
+
+		// Copies attributes of matching formats
+		static void Copy(const char* src, u32 srcStride, char* dst, u32 dstStride, u32 count, u32 attributeSize);
+
+		static u16   FloatToHalf(float value);
+		static float HalfToFloat(u16 value);
+		static u8    FloatToUnorm8(float value);
+		static u8    FloatToSnorm8(float value);
+		static u32   FloatToUnorm10(float value);
+		static u32   PackNormalUnorm10(float x, float y, float z);
+	};
+}
@@ -63,6 +63,13 @@ namespace rageam
 			return profilerFolder;
 		}
 
+		// data/resource_cache
+		static const file::WPath& GetResourceCacheFolder()
+		{
+			static file::WPath resourceCacheFolder = GetDataFolder() / L"resource_cache";
+			return resourceCacheFolder;
+		}
+
 		// Gets path to RageAm data folder, this folder contains logs, icons, fonts
 		static const file::WPath& GetDataFolder()
 		{
@@ -6,6 +6,9 @@
 #include "am/asset/ui/assetwindowfactory.h"
 #include "am/xml/doc.h"
 #include "rage/grcore/fvf.h"
+#include "rage/paging/builder/builder.h"
+#include "rage/physics/bounds/bvhbuilder.h"
+#include "rage/zlib/parallelstream.h"
 #include "exception/handler.h"
 
 #include <easy/profiler.h>
@@ -124,6 +127,10 @@ void rageam::System::Destroy()
 	asset::AssetFactory::Shutdown();
 	ui::AssetWindowFactory::Shutdown();
 	graphics::ImageCompressor::ShutdownClass();
+	zLibParallelCompressor::ShutdownClass();
+	rage::pgRscBuilder::ShutdownClass();
+	rage::phBvhSahBuilder::ShutdownClass();
+	graphics::MeshSplitter::ShutdownClass();
 	m_MainWorker = nullptr;
 	ExceptionHandler::Shutdown();
 
@@ -159,6 +166,10 @@ void rageam::System::Init(bool withUI)
 	ExceptionHandler::Init();
 	asset::AssetFactory::Init();
 	graphics::ImageCompressor::InitClass();
+	zLibParallelCompressor::InitClass();
+	rage::pgRscBuilder::InitClass();
+	rage::phBvhSahBuilder::InitClass();
+	graphics::MeshSplitter::InitClass();
 	m_ImageCache = std::make_unique<graphics::ImageCache>();
 
 	// Not a render thread in integrated mode, because called from Init launcher function
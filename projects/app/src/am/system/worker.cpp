@@ -6,6 +6,57 @@
 
 thread_local rage::atFixedArray<rageam::BackgroundWorker*, 8> rageam::BackgroundWorker::sm_Stack;
 
+void rageam::BackgroundTask::Wait() const
+{
+	while (!IsFinished())
+	{
+		// Only jobs of the worker that task was scheduled on are executed, jobs of other workers may wait on
+		// locks (or semaphores) held by the job we're nested in. Non-worker threads (UI) never execute jobs
+		if (BackgroundWorker::tl_Worker && m_Worker && m_Worker->TryExecutePendingJob())
+			continue;
+
+		// Nothing to help with, sleep until task changes state
+		eBackgroundTaskState state = m_State;
+		if (state == TASK_STATE_PENDING || state == TASK_STATE_RUNNING)
+			m_State.wait(state);
+	}
+}
+
+void rageam::BackgroundWorker::JobDeque::PushBack(amUPtr<BackgroundJob> job)
+{
+	std::unique_lock lock(m_Mutex);
+	m_Jobs.push_back(std::move(job));
+	m_Empty = false;
+}
+
+amUPtr<rageam::BackgroundJob> rageam::BackgroundWorker::JobDeque::PopBack()
+{
+	if (m_Empty)
+		return nullptr;
+
+	std::unique_lock lock(m_Mutex);
+	if (m_Jobs.empty())
+		return nullptr;
+	amUPtr<BackgroundJob> job = std::move(m_Jobs.back());
+	m_Jobs.pop_back();
+	m_Empty = m_Jobs.empty();
+	return job;
+}
+
+amUPtr<rageam::BackgroundJob> rageam::BackgroundWorker::JobDeque::PopFront()
+{
+	if (m_Empty)
+		return nullptr;
+
+	std::unique_lock lock(m_Mutex);
+	if (m_Jobs.empty())
+		return nullptr;
+	amUPtr<BackgroundJob> job = std::move(m_Jobs.front());
+	m_Jobs.pop_front();
+	m_Empty = m_Jobs.empty();
+	return job;
+}
+
 DWORD rageam::BackgroundWorker::ThreadProc(LPVOID lpParam)
 {
 	ThreadProcArg*     arg = static_cast<ThreadProcArg*>(lpParam);
@@ -14,6 +65,9 @@ DWORD rageam::BackgroundWorker::ThreadProc(LPVOID lpParam)
 	delete arg;
 	arg = nullptr;
 
+	tl_Worker = worker;
+	tl_WorkerID = workerID;
+
 	// Add thread name so it can be seen in debugger
 	{
 		wchar_t nameBuffer[64];
@@ -25,67 +79,142 @@ DWORD rageam::BackgroundWorker::ThreadProc(LPVOID lpParam)
 
 	while (!worker->m_WeAreClosing)
 	{
-		// Wait for the next job
-		amUPtr<BackgroundJob> job;
-		{
-			std::unique_lock lock(worker->m_Mutex);
-			worker->m_Condition.wait(lock, [&]
-				{
-					return worker->m_Jobs.Any() || worker->m_WeAreClosing;
-				});
+		if (worker->TryExecutePendingJob())
+			continue;
 
-			if (worker->m_WeAreClosing)
-				break;
+		// Nothing to execute or steal, wait for the next job.
+		// Pending count is incremented before sleeping count is checked in ::Schedule, so wake up is never lost
+		std::unique_lock lock(worker->m_Mutex);
+		++worker->m_SleepingThreadCount;
+		worker->m_Condition.wait(lock, [&]
+			{
+				return worker->m_PendingJobCount > 0 || worker->m_WeAreClosing;
+			});
+		--worker->m_SleepingThreadCount;
+	}
+	return 0;
+}
 
-			job = std::move(worker->m_Jobs.First());
-			worker->m_Jobs.RemoveAt(0);
-		}
+amPtr<rageam::BackgroundTask> rageam::BackgroundWorker::RunVA(const TLambda& lambda, ConstWString fmt, va_list args)
+{
+	amPtr<BackgroundTask> task = std::make_shared<BackgroundTask>();
+	task->m_State = TASK_STATE_PENDING;
+	task->m_Worker = this;
 
-		Timer timer = Timer::StartNew();
-		auto& task = job->GetTask();
-		task->m_WorkerID = workerID;
-		task->m_State = TASK_STATE_RUNNING;
-		bool success = job->GetLambda()();
-		task->m_Result = std::move(tl_Result);
-		task->m_State = success ? TASK_STATE_SUCCESS : TASK_STATE_FAILED;
-		timer.Stop();
+	wchar_t buffer[256];
+	vswprintf_s(buffer, 256, fmt, args);
 
-		wchar_t buffer[256];
-		if (String::IsNullOrEmpty(job->GetName()))
-			swprintf_s(buffer, 256, L"%hs, %llu ms", success ? "OK" : "FAIL", timer.GetElapsedMilliseconds());
-		else
-			swprintf_s(buffer, 256, L"[%ls] %hs, %llu ms", job->GetName(), success ? "OK" : "FAIL", timer.GetElapsedMilliseconds());
+	Schedule(std::make_unique<BackgroundJob>(task, lambda, buffer));
+	return task;
+}
 
-#ifdef WORKER_ENABLE_LOGGING
-		 AM_TRACEF(L"[W: %hs] wID:%i, %s", worker->m_Name, workerID, buffer);
-#endif
+void rageam::BackgroundWorker::Schedule(amUPtr<BackgroundJob> job)
+{
+	if (tl_Worker == this)
+		m_Deques[tl_WorkerID]->PushBack(std::move(job));
+	else
+		m_SharedDeque.PushBack(std::move(job));
 
-		 if (worker->TaskCallback)
-		 	worker->TaskCallback(buffer);
+	++m_PendingJobCount;
+	if (m_SleepingThreadCount > 0)
+	{
+		std::unique_lock lock(m_Mutex);
+		m_Condition.notify_one();
 	}
-	return 0;
 }
 
-amPtr<rageam::BackgroundTask> rageam::BackgroundWorker::RunVA(const TLambda& lambda, ConstWString fmt, va_list args)
+amUPtr<rageam::BackgroundJob> rageam::BackgroundWorker::TakeJob()
 {
-	std::unique_lock lock(m_Mutex);
+	amUPtr<BackgroundJob> job;
 
-	amPtr<BackgroundTask> task = std::make_shared<BackgroundTask>();
-	task->m_State = TASK_STATE_PENDING;
+	int ownID = tl_Worker == this ? tl_WorkerID : -1;
+	if (ownID != -1)
+		job = m_Deques[ownID]->PopBack();
+
+	if (!job)
+		job = m_SharedDeque.PopFront();
+
+	// Steal the oldest job, starting from the next thread so thieves spread over victims
+	int dequeCount = m_Deques.GetSize();
+	for (int i = 1; i <= dequeCount && !job; i++)
+	{
+		int victimID = (ownID + i) % dequeCount;
+		if (victimID == ownID)
+			continue;
+		job = m_Deques[victimID]->PopFront();
+	}
+
+	if (job)
+		--m_PendingJobCount;
+	return job;
+}
+
+void rageam::BackgroundWorker::ExecuteJob(amUPtr<BackgroundJob> job)
+{
+	// Job may be executed while thread waits for another job that already set its result, preserve it
+	std::any outerResult = std::move(tl_Result);
+	tl_Result.reset();
+
+	Timer timer = Timer::StartNew();
+	auto& task = job->GetTask();
+	task->m_WorkerID = tl_WorkerID;
+	task->m_State = TASK_STATE_RUNNING;
+	task->m_State.notify_all();
+	bool success = job->GetLambda()();
+	task->m_Result = std::move(tl_Result);
+	timer.Stop();
+
+	tl_Result = std::move(outerResult);
+
+	List<amUPtr<BackgroundJob>> continuations;
+	{
+		std::unique_lock lock(task->m_ContinuationMutex);
+		task->m_State = success ? TASK_STATE_SUCCESS : TASK_STATE_FAILED;
+		continuations = std::move(task->m_Continuations);
+	}
+	task->m_State.notify_all();
+
+	for (amUPtr<BackgroundJob>& continuation : continuations)
+		Schedule(std::move(continuation));
+
+#ifndef WORKER_ENABLE_LOGGING
+	if (!TaskCallback)
+		return;
+#endif
 
 	wchar_t buffer[256];
-	vswprintf_s(buffer, 256, fmt, args);
+	if (String::IsNullOrEmpty(job->GetName()))
+		swprintf_s(buffer, 256, L"%hs, %llu ms", success ? "OK" : "FAIL", timer.GetElapsedMilliseconds());
+	else
+		swprintf_s(buffer, 256, L"[%ls] %hs, %llu ms", job->GetName(), success ? "OK" : "FAIL", timer.GetElapsedMilliseconds());
 
-	m_Jobs.Construct(new BackgroundJob(task, lambda, buffer));
+#ifdef WORKER_ENABLE_LOGGING
+	AM_TRACEF(L"[W: %hs] wID:%i, %s", m_Name, tl_WorkerID, buffer);
+#endif
 
-	m_Condition.notify_one();
-	return task;
+	if (TaskCallback)
+		TaskCallback(buffer);
+}
+
+bool rageam::BackgroundWorker::TryExecutePendingJob()
+{
+	amUPtr<BackgroundJob> job = TakeJob();
+	if (!job)
+		return false;
+
+	ExecuteJob(std::move(job));
+	return true;
 }
 
 rageam::BackgroundWorker::BackgroundWorker(ConstString name, int threadCount)
 {
 	m_Name = name;
 	m_ThreadPool.Resize(threadCount);
+	m_Deques.Reserve(threadCount);
+	for (int i = 0; i < threadCount; i++)
+		m_Deques.Construct(new JobDeque());
+
+	// Deques must be created before threads start stealing from them
 	for (u64 i = 0; i < threadCount; i++)
 	{
 		ThreadProcArg* arg = new ThreadProcArg(this, i);
@@ -97,8 +226,11 @@ rageam::BackgroundWorker::BackgroundWorker(ConstString name, int threadCount)
 
 rageam::BackgroundWorker::~BackgroundWorker()
 {
-	m_WeAreClosing = true;
-	m_Condition.notify_all();
+	{
+		std::unique_lock lock(m_Mutex);
+		m_WeAreClosing = true;
+		m_Condition.notify_all();
+	}
 
 	for (HANDLE thread : m_ThreadPool)
 	{
@@ -130,10 +262,34 @@ amPtr<rageam::BackgroundTask> rageam::BackgroundWorker::Run(const TLambda& lambd
 	return Run(lambda, L"");
 }
 
+amPtr<rageam::BackgroundTask> rageam::BackgroundWorker::ContinueWith(const amPtr<BackgroundTask>& task, const TLambda& lambda)
+{
+	BackgroundWorker* worker = task->m_Worker;
+	AM_ASSERTS(worker);
+
+	amPtr<BackgroundTask> continuationTask = std::make_shared<BackgroundTask>();
+	continuationTask->m_State = TASK_STATE_PENDING;
+	continuationTask->m_Worker = worker;
+
+	amUPtr<BackgroundJob> job = std::make_unique<BackgroundJob>(continuationTask, lambda, L"");
+	{
+		std::unique_lock lock(task->m_ContinuationMutex);
+		if (!task->IsFinished())
+		{
+			task->m_Continuations.Emplace(std::move(job));
+			return continuationTask;
+		}
+	}
+
+	// Task is already finished, nothing to wait for
+	worker->Schedule(std::move(job));
+	return continuationTask;
+}
+
 bool rageam::BackgroundWorker::WaitFor(const Tasks& tasks)
 {
 	bool success = true;
-	for (amPtr<BackgroundTask>& task : tasks)
+	for (const amPtr<BackgroundTask>& task : tasks)
 	{
 		task->Wait();
 		if (!task->IsSuccess())
@@ -11,6 +11,7 @@
 #include "am/system/ptr.h"
 #include "am/types.h"
 
+#include <deque>
 #include <functional>
 #include <mutex>
 #include <Windows.h>
@@ -28,6 +29,34 @@ namespace rageam
 		TASK_STATE_FAILED,
 	};
 
+	class BackgroundTask;
+	class BackgroundWorker;
+
+	using BackgroundTaskFn = std::function<bool()>;
+
+	/**
+	 * \brief Scheduled task function, owned by worker queue until executed.
+	 */
+	class BackgroundJob
+	{
+		static constexpr u32 TASK_NAME_MAX = 256;
+
+		amPtr<BackgroundTask> m_Task;
+		BackgroundTaskFn      m_Lambda;
+		wchar_t               m_Name[TASK_NAME_MAX];
+
+	public:
+		BackgroundJob(amPtr<BackgroundTask> task, BackgroundTaskFn lambda, ConstWString name)
+			: m_Task(std::move(task)), m_Lambda(std::move(lambda))
+		{
+			String::Copy(m_Name, TASK_NAME_MAX, name);
+		}
+
+		amPtr<BackgroundTask>& GetTask() { return m_Task; }
+		BackgroundTaskFn&      GetLambda() { return m_Lambda; }
+		ConstWString           GetName() const { return m_Name; }
+	};
+
 	/**
 	 * \brief State of background task.
 	 */
@@ -40,6 +69,11 @@ namespace rageam
 		std::any m_Result;
 		// For debugging
 		int m_WorkerID = -1;
+		// Worker that task was scheduled on, waiting thread helps to execute its pending jobs
+		BackgroundWorker* m_Worker = nullptr;
+		// Jobs that are scheduled once this task is finished, see BackgroundWorker::ContinueWith
+		List<amUPtr<BackgroundJob>> m_Continuations;
+		std::mutex                  m_ContinuationMutex;
 
 	public:
 		eBackgroundTaskState GetState() const { return m_State; }
@@ -47,7 +81,9 @@ namespace rageam
 		bool IsSuccess()  const { return m_State == TASK_STATE_SUCCESS; }
 		bool IsFinished() const { return m_State == TASK_STATE_SUCCESS || m_State == TASK_STATE_FAILED; }
 
-		void Wait() const { while (!IsFinished()) { /* ... */ } }
+		// Blocks until task is finished. Worker threads execute pending jobs of the task's worker meanwhile,
+		// so task that waits for tasks on the same worker cannot deadlock it
+		void Wait() const;
 
 		// This value can be safely accessed if IsSuccess returns True.
 		template<typename T>
@@ -66,29 +102,29 @@ namespace rageam
 
 	/**
 	 * \brief Dispatcher of long-running background tasks.
+	 * Every thread owns a deque of jobs, jobs scheduled from worker thread are pushed to its own deque and
+	 * executed in LIFO order (hot in cache), idle threads steal the oldest jobs from other deques.
+	 * Jobs scheduled from outside threads go to shared injection queue.
 	 */
 	class BackgroundWorker
 	{
-		using TLambda = std::function<bool()>;
+		friend class BackgroundTask;
 
-		class BackgroundJob
-		{
-			static constexpr u32 TASK_NAME_MAX = 256;
+		using TLambda = BackgroundTaskFn;
 
-			amPtr<BackgroundTask> m_Task;
-			TLambda               m_Lambda;
-			wchar_t               m_Name[TASK_NAME_MAX];
+		/**
+		 * \brief Deque of pending jobs, owner thread works on the back, thieves take from the front.
+		 */
+		class JobDeque
+		{
+			std::deque<amUPtr<BackgroundJob>> m_Jobs;
+			std::mutex                        m_Mutex;
+			std::atomic_bool                  m_Empty = true; // Lets thieves skip empty deques without locking
 
 		public:
-			BackgroundJob(amPtr<BackgroundTask> task, TLambda lambda, ConstWString name)
-				: m_Task(std::move(task)), m_Lambda(std::move(lambda))
-			{
-				String::Copy(m_Name, TASK_NAME_MAX, name);
-			}
-
-			amPtr<BackgroundTask>& GetTask() { return m_Task; }
-			TLambda&               GetLambda() { return m_Lambda; }
-			ConstWString           GetName() const { return m_Name; }
+			void PushBack(amUPtr<BackgroundJob> job);
+			amUPtr<BackgroundJob> PopBack();
+			amUPtr<BackgroundJob> PopFront();
 		};
 
 		struct ThreadProcArg
@@ -99,18 +135,31 @@ namespace rageam
 
 		ConstString					m_Name;
 		List<HANDLE>                m_ThreadPool;
-		List<amUPtr<BackgroundJob>> m_Jobs;
-		std::mutex                  m_Mutex;
+		List<amUPtr<JobDeque>>      m_Deques;		// One per thread, indexed by worker ID
+		JobDeque                    m_SharedDeque;	// Jobs scheduled from non-worker threads
+		std::atomic_int             m_PendingJobCount = 0;
+		std::atomic_int             m_SleepingThreadCount = 0;
+		std::mutex                  m_Mutex;		// Only guards sleeping threads
 		std::condition_variable     m_Condition;
 		std::atomic_bool			m_WeAreClosing = false;
 
 		static thread_local rage::atFixedArray<BackgroundWorker*, 8> sm_Stack;
 		static inline thread_local std::any tl_Result; // Per-worker unique result value, set from lambda function
+		// Worker that owns current thread, NULL for non-worker threads
+		static inline thread_local BackgroundWorker* tl_Worker = nullptr;
+		static inline thread_local int tl_WorkerID = -1;
 		static inline BackgroundWorker* sm_MainInstance = nullptr;
 
 		static DWORD ThreadProc(LPVOID lpParam);
 		amPtr<BackgroundTask> RunVA(const TLambda& lambda, ConstWString fmt, va_list args);
 
+		void Schedule(amUPtr<BackgroundJob> job);
+		// Own deque first, then shared one, then steal from other threads
+		amUPtr<BackgroundJob> TakeJob();
+		void ExecuteJob(amUPtr<BackgroundJob> job);
+		// Executes single pending job on current thread, returns False if there was nothing to execute
+		bool TryExecutePendingJob();
+
 	public:
 		BackgroundWorker(ConstString name, int threadCount);
 		~BackgroundWorker();
@@ -119,6 +168,11 @@ namespace rageam
 		PRINTF_ATTR(2, 3)  static amPtr<BackgroundTask> Run(const TLambda& lambda, ConstWString fmt, ...);
 		static amPtr<BackgroundTask>                    Run(const TLambda& lambda);
 
+		/**
+		 * \brief Schedules lambda on the same worker once given task is finished (regardless of whether it succeeded).
+		 */
+		static amPtr<BackgroundTask> ContinueWith(const amPtr<BackgroundTask>& task, const TLambda& lambda);
+
 		/**
 		 * \brief Pauses current thread until given list of tasks ran to completion state (either TASK_STATE_SUCCESS or TASK_STATE_FAILED).
 		 * \return True if all tasks were finished with TASK_STATE_SUCCESS or False if either of the tasks was finished with TASK_STATE_FAILED.
@@ -135,11 +189,12 @@ namespace rageam
 		static void Pop() { sm_Stack.RemoveLast(); }
 		static BackgroundWorker* GetInstance()
 		{
-			// Initialize current thread...
+			// Initialize current thread... worker threads schedule nested tasks on their own worker
 			if (!sm_Stack.Any())
 			{
-				AM_ASSERTS(sm_MainInstance);
-				sm_Stack.Add(sm_MainInstance);
+				BackgroundWorker* instance = tl_Worker ? tl_Worker : sm_MainInstance;
+				AM_ASSERTS(instance);
+				sm_Stack.Add(instance);
 			}
 
 			return sm_Stack.Last();
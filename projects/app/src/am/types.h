@@ -4,6 +4,7 @@
 #include "rage/atl/datahash.h"
 #include "rage/atl/fixedarray.h"
 #include "rage/atl/map.h"
+#include "rage/atl/flatmap.h"
 #include "rage/atl/string.h"
 #include "rage/framework/nameregistrar.h"
 #include "rage/framework/pool.h"
@@ -52,6 +53,10 @@ namespace rageam
 	template<typename TValue, typename THashFn = rage::atMapHashFn<TValue>>
 	using HashSet = rage::atMap<TValue, THashFn>;
 
+	// Value set with open addressing, faster lookups but can't be used in resources
+	template<typename TValue, typename THashFn = rage::atMapHashFn<TValue>>
+	using FlatHashSet = rage::atFlatMap<TValue, THashFn>;
+
 	template<typename T>
 	using Pool = rage::fwPool<T>;
 	using PoolIndex = u32;
@@ -2,6 +2,10 @@
 
 #include "common/types.h"
 
+#include <array>
+#include <cstring>
+#include <immintrin.h>
+
 namespace rage
 {
 	inline u32 atPartialDataHash(const void* buffer, size_t size, u32 seed = 0)
@@ -25,4 +29,264 @@ namespace rage
 		hash += hash << 15;
 		return hash;
 	}
+
+	// Generates pseudo-random secret for atFastHash, see splitmix64
+	template<size_t Size>
+	constexpr std::array<u64, Size> atFastHashMakeSecret(u64 state)
+	{
+		std::array<u64, Size> secret = {};
+		for (size_t i = 0; i < Size; i++)
+		{
+			state += 0x9E3779B97F4A7C15;
+			u64 z = state;
+			z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9;
+			z = (z ^ (z >> 27)) * 0x94D049BB133111EB;
+			secret[i] = z ^ (z >> 31);
+		}
+		return secret;
+	}
+
+	/**
+	 * \brief Fast 64 bit content hash for large buffers (pixel data, resource chunks), XXH3-like construction.
+	 * Input is processed in 64 byte stripes by 8 independent 64 bit accumulators, this maps directly on SSE2 / AVX2.
+	 * All implementations (scalar, SSE2, AVX2) produce identical result, so hashes can be safely stored on disk.
+	 * NOTE: Not compatible with atDataHash, must not be used for anything that game hashes!
+	 */
+	class atFastHash
+	{
+		static constexpr size_t STRIPE_SIZE = 64;
+		static constexpr size_t STRIPE_LANES = STRIPE_SIZE / sizeof(u64);
+		static constexpr size_t STRIPES_PER_BLOCK = 16;
+		static constexpr size_t BLOCK_SIZE = STRIPE_SIZE * STRIPES_PER_BLOCK; // Accumulators are scrambled after every block
+		// Every stripe in block uses keys shifted by one lane, so swapping two stripes changes the hash
+		static constexpr size_t SCRAMBLE_KEYS = STRIPES_PER_BLOCK;
+		static constexpr size_t LAST_STRIPE_KEYS = STRIPES_PER_BLOCK + 1;
+		static constexpr size_t MERGE_KEYS = 3;
+		static constexpr size_t SECRET_LANES = LAST_STRIPE_KEYS + STRIPE_LANES;
+
+		static constexpr u64 PRIME32_1 = 0x9E3779B1;
+		static constexpr u64 PRIME32_2 = 0x85EBCA77;
+		static constexpr u64 PRIME32_3 = 0xC2B2AE3D;
+		static constexpr u64 PRIME64_1 = 0x9E3779B185EBCA87;
+		static constexpr u64 PRIME64_2 = 0xC2B2AE3D27D4EB4F;
+		static constexpr u64 PRIME64_3 = 0x165667B19E3779F9;
+		static constexpr u64 PRIME64_4 = 0x85EBCA77C2B2AE63;
+		static constexpr u64 PRIME64_5 = 0x27D4EB2F165667C5;
+
+		static constexpr std::array<u64, SECRET_LANES> DEFAULT_SECRET = atFastHashMakeSecret<SECRET_LANES>(0x5241474541);
+
+		static u64 Read64(const u8* data)
+		{
+			u64 value;
+			memcpy(&value, data, sizeof(u64));
+			return value;
+		}
+
+		// Folds 128 bit product of two 64 bit values
+		static u64 Mul128Fold64(u64 lhs, u64 rhs)
+		{
+			u64 lo = (lhs & 0xFFFFFFFF) * (rhs & 0xFFFFFFFF);
+			u64 mid0 = (lhs >> 32) * (rhs & 0xFFFFFFFF);
+			u64 mid1 = (lhs & 0xFFFFFFFF) * (rhs >> 32);
+			u64 hi = (lhs >> 32) * (rhs >> 32);
+			u64 cross = (lo >> 32) + (mid0 & 0xFFFFFFFF) + mid1;
+			u64 high = hi + (mid0 >> 32) + (cross >> 32);
+			u64 low = (cross << 32) | (lo & 0xFFFFFFFF);
+			return low ^ high;
+		}
+
+		static u64 Avalanche(u64 hash)
+		{
+			hash ^= hash >> 37;
+			hash *= 0x165667919E3779F9;
+			hash ^= hash >> 32;
+			return hash;
+		}
+
+		static void AccumulateScalar(u64* acc, const u8* data, const u64* keys, size_t stripeCount)
+		{
+			for (size_t n = 0; n < stripeCount; n++)
+			{
+				const u8* stripe = data + n * STRIPE_SIZE;
+				for (size_t i = 0; i < STRIPE_LANES; i++)
+				{
+					u64 dataValue = Read64(stripe + i * sizeof(u64));
+					u64 dataKey = dataValue ^ keys[n + i];
+					acc[i ^ 1] += dataValue;
+					acc[i] += (dataKey & 0xFFFFFFFF) * (dataKey >> 32);
+				}
+			}
+		}
+
+		static void ScrambleScalar(u64* acc, const u64* keys)
+		{
+			for (size_t i = 0; i < STRIPE_LANES; i++)
+			{
+				u64 value = acc[i];
+				value ^= value >> 47;
+				value ^= keys[i];
+				acc[i] = value * PRIME32_1;
+			}
+		}
+
+#if defined(__AVX2__)
+		static void AccumulateAVX2(u64* acc, const u8* data, const u64* keys, size_t stripeCount)
+		{
+			__m256i acc0 = _mm256_load_si256(reinterpret_cast<const __m256i*>(acc));
+			__m256i acc1 = _mm256_load_si256(reinterpret_cast<const __m256i*>(acc + 4));
+			for (size_t n = 0; n < stripeCount; n++)
+			{
+				const u8* stripe = data + n * STRIPE_SIZE;
+				__m256i data0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(stripe));
+				__m256i data1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(stripe + 32));
+				__m256i key0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(keys + n));
+				__m256i key1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(keys + n + 4));
+				__m256i dataKey0 = _mm256_xor_si256(data0, key0);
+				__m256i dataKey1 = _mm256_xor_si256(data1, key1);
+				// Low 32 bits * high 32 bits of every lane
+				__m256i product0 = _mm256_mul_epu32(dataKey0, _mm256_srli_epi64(dataKey0, 32));
+				__m256i product1 = _mm256_mul_epu32(dataKey1, _mm256_srli_epi64(dataKey1, 32));
+				// Data is added to neighbour lane (i ^ 1)
+				__m256i swapped0 = _mm256_shuffle_epi32(data0, _MM_SHUFFLE(1, 0, 3, 2));
+				__m256i swapped1 = _mm256_shuffle_epi32(data1, _MM_SHUFFLE(1, 0, 3, 2));
+				acc0 = _mm256_add_epi64(acc0, _mm256_add_epi64(product0, swapped0));
+				acc1 = _mm256_add_epi64(acc1, _mm256_add_epi64(product1, swapped1));
+			}
+			_mm256_store_si256(reinterpret_cast<__m256i*>(acc), acc0);
+			_mm256_store_si256(reinterpret_cast<__m256i*>(acc + 4), acc1);
+		}
+
+		static void ScrambleAVX2(u64* acc, const u64* keys)
+		{
+			const __m256i prime = _mm256_set1_epi32(static_cast<int>(PRIME32_1));
+			for (size_t i = 0; i < STRIPE_LANES; i += 4)
+			{
+				__m256i value = _mm256_load_si256(reinterpret_cast<const __m256i*>(acc + i));
+				__m256i key = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(keys + i));
+				value = _mm256_xor_si256(value, _mm256_srli_epi64(value, 47));
+				value = _mm256_xor_si256(value, key);
+				// 64 bit by 32 bit multiplication
+				__m256i productLo = _mm256_mul_epu32(value, prime);
+				__m256i productHi = _mm256_mul_epu32(_mm256_srli_epi64(value, 32), prime);
+				value = _mm256_add_epi64(productLo, _mm256_slli_epi64(productHi, 32));
+				_mm256_store_si256(reinterpret_cast<__m256i*>(acc + i), value);
+			}
+		}
+#endif
+
+#if defined(_M_X64) || defined(__SSE2__)
+		static void AccumulateSSE2(u64* acc, const u8* data, const u64* keys, size_t stripeCount)
+		{
+			__m128i accs[4];
+			for (size_t i = 0; i < 4; i++)
+				accs[i] = _mm_load_si128(reinterpret_cast<const __m128i*>(acc + i * 2));
+			for (size_t n = 0; n < stripeCount; n++)
+			{
+				const u8* stripe = data + n * STRIPE_SIZE;
+				for (size_t i = 0; i < 4; i++)
+				{
+					__m128i dataValue = _mm_loadu_si128(reinterpret_cast<const __m128i*>(stripe + i * 16));
+					__m128i key = _mm_loadu_si128(reinterpret_cast<const __m128i*>(keys + n + i * 2));
+					__m128i dataKey = _mm_xor_si128(dataValue, key);
+					__m128i product = _mm_mul_epu32(dataKey, _mm_srli_epi64(dataKey, 32));
+					__m128i swapped = _mm_shuffle_epi32(dataValue, _MM_SHUFFLE(1, 0, 3, 2));
+					accs[i] = _mm_add_epi64(accs[i], _mm_add_epi64(product, swapped));
+				}
+			}
+			for (size_t i = 0; i < 4; i++)
+				_mm_store_si128(reinterpret_cast<__m128i*>(acc + i * 2), accs[i]);
+		}
+
+		static void ScrambleSSE2(u64* acc, const u64* keys)
+		{
+			const __m128i prime = _mm_set1_epi32(static_cast<int>(PRIME32_1));
+			for (size_t i = 0; i < STRIPE_LANES; i += 2)
+			{
+				__m128i value = _mm_load_si128(reinterpret_cast<const __m128i*>(acc + i));
+				__m128i key = _mm_loadu_si128(reinterpret_cast<const __m128i*>(keys + i));
+				value = _mm_xor_si128(value, _mm_srli_epi64(value, 47));
+				value = _mm_xor_si128(value, key);
+				__m128i productLo = _mm_mul_epu32(value, prime);
+				__m128i productHi = _mm_mul_epu32(_mm_srli_epi64(value, 32), prime);
+				value = _mm_add_epi64(productLo, _mm_slli_epi64(productHi, 32));
+				_mm_store_si128(reinterpret_cast<__m128i*>(acc + i), value);
+			}
+		}
+#endif
+
+		template<void(*Accumulate)(u64*, const u8*, const u64*, size_t), void(*Scramble)(u64*, const u64*)>
+		static u64 ComputeImpl(const void* buffer, size_t size, u64 seed)
+		{
+			const u8* data = static_cast<const u8*>(buffer);
+
+			// Seed is mixed in secret, so it affects every stripe
+			u64 keys[SECRET_LANES];
+			for (size_t i = 0; i < SECRET_LANES; i++)
+				keys[i] = DEFAULT_SECRET[i] + (i & 1 ? 0 - seed : seed);
+
+			alignas(32) u64 acc[STRIPE_LANES] =
+			{
+				PRIME32_3, PRIME64_1, PRIME64_2, PRIME64_3, PRIME64_4, PRIME32_2, PRIME64_5, PRIME32_1,
+			};
+
+			if (size > STRIPE_SIZE)
+			{
+				// Last stripe is always processed separately, it overlaps with previous data if size is not multiple of stripe size
+				size_t blockCount = (size - 1) / BLOCK_SIZE;
+				for (size_t i = 0; i < blockCount; i++)
+				{
+					Accumulate(acc, data + i * BLOCK_SIZE, keys, STRIPES_PER_BLOCK);
+					Scramble(acc, keys + SCRAMBLE_KEYS);
+				}
+
+				size_t stripeCount = ((size - 1) - blockCount * BLOCK_SIZE) / STRIPE_SIZE;
+				Accumulate(acc, data + blockCount * BLOCK_SIZE, keys, stripeCount);
+				Accumulate(acc, data + size - STRIPE_SIZE, keys + LAST_STRIPE_KEYS, 1);
+			}
+			else if (size > 0)
+			{
+				// Zero-padded, size is accounted in the final mix
+				alignas(32) u8 stripe[STRIPE_SIZE] = {};
+				memcpy(stripe, data, size);
+				Accumulate(acc, stripe, keys + LAST_STRIPE_KEYS, 1);
+			}
+
+			u64 result = size * PRIME64_1;
+			for (size_t i = 0; i < STRIPE_LANES; i += 2)
+				result += Mul128Fold64(acc[i] ^ keys[MERGE_KEYS + i], acc[i + 1] ^ keys[MERGE_KEYS + i + 1]);
+			return Avalanche(result);
+		}
+
+	public:
+		// Uses the widest SIMD instruction set that project is compiled with
+		static u64 Compute(const void* buffer, size_t size, u64 seed = 0)
+		{
+#if defined(__AVX2__)
+			return ComputeImpl<AccumulateAVX2, ScrambleAVX2>(buffer, size, seed);
+#elif defined(_M_X64) || defined(__SSE2__)
+			return ComputeImpl<AccumulateSSE2, ScrambleSSE2>(buffer, size, seed);
+#else
+			return ComputeImpl<AccumulateScalar, ScrambleScalar>(buffer, size, seed);
+#endif
+		}
+
+		// Reference implementation without SIMD
+		static u64 ComputeScalar(const void* buffer, size_t size, u64 seed = 0)
+		{
+			return ComputeImpl<AccumulateScalar, ScrambleScalar>(buffer, size, seed);
+		}
+	};
+
+	// Fast 64 bit hash for large buffers, see atFastHash. Use atDataHash for anything game-related
+	inline u64 atDataHash64(const void* buffer, size_t size, u64 seed = 0)
+	{
+		return atFastHash::Compute(buffer, size, seed);
+	}
+
+	// Folds 64 bit hash to 32 bits for containers that use 32 bit keys
+	inline u32 atDataHash64To32(const void* buffer, size_t size, u64 seed = 0)
+	{
+		u64 hash = atDataHash64(buffer, size, seed);
+		return static_cast<u32>(hash) ^ static_cast<u32>(hash >> 32);
+	}
 }
@@ -0,0 +1,608 @@
+//
+// File: flatmap.h
+//
+// Copyright (C) 2023-2024 ranstar74. All rights violated.
+//
+// Part of "Rage Am" Research Project.
+//
+#pragma once
+
+#include "map.h"
+#include "am/system/asserts.h"
+#include "rage/system/new.h"
+
+#include <bit>
+
+#if defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define AT_FLAT_MAP_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace rage
+{
+	// Slots are matched only by hash, the same way as in atMap
+	template<typename TValue>
+	struct atFlatMapHashEqualFn
+	{
+		bool operator()(const TValue&, const TValue&) const { return true; }
+	};
+
+	// Slots are matched by hash and full value, guards from hash collisions
+	template<typename TValue>
+	struct atFlatMapKeyEqualFn
+	{
+		bool operator()(const TValue& lhs, const TValue& rhs) const { return lhs == rhs; }
+	};
+
+	/**
+	 * \brief Control bytes of slot group, all 16 bytes are compared at once with SSE2.
+	 * Full slot stores 7 bits of hash, empty and deleted slots have the highest bit set.
+	 */
+	struct atFlatMapGroup
+	{
+		static constexpr u32 WIDTH = 16;
+		static constexpr u8  CTRL_EMPTY = 0x80;
+		static constexpr u8  CTRL_DELETED = 0xFE;
+
+#ifdef AT_FLAT_MAP_SSE2
+		__m128i Ctrl;
+
+		atFlatMapGroup(const u8* ctrl) { Ctrl = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ctrl)); }
+
+		u32 Match(u8 h2) const { return _mm_movemask_epi8(_mm_cmpeq_epi8(Ctrl, _mm_set1_epi8(static_cast<char>(h2)))); }
+		u32 MatchEmpty() const { return _mm_movemask_epi8(_mm_cmpeq_epi8(Ctrl, _mm_set1_epi8(static_cast<char>(CTRL_EMPTY)))); }
+		u32 MatchEmptyOrDeleted() const { return _mm_movemask_epi8(Ctrl); }
+#else
+		const u8* Ctrl;
+
+		atFlatMapGroup(const u8* ctrl) { Ctrl = ctrl; }
+
+		u32 Match(u8 h2) const
+		{
+			u32 mask = 0;
+			for (u32 i = 0; i < WIDTH; i++)
+				mask |= static_cast<u32>(Ctrl[i] == h2) << i;
+			return mask;
+		}
+		u32 MatchEmpty() const { return Match(CTRL_EMPTY); }
+		u32 MatchEmptyOrDeleted() const
+		{
+			u32 mask = 0;
+			for (u32 i = 0; i < WIDTH; i++)
+				mask |= static_cast<u32>(Ctrl[i] >> 7) << i;
+			return mask;
+		}
+#endif
+		u32 MatchFull() const { return ~MatchEmptyOrDeleted() & 0xFFFF; }
+
+		static u32 FirstIndex(u32 mask) { return std::countr_zero(mask); }
+	};
+
+	template<typename TValue, typename THashFn, typename TEqualFn>
+	class atFlatMapIterator;
+
+	/**
+	 * \brief Open addressing hash table with SIMD probing of control bytes (Swiss table).
+	 * Values are stored in place together with hash, lookups don't chase pointers and inserts don't allocate
+	 * until table grows. API is the same as in atMap, when TEqualFn is atFlatMapKeyEqualFn functions that
+	 * accept value compare full value in addition to hash, functions that accept only hash compare only hash.
+	 * \n Unlike atMap, this is runtime only container and can't be placed in resource.
+	 */
+	template<typename TValue, typename THashFn = atMapHashFn<TValue>, typename TEqualFn = atFlatMapHashEqualFn<TValue>>
+	class atFlatMap
+	{
+		using Iterator = atFlatMapIterator<TValue, THashFn, TEqualFn>;
+		using Group = atFlatMapGroup;
+
+		friend class atFlatMapIterator<TValue, THashFn, TEqualFn>;
+
+		static constexpr u32 MIN_CAPACITY = Group::WIDTH;
+
+		struct Slot
+		{
+			u32    HashKey;
+			TValue Value;
+		};
+
+		Slot* m_Slots = nullptr;
+		u8*   m_Ctrl = nullptr;
+		u32   m_Capacity = 0;		// Power of two, at least group width
+		u32   m_UsedSlotCount = 0;
+		u32   m_GrowthLeft = 0;		// Number of empty slots that can be used before rehashing, deleted slots are not counted
+
+		// Load factor is 7/8
+		static u32 GetMaxLoad(u32 capacity) { return capacity - capacity / 8; }
+
+		// Hashes of atMapHashFn are not uniform (integers are used as is), spread them over all bits
+		static u64 Mix(u32 hash) { return static_cast<u64>(hash) * 0x9E3779B97F4A7C15ull; }
+		static u8  GetH2(u64 mixed) { return static_cast<u8>(mixed >> 57); }
+		u32 GetStartGroup(u64 mixed) const { return static_cast<u32>(mixed >> 25) & (m_Capacity / Group::WIDTH - 1); }
+
+		u32 GetHash(const TValue& value) const
+		{
+			THashFn fn{};
+			return fn(value);
+		}
+
+		bool IsFull(u32 index) const { return (m_Ctrl[index] & Group::CTRL_EMPTY) == 0; }
+
+		// Value is optional, if not specified only hashes are compared
+		Slot* FindSlot(u32 hash, const TValue* value, u32* outIndex = nullptr) const
+		{
+			if (m_UsedSlotCount == 0)
+				return nullptr;
+
+			TEqualFn equalFn{};
+			u64 mixed = Mix(hash);
+			u8  h2 = GetH2(mixed);
+			u32 groupMask = m_Capacity / Group::WIDTH - 1;
+			u32 group = GetStartGroup(mixed);
+
+			// Triangular probing visits every group once when group count is power of two
+			for (u32 step = 1; step <= groupMask + 1; step++)
+			{
+				u32 groupStart = group * Group::WIDTH;
+				Group ctrl(m_Ctrl + groupStart);
+				for (u32 match = ctrl.Match(h2); match != 0; match &= match - 1)
+				{
+					u32 index = groupStart + Group::FirstIndex(match);
+					Slot& slot = m_Slots[index];
+					if (slot.HashKey == hash && (!value || equalFn(slot.Value, *value)))
+					{
+						if (outIndex) *outIndex = index;
+						return &slot;
+					}
+				}
+
+				// Slot would have been placed in this group if it was in the table
+				if (ctrl.MatchEmpty())
+					return nullptr;
+
+				group = (group + step) & groupMask;
+			}
+			return nullptr;
+		}
+
+		// Finds the first empty or deleted slot in probe sequence of the hash
+		u32 FindFreeSlot(u64 mixed) const
+		{
+			u32 groupMask = m_Capacity / Group::WIDTH - 1;
+			u32 group = GetStartGroup(mixed);
+			for (u32 step = 1;; step++)
+			{
+				u32 groupStart = group * Group::WIDTH;
+				u32 match = Group(m_Ctrl + groupStart).MatchEmptyOrDeleted();
+				if (match != 0)
+					return groupStart + Group::FirstIndex(match);
+
+				group = (group + step) & groupMask;
+				AM_ASSERT(step <= groupMask, "atFlatMap::FindFreeSlot() -> Table is full!");
+			}
+		}
+
+		void Allocate(u32 capacity)
+		{
+			// Slots first to keep them aligned, control bytes go after them
+			size_t slotsSize = static_cast<size_t>(capacity) * sizeof(Slot);
+			char* block = static_cast<char*>(rage_malloc(slotsSize + capacity, alignof(Slot) > 16 ? alignof(Slot) : 16));
+			m_Slots = reinterpret_cast<Slot*>(block);
+			m_Ctrl = reinterpret_cast<u8*>(block + slotsSize);
+			memset(m_Ctrl, Group::CTRL_EMPTY, capacity);
+			m_Capacity = capacity;
+			m_GrowthLeft = GetMaxLoad(capacity) - m_UsedSlotCount;
+		}
+
+		// Reallocates table to given capacity, also gets rid of deleted slots
+		void Rehash(u32 newCapacity)
+		{
+			Slot* oldSlots = m_Slots;
+			u8*   oldCtrl = m_Ctrl;
+			u32   oldCapacity = m_Capacity;
+
+			Allocate(newCapacity);
+			for (u32 i = 0; i < oldCapacity; i++)
+			{
+				if (oldCtrl[i] & Group::CTRL_EMPTY)
+					continue;
+
+				Slot& oldSlot = oldSlots[i];
+				u64 mixed = Mix(oldSlot.HashKey);
+				u32 index = FindFreeSlot(mixed);
+				m_Ctrl[index] = GetH2(mixed);
+				m_Slots[index].HashKey = oldSlot.HashKey;
+				new (&m_Slots[index].Value) TValue(std::move(oldSlot.Value));
+				oldSlot.Value.~TValue();
+			}
+
+			if (oldSlots)
+				rage_free(oldSlots);
+		}
+
+		// Returns existing slot with destroyed value or new slot, value must be constructed in it
+		Slot& AllocateSlotOrFindExisting(u32 hash, const TValue* value)
+		{
+			Slot* existingSlot = FindSlot(hash, value);
+			if (existingSlot)
+			{
+				existingSlot->Value.~TValue();
+				return *existingSlot;
+			}
+
+			if (m_Capacity == 0)
+				Allocate(MIN_CAPACITY);
+
+			u64 mixed = Mix(hash);
+			u32 index = FindFreeSlot(mixed);
+
+			// Deleted slot can be reused without affecting load factor
+			if (m_GrowthLeft == 0 && m_Ctrl[index] == Group::CTRL_EMPTY)
+			{
+				// Table may be filled with deleted slots, then we just clean it up without growing
+				u32 newCapacity = m_UsedSlotCount + 1 > GetMaxLoad(m_Capacity) / 2 ? m_Capacity * 2 : m_Capacity;
+				Rehash(newCapacity);
+				index = FindFreeSlot(mixed);
+			}
+
+			if (m_Ctrl[index] == Group::CTRL_EMPTY)
+				m_GrowthLeft--;
+			m_Ctrl[index] = GetH2(mixed);
+			m_UsedSlotCount++;
+
+			Slot& slot = m_Slots[index];
+			slot.HashKey = hash;
+			return slot;
+		}
+
+		void RemoveSlot(u32 index)
+		{
+			m_Slots[index].Value.~TValue();
+			m_UsedSlotCount--;
+
+			// If group has empty slot, no probe sequence goes through it and slot can be marked as empty
+			u32 groupStart = index & ~(Group::WIDTH - 1);
+			if (Group(m_Ctrl + groupStart).MatchEmpty())
+			{
+				m_Ctrl[index] = Group::CTRL_EMPTY;
+				m_GrowthLeft++;
+			}
+			else
+			{
+				m_Ctrl[index] = Group::CTRL_DELETED;
+			}
+		}
+
+	public:
+		atFlatMap() = default;
+		atFlatMap(const std::initializer_list<TValue>& list)
+		{
+			Reserve(static_cast<u32>(list.size()));
+			for (const TValue& value : list)
+				Insert(value);
+		}
+		atFlatMap(const atFlatMap& other)
+		{
+			CopyFrom(other);
+		}
+		atFlatMap(atFlatMap&& other) noexcept
+		{
+			Swap(other);
+		}
+		~atFlatMap()
+		{
+			Destroy();
+		}
+
+		/*
+		 *	------------------ Initializers / Destructors ------------------
+		 */
+
+		// Allocates table to hold given number of values without rehashing
+		void Reserve(u32 count)
+		{
+			u32 capacity = MIN_CAPACITY;
+			while (GetMaxLoad(capacity) < count)
+				capacity *= 2;
+
+			if (capacity > m_Capacity)
+				Rehash(capacity);
+		}
+
+		void Swap(atFlatMap& other)
+		{
+			std::swap(m_Slots, other.m_Slots);
+			std::swap(m_Ctrl, other.m_Ctrl);
+			std::swap(m_Capacity, other.m_Capacity);
+			std::swap(m_UsedSlotCount, other.m_UsedSlotCount);
+			std::swap(m_GrowthLeft, other.m_GrowthLeft);
+		}
+
+		void CopyFrom(const atFlatMap& other)
+		{
+			Destroy();
+			if (other.m_Capacity == 0)
+				return;
+
+			// Same capacity, so slots can be copied at the same positions
+			m_UsedSlotCount = other.m_UsedSlotCount;
+			Allocate(other.m_Capacity);
+			m_GrowthLeft = other.m_GrowthLeft;
+			memcpy(m_Ctrl, other.m_Ctrl, m_Capacity);
+			for (u32 i = 0; i < m_Capacity; i++)
+			{
+				if (!IsFull(i))
+					continue;
+
+				m_Slots[i].HashKey = other.m_Slots[i].HashKey;
+				new (&m_Slots[i].Value) TValue(other.m_Slots[i].Value);
+			}
+		}
+
+		void Destroy()
+		{
+			if (!m_Slots)
+				return;
+
+			Clear();
+			rage_free(m_Slots);
+			m_Slots = nullptr;
+			m_Ctrl = nullptr;
+			m_Capacity = 0;
+			m_GrowthLeft = 0;
+		}
+
+		// Removes all values but keeps allocated table
+		void Clear()
+		{
+			for (u32 i = 0; i < m_Capacity; i++)
+			{
+				if (IsFull(i))
+					m_Slots[i].Value.~TValue();
+			}
+
+			if (m_Ctrl)
+				memset(m_Ctrl, Group::CTRL_EMPTY, m_Capacity);
+			m_UsedSlotCount = 0;
+			m_GrowthLeft = GetMaxLoad(m_Capacity);
+		}
+
+		/*
+		 *	------------------ Adding / Removing items ------------------
+		 */
+
+		TValue& InsertAt(u32 hash, const TValue& value)
+		{
+			Slot& slot = AllocateSlotOrFindExisting(hash, nullptr);
+			new (&slot.Value) TValue(value); // Placement new
+			return slot.Value;
+		}
+
+		TValue& Insert(const TValue& value)
+		{
+			u32 hash = GetHash(value);
+			Slot& slot = AllocateSlotOrFindExisting(hash, &value);
+			new (&slot.Value) TValue(value);
+			return slot.Value;
+		}
+
+		template<typename... TArgs>
+		TValue& ConstructAt(u32 hash, TArgs... args)
+		{
+			Slot& slot = AllocateSlotOrFindExisting(hash, nullptr);
+			new (&slot.Value) TValue(args...);
+			return slot.Value;
+		}
+
+		TValue& EmplaceAt(u32 hash, TValue&& value)
+		{
+			Slot& slot = AllocateSlotOrFindExisting(hash, nullptr);
+			new (&slot.Value) TValue(std::move(value));
+			return slot.Value;
+		}
+
+		TValue& Emplace(TValue&& value)
+		{
+			u32 hash = GetHash(value);
+			Slot& slot = AllocateSlotOrFindExisting(hash, &value);
+			new (&slot.Value) TValue(std::move(value));
+			return slot.Value;
+		}
+
+		void RemoveAtIterator(const Iterator& it);
+
+		void RemoveAt(u32 hash)
+		{
+			u32 index;
+			Slot* slot = FindSlot(hash, nullptr, &index);
+			AM_ASSERT(slot, "atFlatMap::RemoveAt() -> Slot with key hash %u is not allocated.", hash);
+			RemoveSlot(index);
+		}
+
+		void Remove(const TValue& value)
+		{
+			u32 index;
+			Slot* slot = FindSlot(GetHash(value), &value, &index);
+			AM_ASSERT(slot, "atFlatMap::Remove() -> Value is not present.");
+			RemoveSlot(index);
+		}
+
+		/*
+		 *	------------------ Getters / Operators ------------------
+		 */
+
+		Iterator FindByHash(u32 hash);
+		Iterator Find(const TValue& value);
+
+		TValue* TryGetAt(u32 hash) const
+		{
+			Slot* slot = FindSlot(hash, nullptr);
+			if (!slot)
+				return nullptr;
+			return &slot->Value;
+		}
+
+		TValue& GetAt(u32 hash) const
+		{
+			TValue* value = TryGetAt(hash);
+			AM_ASSERT(value, "atFlatMap::GetAt() -> Value with hash %u is not present.", hash);
+			return *value;
+		}
+
+		bool Equals(const atFlatMap& other) const
+		{
+			if (m_UsedSlotCount != other.m_UsedSlotCount)
+				return false;
+
+			for (u32 i = 0; i < m_Capacity; i++)
+			{
+				if (IsFull(i) && !other.FindSlot(m_Slots[i].HashKey, &m_Slots[i].Value))
+					return false;
+			}
+			return true;
+		}
+
+		atArray<TValue> ToArray() const;
+
+		bool Any() const { return m_UsedSlotCount > 0; }
+		bool Contains(const TValue& value) const { return FindSlot(GetHash(value), &value) != nullptr; }
+		bool ContainsAt(u32 hash) const { return FindSlot(hash, nullptr) != nullptr; }
+		u32  GetCapacity() const { return m_Capacity; }
+		u32  GetNumUsedSlots() const { return m_UsedSlotCount; }
+
+		atFlatMap& operator=(const std::initializer_list<TValue>& list)
+		{
+			Clear();
+			Reserve(static_cast<u32>(list.size()));
+			for (const TValue& value : list)
+				Insert(value);
+			return *this;
+		}
+
+		atFlatMap& operator=(const atFlatMap& other) // NOLINT(bugprone-unhandled-self-assignment)
+		{
+			if (this != &other)
+				CopyFrom(other);
+			return *this;
+		}
+
+		atFlatMap& operator=(atFlatMap&& other) noexcept
+		{
+			Swap(other);
+			return *this;
+		}
+
+		bool operator==(const atFlatMap& other) const { return Equals(other); }
+
+		Iterator begin() const { return Iterator(this, 0); }
+		Iterator end() const { return Iterator::GetEnd(); }
+	};
+
+	/**
+	 * \brief Allows to iterate through allocated slots in atFlatMap, full slots are searched group by group.
+	 */
+	template<typename TValue, typename THashFn = atMapHashFn<TValue>, typename TEqualFn = atFlatMapHashEqualFn<TValue>>
+	class atFlatMapIterator
+	{
+		using Map = atFlatMap<TValue, THashFn, TEqualFn>;
+		using Group = atFlatMapGroup;
+
+		friend class atFlatMap<TValue, THashFn, TEqualFn>;
+
+		const Map* m_Map;
+		u32        m_Index = 0;
+
+		// Moves to the first full slot starting from given index
+		void Seek(u32 index)
+		{
+			while (index < m_Map->m_Capacity)
+			{
+				u32 groupStart = index & ~(Group::WIDTH - 1);
+				u32 match = Group(m_Map->m_Ctrl + groupStart).MatchFull() >> (index - groupStart);
+				if (match != 0)
+				{
+					m_Index = index + Group::FirstIndex(match);
+					return;
+				}
+				index = groupStart + Group::WIDTH;
+			}
+			m_Map = nullptr;
+		}
+
+	public:
+		atFlatMapIterator(const Map* map, u32 index) : m_Map(map)
+		{
+			if (m_Map)
+				Seek(index);
+		}
+
+		static atFlatMapIterator GetEnd() { return atFlatMapIterator(nullptr, 0); }
+
+		bool Next()
+		{
+			if (!m_Map)
+				return false;
+
+			Seek(m_Index + 1);
+			return m_Map != nullptr;
+		}
+
+		atFlatMapIterator operator++()
+		{
+			Next();
+			return *this;
+		}
+
+		TValue& operator*() const { return m_Map->m_Slots[m_Index].Value; }
+		TValue& GetValue() const { return m_Map->m_Slots[m_Index].Value; }
+		u32 GetHashKey() const { return m_Map->m_Slots[m_Index].HashKey; }
+		bool HasValue() const { return m_Map != nullptr; }
+
+		bool operator==(const atFlatMapIterator& other) const
+		{
+			if (m_Map == nullptr && other.m_Map == nullptr)
+				return true;
+
+			return m_Map == other.m_Map && m_Index == other.m_Index;
+		}
+	};
+
+	// Implementation of functions in atFlatMap that depend on atFlatMapIterator
+
+	template<typename TValue, typename THashFn, typename TEqualFn>
+	void atFlatMap<TValue, THashFn, TEqualFn>::RemoveAtIterator(const Iterator& it)
+	{
+		AM_ASSERT(it != end(), "atFlatMap::RemoveAtIterator() -> Invalid iterator!");
+		RemoveSlot(it.m_Index);
+	}
+
+	template<typename TValue, typename THashFn, typename TEqualFn>
+	typename atFlatMap<TValue, THashFn, TEqualFn>::Iterator atFlatMap<TValue, THashFn, TEqualFn>::FindByHash(u32 hash)
+	{
+		u32 index;
+		if (!FindSlot(hash, nullptr, &index))
+			return end();
+		return Iterator(this, index);
+	}
+
+	template<typename TValue, typename THashFn, typename TEqualFn>
+	typename atFlatMap<TValue, THashFn, TEqualFn>::Iterator atFlatMap<TValue, THashFn, TEqualFn>::Find(const TValue& value)
+	{
+		u32 index;
+		if (!FindSlot(GetHash(value), &value, &index))
+			return end();
+		return Iterator(this, index);
+	}
+
+	template<typename TValue, typename THashFn, typename TEqualFn>
+	atArray<TValue> atFlatMap<TValue, THashFn, TEqualFn>::ToArray() const
+	{
+		atArray<TValue> result;
+		result.Reserve(GetNumUsedSlots());
+
+		for (const TValue& value : *this)
+		{
+			result.Add(value);
+		}
+
+		return result;
+	}
+}
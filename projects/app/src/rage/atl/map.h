@@ -10,6 +10,15 @@
 #include "rage/paging/compiler/compiler.h"
 #include "hashstring.h"
 #include "string.h"
+#include "rage/system/new.h"
+
+#include <type_traits>
+
+#ifdef _MSC_VER
+#define AT_NO_UNIQUE_ADDRESS [[msvc::no_unique_address]]
+#else
+#define AT_NO_UNIQUE_ADDRESS [[no_unique_address]]
+#endif
 
 namespace rage
 {
@@ -80,18 +89,120 @@ namespace rage
 	template<> inline u32 atMapHashFn<atString>::operator()(const atString& str) { return atStringHash(str); }
 	template<> inline u32 atMapHashFn<atWideString>::operator()(const atWideString& str) { return atStringHash(str); }
 
-	template<typename TValue, typename THashFn>
+	/**
+	 * \brief Default atMap node allocator, every node is allocated separately (also in resource compiler allocator).
+	 */
+	struct atMapHeapNodeAllocator
+	{
+		static constexpr bool FREES_IN_BULK = false;
+
+		pVoid Allocate(u32 size) const { return pgAlloc(size); }
+		void  Free(pVoid node) const { operator delete(node); }
+		void  FreeAll() const {}
+		void  Swap(atMapHeapNodeAllocator&) const {}
+	};
+
+	/**
+	 * \brief Allocates atMap nodes in contiguous blocks, removed nodes are reused and all blocks are released at once
+	 * in atMap::Clear / atMap::Destroy. Node layout is not changed, but map has to store allocator state after
+	 * the game fields, so pooled maps can't be placed in resources.
+	 */
+	class atMapPooledNodeAllocator
+	{
+		static constexpr u32 MIN_BLOCK_NODE_COUNT = 32;
+		static constexpr u32 MAX_BLOCK_NODE_COUNT = 4096;
+
+		struct Block
+		{
+			Block* Next;
+			u32    Capacity;
+			u32    UsedCount;
+			// Nodes follow
+		};
+		static constexpr u32 BLOCK_HEADER_SIZE = (sizeof(Block) + 15) & ~15;
+
+		Block* m_Blocks = nullptr;
+		pVoid  m_FreeList = nullptr; // Freed nodes, first bytes of node store pointer to next one
+		u32    m_NodeSize = 0;
+
+	public:
+		static constexpr bool FREES_IN_BULK = true;
+
+		atMapPooledNodeAllocator() = default;
+		atMapPooledNodeAllocator(const atMapPooledNodeAllocator&) = delete; // Nodes are owned by the map
+		~atMapPooledNodeAllocator() { FreeAll(); }
+
+		pVoid Allocate(u32 size)
+		{
+			AM_ASSERT(!IsResourceCompiling(), "atMapPooledNodeAllocator::Allocate() -> Pooled maps can't be compiled in resource.");
+			u32 nodeSize = (size + 15) & ~15;
+			AM_ASSERT(m_NodeSize == 0 || m_NodeSize == nodeSize, "atMapPooledNodeAllocator::Allocate() -> Node size mismatch.");
+			m_NodeSize = nodeSize;
+
+			if (m_FreeList)
+			{
+				pVoid node = m_FreeList;
+				m_FreeList = *static_cast<pVoid*>(node);
+				return node;
+			}
+
+			if (!m_Blocks || m_Blocks->UsedCount == m_Blocks->Capacity)
+			{
+				// Grow geometrically to keep number of allocations logarithmic for large maps
+				u32 capacity = MIN_BLOCK_NODE_COUNT;
+				if (m_Blocks)
+					capacity = m_Blocks->Capacity < MAX_BLOCK_NODE_COUNT ? m_Blocks->Capacity * 2 : MAX_BLOCK_NODE_COUNT;
+				Block* block = static_cast<Block*>(rage_malloc(BLOCK_HEADER_SIZE + static_cast<size_t>(capacity) * m_NodeSize, 16));
+				block->Next = m_Blocks;
+				block->Capacity = capacity;
+				block->UsedCount = 0;
+				m_Blocks = block;
+			}
+
+			char* nodes = reinterpret_cast<char*>(m_Blocks) + BLOCK_HEADER_SIZE;
+			return nodes + static_cast<size_t>(m_Blocks->UsedCount++) * m_NodeSize;
+		}
+
+		void Free(pVoid node)
+		{
+			*static_cast<pVoid*>(node) = m_FreeList;
+			m_FreeList = node;
+		}
+
+		void FreeAll()
+		{
+			Block* block = m_Blocks;
+			while (block)
+			{
+				Block* next = block->Next;
+				rage_free(block);
+				block = next;
+			}
+			m_Blocks = nullptr;
+			m_FreeList = nullptr;
+		}
+
+		void Swap(atMapPooledNodeAllocator& other)
+		{
+			std::swap(m_Blocks, other.m_Blocks);
+			std::swap(m_FreeList, other.m_FreeList);
+			std::swap(m_NodeSize, other.m_NodeSize);
+		}
+	};
+
+	template<typename TValue, typename THashFn, typename TNodeAllocator>
 	class atMapIterator;
 
 	/**
 	 * \brief Hash table with separate chaining and mod index function, similar to .NET Dictionary;
 	 * \n You can read on separate chaining & mod here: https://en.wikipedia.org/wiki/Hash_table
 	 * or just refer to actual implementation.
+	 * \n Nodes are allocated by TNodeAllocator, see atMapPooledNodeAllocator.
 	 */
-	template<typename TValue, typename THashFn = atMapHashFn<TValue>>
+	template<typename TValue, typename THashFn = atMapHashFn<TValue>, typename TNodeAllocator = atMapHeapNodeAllocator>
 	class atMap
 	{
-		using Iterator = atMapIterator<TValue, THashFn>;
+		using Iterator = atMapIterator<TValue, THashFn, TNodeAllocator>;
 
 		friend class Iterator;
 
@@ -110,6 +221,8 @@ namespace rage
 		u16    m_UsedSlotCount;
 		u8     m_Pad[3] = {};
 		bool   m_AllowGrowing;
+		// Not a part of game structure, takes no space for stateless allocator
+		AT_NO_UNIQUE_ADDRESS TNodeAllocator m_NodeAllocator;
 
 		Node** AllocateBuckets(u16 size)
 		{
@@ -123,7 +236,7 @@ namespace rage
 		Node* AllocateNode()
 		{
 			// Allocate without invoking default TValue constructor
-			Node* node = static_cast<Node*>(pgAlloc(sizeof Node));
+			Node* node = static_cast<Node*>(m_NodeAllocator.Allocate(sizeof Node));
 			memset(node, 0, sizeof Node);
 			return node;
 		}
@@ -135,7 +248,7 @@ namespace rage
 
 			// Delete without invoking TValue destructor, because otherwise destructor will be called for 
 			// item that wasn't even constructed
-			operator delete(node);
+			m_NodeAllocator.Free(node);
 		}
 
 		u32 GetHash(const TValue& value) const
@@ -310,6 +423,7 @@ namespace rage
 			std::swap(m_AllowGrowing, other.m_AllowGrowing);
 			std::swap(m_UsedSlotCount, other.m_UsedSlotCount);
 			std::swap(m_Buckets, other.m_Buckets);
+			m_NodeAllocator.Swap(other.m_NodeAllocator);
 		}
 
 		void CopyFrom(const atMap& other)
@@ -371,15 +485,31 @@ namespace rage
 			if (!m_Buckets)
 				return;
 
-			// Delete nodes and call destructor, not any different from atMap one
-			for (u16 i = 0; i < m_BucketCount; i++)
+			if constexpr (TNodeAllocator::FREES_IN_BULK)
 			{
-				Node* node = m_Buckets[i];
-				while (node)
+				// Only destructors have to be called, node blocks are released at once
+				if constexpr (!std::is_trivially_destructible_v<TValue>)
 				{
-					Node* nodeToDelete = node;
-					node = node->Next;
-					DeleteNode(nodeToDelete);
+					for (u16 i = 0; i < m_BucketCount; i++)
+					{
+						for (Node* node = m_Buckets[i]; node; node = node->Next)
+							node->Value.~TValue();
+					}
+				}
+				m_NodeAllocator.FreeAll();
+			}
+			else
+			{
+				// Delete nodes and call destructor, not any different from atMap one
+				for (u16 i = 0; i < m_BucketCount; i++)
+				{
+					Node* node = m_Buckets[i];
+					while (node)
+					{
+						Node* nodeToDelete = node;
+						node = node->Next;
+						DeleteNode(nodeToDelete);
+					}
 				}
 			}
 
@@ -591,10 +721,10 @@ namespace rage
 	/**
 	 * \brief Allows to iterate through allocated slots in atMap.
 	 */
-	template<typename TValue, typename THashFn = atMapHashFn<TValue>>
+	template<typename TValue, typename THashFn = atMapHashFn<TValue>, typename TNodeAllocator = atMapHeapNodeAllocator>
 	class atMapIterator
 	{
-		using Set = atMap<TValue, THashFn>;
+		using Set = atMap<TValue, THashFn, TNodeAllocator>;
 		using Node = typename Set::Node;
 
 		friend class Set;
@@ -682,16 +812,16 @@ namespace rage
 
 	// Implementation of functions in atMap that depend on atMapIterator
 
-	template <typename TValue, typename THashFn>
-	void atMap<TValue, THashFn>::RemoveAtIterator(const Iterator& it)
+	template <typename TValue, typename THashFn, typename TNodeAllocator>
+	void atMap<TValue, THashFn, TNodeAllocator>::RemoveAtIterator(const Iterator& it)
 	{
 		AM_ASSERT(it != end(), "atMap::RemoveAtIterator() -> Invalid iterator!");
 
 		RemoveNodeFromLinkedListAndFree(it.m_Node, it.m_BucketIndex);
 	}
 
-	template <typename TValue, typename THashFn>
-	typename atMap<TValue, THashFn>::Iterator atMap<TValue, THashFn>::FindByHash(u32 hash)
+	template <typename TValue, typename THashFn, typename TNodeAllocator>
+	typename atMap<TValue, THashFn, TNodeAllocator>::Iterator atMap<TValue, THashFn, TNodeAllocator>::FindByHash(u32 hash)
 	{
 		u16 bucket;
 		Node* node = TryGetNode(hash, &bucket);
@@ -701,8 +831,8 @@ namespace rage
 		return Iterator(this, bucket, node);
 	}
 
-	template <typename TValue, typename THashFn>
-	atArray<TValue> atMap<TValue, THashFn>::ToArray() const
+	template <typename TValue, typename THashFn, typename TNodeAllocator>
+	atArray<TValue> atMap<TValue, THashFn, TNodeAllocator>::ToArray() const
 	{
 		atArray<TValue> result;
 		result.Reserve(GetNumUsedSlots());
@@ -714,4 +844,7 @@ namespace rage
 
 		return result;
 	}
+
+	// Map is a part of game resources, allocator must not change its size
+	static_assert(sizeof(atMap<u32>) == 16);
 }
@@ -4,21 +4,110 @@
 #include "rage/system/systemheap.h"
 #include "rage/zlib/stream.h"
 
-bool rage::pgRscBuilder::ReadAndDecompressChunks(datResourceMap& map, fiDevice* device, ConstString path)
+u32 rage::pgRscReadAheadStream::ThreadEntry(const rageam::ThreadContext* ctx)
 {
-	u64 offset;
-	fiHandle_t file = device->OpenBulk(path, offset);
-	if (file == FI_INVALID_HANDLE)
+	pgRscReadAheadStream* stream = static_cast<pgRscReadAheadStream*>(ctx->Param);
+	stream->ReadLoop();
+	return 0;
+}
+
+void rage::pgRscReadAheadStream::ReadLoop()
+{
+	while (true)
 	{
-		AM_ERRF("pgRscBuilder::ReadAndDecompressChunks() -> Unable to open file for reading...");
-		return false;
+		u32 index;
+		{
+			// Wait until consumer releases one of the buffers
+			std::unique_lock lock(m_Mutex);
+			m_Condition.wait(lock, [this] { return m_Canceled || m_ReadCount - m_ConsumedCount < BUFFER_COUNT; });
+			if (m_Canceled)
+				return;
+			index = m_ReadCount % BUFFER_COUNT;
+		}
+
+		// Buffer is not accessed by consumer until read count is incremented, no lock needed
+		Buffer& buffer = m_Buffers[index];
+		u32 sizeReaded = m_Device->ReadBulk(m_File, m_Offset, buffer.Data.get(), BUFFER_SIZE);
+
+		bool finished;
+		{
+			std::unique_lock lock(m_Mutex);
+			if (sizeReaded == FI_INVALID_RESULT)
+			{
+				m_Failed = true;
+			}
+			else if (sizeReaded == 0)
+			{
+				m_EndOfFile = true;
+			}
+			else
+			{
+				buffer.Size = sizeReaded;
+				m_Offset += sizeReaded;
+				m_ReadCount++;
+			}
+			finished = m_Failed || m_EndOfFile;
+		}
+		m_Condition.notify_all();
+
+		if (finished)
+			return;
 	}
-	offset += sizeof datResourceHeader;
+}
 
-	char* fileBuffer = new char[READ_BUFFER_SIZE];
+rage::pgRscReadAheadStream::pgRscReadAheadStream(fiDevice* device, fiHandle_t file, u64 offset)
+	: m_Device(device), m_File(file), m_Offset(offset), m_Thread("pgRscReader", ThreadEntry, this, true)
+{
+	for (Buffer& buffer : m_Buffers)
+	{
+		buffer.Data = std::make_unique<char[]>(BUFFER_SIZE);
+		buffer.Size = 0;
+	}
+	// Thread is created paused because buffers must be allocated first
+	m_Thread.Resume();
+}
 
-	AM_DEBUGF("pgRscBuilder::ReadAndDecompressChunks() -> Processing %u chunks (Virtual: %u, Physical: %u)", 
-		map.GetChunkCount(), map.VirtualChunkCount, map.PhysicalChunkCount);
+rage::pgRscReadAheadStream::~pgRscReadAheadStream()
+{
+	Cancel();
+	m_Thread.WaitExit();
+}
+
+bool rage::pgRscReadAheadStream::AcquireNext(char*& buffer, u32& size)
+{
+	std::unique_lock lock(m_Mutex);
+
+	// Previous buffer is not needed anymore, reader can fill it again
+	if (m_HasAcquired)
+	{
+		m_ConsumedCount++;
+		m_HasAcquired = false;
+		m_Condition.notify_all();
+	}
+
+	m_Condition.wait(lock, [this] { return m_ReadCount != m_ConsumedCount || m_Failed || m_EndOfFile; });
+	if (m_ReadCount == m_ConsumedCount)
+		return false;
+
+	Buffer& acquired = m_Buffers[m_ConsumedCount % BUFFER_COUNT];
+	buffer = acquired.Data.get();
+	size = acquired.Size;
+	m_HasAcquired = true;
+	return true;
+}
+
+void rage::pgRscReadAheadStream::Cancel()
+{
+	{
+		std::unique_lock lock(m_Mutex);
+		m_Canceled = true;
+	}
+	m_Condition.notify_all();
+}
+
+bool rage::pgRscBuilder::ReadAndDecompressChunksSequential(datResourceMap& map, fiDevice* device, fiHandle_t file, u64 offset)
+{
+	amUPtr<char[]> fileBuffer = std::make_unique<char[]>(READ_BUFFER_SIZE);
 
 	u32 remaining = 0; // Remaining size indicate us that we need to read more data from file
 	zLibDecompressor decompressor;
@@ -38,8 +127,8 @@ bool rage::pgRscBuilder::ReadAndDecompressChunks(datResourceMap& map, fiDevice*
 			// We read from file & decompress until chunk is done, then move to next chunk
 			if (remaining == 0)
 			{
-				sizeReaded = device->ReadBulk(file, offset, fileBuffer, READ_BUFFER_SIZE);
-				if (sizeReaded == FI_INVALID_RESULT)
+				sizeReaded = device->ReadBulk(file, offset, fileBuffer.get(), READ_BUFFER_SIZE);
+				if (sizeReaded == FI_INVALID_RESULT || sizeReaded == 0)
 				{
 					AM_ERRF("pgRscBuilder::ReadAndDecompressChunks() -> Failed to read file...");
 					return false;
@@ -48,31 +137,93 @@ bool rage::pgRscBuilder::ReadAndDecompressChunks(datResourceMap& map, fiDevice*
 			}
 
 			done = decompressor.Decompress(
-				chunkDest, chunkSize, fileBuffer, sizeReaded, remaining);
+				chunkDest, chunkSize, fileBuffer.get(), sizeReaded, remaining);
 		}
 	}
-	device->Close(file);
-	delete[] fileBuffer;
 	return true;
 }
 
-bool rage::pgRscBuilder::PerformReadInMainThread(ConstString path, u32 version, datResourceMap& map, datResourceInfo& info)
+bool rage::pgRscBuilder::ReadAndDecompressChunksReadAhead(datResourceMap& map, fiDevice* device, fiHandle_t file, u64 offset)
+{
+	pgRscReadAheadStream stream(device, file, offset);
+
+	char*	buffer = nullptr;
+	u32		bufferSize = 0;
+	u32		remaining = 0; // Remaining size indicate us that we need to take next buffer from reader
+	zLibDecompressor decompressor;
+	for (u32 i = 0; i < map.GetChunkCount(); i++)
+	{
+		datResourceChunk& chunk = map.Chunks[i];
+
+		pVoid	chunkDest = chunk.GetAllocatedAddress();
+		u32		chunkSize = static_cast<u32>(chunk.Size);
+		bool	done = false;
+
+		AM_ASSERT(chunkSize < 100'000'000, "pgRscBuilder::ReadAndDecompressChunks() -> Max supported chunk size by streaming loader is 100MB.");
+
+		while (!done)
+		{
+			if (remaining == 0 && !stream.AcquireNext(buffer, bufferSize))
+			{
+				AM_ERRF("pgRscBuilder::ReadAndDecompressChunks() -> Failed to read file...");
+				return false;
+			}
+
+			done = decompressor.Decompress(chunkDest, chunkSize, buffer, bufferSize, remaining);
+		}
+	}
+	return true;
+}
+
+bool rage::pgRscBuilder::ReadAndDecompressChunks(datResourceMap& map, fiDevice* device, ConstString path, bool readAhead)
+{
+	u64 offset;
+	fiHandle_t file = device->OpenBulk(path, offset);
+	if (file == FI_INVALID_HANDLE)
+	{
+		AM_ERRF("pgRscBuilder::ReadAndDecompressChunks() -> Unable to open file for reading...");
+		return false;
+	}
+	offset += sizeof datResourceHeader;
+
+	AM_DEBUGF("pgRscBuilder::ReadAndDecompressChunks() -> Processing %u chunks (Virtual: %u, Physical: %u)", 
+		map.GetChunkCount(), map.VirtualChunkCount, map.PhysicalChunkCount);
+
+	bool success;
+	if (readAhead)
+		success = ReadAndDecompressChunksReadAhead(map, device, file, offset);
+	else
+		success = ReadAndDecompressChunksSequential(map, device, file, offset);
+	device->Close(file);
+	return success;
+}
+
+rage::fiDevice* rage::pgRscBuilder::PrepareMap(ConstString path, u32 version, datResourceMap& map, datResourceInfo& info)
 {
 	fiDevice* device = fiDevice::GetDeviceImpl(path);
 	if (device->GetResourceInfo(path, info) != version)
 	{
-		AM_ERRF("pgRscBuilder::PerformReadInMainThread() -> File is not a valid resource, unable to read header.");
-		return false;
+		AM_ERRF("pgRscBuilder::PrepareMap() -> File is not a valid resource, unable to read header.");
+		return nullptr;
 	}
 
 	info.GenerateMap(map);
 
 	if (!AllocateMap(map))
 	{
-		AM_ERRF("pgRscBuilder::PerformReadInMainThread() -> Failed to allocate map.");
-		return false;
+		AM_ERRF("pgRscBuilder::PrepareMap() -> Failed to allocate map.");
+		return nullptr;
 	}
 
+	return device;
+}
+
+bool rage::pgRscBuilder::PerformReadInMainThread(ConstString path, u32 version, datResourceMap& map, datResourceInfo& info)
+{
+	fiDevice* device = PrepareMap(path, version, map, info);
+	if (!device)
+		return false;
+
 	if (!ReadAndDecompressChunks(map, device, path))
 		return false;
 
@@ -99,6 +250,44 @@ rage::pgBase* rage::pgRscBuilder::LoadBuild(ConstString path, u32 version, datRe
 	return map.MainChunk;
 }
 
+rageam::BackgroundTaskPtr rage::pgRscBuilder::LoadBuildAsync(ConstString path, u32 version, datResourceMap& map, datResourceInfo& info)
+{
+	char fullName[256];
+	ConstructName(fullName, 256, path);
+
+	fiDevice* device = PrepareMap(fullName, version, map, info);
+	if (!device)
+		return nullptr;
+
+	if (sm_Worker) rageam::BackgroundWorker::Push(sm_Worker);
+	rageam::BackgroundTaskPtr task = rageam::BackgroundWorker::Run([&map, device, name = rageam::file::Path(fullName)]
+		{
+			if (!ReadAndDecompressChunks(map, device, name))
+				return false;
+
+			map.MainChunk = static_cast<pgBase*>(map.Chunks[map.MainChunkIndex].GetAllocatedAddress());
+			pgBase* root = map.MainChunk;
+			rageam::BackgroundWorker::SetCurrentResult(root);
+			return true;
+		}, L"pgRscBuilder::LoadBuildAsync(%hs)", fullName);
+	if (sm_Worker) rageam::BackgroundWorker::Pop();
+
+	return task;
+}
+
+void rage::pgRscBuilder::InitClass()
+{
+	SYSTEM_INFO sysInfo;
+	GetSystemInfo(&sysInfo);
+	sm_Worker = new rageam::BackgroundWorker("pgRscBuilder", static_cast<int>(sysInfo.dwNumberOfProcessors));
+}
+
+void rage::pgRscBuilder::ShutdownClass()
+{
+	delete sm_Worker;
+	sm_Worker = nullptr;
+}
+
 void rage::pgRscBuilder::Cleanup(const datResourceMap& map)
 {
 	sysMemAllocator* allocator = GetMultiAllocator()->GetAllocator(ALLOC_TYPE_PHYSICAL);
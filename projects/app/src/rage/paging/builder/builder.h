@@ -12,25 +12,88 @@
 #include "rage/paging/resourceinfo.h"
 #include "am/system/asserts.h"
 #include "am/system/timer.h"
+#include "am/system/worker.h"
 #include "rage/file/device.h"
 #include "common/logger.h"
+#include "am/system/thread.h"
 
 namespace rage
 {
+	/**
+	 * \brief Reads compressed resource data ahead of decompression in separate thread,
+	 * so file reading and inflating chunks overlap. Memory is bounded by the ring of read buffers.
+	 */
+	class pgRscReadAheadStream
+	{
+		static constexpr u32 BUFFER_SIZE = 0x200000; // 2MB
+		static constexpr u32 BUFFER_COUNT = 4;
+
+		struct Buffer
+		{
+			amUPtr<char[]>	Data;
+			u32				Size;
+		};
+
+		fiDevice*				m_Device;
+		fiHandle_t				m_File;
+		u64						m_Offset;
+		Buffer					m_Buffers[BUFFER_COUNT];
+		u32						m_ReadCount = 0;		// Total number of buffers filled by reader
+		u32						m_ConsumedCount = 0;	// Total number of buffers released by consumer
+		bool					m_HasAcquired = false;	// Consumer holds buffer until it asks for the next one
+		bool					m_EndOfFile = false;
+		bool					m_Failed = false;
+		bool					m_Canceled = false;
+		std::mutex				m_Mutex;
+		std::condition_variable	m_Condition;
+		rageam::Thread			m_Thread;
+
+		static u32 ThreadEntry(const rageam::ThreadContext* ctx);
+		void ReadLoop();
+
+	public:
+		pgRscReadAheadStream(fiDevice* device, fiHandle_t file, u64 offset);
+		// Stops reading and waits for reader thread to exit
+		~pgRscReadAheadStream();
+
+		// Blocks until the next buffer is read, previously acquired buffer is released to reader,
+		// returns false if reading failed or end of file is reached
+		bool AcquireNext(char*& buffer, u32& size);
+		// Notifies reader that no more buffers are needed
+		void Cancel();
+	};
+
 	class pgRscBuilder
 	{
 		static constexpr u32 READ_BUFFER_SIZE = 0x1000000; // 16MB
 
 		// Native implementation uses pgReader which does resource reading in parallel thread,
-		// we don't need that yet (because we are not streaming resources in real-time) so we can read resource in caller thread.
+		// we use pgRscReadAheadStream for the same purpose. LoadBuildAsync also moves decompression to worker thread.
+
+		static inline rageam::BackgroundWorker* sm_Worker = nullptr;
 
 		static bool PerformReadInMainThread(ConstString path, u32 version, datResourceMap& map, datResourceInfo& info);
+		// Reads header and allocates chunks in caller thread, because allocator is selected per thread
+		static fiDevice* PrepareMap(ConstString path, u32 version, datResourceMap& map, datResourceInfo& info);
+		static bool ReadAndDecompressChunksSequential(datResourceMap& map, fiDevice* device, fiHandle_t file, u64 offset);
+		static bool ReadAndDecompressChunksReadAhead(datResourceMap& map, fiDevice* device, fiHandle_t file, u64 offset);
 		static void ConstructName(char* buffer, u32 bufferSize, const char* path);
 
 	public:
-		static bool ReadAndDecompressChunks(datResourceMap& map, fiDevice* device, ConstString path);
+		static void InitClass();
+		static void ShutdownClass();
+
+		// Read ahead overlaps file reading with decompression, otherwise single thread reads and inflates in turns
+		static bool ReadAndDecompressChunks(datResourceMap& map, fiDevice* device, ConstString path, bool readAhead = true);
 
 		static pgBase* LoadBuild(ConstString path, u32 version, datResourceMap& map, datResourceInfo& info);
+		/**
+		 * \brief Same as LoadBuild, but chunks are decompressed in background. Header is read and map is allocated
+		 * in caller thread, so multiple resources can be loaded in parallel without touching allocators from workers.
+		 * \return Task with pgBase* result or NULL if header can't be read or map allocated.
+		 * Map and info must stay alive until task is finished.
+		 */
+		static rageam::BackgroundTaskPtr LoadBuildAsync(ConstString path, u32 version, datResourceMap& map, datResourceInfo& info);
 		/**
 		 * \brief Frees up physical chunks.
 		 */
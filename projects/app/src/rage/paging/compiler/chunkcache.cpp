@@ -0,0 +1,166 @@
+#include "chunkcache.h"
+
+#include "am/file/fileutils.h"
+#include "am/file/iterator.h"
+#include "rage/atl/datahash.h"
+#include "helpers/ranges.h"
+
+rageam::file::WPath rage::pgRscChunkCache::GetEntryPath(u64 key) const
+{
+	return m_Directory / String::FormatTemp(L"%016llx.chunk", key);
+}
+
+bool rage::pgRscChunkCache::Load(u64 key, u32 size, atArray<char, u32>& outCompressed) const
+{
+	rageam::file::WPath path = GetEntryPath(key);
+	if (!rageam::file::IsFileExists(path))
+		return false;
+
+	FILE* fs = rageam::file::OpenFileStream(path, L"rb");
+	if (!fs)
+		return false;
+
+	// Entry might be corrupted or written by another version, in this case we just recompress chunk
+	EntryHeader header;
+	bool valid =
+		rageam::file::ReadFileSteam(&header, sizeof EntryHeader, sizeof EntryHeader, fs) == sizeof EntryHeader &&
+		header.Magic == ENTRY_MAGIC &&
+		header.Version == ENTRY_VERSION &&
+		header.Key == key &&
+		header.Size == size;
+	if (valid)
+	{
+		outCompressed.Resize(header.CompressedSize);
+		valid = rageam::file::ReadFileSteam(
+			outCompressed.GetItems(), header.CompressedSize, header.CompressedSize, fs) == header.CompressedSize;
+	}
+
+	rageam::file::CloseFileStream(fs);
+	return valid;
+}
+
+void rage::pgRscChunkCache::Store(u64 key, u32 size, const atArray<char, u32>& compressed) const
+{
+	// Write to temporary file first and then move it, so other compiler thread will never read half-written entry
+	rageam::file::WPath path = GetEntryPath(key);
+	rageam::file::WPath tempPath = path;
+	tempPath += String::FormatTemp(L".%u.tmp", GetCurrentThreadId());
+
+	FILE* fs = rageam::file::OpenFileStream(tempPath, L"wb");
+	if (!fs)
+	{
+		AM_WARNINGF(L"pgRscChunkCache::Store() -> Failed to open '%ls' for writing", tempPath.GetCStr());
+		return;
+	}
+
+	EntryHeader header;
+	header.Magic = ENTRY_MAGIC;
+	header.Version = ENTRY_VERSION;
+	header.Key = key;
+	header.Size = size;
+	header.CompressedSize = compressed.GetSize();
+
+	bool written =
+		rageam::file::WriteFileSteam(&header, sizeof EntryHeader, fs) &&
+		rageam::file::WriteFileSteam(compressed.GetItems(), compressed.GetSize(), fs);
+	rageam::file::CloseFileStream(fs);
+
+	if (!written || !MoveFileExW(tempPath, path, MOVEFILE_REPLACE_EXISTING))
+	{
+		AM_WARNINGF(L"pgRscChunkCache::Store() -> Failed to store entry '%ls'", path.GetCStr());
+		DeleteFileW(tempPath);
+	}
+}
+
+rage::pgRscChunkCache::pgRscChunkCache(const rageam::file::WPath& directory, u64 budget)
+{
+	m_Directory = directory;
+	CreateDirectoryW(m_Directory, NULL);
+	TrimToBudget(budget);
+}
+
+u64 rage::pgRscChunkCache::ComputeKey(pConstVoid data, u32 size, pConstVoid dictionary, u32 dictionarySize, const zLibCompressionProfile& profile)
+{
+	// Compressed chunk depends on data, deflate window (dictionary) and compression parameters
+	u64 seed = profile.Level | profile.MemoryLevel << 8 | profile.Strategy << 16;
+	if (dictionarySize > zLibParallelCompressor::DICTIONARY_SIZE)
+	{
+		dictionary = static_cast<const char*>(dictionary) + dictionarySize - zLibParallelCompressor::DICTIONARY_SIZE;
+		dictionarySize = zLibParallelCompressor::DICTIONARY_SIZE;
+	}
+	seed = atDataHash64(dictionary, dictionarySize, seed);
+	return atDataHash64(data, size, seed);
+}
+
+bool rage::pgRscChunkCache::CompressChunk(pConstVoid data, u32 size, pConstVoid dictionary, u32 dictionarySize, const zLibParallelCompressor::WriteFn& writeFn,
+	const zLibCompressionProfile& profile)
+{
+	u64 key = ComputeKey(data, size, dictionary, dictionarySize, profile);
+
+	atArray<char, u32> compressed;
+	if (Load(key, size, compressed))
+	{
+		++m_Hits;
+		return writeFn(compressed.GetItems(), compressed.GetSize());
+	}
+	++m_Misses;
+
+	// Chunk is not cached, compress and write it
+	bool success = zLibParallelCompressor::CompressAll(data, size, [&](pConstVoid compressedBuffer, u32 compressedSize)
+		{
+			u32 offset = compressed.GetSize();
+			if (offset + compressedSize > compressed.GetCapacity())
+				compressed.Reserve(MAX(offset + compressedSize, compressed.GetCapacity() * 2));
+			compressed.Resize(offset + compressedSize);
+			memcpy(compressed.GetItems() + offset, compressedBuffer, compressedSize);
+			return writeFn(compressedBuffer, compressedSize);
+		}, dictionary, dictionarySize, profile);
+
+	if (success)
+		Store(key, size, compressed);
+
+	return success;
+}
+
+void rage::pgRscChunkCache::TrimToBudget(u64 budget) const
+{
+	rageam::file::WPath searchPath = m_Directory / L"*.chunk";
+	rageam::file::Iterator it(searchPath);
+	rageam::file::FindData findData;
+	atArray<rageam::file::FindData, u32> entries;
+	u64 totalSize = 0;
+	while (it.Next())
+	{
+		it.GetCurrent(findData);
+		totalSize += findData.Size;
+		entries.Add(findData);
+	}
+
+	if (totalSize <= budget)
+		return;
+
+	entries.Sort([](const rageam::file::FindData& lhs, const rageam::file::FindData& rhs)
+		{
+			return lhs.LastWriteTime.GetTicks() < rhs.LastWriteTime.GetTicks();
+		});
+
+	for (const rageam::file::FindData& entry : entries)
+	{
+		if (totalSize <= budget)
+			break;
+		if (DeleteFileW(entry.Path))
+			totalSize -= entry.Size;
+	}
+}
+
+void rage::pgRscChunkCache::Clear() const
+{
+	rageam::file::WPath searchPath = m_Directory / L"*.chunk";
+	rageam::file::Iterator it(searchPath);
+	rageam::file::FindData findData;
+	while (it.Next())
+	{
+		it.GetCurrent(findData);
+		DeleteFileW(findData.Path);
+	}
+}
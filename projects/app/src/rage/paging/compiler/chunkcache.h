@@ -0,0 +1,70 @@
+//
+// File: chunkcache.h
+//
+// Copyright (C) 2023-2024 ranstar74. All rights violated.
+//
+// Part of "Rage Am" Research Project.
+//
+#pragma once
+
+#include "am/file/path.h"
+#include "helpers/fourcc.h"
+#include "rage/atl/array.h"
+#include "rage/zlib/parallelstream.h"
+
+namespace rage
+{
+	/**
+	 * \brief Content-addressed file system cache of compressed resource chunks.
+	 * Every chunk is compressed as separate part of deflate stream that is primed only with the tail of
+	 * previous chunk, so compressed data depends only on chunk contents and can be reused between compilations.
+	 * When single texture or model changes, only chunks that contain it (and the chunk right after) are recompressed.
+	 * Output with and without cached entries is byte-identical, only compression is skipped.
+	 */
+	class pgRscChunkCache
+	{
+		static constexpr u32 ENTRY_MAGIC = FOURCC('R', 'C', 'C', 'E');
+		static constexpr u32 ENTRY_VERSION = 1;
+		static constexpr u64 DEFAULT_BUDGET = 1024ull * 1024ull * 1024ull; // 1GB
+
+		struct EntryHeader
+		{
+			u32 Magic;
+			u32 Version;
+			u64 Key;
+			u32 Size;			// Uncompressed chunk size
+			u32 CompressedSize;
+		};
+
+		rageam::file::WPath m_Directory;
+		std::atomic_uint32_t m_Hits = 0;
+		std::atomic_uint32_t m_Misses = 0;
+
+		rageam::file::WPath GetEntryPath(u64 key) const;
+		bool Load(u64 key, u32 size, atArray<char, u32>& outCompressed) const;
+		void Store(u64 key, u32 size, const atArray<char, u32>& compressed) const;
+
+	public:
+		// Oldest entries are removed if total size of cache exceeds given budget
+		pgRscChunkCache(const rageam::file::WPath& directory, u64 budget = DEFAULT_BUDGET);
+
+		// Key of chunk in cache, accounts chunk data, dictionary and compression parameters
+		static u64 ComputeKey(pConstVoid data, u32 size, pConstVoid dictionary, u32 dictionarySize, const zLibCompressionProfile& profile = {});
+
+		/**
+		 * \brief Writes compressed chunk from cache or compresses and stores it if chunk is not cached yet.
+		 * \param dictionary Data that precedes chunk in the stream, NULL for the first chunk.
+		 */
+		bool CompressChunk(pConstVoid data, u32 size, pConstVoid dictionary, u32 dictionarySize, const zLibParallelCompressor::WriteFn& writeFn,
+			const zLibCompressionProfile& profile = {});
+
+		// Removes the oldest entries until total size fits in given budget
+		void TrimToBudget(u64 budget) const;
+		// Removes all cached entries from file system
+		void Clear() const;
+
+		u32 GetHitCount() const { return m_Hits; }
+		u32 GetMissCount() const { return m_Misses; }
+		void ResetStats() { m_Hits = 0; m_Misses = 0; }
+	};
+}
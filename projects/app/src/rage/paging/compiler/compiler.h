@@ -7,6 +7,7 @@
 //
 #pragma once
 
+#include "chunkcache.h"
 #include "packer.h"
 #include "writer.h"
 #include "snapshotallocator.h"
@@ -66,10 +67,10 @@ namespace rage
 
 			// Possible fail reasons:
 			//  - Block size is larger than 100MB (pgStreamer limit)
-			pgRscPacker virtualPacker(virtualAllocator, 0);
+			pgRscPacker virtualPacker(virtualAllocator, 0, PackerStrategy);
 			if (success && !virtualPacker.Pack(data.VirtualChunks)) success = false;
 
-			pgRscPacker physicalPacker(physicalAllocator, data.VirtualChunks.ChunkCount);
+			pgRscPacker physicalPacker(physicalAllocator, data.VirtualChunks.ChunkCount, PackerStrategy);
 			if (success && !physicalPacker.Pack(data.PhysicalChunks)) success = false;
 
 			if (success)
@@ -83,6 +84,9 @@ namespace rage
 				// Step 4: Compress and write data to file.
 				ReportProgress(L"Writing to file", 0.9);
 				pgRscWriter writer;
+				writer.SetParallelCompression(ParallelCompression);
+				writer.SetCompressionProfile(CompressionProfile);
+				writer.SetChunkCache(ChunkCache);
 
 				// Possible fail reasons:
 				//  - Unable to open file for writing
@@ -99,6 +103,15 @@ namespace rage
 		// This function is thread-safe (invoked only from caller thread)
 		std::function<ResourceCompileCallback> CompileCallback;
 
+		// Deflates resource segments on multiple threads, much faster on large resources
+		bool ParallelCompression = false;
+		// Trades export time for file size, see zLibCompressionProfile::Fast / Max
+		zLibCompressionProfile CompressionProfile;
+		// Optimal packing reduces memory wasted in chunks at cost of slightly longer compilation
+		ePackerStrategy PackerStrategy = PACKER_STRATEGY_OPTIMAL;
+		// Compressed chunks that didn't change since last compilation are taken from this cache
+		pgRscChunkCache* ChunkCache = nullptr;
+
 		void ReportProgress(ConstWString message, double progress) const
 		{
 			if (!CompileCallback)
@@ -278,10 +278,299 @@ u8 rage::pgRscPacker::TryPack(u8 startBucket, u8 sizeShift)
 	return sizeShift;
 }
 
-rage::pgRscPacker::pgRscPacker(const pgSnapshotAllocator& allocator, u32 reservedChunks) : m_SortedBlocks(0)
+void rage::pgRscPacker::SearchOptimal(u8 sizeShift, SearchResult& best) const
+{
+	// Search state is kept in flat arrays indexed by sorted block index (search depth), recursion is not an option
+	// because resource may have tens of thousands of blocks.
+	// For every block we try (in this order):
+	//  - Chunk with the least free space that block fits in (best-fit);
+	//  - New chunk from the smallest bucket that block fits in;
+	//  - New chunk from the next larger bucket.
+	// So the first visited path is plain best-fit decreasing, all other paths are attempts to improve it.
+
+	u32 blockCount = m_SortedBlocks.GetSize();
+	u32 maxChunks = PG_MAX_CHUNKS - m_ReservedChunks;
+	// Main chunk must always be the first one, it can only be placed in the largest used bucket
+	bool pinFirstBlock = m_Allocator->IsVirtual();
+
+	u32 bucketChunkSizes[PG_MAX_BUCKETS];
+	u32 chunkSize = PG_MIN_CHUNK_SIZE << sizeShift;
+	for (u32& bucketChunkSize : bucketChunkSizes)
+	{
+		bucketChunkSize = chunkSize;
+		chunkSize /= 2;
+	}
+
+	// Sum of block sizes starting from given index, for lower bound of allocated size
+	atArray<u32, u32> remainingSizes(blockCount + 1);
+	remainingSizes[blockCount] = 0;
+	for (u32 i = blockCount; i > 0; i--)
+		remainingSizes[i - 1] = remainingSizes[i] + m_SortedBlocks[i - 1].Size;
+
+	static constexpr u8 NEW_CHUNK = 128; // Option value in range [128, 128 + PG_MAX_BUCKETS) opens new chunk in bucket
+
+	atArray<u8, u32> options(blockCount * SEARCH_MAX_OPTIONS);
+	atArray<u8, u32> optionCounts(blockCount);
+	atArray<u8, u32> optionIndices(blockCount);
+	atArray<u8, u32> blockChunks(blockCount);
+
+	SearchChunk chunks[PG_MAX_CHUNKS];
+	u8  chunkCount = 0;
+	u8  bucketCounts[PG_MAX_BUCKETS] = {};
+	u8  minBucket = 0;
+	u32 allocatedSize = 0;
+	u32 freeSize = 0; // Total free space in all opened chunks
+
+	auto generateOptions = [&](u32 depth)
+		{
+			u32 blockSize = m_SortedBlocks[depth].Size;
+			u8* depthOptions = &options[depth * SEARCH_MAX_OPTIONS];
+			u8  count = 0;
+
+			optionIndices[depth] = 0;
+
+			// Root block opens the very first chunk, try largest buckets first because all other chunks
+			// must be equal or smaller than the main one
+			if (depth == 0 && pinFirstBlock)
+			{
+				for (u8 bucket = 0; bucket < PG_MAX_BUCKETS && count < SEARCH_MAX_OPTIONS; bucket++)
+				{
+					u32 size = bucketChunkSizes[bucket];
+					if (size >= PG_MAX_CHUNK_SIZE || size < blockSize || size < PG_MIN_CHUNK_SIZE)
+						continue;
+					depthOptions[count++] = NEW_CHUNK + bucket;
+				}
+				optionCounts[depth] = count;
+				return;
+			}
+
+			// Best fit in already opened chunks
+			u32 bestFreeSize = u32(-1);
+			u8  bestChunk = u8(-1);
+			for (u8 i = 0; i < chunkCount; i++)
+			{
+				u32 chunkFreeSize = chunks[i].FreeSize;
+				if (chunkFreeSize >= blockSize && chunkFreeSize < bestFreeSize)
+				{
+					bestFreeSize = chunkFreeSize;
+					bestChunk = i;
+				}
+			}
+			if (bestChunk != u8(-1))
+				depthOptions[count++] = bestChunk;
+
+			// New chunk, starting from the smallest bucket
+			if (chunkCount < maxChunks)
+			{
+				for (s32 bucket = PG_MAX_BUCKETS - 1; bucket >= minBucket && count < SEARCH_MAX_OPTIONS; bucket--)
+				{
+					u32 size = bucketChunkSizes[bucket];
+					// Though chunks smaller than minimum are parsed fine, buddy allocator will allocate minimum size anyway
+					if (size < blockSize || size < PG_MIN_CHUNK_SIZE)
+						continue;
+					if (size >= PG_MAX_CHUNK_SIZE)
+						break;
+					if (bucketCounts[bucket] == datResourceInfo::GetMaxChunkCountInBucket(bucket))
+						continue;
+					depthOptions[count++] = NEW_CHUNK + static_cast<u8>(bucket);
+				}
+			}
+			optionCounts[depth] = count;
+		};
+
+	auto apply = [&](u32 depth)
+		{
+			u8  option = options[depth * SEARCH_MAX_OPTIONS + optionIndices[depth]];
+			u32 blockSize = m_SortedBlocks[depth].Size;
+			if (option < NEW_CHUNK)
+			{
+				chunks[option].FreeSize -= blockSize;
+				freeSize -= blockSize;
+				blockChunks[depth] = option;
+				return;
+			}
+
+			u8  bucket = option - NEW_CHUNK;
+			u32 size = bucketChunkSizes[bucket];
+			chunks[chunkCount] = SearchChunk(bucket, size - blockSize);
+			blockChunks[depth] = chunkCount;
+			chunkCount++;
+			bucketCounts[bucket]++;
+			allocatedSize += size;
+			freeSize += size - blockSize;
+			if (depth == 0 && pinFirstBlock)
+				minBucket = bucket;
+		};
+
+	auto undo = [&](u32 depth)
+		{
+			u8  chunk = blockChunks[depth];
+			u32 blockSize = m_SortedBlocks[depth].Size;
+			u8  option = options[depth * SEARCH_MAX_OPTIONS + optionIndices[depth]];
+			if (option < NEW_CHUNK)
+			{
+				chunks[chunk].FreeSize += blockSize;
+				freeSize += blockSize;
+				return;
+			}
+
+			// Chunks are opened and closed in stack order, so it's always the last one
+			u32 size = bucketChunkSizes[chunks[chunk].Bucket];
+			bucketCounts[chunks[chunk].Bucket]--;
+			chunkCount--;
+			allocatedSize -= size;
+			freeSize -= size - blockSize;
+			if (depth == 0 && pinFirstBlock)
+				minBucket = 0;
+		};
+
+	u32 nodeCount = 0;
+	s32 depth = 0;
+	generateOptions(0);
+	while (depth >= 0)
+	{
+		if (++nodeCount > SEARCH_MAX_NODES)
+		{
+			AM_DEBUGF("pgRscPacker::SearchOptimal() -> Node budget exceeded with size shift %u", sizeShift);
+			break;
+		}
+
+		// Every block is packed, store the result if it is better
+		if (static_cast<u32>(depth) == blockCount)
+		{
+			if (best.IsImprovedBy(allocatedSize, chunkCount))
+			{
+				best.AllocatedSize = allocatedSize;
+				best.ChunkCount = chunkCount;
+				best.SizeShift = sizeShift;
+				best.Chunks = atArray<SearchChunk>(chunks, chunks + chunkCount);
+				best.BlockChunks = atArray<u8>(blockChunks.begin(), blockChunks.end());
+			}
+
+			depth--;
+			undo(depth);
+			optionIndices[depth]++;
+			continue;
+		}
+
+		// Lower bound - remaining blocks that don't fit in free space will need at least that much more memory
+		if (optionIndices[depth] == 0)
+		{
+			u32 remainingSize = remainingSizes[depth];
+			u32 lowerBound = allocatedSize + (remainingSize > freeSize ? remainingSize - freeSize : 0);
+			if (!best.IsImprovedBy(lowerBound, chunkCount))
+				optionIndices[depth] = optionCounts[depth]; // Prune
+		}
+
+		// All options are exhausted, go back
+		if (optionIndices[depth] >= optionCounts[depth])
+		{
+			depth--;
+			if (depth >= 0)
+			{
+				undo(depth);
+				optionIndices[depth]++;
+			}
+			continue;
+		}
+
+		apply(depth);
+		depth++;
+		if (static_cast<u32>(depth) < blockCount)
+			generateOptions(depth);
+	}
+}
+
+void rage::pgRscPacker::ApplySearchResult(const SearchResult& result)
+{
+	m_BucketsDirty = true;
+	ResetBuckets();
+
+	// Chunks in every bucket are placed in order they were opened
+	u8 chunkIndices[PG_MAX_CHUNKS];
+	u8 bucketCounts[PG_MAX_BUCKETS] = {};
+	for (u16 i = 0; i < result.Chunks.GetSize(); i++)
+	{
+		chunkIndices[i] = bucketCounts[result.Chunks[i].Bucket]++;
+	}
+
+	for (u16 i = 0; i < m_SortedBlocks.GetSize(); i++)
+	{
+		u8 chunk = result.BlockChunks[i];
+		u8 bucket = result.Chunks[chunk].Bucket;
+		m_Buckets[bucket][chunkIndices[chunk]].Add(m_SortedBlocks[i].Index);
+	}
+}
+
+u8 rage::pgRscPacker::TryPackOptimal(u8 startBucket, u8 sizeShift)
+{
+	// Greedy packing is used as initial upper bound, search result is accepted only if it's strictly better
+	SearchResult best;
+	best.AllocatedSize = u32(-1);
+	best.ChunkCount = u8(-1);
+
+	u8 greedySizeShift = TryPack(startBucket, sizeShift);
+	if (greedySizeShift != 255)
+	{
+		datPackedChunks greedyPack = {};
+		greedyPack.SizeShift = greedySizeShift;
+		CalculateChunkCountInBuckets(greedyPack);
+
+		best.AllocatedSize = greedyPack.GetAllocatedSize();
+		best.ChunkCount = greedyPack.ChunkCount;
+		best.SizeShift = greedySizeShift;
+	}
+	u32 greedySize = best.AllocatedSize;
+
+	// Smallest size shift where the largest block fits in the first bucket
+	u8 minShift = PG_MIN_SIZE_SHIFT;
+	while ((PG_MIN_CHUNK_SIZE << minShift) < m_LargestBlock)
+		minShift++;
+
+	// Searching with size shift that can't fit all blocks in max chunk count is waste of node budget
+	u32 totalSize = GetTotalBlockSize(0, 0);
+	auto getMaxCapacity = [this](u8 shift)
+		{
+			u64 capacity = 0;
+			u32 chunksLeft = PG_MAX_CHUNKS - m_ReservedChunks;
+			u32 chunkSize = PG_MIN_CHUNK_SIZE << shift;
+			for (u8 i = 0; i < PG_MAX_BUCKETS; i++)
+			{
+				if (chunkSize < PG_MAX_CHUNK_SIZE && chunkSize >= PG_MIN_CHUNK_SIZE)
+				{
+					u32 count = MIN(chunksLeft, datResourceInfo::GetMaxChunkCountInBucket(i));
+					capacity += static_cast<u64>(chunkSize) * count;
+					chunksLeft -= count;
+				}
+				chunkSize /= 2;
+			}
+			return capacity;
+		};
+	while (minShift - PG_MIN_SIZE_SHIFT < SIZE_SHIFT_MASK && getMaxCapacity(minShift) < totalSize)
+		minShift++;
+
+	for (u8 shift = minShift; shift < minShift + SEARCH_SIZE_SHIFTS; shift++)
+	{
+		if (shift - PG_MIN_SIZE_SHIFT > SIZE_SHIFT_MASK)
+			break;
+		SearchOptimal(shift, best);
+	}
+
+	// Nothing better than greedy packing was found, it's still in buckets
+	if (!best.Chunks.Any())
+		return greedySizeShift;
+
+	AM_DEBUGF("pgRscPacker::TryPackOptimal() -> Reduced allocated size from %#x to %#x", greedySize, best.AllocatedSize);
+
+	ApplySearchResult(best);
+	return best.SizeShift;
+}
+
+rage::pgRscPacker::pgRscPacker(const pgSnapshotAllocator& allocator, u32 reservedChunks, ePackerStrategy strategy) : m_SortedBlocks(0)
 {
 	m_Allocator = &allocator;
 	m_ReservedChunks = reservedChunks;
+	m_Strategy = strategy;
 
 	CopyAndSortBlocks(allocator);
 }
@@ -314,7 +603,9 @@ bool rage::pgRscPacker::Pack(datPackedChunks& outPack)
 		startBucket, startShift, PG_MIN_CHUNK_SIZE << startShift);
 
 	// Do packing and calculate number of chunks in every bucket
-	u8 resultSizeShift = TryPack(startBucket, startShift);
+	u8 resultSizeShift = m_Strategy == PACKER_STRATEGY_OPTIMAL ?
+		TryPackOptimal(startBucket, startShift) :
+		TryPack(startBucket, startShift);
 
 	if (!AM_VERIFY(resultSizeShift != 255, "pgRscPacker::Pack() -> Resource cannot be packed because largest chunk size exceeds 100MB limit."))
 		return false;
@@ -14,6 +14,12 @@ namespace rage
 {
 	class pgSnapshotAllocator;
 
+	enum ePackerStrategy
+	{
+		PACKER_STRATEGY_GREEDY,		// First-fit decreasing with size shift retries, fast but may leave large fragmentation
+		PACKER_STRATEGY_OPTIMAL,	// Best-fit decreasing with bounded branch and bound over chunk sizes, never worse than greedy
+	};
+
 	struct datPackedChunks
 	{
 		u8 SizeShift;
@@ -23,6 +29,22 @@ namespace rage
 		u8 ChunkCount;
 
 		bool IsEmpty; // Whether there's any packed block
+
+		// Total size of all packed chunks, this is how much memory resource will take in game heap
+		u32 GetAllocatedSize() const
+		{
+			if (IsEmpty)
+				return 0;
+
+			u32 size = 0;
+			u32 chunkSize = PG_MIN_CHUNK_SIZE << SizeShift;
+			for (u8 i = 0; i < PG_MAX_BUCKETS; i++)
+			{
+				size += chunkSize * BucketCounts[i];
+				chunkSize /= 2;
+			}
+			return size;
+		}
 	};
 
 	/**
@@ -78,6 +100,38 @@ namespace rage
 		static constexpr u32 BUCKET_SHIFT = 4;
 		static constexpr u32 SIZE_SHIFT_MASK = 0xF;
 
+		// Optimal search is exponential in the worst case, we stop after visiting this many nodes per size shift
+		// and keep the best packing found so far. First visited path is plain best-fit decreasing.
+		static constexpr u32 SEARCH_MAX_NODES = 1 << 18;
+		// Number of size shifts to search, starting from the smallest one that fits the largest block
+		static constexpr u8 SEARCH_SIZE_SHIFTS = 3;
+		// Max number of alternatives for every block: best-fit chunk, smallest fitting new chunk, twice larger new chunk
+		static constexpr u8 SEARCH_MAX_OPTIONS = 3;
+
+		struct SearchChunk
+		{
+			u8	Bucket;
+			u32 FreeSize;
+		};
+
+		// Packing found by ::SearchOptimal, chunk index of every sorted block
+		struct SearchResult
+		{
+			u32						AllocatedSize = 0;
+			u8						ChunkCount = 0;
+			u8						SizeShift = 0;
+			atArray<SearchChunk>	Chunks;
+			atArray<u8>				BlockChunks;
+
+			// Whether packing with given size and chunk count is strictly better than this one
+			bool IsImprovedBy(u32 allocatedSize, u8 chunkCount) const
+			{
+				if (AllocatedSize != allocatedSize)
+					return allocatedSize < AllocatedSize;
+				return chunkCount < ChunkCount;
+			}
+		};
+
 		// Gets optimal starting bucket / shift to start packing with
 		static void GetInitialBucketAndSizeShift(u32 largestBlock, u8& bucket, u8& shift);
 
@@ -86,6 +140,7 @@ namespace rage
 		u32	m_ReservedChunks;
 
 		const pgSnapshotAllocator* m_Allocator;
+		ePackerStrategy			   m_Strategy;
 
 		u32						m_LargestBlock;
 		atArray<SortedBlock>	m_SortedBlocks;
@@ -123,8 +178,16 @@ namespace rage
 		// Tries to pack blocks with given min chunk size, if not successful, retries with larger min chunk size.
 		// Returns packed size shift, or 255 if wasn't able to pack.
 		u8 TryPack(u8 startBucket, u8 sizeShift);
+
+		// Bounded depth-first search over chunk choices with given size shift.
+		// Result is updated only if found packing is better than current one.
+		void SearchOptimal(u8 sizeShift, SearchResult& best) const;
+		// Moves search result into buckets
+		void ApplySearchResult(const SearchResult& result);
+		// Runs greedy packing and then tries to improve it with ::SearchOptimal, returns size shift or 255.
+		u8 TryPackOptimal(u8 startBucket, u8 sizeShift);
 	public:
-		pgRscPacker(const pgSnapshotAllocator& allocator, u32 reservedChunks);
+		pgRscPacker(const pgSnapshotAllocator& allocator, u32 reservedChunks, ePackerStrategy strategy = PACKER_STRATEGY_GREEDY);
 
 		bool Pack(datPackedChunks& outPack);
 	};
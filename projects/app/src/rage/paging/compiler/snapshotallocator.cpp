@@ -76,6 +76,10 @@ rage::pgSnapshotAllocator::Node* rage::pgSnapshotAllocator::Node::GetNext() cons
 
 rage::pgSnapshotAllocator::Node* rage::pgSnapshotAllocator::GetNodeFromBlock(pVoid block) const
 {
+	// Pointer within the first header can't be block start, also avoids reading before the heap
+	if (!IS_WITHIN(block, m_Heap, m_Offset) || DISTANCE(m_Heap, block) < sizeof(Node))
+		return nullptr;
+
 	Node* node = (Node*)((u64)block - sizeof(Node));
 	if (node->VerifyGuard())
 		return node;
@@ -84,28 +88,35 @@ rage::pgSnapshotAllocator::Node* rage::pgSnapshotAllocator::GetNodeFromBlock(pVo
 
 rage::pgSnapshotAllocator::Node* rage::pgSnapshotAllocator::FindBlockThatContainsPointer(pVoid ptr) const
 {
-	Node* node = GetRootNode();
-	while (node)
+	if (!IS_WITHIN(ptr, m_Heap, m_Offset))
+		return nullptr;
+
+	// Find the last node with block starting at or before the pointer
+	u32 left = 0;
+	u32 right = m_Nodes.GetSize();
+	while (left < right)
 	{
-		if (IS_WITHIN(ptr, node->GetBlock(), node->Size))
-			return node;
-		node = node->GetNext();
+		u32 middle = (left + right) / 2;
+		if ((u64)m_Nodes[middle]->GetBlock() <= (u64)ptr)
+			left = middle + 1;
+		else
+			right = middle;
 	}
+
+	if (left == 0)
+		return nullptr;
+
+	// Pointer may still be in the header of the next node
+	Node* node = m_Nodes[left - 1];
+	if (IS_WITHIN(ptr, node->GetBlock(), node->Size))
+		return node;
 	return nullptr;
 }
 
 rage::pgSnapshotAllocator::Node* rage::pgSnapshotAllocator::GetNodeFromBlockIndex(u32 index) const
 {
-	u32 i = 0;
-	Node* node = GetRootNode();
-	while (node)
-	{
-		if (i++ == index)
-			return node;
-		node = node->GetNext();
-	}
-	AM_ASSERT(false, "SnapshotAllocator::GetNodeFromBlockIndex() -> Block index %i is not valid.", index);
-	return nullptr; // Assert won't return
+	AM_ASSERT(index < m_Nodes.GetSize(), "SnapshotAllocator::GetNodeFromBlockIndex() -> Block index %i is not valid.", index);
+	return m_Nodes[index];
 }
 
 rage::pgSnapshotAllocator::Node* rage::pgSnapshotAllocator::GetRootNode() const
@@ -119,7 +130,7 @@ rage::pgSnapshotAllocator::Node* rage::pgSnapshotAllocator::GetRootNode() const
 void rage::pgSnapshotAllocator::SanityCheck() const
 {
 #ifdef DEBUG
-	if (m_NodeCount > 0)
+	if (m_Nodes.Any())
 	{
 		u32 nodeCount = 0;
 		Node* node = (Node*)m_Heap;
@@ -130,7 +141,7 @@ void rage::pgSnapshotAllocator::SanityCheck() const
 			nodeCount++;
 			node = node->GetNext();
 		}
-		AM_ASSERT(nodeCount == m_NodeCount, "pgSnapshotAllocator::SanityCheck() -> Node count mismatch.");
+		AM_ASSERT(nodeCount == m_Nodes.GetSize(), "pgSnapshotAllocator::SanityCheck() -> Node count mismatch.");
 	}
 #endif
 }
@@ -173,9 +184,10 @@ pVoid rage::pgSnapshotAllocator::Allocate(u32 size)
 	Node* header = new (block) Node(size);
 
 	m_Offset += size + sizeof(Node);
-	m_NodeCount++;
+	m_Nodes.Add(header);
 
 	AM_ASSERT(m_Offset < m_HeapSize, "SnapshotAllocator::Allocate() -> Out of memory.");
+	AM_ASSERT(m_Nodes.GetSize() <= UINT16_MAX, "SnapshotAllocator::Allocate() -> Too many blocks, block index is 16 bit.");
 
 	return header->GetBlock();
 }
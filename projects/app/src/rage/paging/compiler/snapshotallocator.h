@@ -59,10 +59,12 @@ namespace rage
 		pVoid m_Heap;
 		u32	m_Offset = 0;
 		u32 m_HeapSize = 0;
-		u16 m_NodeCount = 0;
+		// Nodes in allocation order, allocator is linear so they're also sorted by address
+		atArray<Node*, u32> m_Nodes;
 
 		Node* GetNodeFromBlock(pVoid block) const;
-		Node* FindBlockThatContainsPointer(pVoid ptr) const; // Used for offset ref
+		// Used for offset ref, binary search in sorted nodes
+		Node* FindBlockThatContainsPointer(pVoid ptr) const;
 		Node* GetNodeFromBlockIndex(u32 index) const;
 		Node* GetRootNode() const;
 
@@ -107,7 +109,7 @@ namespace rage
 		/**
 		 * \brief Gets total number of allocated blocks.
 		 */
-		u16 GetBlockCount() const { return m_NodeCount; }
+		u16 GetBlockCount() const { return static_cast<u16>(m_Nodes.GetSize()); }
 
 		/**
 		 * \brief Gets whether this allocator contains virtual or physical data.
@@ -6,10 +6,14 @@
 #include "helpers/format.h"
 #include "rage/system/tls.h"
 #include "rage/zlib/stream.h"
+#include "rage/zlib/parallelstream.h"
 
+#include "chunkcache.h"
 #include "snapshotallocator.h"
 #include "am/file/fileutils.h"
 
+#include <psapi.h>
+
 rage::datResourceHeader rage::datCompileData::GetHeader() const
 {
 	u32 virtualData = datResourceInfo::EncodeChunks(VirtualChunks);
@@ -49,21 +53,9 @@ bool rage::pgRscWriter::WriteHeader() const
 	return AM_VERIFY(dwBytesWritten == sizeof datResourceHeader, "pgRscWriter::WriteHeader() -> Failed to write file!");
 }
 
-bool rage::pgRscWriter::WriteData(const datPackedChunks& packedPage, const pgSnapshotAllocator* pAllocator)
+void rage::pgRscWriter::BuildSegments(const datPackedChunks& packedPage, const pgSnapshotAllocator* pAllocator, atArray<zLibSegment, u32>& outSegments)
 {
-	if (packedPage.IsEmpty)
-		return true;
-
 	u32 chunkSize = PG_MIN_CHUNK_SIZE << packedPage.SizeShift;
-
-	// Allocate buffer that is large enough to compress all chunks in single pass (it is much faster)
-	u32 bufferSize = ComputeUsedSize(packedPage);
-	char* buffer = new char[bufferSize];
-	memset(buffer, 0, bufferSize);
-
-	AM_DEBUGF("pgRscWriter::WriteData() -> Using %u as buffer size", bufferSize);
-
-	u32 bufferOffset = 0;
 	for (u8 i = 0; i < PG_MAX_BUCKETS; i++)
 	{
 		// Each bucket has different amount of chunks (from 1 to 127),
@@ -74,55 +66,117 @@ bool rage::pgRscWriter::WriteData(const datPackedChunks& packedPage, const pgSna
 			if (!chunk.Any())
 				continue;
 
-			// Copy every block data to chunk buffer
+			// Blocks are referenced in place, the rest of chunk is padded with zeroes
 			u32 chunkOffset = 0;
 			for (u16 index : chunk)
 			{
-				pVoid block = pAllocator->GetBlock(index);
 				u32 blockSize = pAllocator->GetBlockSize(index);
-
-				m_RawSize += blockSize;
-
-				memcpy(buffer + bufferOffset + chunkOffset, block, blockSize);
+				outSegments.Add({ pAllocator->GetBlock(index), blockSize });
 				chunkOffset += blockSize;
+				m_RawSize += blockSize;
 			}
+			if (chunkOffset < chunkSize)
+				outSegments.Add({ nullptr, chunkSize - chunkOffset });
 
-			bufferOffset += chunkSize;
 			m_AllocSize += chunkSize;
 		}
 		chunkSize /= 2;
 	}
+}
 
-	bool success = CompressAndWrite(buffer, bufferSize);
-	delete[] buffer;
-	return success;
+bool rage::pgRscWriter::WriteData(const datPackedChunks& packedPage, const pgSnapshotAllocator* pAllocator)
+{
+	if (packedPage.IsEmpty)
+		return true;
+
+	// Snapshot blocks are compressed directly from allocator, so resource data is never copied in single buffer
+	atArray<zLibSegment, u32> segments;
+	BuildSegments(packedPage, pAllocator, segments);
+
+	AM_DEBUGF("pgRscWriter::WriteData() -> Compressing %u bytes in %u segments", ComputeUsedSize(packedPage), segments.GetSize());
+
+	if (m_ChunkCache)				return CompressAndWriteCached(packedPage, pAllocator);
+	if (m_ParallelCompression)		return CompressAndWriteParallel(segments);
+	return CompressAndWrite(segments);
 }
 
-bool rage::pgRscWriter::CompressAndWrite(pVoid data, u32 dataSize)
+bool rage::pgRscWriter::CompressAndWrite(const atArray<zLibSegment, u32>& segments)
 {
-	DWORD dwBytesWritten;
+	if (!m_Compressor)
+		m_Compressor = std::make_unique<zLibCompressor>(COMPRESS_BUFFER_SIZE, m_CompressionProfile);
+	return m_Compressor->CompressSegments(segments.GetItems(), segments.GetSize(), [this](pConstVoid compressedBuffer, u32 compressedSize)
+		{
+			return WriteCompressed(compressedBuffer, compressedSize);
+		});
+}
 
-	bool done = false;
-	while (!done)
-	{
-		pVoid compressedBuffer;
-		u32	compressedSize;
+bool rage::pgRscWriter::CompressAndWriteParallel(const atArray<zLibSegment, u32>& segments)
+{
+	return zLibParallelCompressor::CompressSegments(segments.GetItems(), segments.GetSize(), [this](pConstVoid compressedBuffer, u32 compressedSize)
+		{
+			return WriteCompressed(compressedBuffer, compressedSize);
+		}, nullptr, 0, m_CompressionProfile);
+}
+
+bool rage::pgRscWriter::CompressAndWriteCached(const datPackedChunks& packedPage, const pgSnapshotAllocator* pAllocator)
+{
+	static constexpr u32 DICTIONARY_SIZE = zLibParallelCompressor::DICTIONARY_SIZE;
 
-		done = m_Compressor.Compress(data, dataSize, compressedBuffer, compressedSize);
-		m_FileSize += compressedSize;
-		AM_DEBUGF("pgRscWriter::CompressAndWrite() -> Compressed %u to %u", dataSize, compressedSize);
+	auto writeFn = [this](pConstVoid compressedBuffer, u32 compressedSize)
+		{
+			return WriteCompressed(compressedBuffer, compressedSize);
+		};
 
-		WriteFile(m_File, compressedBuffer, compressedSize, &dwBytesWritten, NULL);
-		if (!AM_VERIFY(dwBytesWritten == compressedSize, 
-			"pgRscWriter::CompressAndWrite() -> Tried to write %u bytes, but only %u been written!",
-			compressedSize, dwBytesWritten))
+	// Chunk cache needs contiguous chunk to compute its key, we gather one chunk at a time right after
+	// the tail of previous chunks (deflate window), so memory is bounded by the largest chunk size
+	u32 chunkSize = PG_MIN_CHUNK_SIZE << packedPage.SizeShift;
+	amUPtr<char[]> buffer = std::make_unique<char[]>(DICTIONARY_SIZE + chunkSize);
+	char* chunkBuffer = buffer.get() + DICTIONARY_SIZE;
+	u32 dictionarySize = 0;
+	for (u8 i = 0; i < PG_MAX_BUCKETS; i++)
+	{
+		for (const auto& chunk : packedPage.Buckets[i])
 		{
-			return false;
+			if (!chunk.Any())
+				continue;
+
+			u32 chunkOffset = 0;
+			for (u16 index : chunk)
+			{
+				u32 blockSize = pAllocator->GetBlockSize(index);
+				memcpy(chunkBuffer + chunkOffset, pAllocator->GetBlock(index), blockSize);
+				chunkOffset += blockSize;
+			}
+			memset(chunkBuffer + chunkOffset, 0, chunkSize - chunkOffset);
+
+			// Chunk is primed with the tail of previous chunks, the first one in segment starts clean
+			if (!m_ChunkCache->CompressChunk(chunkBuffer, chunkSize, chunkBuffer - dictionarySize, dictionarySize, writeFn, m_CompressionProfile))
+				return false;
+
+			// Move the new tail right before chunk buffer
+			u32 newDictionarySize = MIN(dictionarySize + chunkSize, DICTIONARY_SIZE);
+			memmove(chunkBuffer - newDictionarySize, chunkBuffer + chunkSize - newDictionarySize, newDictionarySize);
+			dictionarySize = newDictionarySize;
 		}
+		chunkSize /= 2;
 	}
+
+	AM_DEBUGF("pgRscWriter::CompressAndWriteCached() -> Cache hits: %u, misses: %u",
+		m_ChunkCache->GetHitCount(), m_ChunkCache->GetMissCount());
 	return true;
 }
 
+bool rage::pgRscWriter::WriteCompressed(pConstVoid compressedBuffer, u32 compressedSize)
+{
+	m_FileSize += compressedSize;
+
+	DWORD dwBytesWritten;
+	WriteFile(m_File, compressedBuffer, compressedSize, &dwBytesWritten, NULL);
+	return AM_VERIFY(dwBytesWritten == compressedSize,
+		"pgRscWriter::WriteCompressed() -> Tried to write %u bytes, but only %u been written!",
+		compressedSize, dwBytesWritten);
+}
+
 bool rage::pgRscWriter::OpenResource()
 {
 	m_File = rageam::file::CreateNew(m_Path);
@@ -149,6 +203,12 @@ void rage::pgRscWriter::PrintWriteStats() const
 	AM_TRACEF("Raw Size: %s", FormatSize(m_RawSize));
 	AM_TRACEF("File Size: %s", FormatSize(m_FileSize));
 	AM_TRACEF("Alloc Size: %s", FormatSize(m_AllocSize));
+	AM_TRACEF("Compression: %s, level %i, memory level %i, strategy %i", ZLIB_BACKEND_NAME,
+		m_CompressionProfile.Level, m_CompressionProfile.MemoryLevel, m_CompressionProfile.Strategy);
+
+	PROCESS_MEMORY_COUNTERS memoryCounters;
+	if (GetProcessMemoryInfo(GetCurrentProcess(), &memoryCounters, sizeof(memoryCounters)))
+		AM_TRACEF("Peak Working Set: %s", FormatSize(memoryCounters.PeakWorkingSetSize));
 }
 
 bool rage::pgRscWriter::Write(const wchar_t* path, const datCompileData& writeData)
@@ -170,6 +230,7 @@ bool rage::pgRscWriter::Write(const wchar_t* path, const datCompileData& writeDa
 	PrintWriteStats();
 	CloseResource();
 
+	m_Compressor = nullptr;
 	m_WriteData = nullptr;
 	m_Path = nullptr;
 
@@ -16,6 +16,7 @@
 namespace rage
 {
 	class pgSnapshotAllocator;
+	class pgRscChunkCache;
 
 	/**
 	 * \brief Contains resource version and packed chunks.
@@ -46,15 +47,28 @@ namespace rage
 
 		HANDLE m_File;
 
-		zLibCompressor m_Compressor = { 30 * 1024u * 1024u }; // 30MB~ buffer
+		static constexpr u32 COMPRESS_BUFFER_SIZE = 1024u * 1024u; // Compressed data is written once buffer is full
+
+		// Created on first write with current profile, virtual and physical data share single stream
+		amUPtr<zLibCompressor> m_Compressor;
+		zLibCompressionProfile m_CompressionProfile;
+		bool m_ParallelCompression = false;
+		pgRscChunkCache* m_ChunkCache = nullptr;
 
 		const datCompileData* m_WriteData;
 		const wchar_t* m_Path;
 
 		u32 ComputeUsedSize(const datPackedChunks& packedPage) const;
 		bool WriteHeader() const;
+		// Scatter-gather list of snapshot blocks placed in packed chunks and zero padding at the end of every chunk
+		void BuildSegments(const datPackedChunks& packedPage, const pgSnapshotAllocator* pAllocator, atArray<zLibSegment, u32>& outSegments);
 		bool WriteData(const datPackedChunks& packedPage, const pgSnapshotAllocator* pAllocator);
-		bool CompressAndWrite(pVoid data, u32 dataSize);
+		bool CompressAndWrite(const atArray<zLibSegment, u32>& segments);
+		// Splits data on slices that are compressed on worker threads, see zLibParallelCompressor
+		bool CompressAndWriteParallel(const atArray<zLibSegment, u32>& segments);
+		// Compresses every chunk separately and reuses compressed chunks from cache, see pgRscChunkCache
+		bool CompressAndWriteCached(const datPackedChunks& packedPage, const pgSnapshotAllocator* pAllocator);
+		bool WriteCompressed(pConstVoid compressedBuffer, u32 compressedSize);
 
 		bool OpenResource();
 		void CloseResource() const;
@@ -64,6 +78,13 @@ namespace rage
 	public:
 		pgRscWriter() = default;
 
+		// Compresses large chunks on multiple threads, output is slightly larger than single-threaded one
+		void SetParallelCompression(bool toggle) { m_ParallelCompression = toggle; }
+		// Deflate level and strategy, chunk cache keeps entries of different profiles separately
+		void SetCompressionProfile(const zLibCompressionProfile& profile) { m_CompressionProfile = profile; }
+		// If set, chunks are compressed independently and cached, this takes precedence over parallel compression
+		void SetChunkCache(pgRscChunkCache* cache) { m_ChunkCache = cache; }
+
 		bool Write(const wchar_t* path, const datCompileData& writeData);
 	};
 }
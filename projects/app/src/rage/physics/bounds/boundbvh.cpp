@@ -153,7 +153,7 @@ void rage::phBoundBVH::BuildBVH()
 	}
 
 	// This is where the tree is built
-	m_BVH->BuildFromPrimitiveData(primitiveDatas.get(), primitiveCount, 4);
+	m_BVH->BuildFromPrimitiveData(primitiveDatas.get(), primitiveCount, 4, PH_BVH_BUILD_BINNED_SAH);
 
 	// BVH sorts primitives internaly for faster access (they're indexed by start position and count)
 	// We have to manually remap bounds:
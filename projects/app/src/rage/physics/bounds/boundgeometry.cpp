@@ -19,6 +19,89 @@ void rage::phBoundPolyhedron::ComputeNeighbors() const
 
 	// Refer to diagram in header to understand things better
 
+	auto getNextIndexL = [](u16 index) -> u16 { return (index + 1) % 3; };
+	// Relatively to polygon 1, adjacent polygon 2 indices are incrementing in opposite direction
+	auto getNextIndexR = [](u16 index) -> u16 { return index == 0 ? 2 : index - 1; };
+
+	// Polygon with edge A:B is adjacent to polygon with opposite edge B:A. All directed edges are stored in a single table,
+	// grouped by the first vertex index (which works as perfect hash of the edge) and sorted by polygon index within group,
+	// so we link exactly the same polygons as ComputeNeighborsReference does
+	struct Edge
+	{
+		u32 Polygon;
+		u16 To;
+		u16 PolygonVertex; // Index of the first edge vertex in polygon
+	};
+
+	amUPtr<u32[]> vertexEdgeStarts = std::make_unique<u32[]>(m_NumVertices + 1);
+	memset(vertexEdgeStarts.get(), 0, sizeof(u32) * (m_NumVertices + 1));
+	for (u32 i = 0; i < m_NumPolygons; i++)
+	{
+		phPolygon& poly = GetPolygon(i);
+		if (m_Type == PH_BOUND_BVH && !poly.IsPolygon())
+			continue;
+
+		poly.ResetNeighboors();
+
+		for (u32 k = 0; k < 3; k++)
+			vertexEdgeStarts[poly.GetVertexIndex(k) + 1]++;
+	}
+	for (u32 i = 0; i < m_NumVertices; i++)
+		vertexEdgeStarts[i + 1] += vertexEdgeStarts[i];
+
+	amUPtr<Edge[]> edges = std::make_unique<Edge[]>(vertexEdgeStarts[m_NumVertices]);
+	amUPtr<u32[]>  vertexEdgeCursors = std::make_unique<u32[]>(m_NumVertices);
+	memcpy(vertexEdgeCursors.get(), vertexEdgeStarts.get(), sizeof(u32) * m_NumVertices);
+	for (u32 i = 0; i < m_NumPolygons; i++)
+	{
+		phPolygon& poly = GetPolygon(i);
+		if (m_Type == PH_BOUND_BVH && !poly.IsPolygon())
+			continue;
+
+		// Order of polygon vertices in the reference implementation
+		for (u16 k = 0; k < 3; k++)
+		{
+			u16 prevK = getNextIndexR(k);
+			u16 from = poly.GetVertexIndex(prevK);
+			edges[vertexEdgeCursors[from]++] = { i, poly.GetVertexIndex(k), prevK };
+		}
+	}
+
+	for (u32 lhsPolyIdx = 0; lhsPolyIdx < m_NumPolygons; lhsPolyIdx++)
+	{
+		phPolygon& lhsPoly = GetPolygon(lhsPolyIdx);
+		if (m_Type == PH_BOUND_BVH && !lhsPoly.IsPolygon())
+			continue;
+
+		for (u16 lhsPolyVertIdx = 0; lhsPolyVertIdx < 3; lhsPolyVertIdx++)
+		{
+			u16 lhsVertexIdx = lhsPoly.GetVertexIndex(lhsPolyVertIdx);
+			u16 lhsVertexIdxNext = lhsPoly.GetVertexIndex(getNextIndexL(lhsPolyVertIdx));
+
+			u32 edgesEnd = vertexEdgeStarts[lhsVertexIdxNext + 1];
+			for (u32 i = vertexEdgeStarts[lhsVertexIdxNext]; i < edgesEnd; i++)
+			{
+				const Edge& edge = edges[i];
+
+				// Each pair is linked only once, from polygon with lower index
+				if (edge.To != lhsVertexIdx || edge.Polygon <= lhsPolyIdx)
+					continue;
+
+				lhsPoly.SetNeighborIndex(lhsPolyVertIdx, edge.Polygon);
+				GetPolygon(edge.Polygon).SetNeighborIndex(edge.PolygonVertex, lhsPolyIdx);
+				break;
+			}
+		}
+	}
+}
+
+void rage::phBoundPolyhedron::ComputeNeighborsReference() const
+{
+	if (m_NumPolygons == 0)
+		return;
+
+	// Refer to diagram in header to understand things better
+
 	amUPtr<atArray<u32>[]> vertexToPolys = std::make_unique<atArray<u32>[]>(m_NumVertices);
 
 	// Generate vertex to polygons map, this allows us to quickly look up all polygons that share vertex at index X
@@ -140,6 +223,98 @@ void rage::phBoundPolyhedron::RecomputeOctantMap()
 }
 
 void rage::phBoundPolyhedron::ComputeOctantMap()
+{
+	if (m_Type == PH_BOUND_BVH)
+		return;
+
+	if (m_NumShrunkVertices == 0)
+		return;
+
+	// Same as OctantMasks in ComputeOctantMapReference
+	static const Vec3V OctantDirs[8] =
+	{
+		{  1.0f,  1.0f,  1.0f },
+		{ -1.0f,  1.0f,  1.0f },
+		{  1.0f, -1.0f,  1.0f },
+		{ -1.0f, -1.0f,  1.0f },
+		{  1.0f,  1.0f, -1.0f },
+		{ -1.0f,  1.0f, -1.0f },
+		{  1.0f, -1.0f, -1.0f },
+		{ -1.0f, -1.0f, -1.0f },
+	};
+
+	// Octant contains vertices that are not behind any other vertex in octant direction. Unlike ComputeOctantMapReference,
+	// we go through vertices once and add every vertex to all octants at once. Octant vertices never are behind each other,
+	// so vertex can't be both in front of one octant vertex and behind another one - the order of comparisons doesn't matter
+	// and we can check vertex that was in front last time first, neighbor vertices are mostly behind the same octant vertex
+	u32 vertexCount = m_NumShrunkVertices;
+	amUPtr<Vec3V[]> octantVertices = std::make_unique<Vec3V[]>(static_cast<size_t>(vertexCount) * phOctantMap::MAX_OCTANTS);
+	amUPtr<u32[]>   octantIndexBuffer = std::make_unique<u32[]>(static_cast<size_t>(vertexCount) * phOctantMap::MAX_OCTANTS);
+	u32  octantIndexCounts[8] = {};
+	u32  octantMaxIndexCounts[8] = {};
+	u32  octantLastInFront[8] = {};
+	u32* octantIndices[8];
+	for (u32 octant = 0; octant < phOctantMap::MAX_OCTANTS; octant++)
+		octantIndices[octant] = octantIndexBuffer.get() + static_cast<size_t>(vertexCount) * octant;
+
+	for (u32 vertexIndex = 0; vertexIndex < vertexCount; vertexIndex++)
+	{
+		Vec3V vertex = DecompressVertex(vertexIndex, true);
+		for (u32 octant = 0; octant < phOctantMap::MAX_OCTANTS; octant++)
+		{
+			// Vertices are stored multiplied by octant direction, so 'in front' is simply greater or equal
+			Vec3V* vertices = octantVertices.get() + static_cast<size_t>(vertexCount) * octant;
+			u32* indices = octantIndices[octant];
+			u32& count = octantIndexCounts[octant];
+			Vec3V octantVertex = vertex * OctantDirs[octant];
+
+			u32& lastInFront = octantLastInFront[octant];
+			if (lastInFront < count && vertices[lastInFront] >= octantVertex)
+				continue;
+
+			// Vertex is either behind some octant vertex or removes all octant vertices that are behind it
+			u32 newCount = 0;
+			bool behind = false;
+			for (u32 i = 0; i < count; i++)
+			{
+				Vec3V toVertex = octantVertex - vertices[i];
+				if (toVertex <= S_ZERO)
+				{
+					lastInFront = i;
+					behind = true;
+					break;
+				}
+
+				if (toVertex >= S_ZERO)
+					continue;
+
+				vertices[newCount] = vertices[i];
+				indices[newCount] = indices[i];
+				newCount++;
+			}
+
+			if (behind)
+				continue;
+
+			vertices[newCount] = octantVertex;
+			indices[newCount] = vertexIndex;
+			count = newCount + 1;
+			octantMaxIndexCounts[octant] = Max(octantMaxIndexCounts[octant], count);
+		}
+	}
+
+	// Original implementation builds octants in single buffer of vertex count size and gives up once it overflows
+	u32 totalIndexCount = 0;
+	for (u32 octant = 0; octant < phOctantMap::MAX_OCTANTS; octant++)
+	{
+		if (totalIndexCount + octantMaxIndexCounts[octant] > vertexCount)
+			return;
+		totalIndexCount += octantIndexCounts[octant];
+	}
+	OctantMapAllocateAndCopy(octantIndexCounts, octantIndices);
+}
+
+void rage::phBoundPolyhedron::ComputeOctantMapReference()
 {
 	if (m_Type == PH_BOUND_BVH)
 		return;
@@ -616,7 +791,319 @@ void rage::phBoundGeometry::ShrinkPolysOrVertsByMargin(float margin, float t, Ve
 	delete[] shrunkVerts;
 }
 
+namespace
+{
+	// Segment from shrunk vertex to original vertex against polygon before and after shrinking
+	bool ShrinkSegmentIntersectsPolygon(
+		const rage::Vec3V& segmentPos, const rage::Vec3V& segmentDir, float maxDistance,
+		const rage::Vec3V& v1, const rage::Vec3V& v2, const rage::Vec3V& v3,
+		const rage::Vec3V& vs1, const rage::Vec3V& vs2, const rage::Vec3V& vs3)
+	{
+		float distance;
+		if (rageam::graphics::ShapeTest::RayIntersectsTriangle(segmentPos, segmentDir, v1, v2, v3, distance) && distance <= maxDistance)
+			return true;
+		if (rageam::graphics::ShapeTest::RayIntersectsTriangle(segmentPos, segmentDir, vs1, vs2, vs3, distance) && distance <= maxDistance)
+			return true;
+		return false;
+	}
+
+	struct ShrinkBox
+	{
+		float Min[3];
+		float Max[3];
+
+		void Reset()
+		{
+			for (int i = 0; i < 3; i++)
+			{
+				Min[i] = FLT_MAX;
+				Max[i] = -FLT_MAX;
+			}
+		}
+
+		void Add(const rage::Vec3V& point)
+		{
+			float coords[3] = { point.X(), point.Y(), point.Z() };
+			for (int i = 0; i < 3; i++)
+			{
+				// Comparisons with NaN are false, so NaN point won't make box look finite
+				if (coords[i] < Min[i] || !(coords[i] == coords[i])) Min[i] = coords[i];
+				if (coords[i] > Max[i] || !(coords[i] == coords[i])) Max[i] = coords[i];
+			}
+		}
+
+		void Add(const ShrinkBox& other)
+		{
+			for (int i = 0; i < 3; i++)
+			{
+				Min[i] = rage::Min(Min[i], other.Min[i]);
+				Max[i] = rage::Max(Max[i], other.Max[i]);
+			}
+		}
+
+		bool IsFinite() const
+		{
+			for (int i = 0; i < 3; i++)
+			{
+				if (!std::isfinite(Min[i]) || !std::isfinite(Max[i]))
+					return false;
+			}
+			return true;
+		}
+	};
+
+	// Uniform grid for phBoundGeometry::TryShrinkByMargin, every polygon is placed in all cells that overlap
+	// bounding box of both original and shrunk polygon, so segment can only hit polygons in cells its own box overlaps.
+	// Polygons with non-finite vertices (degenerate shrinking) can't be placed in grid and are tested against every segment
+	class ShrinkPolygonGrid
+	{
+		static constexpr int MAX_CELLS_PER_AXIS = 128;
+		static constexpr u32 MAX_CELLS_PER_POLYGON = 2;
+		// Intersection point may be computed slightly outside of triangle or segment, boxes are expanded by this fraction of bound size or position
+		static constexpr float BOX_PADDING = 0.0001f;
+
+		u32           m_PolygonCount;
+		ShrinkBox     m_Bounds;
+		float         m_CellSizeInv[3] = {};
+		int           m_CellCounts[3] = { 1, 1, 1 };
+		float         m_Padding = 0.0f;
+		amUPtr<u32[]> m_CellStarts;		// Offset of the first polygon of every cell in m_CellPolygons, the last one is the total count
+		amUPtr<u32[]> m_CellPolygons;
+		amUPtr<u32[]> m_PolygonStamps;	// Last segment that tested polygon, polygon may be stored in multiple cells
+		u32           m_Stamp = 0;
+		rage::List<u32> m_UnboundedPolygons;
+
+		void GetCellRange(const ShrinkBox& box, int outMin[3], int outMax[3]) const
+		{
+			for (int i = 0; i < 3; i++)
+			{
+				float min = (box.Min[i] - m_Bounds.Min[i]) * m_CellSizeInv[i];
+				float max = (box.Max[i] - m_Bounds.Min[i]) * m_CellSizeInv[i];
+				outMin[i] = static_cast<int>(rage::Clamp(min, 0.0f, static_cast<float>(m_CellCounts[i] - 1)));
+				outMax[i] = static_cast<int>(rage::Clamp(max, 0.0f, static_cast<float>(m_CellCounts[i] - 1)));
+			}
+		}
+
+		u32 GetCellIndex(int x, int y, int z) const { return (z * m_CellCounts[1] + y) * m_CellCounts[0] + x; }
+
+	public:
+		ShrinkPolygonGrid(const rage::phBoundPolyhedron& bound, const rage::Vec3V* vertices, const rage::Vec3V* shrunkVertices)
+		{
+			u32 polygonCount = bound.GetPolygonCount();
+			m_PolygonCount = polygonCount;
+			amUPtr<ShrinkBox[]> polygonBoxes = std::make_unique<ShrinkBox[]>(polygonCount);
+			m_PolygonStamps = std::make_unique<u32[]>(polygonCount);
+
+			// Compute box of every polygon and average polygon size, it is used as cell size
+			m_Bounds.Reset();
+			double averageSize = 0.0;
+			u32 boundedPolygonCount = 0;
+			for (u32 i = 0; i < polygonCount; i++)
+			{
+				m_PolygonStamps[i] = 0;
+
+				const rage::phPolygon& poly = bound.GetPolygon(static_cast<u16>(i));
+				ShrinkBox& box = polygonBoxes[i];
+				box.Reset();
+				for (int k = 0; k < 3; k++)
+				{
+					u16 vertexIndex = poly.GetVertexIndex(k);
+					box.Add(vertices[vertexIndex]);
+					box.Add(shrunkVertices[vertexIndex]);
+				}
+
+				if (!box.IsFinite())
+				{
+					m_UnboundedPolygons.Add(i);
+					continue;
+				}
+
+				m_Bounds.Add(box);
+				averageSize += rage::Max(box.Max[0] - box.Min[0], rage::Max(box.Max[1] - box.Min[1], box.Max[2] - box.Min[2]));
+				boundedPolygonCount++;
+			}
+
+			if (boundedPolygonCount == 0)
+			{
+				m_CellStarts = std::make_unique<u32[]>(2);
+				m_CellStarts[0] = m_CellStarts[1] = 0;
+				return;
+			}
+
+			float extents[3];
+			float maxExtent = 0.0f;
+			float maxCoord = 0.0f;
+			for (int i = 0; i < 3; i++)
+			{
+				extents[i] = m_Bounds.Max[i] - m_Bounds.Min[i];
+				maxExtent = rage::Max(maxExtent, extents[i]);
+				maxCoord = rage::Max(maxCoord, rage::Max(fabsf(m_Bounds.Min[i]), fabsf(m_Bounds.Max[i])));
+			}
+			// Rounding error grows with magnitude of coordinates, not only with size of the bound
+			m_Padding = rage::Max(maxExtent, maxCoord) * BOX_PADDING;
+
+			// Pick cell size close to polygon size, but keep cell count proportional to polygon count
+			float cellSize = static_cast<float>(averageSize / boundedPolygonCount);
+			cellSize = rage::Max(cellSize, maxExtent / MAX_CELLS_PER_AXIS);
+			u64 maxCellCount = rage::Max(1u, boundedPolygonCount * MAX_CELLS_PER_POLYGON);
+			while (true)
+			{
+				u64 cellCount = 1;
+				for (int i = 0; i < 3; i++)
+				{
+					int count = cellSize > 0.0f ? static_cast<int>(ceilf(extents[i] / cellSize)) : 1;
+					m_CellCounts[i] = rage::Min(rage::Max(count, 1), MAX_CELLS_PER_AXIS);
+					cellCount *= m_CellCounts[i];
+				}
+				if (cellCount <= maxCellCount)
+					break;
+				cellSize *= cbrtf(static_cast<float>(cellCount) / static_cast<float>(maxCellCount)) * 1.01f;
+			}
+			for (int i = 0; i < 3; i++)
+				m_CellSizeInv[i] = extents[i] > 0.0f ? static_cast<float>(m_CellCounts[i]) / extents[i] : 0.0f;
+
+			// Count polygons in every cell, convert counts to offsets and then fill cells
+			u32 cellCount = m_CellCounts[0] * m_CellCounts[1] * m_CellCounts[2];
+			m_CellStarts = std::make_unique<u32[]>(cellCount + 1);
+			memset(m_CellStarts.get(), 0, sizeof(u32) * (cellCount + 1));
+			auto forEachPolygonCell = [&](auto fn)
+				{
+					for (u32 i = 0; i < polygonCount; i++)
+					{
+						const ShrinkBox& box = polygonBoxes[i];
+						if (!box.IsFinite())
+							continue;
+
+						int cellMin[3], cellMax[3];
+						GetCellRange(box, cellMin, cellMax);
+						for (int z = cellMin[2]; z <= cellMax[2]; z++)
+							for (int y = cellMin[1]; y <= cellMax[1]; y++)
+								for (int x = cellMin[0]; x <= cellMax[0]; x++)
+									fn(i, GetCellIndex(x, y, z));
+					}
+				};
+
+			forEachPolygonCell([&](u32, u32 cellIndex) { m_CellStarts[cellIndex + 1]++; });
+			for (u32 i = 0; i < cellCount; i++)
+				m_CellStarts[i + 1] += m_CellStarts[i];
+
+			m_CellPolygons = std::make_unique<u32[]>(m_CellStarts[cellCount]);
+			amUPtr<u32[]> cellFill = std::make_unique<u32[]>(cellCount);
+			memcpy(cellFill.get(), m_CellStarts.get(), sizeof(u32) * cellCount);
+			forEachPolygonCell([&](u32 polygonIndex, u32 cellIndex) { m_CellPolygons[cellFill[cellIndex]++] = polygonIndex; });
+		}
+
+		// Invokes function on every polygon that may intersect given segment, stops and returns true once function returns true
+		template<typename TFunc>
+		bool ForEachCandidate(const rage::Vec3V& from, const rage::Vec3V& to, TFunc fn)
+		{
+			for (u32 polygonIndex : m_UnboundedPolygons)
+			{
+				if (fn(polygonIndex))
+					return true;
+			}
+
+			ShrinkBox box;
+			box.Reset();
+			box.Add(from);
+			box.Add(to);
+
+			// Non-finite segment can't be located in grid either, just test it against everything
+			if (!box.IsFinite())
+			{
+				for (u32 i = 0; i < m_PolygonCount; i++)
+				{
+					if (fn(i))
+						return true;
+				}
+				return false;
+			}
+
+			for (int i = 0; i < 3; i++)
+			{
+				box.Min[i] -= m_Padding;
+				box.Max[i] += m_Padding;
+
+				// Segment lies outside of all polygons
+				if (box.Max[i] < m_Bounds.Min[i] || box.Min[i] > m_Bounds.Max[i])
+					return false;
+			}
+
+			m_Stamp++;
+			int cellMin[3], cellMax[3];
+			GetCellRange(box, cellMin, cellMax);
+			for (int z = cellMin[2]; z <= cellMax[2]; z++)
+			{
+				for (int y = cellMin[1]; y <= cellMax[1]; y++)
+				{
+					for (int x = cellMin[0]; x <= cellMax[0]; x++)
+					{
+						u32 cellIndex = GetCellIndex(x, y, z);
+						for (u32 i = m_CellStarts[cellIndex]; i < m_CellStarts[cellIndex + 1]; i++)
+						{
+							u32 polygonIndex = m_CellPolygons[i];
+							if (m_PolygonStamps[polygonIndex] == m_Stamp)
+								continue;
+							m_PolygonStamps[polygonIndex] = m_Stamp;
+
+							if (fn(polygonIndex))
+								return true;
+						}
+					}
+				}
+			}
+			return false;
+		}
+	};
+}
+
 bool rage::phBoundGeometry::TryShrinkByMargin(float margin, float t, Vec3V* outShrunkVertices) const
+{
+	// Building grid doesn't pay off on small bounds
+	if (m_NumPolygons < SHRINK_GRID_MIN_POLYGONS)
+		return TryShrinkByMarginBruteForce(margin, t, outShrunkVertices);
+
+	ShrinkPolysOrVertsByMargin(margin, t, outShrunkVertices);
+
+	amUPtr<Vec3V[]> vertices = std::make_unique<Vec3V[]>(m_NumVertices);
+	DecompressVertices(vertices.get());
+
+	// Result is the same as in brute force version, only polygons that can't possibly intersect segment are skipped
+	ShrinkPolygonGrid grid(*this, vertices.get(), outShrunkVertices);
+	for (u32 vertexIndex = 0; vertexIndex < m_NumVertices; vertexIndex++)
+	{
+		Vec3V vertex = vertices[vertexIndex];
+		Vec3V shrunkVertex = outShrunkVertices[vertexIndex];
+
+		Vec3V segmentPos = shrunkVertex;
+		Vec3V segmentDir = vertex - shrunkVertex;
+		ScalarV segmentLength = segmentDir.Length();
+		segmentDir /= segmentLength;
+		float maxDistance = segmentLength.Get();
+
+		bool intersects = grid.ForEachCandidate(shrunkVertex, vertex, [&](u32 polygonIndex)
+			{
+				phPolygon& poly = GetPolygon(static_cast<u16>(polygonIndex));
+
+				u16 vi1 = poly.GetVertexIndex(0);
+				u16 vi2 = poly.GetVertexIndex(1);
+				u16 vi3 = poly.GetVertexIndex(2);
+
+				if (vi1 == vertexIndex || vi2 == vertexIndex || vi3 == vertexIndex)
+					return false;
+
+				return ShrinkSegmentIntersectsPolygon(segmentPos, segmentDir, maxDistance,
+					vertices[vi1], vertices[vi2], vertices[vi3],
+					outShrunkVertices[vi1], outShrunkVertices[vi2], outShrunkVertices[vi3]);
+			});
+
+		if (intersects)
+			return false;
+	}
+	return true;
+}
+
+bool rage::phBoundGeometry::TryShrinkByMarginBruteForce(float margin, float t, Vec3V* outShrunkVertices) const
 {
 	ShrinkPolysOrVertsByMargin(margin, t, outShrunkVertices);
 
@@ -633,14 +1120,6 @@ bool rage::phBoundGeometry::TryShrinkByMargin(float margin, float t, Vec3V* outS
 
 		// Line segment intersection
 		float maxDistance = segmentLength.Get();
-		auto intersectTest = [&](const Vec3V& v1, const Vec3V& v2, const Vec3V& v3)
-			{
-				float distance;
-				if (!rageam::graphics::ShapeTest::RayIntersectsTriangle(segmentPos, segmentDir, v1, v2, v3, distance))
-					return false;
-
-				return distance <= maxDistance;
-			};
 
 		for (u32 polygonIndex = 0; polygonIndex < m_NumPolygons; polygonIndex++)
 		{
@@ -654,18 +1133,10 @@ bool rage::phBoundGeometry::TryShrinkByMargin(float margin, float t, Vec3V* outS
 			if (vi1 == vertexIndex || vi2 == vertexIndex || vi3 == vertexIndex)
 				continue;
 
-			// Check intersection against non-shrunk polygon
-			Vec3V v1 = DecompressVertex(vi1);
-			Vec3V v2 = DecompressVertex(vi2);
-			Vec3V v3 = DecompressVertex(vi3);
-			if (intersectTest(v1, v2, v3))
-				return false;
-
-			// Against shrunk polygon
-			Vec3V vs1 = outShrunkVertices[vi1];
-			Vec3V vs2 = outShrunkVertices[vi2];
-			Vec3V vs3 = outShrunkVertices[vi3];
-			if (intersectTest(vs1, vs2, vs3))
+			// Check intersection against non-shrunk and shrunk polygon
+			if (ShrinkSegmentIntersectsPolygon(segmentPos, segmentDir, maxDistance,
+				DecompressVertex(vi1), DecompressVertex(vi2), DecompressVertex(vi3),
+				outShrunkVertices[vi1], outShrunkVertices[vi2], outShrunkVertices[vi3]))
 				return false;
 		}
 	}
@@ -96,8 +96,10 @@ namespace rage
 
 		void SetBoundingBox(const Vec3V& min, const Vec3V& max);
 		void ComputeBoundingBoxCenter();
-		// Computes neighbor polygon indices for each vertex in polygons
+		// Computes neighbor polygon indices for each vertex in polygons, polygons are matched by shared edge
 		void ComputeNeighbors() const;
+		// Original implementation that matches polygons through vertex to polygons map, used to verify ComputeNeighbors
+		void ComputeNeighborsReference() const;
 		// Must be computed before compressing new vertices
 		void ComputeUnQuantizeFactor();
 		void CalculateBoundingSphere()
@@ -115,7 +117,10 @@ namespace rage
 		void SetOctantMap(phOctantMap*);
 		void OctantMapDelete();
 		void RecomputeOctantMap();
+		// Classifies vertices into all octants at once, the result is the same as in ComputeOctantMapReference
 		void ComputeOctantMap();
+		// Original implementation that does pass over vertices for every octant
+		void ComputeOctantMapReference();
 		void OctantMapAllocateAndCopy(const u32* indexCounts, u32** indices);
 
 	public:
@@ -161,6 +166,8 @@ namespace rage
 	class phBoundGeometry : public phBoundPolyhedron
 	{
 	protected:
+		static constexpr u32 SHRINK_GRID_MIN_POLYGONS = 256; // Smaller bounds are shrunk using brute force intersection tests
+
 		phMaterialMgr::Id* m_Materials;
 		u32*               m_MaterialColors;
 		u8                 m_Pad1[4];
@@ -177,8 +184,11 @@ namespace rage
 		void ShrinkPolysByMargin(float margin, Vec3V* outVertices) const;
 		// T specifies amount of interpolation from polygon to vertex shrink
 		void ShrinkPolysOrVertsByMargin(float margin, float t, Vec3V* outVertices) const;
-		// Attempts to shrink and returns if any polygon intersects or not
+		// Attempts to shrink and returns if any polygon intersects or not,
+		// segments of shrunk vertices are tested only against polygons that are located in the same cells of uniform grid
 		bool TryShrinkByMargin(float margin, float t, Vec3V* outShrunkVertices) const;
+		// Reference version of TryShrinkByMargin that tests every vertex against every polygon
+		bool TryShrinkByMarginBruteForce(float margin, float t, Vec3V* outShrunkVertices) const;
 
 	public:
 		phBoundGeometry();
@@ -0,0 +1,331 @@
+#include "bvhbuilder.h"
+
+#include "am/system/worker.h"
+
+#include <algorithm>
+
+void rage::phBvhSahBuilder::Bounds::Reset()
+{
+	for (int i = 0; i < 3; i++)
+	{
+		AABBMin[i] = INT16_MAX;
+		AABBMax[i] = INT16_MIN;
+		CentroidMin[i] = INT32_MAX;
+		CentroidMax[i] = INT32_MIN;
+	}
+}
+
+void rage::phBvhSahBuilder::Bounds::Add(const phBvhPrimitiveData& primitive)
+{
+	for (int i = 0; i < 3; i++)
+	{
+		s32 centroid = GetCentroid(primitive, i);
+		AABBMin[i] = Min(AABBMin[i], primitive.AABBMin[i]);
+		AABBMax[i] = Max(AABBMax[i], primitive.AABBMax[i]);
+		CentroidMin[i] = Min(CentroidMin[i], centroid);
+		CentroidMax[i] = Max(CentroidMax[i], centroid);
+	}
+}
+
+void rage::phBvhSahBuilder::Bounds::Merge(const Bounds& other)
+{
+	for (int i = 0; i < 3; i++)
+	{
+		AABBMin[i] = Min(AABBMin[i], other.AABBMin[i]);
+		AABBMax[i] = Max(AABBMax[i], other.AABBMax[i]);
+		CentroidMin[i] = Min(CentroidMin[i], other.CentroidMin[i]);
+		CentroidMax[i] = Max(CentroidMax[i], other.CentroidMax[i]);
+	}
+}
+
+void rage::phBvhSahBuilder::Bin::Reset()
+{
+	for (int i = 0; i < 3; i++)
+	{
+		AABBMin[i] = INT16_MAX;
+		AABBMax[i] = INT16_MIN;
+	}
+	Count = 0;
+}
+
+void rage::phBvhSahBuilder::Bin::Add(const s16 aabbMin[3], const s16 aabbMax[3])
+{
+	for (int i = 0; i < 3; i++)
+	{
+		AABBMin[i] = Min(AABBMin[i], aabbMin[i]);
+		AABBMax[i] = Max(AABBMax[i], aabbMax[i]);
+	}
+}
+
+s64 rage::phBvhSahBuilder::Bin::ComputeHalfArea() const
+{
+	s64 x = s64(AABBMax[0]) - s64(AABBMin[0]);
+	s64 y = s64(AABBMax[1]) - s64(AABBMin[1]);
+	s64 z = s64(AABBMax[2]) - s64(AABBMin[2]);
+	return x * y + y * z + z * x;
+}
+
+rage::phBvhBuildNode* rage::phBvhSahBuilder::AllocateNode()
+{
+	int index = m_NodeCount++;
+	AM_ASSERT(index < m_PrimitiveCount * 2, "phBvhSahBuilder::AllocateNode() -> Node pool overflow.");
+	return &m_Nodes[index];
+}
+
+void rage::phBvhSahBuilder::RunChunks(int startIndex, int endIndex, const std::function<void(int chunk, int chunkStart, int chunkEnd)>& fn) const
+{
+	s64 count = endIndex - startIndex;
+	auto getChunkStart = [&](int chunk) { return startIndex + static_cast<int>(count * chunk / BINNING_CHUNK_COUNT); };
+
+	rageam::BackgroundTaskPtr tasks[BINNING_CHUNK_COUNT - 1];
+	rageam::BackgroundWorker::Push(sm_Worker);
+	for (int i = 0; i < BINNING_CHUNK_COUNT - 1; i++)
+	{
+		int chunkStart = getChunkStart(i);
+		int chunkEnd = getChunkStart(i + 1);
+		tasks[i] = rageam::BackgroundWorker::Run([&fn, i, chunkStart, chunkEnd]
+			{
+				fn(i, chunkStart, chunkEnd);
+				return true;
+			});
+	}
+	rageam::BackgroundWorker::Pop();
+
+	fn(BINNING_CHUNK_COUNT - 1, getChunkStart(BINNING_CHUNK_COUNT - 1), endIndex);
+
+	for (rageam::BackgroundTaskPtr& task : tasks)
+		task->Wait();
+}
+
+void rage::phBvhSahBuilder::ComputeBounds(int startIndex, int endIndex, Bounds& outBounds) const
+{
+	outBounds.Reset();
+	if (!sm_Worker || endIndex - startIndex < PARALLEL_BINNING_THRESHOLD)
+	{
+		for (int i = startIndex; i < endIndex; i++)
+			outBounds.Add(m_Primitives[i]);
+		return;
+	}
+
+	// Chunks are merged in fixed order, result doesn't depend on scheduling
+	Bounds chunkBounds[BINNING_CHUNK_COUNT];
+	RunChunks(startIndex, endIndex, [&](int chunk, int chunkStart, int chunkEnd)
+		{
+			chunkBounds[chunk].Reset();
+			for (int i = chunkStart; i < chunkEnd; i++)
+				chunkBounds[chunk].Add(m_Primitives[i]);
+		});
+	for (const Bounds& bounds : chunkBounds)
+		outBounds.Merge(bounds);
+}
+
+void rage::phBvhSahBuilder::ComputeBins(int startIndex, int endIndex, const Bounds& bounds, Bins& outBins) const
+{
+	auto fillBins = [&](int chunkStart, int chunkEnd, Bins& bins)
+		{
+			for (int axis = 0; axis < 3; axis++)
+			{
+				for (Bin& bin : bins.Axes[axis])
+					bin.Reset();
+
+				s32 centroidMin = bounds.CentroidMin[axis];
+				s32 extent = bounds.CentroidMax[axis] - centroidMin;
+				for (int i = chunkStart; i < chunkEnd; i++)
+				{
+					const phBvhPrimitiveData& primitive = m_Primitives[i];
+					Bin& bin = bins.Axes[axis][GetBinIndex(GetCentroid(primitive, axis), centroidMin, extent)];
+					bin.Add(primitive.AABBMin, primitive.AABBMax);
+					bin.Count++;
+				}
+			}
+		};
+
+	if (!sm_Worker || endIndex - startIndex < PARALLEL_BINNING_THRESHOLD)
+	{
+		fillBins(startIndex, endIndex, outBins);
+		return;
+	}
+
+	Bins chunkBins[BINNING_CHUNK_COUNT];
+	RunChunks(startIndex, endIndex, [&](int chunk, int chunkStart, int chunkEnd)
+		{
+			fillBins(chunkStart, chunkEnd, chunkBins[chunk]);
+		});
+
+	for (int axis = 0; axis < 3; axis++)
+	{
+		for (int i = 0; i < BIN_COUNT; i++)
+		{
+			Bin& bin = outBins.Axes[axis][i];
+			bin.Reset();
+			for (const Bins& bins : chunkBins)
+			{
+				const Bin& chunkBin = bins.Axes[axis][i];
+				bin.Add(chunkBin.AABBMin, chunkBin.AABBMax);
+				bin.Count += chunkBin.Count;
+			}
+		}
+	}
+}
+
+int rage::phBvhSahBuilder::SplitMedian(int startIndex, int endIndex, const Bounds& bounds) const
+{
+	int axis = 0;
+	for (int i = 1; i < 3; i++)
+	{
+		if (bounds.CentroidMax[i] - bounds.CentroidMin[i] > bounds.CentroidMax[axis] - bounds.CentroidMin[axis])
+			axis = i;
+	}
+
+	int splitIndex = startIndex + GetLeafCount((endIndex - startIndex) / 2) * m_MaxPrimitivesPerNode;
+	std::nth_element(m_Primitives + startIndex, m_Primitives + splitIndex, m_Primitives + endIndex,
+		[axis](const phBvhPrimitiveData& lhs, const phBvhPrimitiveData& rhs)
+		{
+			return GetCentroid(lhs, axis) < GetCentroid(rhs, axis);
+		});
+	return splitIndex;
+}
+
+int rage::phBvhSahBuilder::Split(int startIndex, int endIndex, const Bounds& bounds, int depth) const
+{
+	if (depth >= MAX_SAH_DEPTH)
+		return SplitMedian(startIndex, endIndex, bounds);
+
+	Bins bins;
+	ComputeBins(startIndex, endIndex, bounds, bins);
+
+	s64 bestCost = INT64_MAX;
+	int bestAxis = -1;
+	int bestBin = 0;
+	int bestLeftCount = 0;
+	for (int axis = 0; axis < 3; axis++)
+	{
+		// All centroids are in the first bin
+		if (bounds.CentroidMin[axis] == bounds.CentroidMax[axis])
+			continue;
+
+		const Bin* axisBins = bins.Axes[axis];
+
+		// Sweep from the right, cost of the right child if split is placed before bin 'i'
+		s64 rightCosts[BIN_COUNT];
+		Bin right;
+		right.Reset();
+		for (int i = BIN_COUNT - 1; i > 0; i--)
+		{
+			right.Add(axisBins[i].AABBMin, axisBins[i].AABBMax);
+			right.Count += axisBins[i].Count;
+			rightCosts[i] = right.Count != 0 ? right.ComputeHalfArea() * GetLeafCount(right.Count) : -1;
+		}
+
+		// Sweep from the left and find the cheapest split
+		Bin left;
+		left.Reset();
+		for (int i = 0; i < BIN_COUNT - 1; i++)
+		{
+			left.Add(axisBins[i].AABBMin, axisBins[i].AABBMax);
+			left.Count += axisBins[i].Count;
+			if (left.Count == 0 || rightCosts[i + 1] < 0)
+				continue;
+
+			s64 cost = left.ComputeHalfArea() * GetLeafCount(left.Count) + rightCosts[i + 1];
+			if (cost < bestCost)
+			{
+				bestCost = cost;
+				bestAxis = axis;
+				bestBin = i;
+				bestLeftCount = left.Count;
+			}
+		}
+	}
+
+	// Every primitive has the same centroid, any split is as good as another one
+	if (bestAxis == -1)
+		return SplitMedian(startIndex, endIndex, bounds);
+
+	s32 centroidMin = bounds.CentroidMin[bestAxis];
+	s32 extent = bounds.CentroidMax[bestAxis] - centroidMin;
+	std::partition(m_Primitives + startIndex, m_Primitives + endIndex, [&](const phBvhPrimitiveData& primitive)
+		{
+			return GetBinIndex(GetCentroid(primitive, bestAxis), centroidMin, extent) <= bestBin;
+		});
+	return startIndex + bestLeftCount;
+}
+
+rage::phBvhBuildNode* rage::phBvhSahBuilder::Subdivide(int startIndex, int endIndex, int depth)
+{
+	phBvhBuildNode* node = AllocateNode();
+	int count = endIndex - startIndex;
+
+	Bounds bounds;
+	ComputeBounds(startIndex, endIndex, bounds);
+	memcpy(node->AABBMin, bounds.AABBMin, sizeof node->AABBMin);
+	memcpy(node->AABBMax, bounds.AABBMax, sizeof node->AABBMax);
+	node->StartIndex = startIndex;
+	node->Children[0] = nullptr;
+	node->Children[1] = nullptr;
+
+	// Leaf size limit is the same as in median split
+	if (count <= m_MaxPrimitivesPerNode)
+	{
+		node->PrimitiveCount = count;
+		return node;
+	}
+	node->PrimitiveCount = 0;
+
+	int splitIndex = Split(startIndex, endIndex, bounds, depth);
+
+	// Children are built on disjoint ranges of primitives, so they don't depend on each other
+	if (sm_Worker && count >= PARALLEL_SUBTREE_THRESHOLD)
+	{
+		rageam::BackgroundWorker::Push(sm_Worker);
+		rageam::BackgroundTaskPtr leftTask = rageam::BackgroundWorker::Run([this, node, startIndex, splitIndex, depth]
+			{
+				node->Children[0] = Subdivide(startIndex, splitIndex, depth + 1);
+				return true;
+			});
+		rageam::BackgroundWorker::Pop();
+
+		node->Children[1] = Subdivide(splitIndex, endIndex, depth + 1);
+		leftTask->Wait();
+	}
+	else
+	{
+		node->Children[0] = Subdivide(startIndex, splitIndex, depth + 1);
+		node->Children[1] = Subdivide(splitIndex, endIndex, depth + 1);
+	}
+
+	return node;
+}
+
+rage::phBvhSahBuilder::phBvhSahBuilder(phBvhPrimitiveData* primitives, int count, int maxPrimitivesPerNode)
+{
+	AM_ASSERT(maxPrimitivesPerNode > 0, "phBvhSahBuilder() -> Max primitive count must be greater than zero!");
+
+	m_Primitives = primitives;
+	m_PrimitiveCount = count;
+	m_MaxPrimitivesPerNode = maxPrimitivesPerNode;
+	// Allocated on caller thread, worker threads only write to it
+	m_Nodes = std::make_unique<phBvhBuildNode[]>(Max(count * 2, 1));
+}
+
+const rage::phBvhBuildNode* rage::phBvhSahBuilder::Build()
+{
+	m_NodeCount = 0;
+	if (m_PrimitiveCount == 0)
+		return nullptr;
+
+	return Subdivide(0, m_PrimitiveCount, 0);
+}
+
+void rage::phBvhSahBuilder::InitClass()
+{
+	SYSTEM_INFO sysInfo;
+	GetSystemInfo(&sysInfo);
+	sm_Worker = new rageam::BackgroundWorker("BVH", static_cast<int>(sysInfo.dwNumberOfProcessors));
+}
+
+void rage::phBvhSahBuilder::ShutdownClass()
+{
+	delete sm_Worker;
+	sm_Worker = nullptr;
+}
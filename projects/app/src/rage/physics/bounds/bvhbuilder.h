@@ -0,0 +1,116 @@
+//
+// File: bvhbuilder.h
+//
+// Copyright (C) 2023-2024 ranstar74. All rights violated.
+//
+// Part of "Rage Am" Research Project.
+//
+#pragma once
+
+#include "optimizedbvh.h"
+#include "am/system/ptr.h"
+
+#include <atomic>
+
+namespace rageam
+{
+	class BackgroundWorker;
+}
+
+namespace rage
+{
+	/**
+	 * \brief Node of intermediate tree, emitted to phOptimizedBvh in depth-first order once the whole tree is built.
+	 */
+	struct phBvhBuildNode
+	{
+		s16             AABBMin[3];
+		s16             AABBMax[3];
+		int             StartIndex;
+		int             PrimitiveCount;	// Non-zero only for leaf nodes
+		phBvhBuildNode* Children[2];
+
+		bool IsLeafNode() const { return PrimitiveCount != 0; }
+	};
+
+	/**
+	 * \brief Builds BVH tree using binned surface area heuristic, see phOptimizedBvh::BuildFromPrimitiveData.
+	 * Splits are searched in fixed number of bins along every axis of centroid bounds, cost of the child is its
+	 * surface area multiplied by number of leaves it needs - this keeps leaves full, like median split does.
+	 * Bins of large ranges are filled and subtrees are built on worker threads, all computations are done in
+	 * quantized integer space, so the tree is the same regardless of thread count.
+	 */
+	class phBvhSahBuilder
+	{
+		static constexpr int BIN_COUNT = 16;
+		static constexpr int BINNING_CHUNK_COUNT = 8;				// Large ranges are binned in this many chunks in parallel
+		static constexpr int PARALLEL_BINNING_THRESHOLD = 16384;	// Min number of primitives to bin range in parallel
+		static constexpr int PARALLEL_SUBTREE_THRESHOLD = 1024;		// Min number of primitives to build subtree on worker thread
+		static constexpr int MAX_SAH_DEPTH = 48;					// Deeper nodes are split at median, bounds depth on degenerate input
+
+		struct Bounds
+		{
+			s16 AABBMin[3];
+			s16 AABBMax[3];
+			s32 CentroidMin[3];
+			s32 CentroidMax[3];
+
+			void Reset();
+			void Add(const phBvhPrimitiveData& primitive);
+			void Merge(const Bounds& other);
+		};
+
+		struct Bin
+		{
+			s16 AABBMin[3];
+			s16 AABBMax[3];
+			int Count;
+
+			void Reset();
+			void Add(const s16 aabbMin[3], const s16 aabbMax[3]);
+			// Surface area is not multiplied by 2, only relative cost matters
+			s64 ComputeHalfArea() const;
+		};
+
+		struct Bins
+		{
+			Bin Axes[3][BIN_COUNT];
+		};
+
+		static inline rageam::BackgroundWorker* sm_Worker = nullptr;
+
+		phBvhPrimitiveData*      m_Primitives;
+		int                      m_PrimitiveCount;
+		int                      m_MaxPrimitivesPerNode;
+		amUPtr<phBvhBuildNode[]> m_Nodes; // Binary tree with at least one primitive per leaf has at most 2N - 1 nodes
+		std::atomic_int          m_NodeCount = 0;
+
+		static s32 GetCentroid(const phBvhPrimitiveData& primitive, int axis) { return s32(primitive.AABBMin[axis]) + s32(primitive.AABBMax[axis]); }
+		static int GetBinIndex(s32 centroid, s32 centroidMin, s32 extent) { return static_cast<int>(static_cast<s64>(centroid - centroidMin) * BIN_COUNT / (extent + 1)); }
+
+		int GetLeafCount(int primitiveCount) const { return (primitiveCount + m_MaxPrimitivesPerNode - 1) / m_MaxPrimitivesPerNode; }
+
+		phBvhBuildNode* AllocateNode();
+		// Invokes function on equal parts of the range, all but the last one are executed on worker threads
+		void RunChunks(int startIndex, int endIndex, const std::function<void(int chunk, int chunkStart, int chunkEnd)>& fn) const;
+		void ComputeBounds(int startIndex, int endIndex, Bounds& outBounds) const;
+		void ComputeBins(int startIndex, int endIndex, const Bounds& bounds, Bins& outBins) const;
+		// Splits primitives in two halves along the axis with the largest centroid extent, left half is multiple of leaf size
+		int SplitMedian(int startIndex, int endIndex, const Bounds& bounds) const;
+		// Picks the cheapest split and partitions primitives, returns index of the first primitive in the right child
+		int Split(int startIndex, int endIndex, const Bounds& bounds, int depth) const;
+		phBvhBuildNode* Subdivide(int startIndex, int endIndex, int depth);
+
+	public:
+		// Primitives are reordered during the build, leaf nodes reference them by start index and count
+		phBvhSahBuilder(phBvhPrimitiveData* primitives, int count, int maxPrimitivesPerNode);
+
+		// Returns root node of the tree, NULL if there are no primitives
+		const phBvhBuildNode* Build();
+		int GetNodeCount() const { return m_NodeCount; }
+
+		// Without worker the whole tree is built on caller thread
+		static void InitClass();
+		static void ShutdownClass();
+	};
+}
@@ -1,4 +1,5 @@
 #include "optimizedbvh.h"
+#include "bvhbuilder.h"
 
 #include "am/integration/memory/address.h"
 #include "common/logger.h"
@@ -137,14 +138,21 @@ rage::phOptimizedBvhNode* rage::phOptimizedBvh::BuildTree(phBvhPrimitiveData* pr
 	phOptimizedBvhNode* rightChild = BuildTree(primitives, splitIndex, endIndex, maxPrimitivesPerNode, splitAxis);
 
 	node.SetEscapeIndex(m_NumNodesInUse - currentIndex);
+	AddSubtreeHeaders(*leftChild, *rightChild);
+	node.CombineAABBs(*leftChild, *rightChild);
+
+	return &node;
+}
 
-	constexpr int MAX_SUBTREE_SIZE = 128 * sizeof phOptimizedBvhNode;
+void rage::phOptimizedBvh::AddSubtreeHeaders(phOptimizedBvhNode& leftChild, phOptimizedBvhNode& rightChild)
+{
+	constexpr int MAX_SUBTREE_SIZE = 128 * sizeof(phOptimizedBvhNode);
 
 	// The escape index tells us by how many nodes to skip ahead, thereby telling us the size of the subtree
-	int leftSubTreeMaxCount = leftChild->GetEscapeIndex();
-	int rightSubTreeMaxCount = rightChild->GetEscapeIndex();
-	int leftSubTreeSize = leftSubTreeMaxCount * sizeof phOptimizedBvhNode;
-	int rightSubTreeSize = rightSubTreeMaxCount * sizeof phOptimizedBvhNode;
+	int leftSubTreeMaxCount = leftChild.GetEscapeIndex();
+	int rightSubTreeMaxCount = rightChild.GetEscapeIndex();
+	int leftSubTreeSize = leftSubTreeMaxCount * sizeof(phOptimizedBvhNode);
+	int rightSubTreeSize = rightSubTreeMaxCount * sizeof(phOptimizedBvhNode);
 	if (leftSubTreeSize + rightSubTreeSize >= MAX_SUBTREE_SIZE)
 	{
 		auto createSubtreeInfo = [this] (phOptimizedBvhNode& fromNode)
@@ -156,17 +164,75 @@ rage::phOptimizedBvhNode* rage::phOptimizedBvh::BuildTree(phBvhPrimitiveData* pr
 			};
 
 		if (leftSubTreeSize <= MAX_SUBTREE_SIZE)
-			createSubtreeInfo(*leftChild);
+			createSubtreeInfo(leftChild);
 
 		if (rightSubTreeSize <= MAX_SUBTREE_SIZE)
-			createSubtreeInfo(*rightChild);
+			createSubtreeInfo(rightChild);
 	}
+}
 
-	node.CombineAABBs(*leftChild, *rightChild);
+void rage::phOptimizedBvh::FinishSubtreeHeaders()
+{
+	if (m_CurSubtreeHeaderIndex != 0)
+		return;
+
+	m_SubtreeHeaders[0].SetAABBFromNode(m_ContiniousNodes[0]);
+	m_SubtreeHeaders[0].RootNodeIndex = 0;
+	m_SubtreeHeaders[0].EndIndex = m_NumNodesInUse;
+	m_CurSubtreeHeaderIndex = 1;
+}
+
+rage::phOptimizedBvhNode* rage::phOptimizedBvh::EmitBuildNode(const phBvhBuildNode* buildNode)
+{
+	int currentIndex = m_NumNodesInUse++;
+	phOptimizedBvhNode& node = m_ContiniousNodes[currentIndex];
+	memcpy(node.AABBMin, buildNode->AABBMin, sizeof node.AABBMin);
+	memcpy(node.AABBMax, buildNode->AABBMax, sizeof node.AABBMax);
+
+	if (buildNode->IsLeafNode())
+	{
+		node.SetPrimitiveCount(buildNode->PrimitiveCount);
+		node.SetPrimitiveIndex(buildNode->StartIndex);
+		return &node;
+	}
+
+	phOptimizedBvhNode* leftChild = EmitBuildNode(buildNode->Children[0]);
+	phOptimizedBvhNode* rightChild = EmitBuildNode(buildNode->Children[1]);
+
+	node.SetEscapeIndex(m_NumNodesInUse - currentIndex);
+	AddSubtreeHeaders(*leftChild, *rightChild);
 
 	return &node;
 }
 
+bool rage::phOptimizedBvh::BuildBinnedSah(phBvhPrimitiveData* primitives, int count, int maxPrimitivesPerNode)
+{
+	phBvhSahBuilder builder(primitives, count, maxPrimitivesPerNode);
+	const phBvhBuildNode* root = builder.Build();
+
+	// Leaves are not always full, so there may be more nodes than median split produces
+	int nodeCount = builder.GetNodeCount();
+	if (nodeCount > UINT16_MAX)
+	{
+		AM_WARNINGF("phOptimizedBvh::BuildBinnedSah() -> %i nodes don't fit in 16 bit indices, falling back to median split.", nodeCount);
+		return false;
+	}
+
+	m_NumNodes = nodeCount;
+	m_NumSubtreeHeaders = Max(m_NumNodes / 2, 1);
+	m_ContiniousNodes = new phOptimizedBvhNode[m_NumNodes];
+	m_SubtreeHeaders = new phOptimizedBvhSubtreeInfo[m_NumSubtreeHeaders];
+
+	m_NumNodesInUse = 0;
+	m_CurSubtreeHeaderIndex = 0;
+	for (int i = 0; i < m_NumNodes; i++)
+		m_ContiniousNodes[i].Reset();
+
+	EmitBuildNode(root);
+	FinishSubtreeHeaders();
+	return true;
+}
+
 rage::phOptimizedBvh::phOptimizedBvh()
 {
 	m_ContiniousNodes = nullptr;
@@ -261,23 +327,19 @@ void rage::phOptimizedBvh::BuildFromPrimitiveDataNoAllocate(phBvhPrimitiveData*
 		return;
 
 	BuildTree(primitives, 0, count, maxPrimitivesPerNode);
-
-	// Tree was too small to generate any subtree headers
-	if (m_CurSubtreeHeaderIndex == 0)
-	{
-		m_SubtreeHeaders[0].SetAABBFromNode(m_ContiniousNodes[0]);
-		m_SubtreeHeaders[0].RootNodeIndex = 0;
-		m_SubtreeHeaders[0].EndIndex = m_NumNodesInUse;
-		m_CurSubtreeHeaderIndex = 1;
-	}
+	FinishSubtreeHeaders();
 }
 
-void rage::phOptimizedBvh::BuildFromPrimitiveData(phBvhPrimitiveData* primitives, int count, int maxPrimitivesPerNode)
+void rage::phOptimizedBvh::BuildFromPrimitiveData(phBvhPrimitiveData* primitives, int count, int maxPrimitivesPerNode, phBvhBuildMethod method)
 {
 	Destroy();
 	if (count == 0)
 		return;
 
+	// Nodes are allocated for exact size of the built tree
+	if (method == PH_BVH_BUILD_BINNED_SAH && BuildBinnedSah(primitives, count, maxPrimitivesPerNode))
+		return;
+
 	// Approximate number of nodes to allocate, this is may produce 1-2 more nodes than actually needed
 	m_NumNodes = 2 * count / maxPrimitivesPerNode + 1;
 	m_NumSubtreeHeaders = Max(m_NumNodes / 2, 1);
@@ -18,6 +18,14 @@ namespace rage
 	// NOTE: Native implementation uses term 'Polygon' for simplest shapes, we use 'Primitive' instead,
 	// to prevent confusion with phPolygon
 
+	struct phBvhBuildNode;
+
+	enum phBvhBuildMethod
+	{
+		PH_BVH_BUILD_MEDIAN,		// Native implementation, splits at median along the axis of the largest variance
+		PH_BVH_BUILD_BINNED_SAH,	// Splits by surface area heuristic, built in parallel, see phBvhSahBuilder
+	};
+
 	/**
 	 * \brief Used when building BVH tree.
 	 */
@@ -105,6 +113,14 @@ namespace rage
 		int CalculateSplittingAxis(phBvhPrimitiveData* primitives, int startIndex, int endIndex, int& middleAxis) const;
 		void SortPrimitivesAlongAxes(phBvhPrimitiveData* primitives, int startIndex, int endIndex, int axis1, int axis2) const;
 		phOptimizedBvhNode* BuildTree(phBvhPrimitiveData* primitives, int startIndex, int endIndex, int maxPrimitivesPerNode, int lastSortAxis = -1);
+		// Creates subtree headers for children that fit in single subtree, if they both don't
+		void AddSubtreeHeaders(phOptimizedBvhNode& leftChild, phOptimizedBvhNode& rightChild);
+		// Tree that is too small to generate any subtree headers gets single one for the whole tree
+		void FinishSubtreeHeaders();
+		// Writes tree built by phBvhSahBuilder in depth-first order
+		phOptimizedBvhNode* EmitBuildNode(const phBvhBuildNode* buildNode);
+		// Returns False if tree doesn't fit in 16 bit node indices
+		bool BuildBinnedSah(phBvhPrimitiveData* primitives, int count, int maxPrimitivesPerNode);
 
 	public:
 		phOptimizedBvh();
@@ -129,7 +145,7 @@ namespace rage
 		// Used when BVH needs to be updated without re-allocating tree nodes (meaning number of elements didn't change)
 		void BuildFromPrimitiveDataNoAllocate(phBvhPrimitiveData* primitives, int count, int maxPrimitivesPerNode);
 		// Builds the tree from scratch, destroying existing one
-		void BuildFromPrimitiveData(phBvhPrimitiveData* primitives, int count, int maxPrimitivesPerNode);
+		void BuildFromPrimitiveData(phBvhPrimitiveData* primitives, int count, int maxPrimitivesPerNode, phBvhBuildMethod method = PH_BVH_BUILD_MEDIAN);
 
 		int GetNodeCount() const { return m_NumNodesInUse; }
 		phOptimizedBvhNode& GetNode(int index) const;
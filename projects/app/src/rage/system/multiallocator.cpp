@@ -1,5 +1,6 @@
 #include "multiallocator.h"
 
+#include "simpleallocator.h"
 #include "am/system/asserts.h"
 
 void rage::sysMemMultiAllocator::Free(pVoid block)
@@ -87,6 +88,23 @@ bool rage::sysMemMultiAllocator::IsValidPointer(pVoid block)
 	return false;
 }
 
+rage::sysMemThreadCacheStats rage::sysMemMultiAllocator::GetThreadCacheStats() const
+{
+	sysMemThreadCacheStats stats;
+	for (u32 i = 0; i < m_AllocatorCount; i++)
+	{
+		// Same allocator is mapped to multiple slots, count it only once
+		bool isDuplicate = false;
+		for (u32 k = 0; k < i; k++)
+			isDuplicate |= m_Allocators[k] == m_Allocators[i];
+
+		auto simpleAllocator = dynamic_cast<const sysMemSimpleAllocator*>(m_Allocators[i]);
+		if (!isDuplicate && simpleAllocator)
+			stats.Add(simpleAllocator->GetThreadCacheStats());
+	}
+	return stats;
+}
+
 u64 rage::sysMemMultiAllocator::GetSizeWithOverhead(pVoid block)
 {
 	for (sysMemAllocator* allocator : m_Allocators)
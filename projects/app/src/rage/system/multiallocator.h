@@ -1,6 +1,7 @@
 #pragma once
 
 #include "allocator.h"
+#include "threadcache.h"
 
 namespace rage
 {
@@ -82,6 +83,9 @@ namespace rage
 		pVoid GetHeapBase() override { return nullptr; }
 		u64 GetHeapSize() override { return 0; }
 
+		// Note: Not part of rage, sums thread cache stats of all simple allocators
+		sysMemThreadCacheStats GetThreadCacheStats() const;
+
 		void AddAllocator(sysMemAllocator* that)
 		{
 			m_Allocators[m_AllocatorCount++] = that;
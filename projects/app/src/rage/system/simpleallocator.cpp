@@ -49,12 +49,6 @@ void rage::sysMemSimpleAllocator::InitHeap(pVoid heap, u64 size, bool useSmalloc
 	m_HeapBase = heap;
 	m_HeapSize = size;
 
-	if (useSmallocator && size >= SMALLOCATOR_MIN_SIZE)
-	{
-		m_UseSmallocator = true;
-		m_Smallocator.Init(this);
-	}
-
 	u64 heapAddr = reinterpret_cast<u64>(heap);
 
 	// To calculate root node size
@@ -68,6 +62,15 @@ void rage::sysMemSimpleAllocator::InitHeap(pVoid heap, u64 size, bool useSmalloc
 	m_MainHeapSize = root->BlockSize + HEADER_SIZE;
 	m_MainBlock = root;
 
+	// Smallocator computes chunk indices relative to heap base, so it must be initialized after the main block
+	m_UseSmallocator = false;
+	if (useSmallocator && size >= SMALLOCATOR_MIN_SIZE)
+	{
+		m_UseSmallocator = true;
+		m_UseThreadCache = true;
+		m_Smallocator.Init(this);
+	}
+
 	m_AvailableMemoryHigh = root->BlockSize;
 	m_AvailableMemoryLow = m_AvailableMemoryHigh;
 
@@ -698,6 +701,8 @@ rage::sysMemSimpleAllocator::sysMemSimpleAllocator(u64 size, u8 allocIdSeed, boo
 
 rage::sysMemSimpleAllocator::~sysMemSimpleAllocator()
 {
+	// Caches of other threads must be flushed by now, see sysMemThreadCache
+	sysMemThreadCache::Release(this);
 	m_Smallocator.Destroy(this);
 
 	if (m_bOwnHeap)
@@ -717,6 +722,18 @@ bool rage::sysMemSimpleAllocator::SetQuitOnFail(bool toggle)
 
 pVoid rage::sysMemSimpleAllocator::Allocate(u64 size, u64 align, u32 type)
 {
+	if (m_UseThreadCache && m_Smallocator.CanAllocate(size, align))
+	{
+		sysMemThreadCache* cache = sysMemThreadCache::Get(this);
+		if (cache)
+		{
+			pVoid block = cache->Allocate(sysMemThreadCache::GetSizeClass(size));
+			if (block)
+				return block;
+		}
+		// Size class is not cached or we're out of memory, let locked path handle it
+	}
+
 	sysCriticalSectionLock lock(m_CriticalSection);
 
 	ALLOC_LOG("");
@@ -764,6 +781,14 @@ pVoid rage::sysMemSimpleAllocator::TryAllocate(u64 size, u64 align, u32 type)
 
 void rage::sysMemSimpleAllocator::Free(pVoid block)
 {
+	// Smallocator chunk state can't change while block in it is allocated, no need to lock to check ownership
+	if (m_UseThreadCache && IsValidPointer(block) && m_Smallocator.IsPointerOwner(block))
+	{
+		sysMemThreadCache* cache = sysMemThreadCache::Get(this);
+		if (cache && cache->Free(block, sysMemThreadCache::GetSizeClass(m_Smallocator.GetSize(block))))
+			return;
+	}
+
 	sysCriticalSectionLock lock(m_CriticalSection);
 
 	ALLOC_LOG("");
@@ -966,6 +991,16 @@ void rage::sysMemSimpleAllocator::EndMemoryLog()
 #endif
 }
 
+void rage::sysMemSimpleAllocator::SetUseThreadCache(bool toggle)
+{
+	AM_ASSERT(!toggle || m_UseSmallocator, "SimpleAllocator::SetUseThreadCache() -> Thread cache requires smallocator.");
+
+	// Caches of other threads will be flushed on thread exit
+	if (!toggle)
+		FlushThreadCache();
+	m_UseThreadCache = toggle;
+}
+
 void rage::sysMemSimpleAllocator::SanityCheck()
 {
 	sysCriticalSectionLock lock(m_CriticalSection);
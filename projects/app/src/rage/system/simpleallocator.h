@@ -2,6 +2,7 @@
 
 #include "allocator.h"
 #include "smallocator.h"
+#include "threadcache.h"
 #include "helpers/ranges.h"
 
 #include "ipc.h"
@@ -176,6 +177,12 @@ namespace rage
 
 		sysCriticalSectionToken m_CriticalSection;
 
+		// Note: Not part of rage, small allocations are served by thread caches without taking the lock
+		friend class sysMemThreadCache;
+		bool						m_UseThreadCache = false;
+		sysMemThreadCacheConfig		m_ThreadCacheConfig;
+		sysMemThreadCacheCounters	m_ThreadCacheCounters;
+
 		enum eGetNodeHint
 		{
 			GET_NODE_DEFAULT,
@@ -308,5 +315,14 @@ namespace rage
 
 		u64 GetHeapSize() override { return m_MainHeapSize; }
 		pVoid GetHeapBase() override { return m_MainBlock; }
+
+		// Thread cache is enabled by default if smallocator is used, see sysMemThreadCache
+		void SetUseThreadCache(bool toggle);
+		bool GetUseThreadCache() const { return m_UseThreadCache; }
+		void SetThreadCacheConfig(const sysMemThreadCacheConfig& config) { m_ThreadCacheConfig = config; }
+		const sysMemThreadCacheConfig& GetThreadCacheConfig() const { return m_ThreadCacheConfig; }
+		// Returns blocks cached by calling thread to shared heap
+		void FlushThreadCache() { sysMemThreadCache::Release(this); }
+		sysMemThreadCacheStats GetThreadCacheStats() const { return m_ThreadCacheCounters.Get(); }
 	};
 }
@@ -235,6 +235,50 @@ pVoid rage::sysSmallocator::Allocate(u64 size, u64 align, sysMemSimpleAllocator*
 	return DoAllocate(GetBucket(size), allocator);
 }
 
+u32 rage::sysSmallocator::AllocateBatch(u64 size, u32 count, pVoid& outHead, sysMemSimpleAllocator* allocator)
+{
+	u8 bucketIndex = GetBucket(ALIGN_16(size));
+	Bucket& bucket = m_Buckets[bucketIndex];
+
+	FreeNode* head = nullptr;
+	FreeNode* tail = nullptr;
+	u32 allocatedCount = 0;
+	while (allocatedCount < count)
+	{
+		// Same as in DoAllocate, but take as many blocks from the chunk as we can
+		Chunk* chunk = bucket.MainChunk;
+		while (chunk && chunk->FreeBlockCount == 0)
+			chunk = chunk->NextLinked;
+
+		if (!chunk)
+		{
+			chunk = AllocateNewChunk(bucketIndex, allocator);
+			if (!chunk)
+			{
+				AM_ERR("Smallocator::AllocateBatch() -> Failed to allocate new pool chunk");
+				break;
+			}
+		}
+
+		while (allocatedCount < count && chunk->FreeBlockCount > 0)
+		{
+			FreeNode* block = chunk->AllocateBlock();
+			if (tail)
+				tail->NextLinked = block;
+			else
+				head = block;
+			tail = block;
+			allocatedCount++;
+		}
+	}
+
+	if (tail)
+		tail->NextLinked = nullptr;
+
+	outHead = head;
+	return allocatedCount;
+}
+
 void rage::sysSmallocator::Free(pVoid block, sysMemSimpleAllocator* allocator)
 {
 	Chunk* chunk = GetChunkFromBlock(block);
@@ -254,6 +298,18 @@ void rage::sysSmallocator::Free(pVoid block, sysMemSimpleAllocator* allocator)
 	allocator->Free(chunk);
 }
 
+void rage::sysSmallocator::FreeBatch(pVoid head, sysMemSimpleAllocator* allocator)
+{
+	FreeNode* block = static_cast<FreeNode*>(head);
+	while (block)
+	{
+		// Free links block into chunk list, get next one before that
+		FreeNode* next = block->NextLinked;
+		Free(block, allocator);
+		block = next;
+	}
+}
+
 bool rage::sysSmallocator::IsPointerOwner(pVoid block) const
 {
 	u64 addr = reinterpret_cast<u64>(block);
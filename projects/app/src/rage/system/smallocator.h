@@ -204,8 +204,15 @@ namespace rage
 
 		pVoid Allocate(u64 size, u64 align, sysMemSimpleAllocator* allocator);
 
+		// Allocates up to given number of blocks, blocks are linked through their first 8 bytes.
+		// Returns number of allocated blocks, used to refill sysMemThreadCache.
+		u32 AllocateBatch(u64 size, u32 count, pVoid& outHead, sysMemSimpleAllocator* allocator);
+
 		void Free(pVoid block, sysMemSimpleAllocator* allocator);
 
+		// Frees blocks linked the same way as in AllocateBatch.
+		void FreeBatch(pVoid head, sysMemSimpleAllocator* allocator);
+
 		bool IsPointerOwner(pVoid block) const;
 
 		u64 GetSize(pVoid block) const;
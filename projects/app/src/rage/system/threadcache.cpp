@@ -0,0 +1,177 @@
+#include "threadcache.h"
+
+#include "simpleallocator.h"
+
+namespace
+{
+	// Number of allocators single thread can cache at once, in practice there's only general one
+	constexpr u32 MAX_THREAD_CACHES = 4;
+
+	// Caches are trivially destructible and remain accessible during thread shutdown
+	thread_local rage::sysMemThreadCache tl_Caches[MAX_THREAD_CACHES];
+	thread_local bool tl_ThreadExiting = false;
+
+	// Returns cached blocks of exiting thread to allocators, destructor is registered on first access
+	struct ThreadCacheFlusher
+	{
+		bool Registered = false;
+
+		~ThreadCacheFlusher()
+		{
+			// Frees that happen after this point go to the allocator directly
+			tl_ThreadExiting = true;
+			for (rage::sysMemThreadCache& cache : tl_Caches)
+				cache.Flush();
+		}
+	};
+	thread_local ThreadCacheFlusher tl_Flusher;
+}
+
+rage::sysMemThreadCacheStats rage::sysMemThreadCacheCounters::Get() const
+{
+	sysMemThreadCacheStats stats;
+	stats.AllocHits = AllocHits.load(std::memory_order_relaxed);
+	stats.FreeHits = FreeHits.load(std::memory_order_relaxed);
+	stats.Refills = Refills.load(std::memory_order_relaxed);
+	stats.Drains = Drains.load(std::memory_order_relaxed);
+	stats.CachedBytes = CachedBytes.load(std::memory_order_relaxed);
+	return stats;
+}
+
+void rage::sysMemThreadCache::PublishStats()
+{
+	sysMemThreadCacheCounters& counters = m_Owner->m_ThreadCacheCounters;
+	counters.AllocHits.fetch_add(m_LocalStats.AllocHits, std::memory_order_relaxed);
+	counters.FreeHits.fetch_add(m_LocalStats.FreeHits, std::memory_order_relaxed);
+	counters.Refills.fetch_add(m_LocalStats.Refills, std::memory_order_relaxed);
+	counters.Drains.fetch_add(m_LocalStats.Drains, std::memory_order_relaxed);
+	counters.CachedBytes.fetch_add(m_LocalStats.CachedBytes, std::memory_order_relaxed);
+	m_LocalStats = {};
+}
+
+void rage::sysMemThreadCache::Drain(u8 sizeClass, u32 count)
+{
+	SizeClass& sizeClassList = m_Classes[sizeClass];
+	if (count > sizeClassList.Count)
+		count = sizeClassList.Count;
+	if (count == 0)
+		return;
+
+	// Detach first blocks from the list and return them in one go
+	FreeBlock* head = sizeClassList.Head;
+	FreeBlock* tail = head;
+	for (u32 i = 1; i < count; i++)
+		tail = tail->Next;
+
+	sizeClassList.Head = tail->Next;
+	sizeClassList.Count -= count;
+	tail->Next = nullptr;
+
+	m_LocalStats.Drains++;
+	m_LocalStats.CachedBytes -= static_cast<s64>(count) * GetBlockSize(sizeClass);
+
+	sysCriticalSectionLock lock(m_Owner->m_CriticalSection);
+	m_Owner->m_Smallocator.FreeBatch(head, m_Owner);
+	PublishStats();
+}
+
+rage::sysMemThreadCache* rage::sysMemThreadCache::Get(sysMemSimpleAllocator* owner)
+{
+	if (tl_ThreadExiting)
+		return nullptr;
+
+	sysMemThreadCache* freeCache = nullptr;
+	for (sysMemThreadCache& cache : tl_Caches)
+	{
+		if (cache.m_Owner == owner)
+			return &cache;
+
+		if (!freeCache && !cache.m_Owner)
+			freeCache = &cache;
+	}
+
+	if (!freeCache)
+		return nullptr;
+
+	tl_Flusher.Registered = true;
+	freeCache->m_Owner = owner;
+	return freeCache;
+}
+
+void rage::sysMemThreadCache::Release(sysMemSimpleAllocator* owner)
+{
+	for (sysMemThreadCache& cache : tl_Caches)
+	{
+		if (cache.m_Owner != owner)
+			continue;
+
+		cache.Flush();
+		cache.m_Owner = nullptr;
+	}
+}
+
+pVoid rage::sysMemThreadCache::Allocate(u8 sizeClass)
+{
+	SizeClass& sizeClassList = m_Classes[sizeClass];
+	if (!sizeClassList.Head)
+	{
+		u32 batchSize = m_Owner->m_ThreadCacheConfig.BatchSize[sizeClass];
+		if (batchSize == 0)
+			return nullptr;
+
+		sysCriticalSectionLock lock(m_Owner->m_CriticalSection);
+
+		pVoid head;
+		u32 count = m_Owner->m_Smallocator.AllocateBatch(GetBlockSize(sizeClass), batchSize, head, m_Owner);
+		if (count == 0)
+			return nullptr;
+
+		sizeClassList.Head = static_cast<FreeBlock*>(head);
+		sizeClassList.Count = count;
+
+		m_LocalStats.Refills++;
+		m_LocalStats.CachedBytes += static_cast<s64>(count) * GetBlockSize(sizeClass);
+		PublishStats();
+	}
+
+	FreeBlock* block = sizeClassList.Head;
+	sizeClassList.Head = block->Next;
+	sizeClassList.Count--;
+
+	m_LocalStats.AllocHits++;
+	m_LocalStats.CachedBytes -= GetBlockSize(sizeClass);
+	return block;
+}
+
+bool rage::sysMemThreadCache::Free(pVoid block, u8 sizeClass)
+{
+	const sysMemThreadCacheConfig& config = m_Owner->m_ThreadCacheConfig;
+	if (config.BatchSize[sizeClass] == 0)
+		return false;
+
+	SizeClass& sizeClassList = m_Classes[sizeClass];
+	FreeBlock* freeBlock = static_cast<FreeBlock*>(block);
+	freeBlock->Next = sizeClassList.Head;
+	sizeClassList.Head = freeBlock;
+	sizeClassList.Count++;
+
+	m_LocalStats.FreeHits++;
+	m_LocalStats.CachedBytes += GetBlockSize(sizeClass);
+
+	if (sizeClassList.Count > config.MaxCachedBlocks[sizeClass])
+		Drain(sizeClass, config.BatchSize[sizeClass]);
+
+	return true;
+}
+
+void rage::sysMemThreadCache::Flush()
+{
+	if (!m_Owner)
+		return;
+
+	for (u8 i = 0; i < SYS_MEM_THREAD_CACHE_SIZE_CLASSES; i++)
+		Drain(i, m_Classes[i].Count);
+
+	// Hits since the last batch
+	PublishStats();
+}
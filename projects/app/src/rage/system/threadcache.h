@@ -0,0 +1,113 @@
+//
+// File: threadcache.h
+//
+// Copyright (C) 2023-2024 ranstar74. All rights violated.
+//
+// Part of "Rage Am" Research Project.
+//
+#pragma once
+
+#include "common/types.h"
+
+#include <atomic>
+
+namespace rage
+{
+	class sysMemSimpleAllocator;
+
+	// Note: This is not part of rage.
+
+	static constexpr u32 SYS_MEM_THREAD_CACHE_SIZE_CLASSES = 8;		// Same as sysSmallocator buckets: 16, 32 ... 128
+	static constexpr u32 SYS_MEM_THREAD_CACHE_SIZE_CLASS_SHIFT = 4;
+
+	/**
+	 * \brief Per size class settings of thread cache.
+	 */
+	struct sysMemThreadCacheConfig
+	{
+		// Number of blocks moved between thread cache and shared heap under a single lock, zero disables caching of the size class
+		u16 BatchSize[SYS_MEM_THREAD_CACHE_SIZE_CLASSES] = { 64, 64, 32, 32, 32, 16, 16, 16 };
+		// Once thread cache holds more blocks than this, a batch is returned to the shared heap
+		u16 MaxCachedBlocks[SYS_MEM_THREAD_CACHE_SIZE_CLASSES] = { 256, 256, 128, 128, 128, 64, 64, 64 };
+	};
+
+	/**
+	 * \brief Thread cache statistics of allocator, threads publish their counters only when they take the lock,
+	 * so values lag behind a bit.
+	 */
+	struct sysMemThreadCacheStats
+	{
+		u64 AllocHits = 0;		// Allocations served by thread cache
+		u64 FreeHits = 0;		// Blocks freed to thread cache
+		u64 Refills = 0;		// Batches taken from shared heap
+		u64 Drains = 0;			// Batches returned to shared heap
+		s64 CachedBytes = 0;	// Free memory sitting in thread caches
+
+		void Add(const sysMemThreadCacheStats& other)
+		{
+			AllocHits += other.AllocHits;
+			FreeHits += other.FreeHits;
+			Refills += other.Refills;
+			Drains += other.Drains;
+			CachedBytes += other.CachedBytes;
+		}
+	};
+
+	// Shared counters of the allocator, see sysMemThreadCacheStats
+	struct sysMemThreadCacheCounters
+	{
+		std::atomic<u64> AllocHits = 0;
+		std::atomic<u64> FreeHits = 0;
+		std::atomic<u64> Refills = 0;
+		std::atomic<u64> Drains = 0;
+		std::atomic<s64> CachedBytes = 0;
+
+		sysMemThreadCacheStats Get() const;
+	};
+
+	/**
+	 * \brief Small block cache of a single thread in front of sysMemSimpleAllocator, blocks are taken from and
+	 * returned to sysSmallocator in batches, so threads take allocator lock once per batch instead of every operation.
+	 * \n Cached blocks are still allocated from smallocator point of view, which means that chunk they belong to
+	 * won't be released until thread cache is flushed. Caches are flushed on thread exit, allocator must outlive
+	 * all threads that used it.
+	 */
+	class sysMemThreadCache
+	{
+		// Blocks are linked through their first 8 bytes, like in sysSmallocator
+		struct FreeBlock
+		{
+			FreeBlock* Next;
+		};
+
+		struct SizeClass
+		{
+			FreeBlock* Head = nullptr;
+			u32        Count = 0;
+		};
+
+		sysMemSimpleAllocator* m_Owner = nullptr;
+		SizeClass              m_Classes[SYS_MEM_THREAD_CACHE_SIZE_CLASSES] = {};
+		// Not yet published to sysMemThreadCacheCounters
+		sysMemThreadCacheStats m_LocalStats;
+
+		static u32 GetBlockSize(u8 sizeClass) { return (sizeClass + 1) << SYS_MEM_THREAD_CACHE_SIZE_CLASS_SHIFT; }
+
+		void PublishStats();
+		void Drain(u8 sizeClass, u32 count);
+
+	public:
+		// Gets cache of calling thread for given allocator, NULL if thread is exiting or there are too many allocators
+		static sysMemThreadCache* Get(sysMemSimpleAllocator* owner);
+		// Returns blocks cached by calling thread to the allocator
+		static void Release(sysMemSimpleAllocator* owner);
+
+		static u8 GetSizeClass(u64 size) { return size <= 16 ? 0 : static_cast<u8>((size - 1) >> SYS_MEM_THREAD_CACHE_SIZE_CLASS_SHIFT); }
+
+		// NULL if size class is not cached or shared heap is out of memory
+		pVoid Allocate(u8 sizeClass);
+		// False if size class is not cached, block must be freed by allocator then
+		bool Free(pVoid block, u8 sizeClass);
+		void Flush();
+	};
+}
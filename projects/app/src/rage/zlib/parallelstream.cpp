@@ -0,0 +1,172 @@
+#include "parallelstream.h"
+
+#include "helpers/ranges.h"
+
+void zLibParallelCompressor::CompressSlice(Slice& slice, u32 dataSize, const zLibCompressionProfile& profile)
+{
+	// Worst case for deflate is stored blocks, 5 bytes per 16KB block + sync flush marker,
+	// but zlib-ng on level 1 emits only static huffman blocks, that may take up to 9 bits per byte.
+	// Buffer is large enough to compress slice in single pass
+	u32 bufferSize = dataSize + (dataSize >> 3) + 64;
+	slice.Buffer = std::make_unique<char[]>(bufferSize);
+
+	zLibCompressor compressor(slice.Buffer.get(), bufferSize, profile);
+	if (slice.DictionarySize > 0)
+		compressor.SetDictionary(slice.Dictionary.get(), slice.DictionarySize);
+
+	u32 compressedSize = 0;
+	bool done = compressor.CompressSegments(slice.Segments.GetItems(), slice.Segments.GetSize(), [&](pConstVoid, u32 size)
+		{
+			// Buffer is filled only once, so it's the whole slice
+			compressedSize = size;
+			return compressedSize < bufferSize;
+		});
+	AM_ASSERT(done, "zLibParallelCompressor::CompressSlice() -> Buffer of size %u is too small!", bufferSize);
+	slice.Size = compressedSize;
+}
+
+void zLibParallelCompressor::GatherTail(const rage::atArray<zLibSegment, u32>& segments, char* destination, u32 size)
+{
+	// Walk segments backwards, filling destination from the end
+	u32 remaining = size;
+	for (u32 i = segments.GetSize(); i > 0 && remaining > 0; i--)
+	{
+		const zLibSegment& segment = segments[i - 1];
+		u32 copySize = MIN(segment.Size, remaining);
+		remaining -= copySize;
+		if (segment.Data)
+			memcpy(destination + remaining, static_cast<const char*>(segment.Data) + segment.Size - copySize, copySize);
+		else
+			memset(destination + remaining, 0, copySize);
+	}
+}
+
+bool zLibParallelCompressor::CompressAll(pConstVoid data, u32 dataSize, const WriteFn& writeFn, pConstVoid dictionary, u32 dictionarySize,
+	const zLibCompressionProfile& profile)
+{
+	zLibSegment segment = { data, dataSize };
+	return CompressSegments(&segment, 1, writeFn, dictionary, dictionarySize, profile);
+}
+
+bool zLibParallelCompressor::CompressSegments(const zLibSegment* segments, u32 segmentCount, const WriteFn& writeFn, pConstVoid dictionary, u32 dictionarySize,
+	const zLibCompressionProfile& profile)
+{
+	// Only the tail of preceding data fits in deflate window
+	if (dictionarySize > DICTIONARY_SIZE)
+	{
+		dictionary = static_cast<const char*>(dictionary) + dictionarySize - DICTIONARY_SIZE;
+		dictionarySize = DICTIONARY_SIZE;
+	}
+
+	u32 dataSize = 0;
+	for (u32 i = 0; i < segmentCount; i++)
+		dataSize += segments[i].Size;
+	u32 sliceCount = (dataSize + SLICE_SIZE - 1) / SLICE_SIZE;
+
+	// Ring of slices, slice 'i' occupies slot 'i % MAX_SLICES_IN_FLIGHT'
+	Slice slices[MAX_SLICES_IN_FLIGHT];
+
+	// Slices are submitted in order, so we only move forward in segment list
+	u32 segmentIndex = 0;
+	u32 segmentOffset = 0;
+
+	auto submitSlice = [&](u32 index)
+		{
+			Slice& slice = slices[index % MAX_SLICES_IN_FLIGHT];
+			Slice& prevSlice = slices[(index + MAX_SLICES_IN_FLIGHT - 1) % MAX_SLICES_IN_FLIGHT];
+
+			u32 size = MIN(SLICE_SIZE, dataSize - index * SLICE_SIZE);
+
+			// First slice is primed with user dictionary (if there's any), others with the tail of previous slice
+			if (!slice.Dictionary)
+				slice.Dictionary = std::make_unique<char[]>(DICTIONARY_SIZE);
+			if (index == 0)
+			{
+				slice.DictionarySize = dictionarySize;
+				if (dictionarySize > 0)
+					memcpy(slice.Dictionary.get(), dictionary, dictionarySize);
+			}
+			else
+			{
+				// Segments of previous slice stay in its slot until slot is reused by slice 'index - 1 + MAX_SLICES_IN_FLIGHT'
+				slice.DictionarySize = DICTIONARY_SIZE;
+				GatherTail(prevSlice.Segments, slice.Dictionary.get(), DICTIONARY_SIZE);
+			}
+
+			slice.Segments.Clear();
+			for (u32 remaining = size; remaining > 0;)
+			{
+				const zLibSegment& segment = segments[segmentIndex];
+				u32 partSize = MIN(segment.Size - segmentOffset, remaining);
+				if (partSize > 0)
+				{
+					pConstVoid partData = segment.Data ? static_cast<const char*>(segment.Data) + segmentOffset : nullptr;
+					slice.Segments.Add({ partData, partSize });
+				}
+				remaining -= partSize;
+				segmentOffset += partSize;
+				if (segmentOffset == segment.Size)
+				{
+					segmentIndex++;
+					segmentOffset = 0;
+				}
+			}
+
+			if (!sm_Worker)
+			{
+				CompressSlice(slice, size, profile);
+				return;
+			}
+
+			rageam::BackgroundWorker::Push(sm_Worker);
+			slice.Task = rageam::BackgroundWorker::Run([&slice, size, profile]
+				{
+					CompressSlice(slice, size, profile);
+					return true;
+				});
+			rageam::BackgroundWorker::Pop();
+		};
+
+	bool success = true;
+	u32 submitted = 0;
+	u32 written = 0;
+	for (; written < sliceCount; written++)
+	{
+		// Keep the window of slices full, this limits peak memory to MAX_SLICES_IN_FLIGHT compressed slices
+		while (submitted < sliceCount && submitted - written < MAX_SLICES_IN_FLIGHT)
+			submitSlice(submitted++);
+
+		// Slices must be written strictly in order, wait for the oldest one
+		Slice& slice = slices[written % MAX_SLICES_IN_FLIGHT];
+		if (slice.Task) slice.Task->Wait();
+
+		success = writeFn(slice.Buffer.get(), slice.Size);
+
+		slice.Buffer = nullptr;
+		slice.Task = nullptr;
+
+		if (!success)
+			break;
+	}
+
+	// Write failed, we can't leave while slices in flight still reference source buffer
+	for (Slice& slice : slices)
+	{
+		if (slice.Task) slice.Task->Wait();
+	}
+
+	return success;
+}
+
+void zLibParallelCompressor::InitClass()
+{
+	SYSTEM_INFO sysInfo;
+	GetSystemInfo(&sysInfo);
+	sm_Worker = new rageam::BackgroundWorker("zLib", static_cast<int>(sysInfo.dwNumberOfProcessors));
+}
+
+void zLibParallelCompressor::ShutdownClass()
+{
+	delete sm_Worker;
+	sm_Worker = nullptr;
+}
@@ -0,0 +1,67 @@
+//
+// File: parallelstream.h
+//
+// Copyright (C) 2023-2024 ranstar74. All rights violated.
+//
+// Part of "Rage Am" Research Project.
+//
+#pragma once
+
+#include "stream.h"
+#include "am/system/worker.h"
+
+#include <functional>
+
+/**
+ * \brief Compresses large buffer by splitting it on independent slices that are deflated on worker threads.
+ * Slices are stitched in single raw deflate stream that zLibDecompressor reads exactly as zLibCompressor output:
+ * - Every slice ends with sync flush, so it is byte aligned and never contains final block;
+ * - Every slice is primed with the last 32KB of previous slice, back-references never leave decompressor window.
+ */
+class zLibParallelCompressor
+{
+public:
+	// Invoked on caller thread in the same order as slices are placed in source buffer
+	using WriteFn = zLibWriteFn;
+
+	static constexpr u32 SLICE_SIZE = 0x100000;		// 1MB
+	static constexpr u32 DICTIONARY_SIZE = 0x8000;	// 32KB, deflate window size
+	static constexpr u32 MAX_SLICES_IN_FLIGHT = 32;	// Bounds memory used by compressed slices waiting to be written
+
+private:
+	struct Slice
+	{
+		rage::atArray<zLibSegment, u32>	Segments;	// Parts of source segments that fall into slice
+		amUPtr<char[]>					Dictionary;	// Tail of previous slice, gathered because it may span multiple segments
+		u32								DictionarySize = 0;
+		amUPtr<char[]>					Buffer;
+		u32								Size = 0;
+		rageam::BackgroundTaskPtr		Task;
+	};
+
+	static inline rageam::BackgroundWorker* sm_Worker = nullptr;
+
+	static void CompressSlice(Slice& slice, u32 dataSize, const zLibCompressionProfile& profile);
+	// Copies last bytes of segment list to destination buffer
+	static void GatherTail(const rage::atArray<zLibSegment, u32>& segments, char* destination, u32 size);
+
+public:
+	/**
+	 * \brief Compresses data on worker threads and passes compressed slices to write function in order.
+	 * \param dictionary		Optional data that precedes given buffer in the stream, first slice is primed with it.
+	 * \param profile			Deflate parameters used for every slice.
+	 * \return True if all data was compressed and written, False if write function failed.
+	 * \remarks If worker was not initialized (see ::InitClass), slices are compressed on caller thread.
+	 */
+	static bool CompressAll(pConstVoid data, u32 dataSize, const WriteFn& writeFn, pConstVoid dictionary = nullptr, u32 dictionarySize = 0,
+		const zLibCompressionProfile& profile = {});
+	/**
+	 * \brief Same as CompressAll, but source data is scatter-gather list of segments (see zLibCompressor::CompressSegments).
+	 * Segments are never gathered in single buffer, only deflate window of every slice is copied.
+	 */
+	static bool CompressSegments(const zLibSegment* segments, u32 segmentCount, const WriteFn& writeFn, pConstVoid dictionary = nullptr, u32 dictionarySize = 0,
+		const zLibCompressionProfile& profile = {});
+
+	static void InitClass();
+	static void ShutdownClass();
+};
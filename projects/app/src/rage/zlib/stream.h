@@ -9,6 +9,9 @@
 
 #include "common/types.h"
 #include "am/system/asserts.h"
+#include "helpers/ranges.h"
+
+#include <functional>
 
 #if defined AM_ZLIB
 #include "zlib.h"
@@ -17,9 +20,11 @@ typedef Bytef* zBuffer_t;
 #define Z_DEFLATE_INIT2 deflateInit2
 #define Z_DEFLATE_END deflateEnd
 #define Z_DEFLATE deflate
+#define Z_DEFLATE_SET_DICTIONARY deflateSetDictionary
 #define Z_INFLATE_INIT2 inflateInit2
 #define Z_INFLATE_END inflateEnd
 #define Z_INFLATE inflate
+#define ZLIB_BACKEND_NAME "zlib"
 #elif defined AM_ZLIB_NG
 #include "zlib-ng.h"
 typedef zng_stream zStream_t;
@@ -27,9 +32,11 @@ typedef Bytef* zBuffer_t;
 #define Z_DEFLATE_INIT2 zng_deflateInit2
 #define Z_DEFLATE_END zng_deflateEnd
 #define Z_DEFLATE zng_deflate
+#define Z_DEFLATE_SET_DICTIONARY zng_deflateSetDictionary
 #define Z_INFLATE_INIT2 zng_inflateInit2
 #define Z_INFLATE_END zng_inflateEnd
 #define Z_INFLATE zng_inflate
+#define ZLIB_BACKEND_NAME "zlib-ng"
 #elif defined AM_MINIZ
 #include "miniz.h"
 typedef mz_stream zStream_t;
@@ -40,6 +47,9 @@ typedef Bytef* zBuffer_t;
 #define Z_INFLATE_INIT2 mz_inflateInit2
 #define Z_INFLATE_END mz_inflateEnd
 #define Z_INFLATE mz_inflate
+#define ZLIB_BACKEND_NAME "miniz"
+// Miniz has no preset dictionary support, parallel compressor will produce slightly larger output
+#define ZLIB_NO_SET_DICTIONARY
 #else
 #error No ZLIB Library is specified
 #endif
@@ -48,9 +58,47 @@ static constexpr int ZLIB_WINDOW_BITS = -15;
 static constexpr int ZLIB_COMPRESSION_LEVEL = 5;
 static constexpr int ZLIB_MEMORY_LEVEL = 8;
 
+/**
+ * \brief Deflate parameters that are chosen at runtime, backend library is still chosen at compile time (see ZLIB_BACKEND_NAME).
+ * Default profile is the same as the one that was used before profiles were added, so output is unchanged.
+ */
+struct zLibCompressionProfile
+{
+	int Level = ZLIB_COMPRESSION_LEVEL;		// 0 - 9, 0 is store only
+	int MemoryLevel = ZLIB_MEMORY_LEVEL;	// 1 - 9, size of internal hash table
+	int Strategy = Z_DEFAULT_STRATEGY;
+
+	// For iterating in editor, export time matters more than file size
+	static zLibCompressionProfile Fast() { return { 1, 9, Z_DEFAULT_STRATEGY }; }
+	static zLibCompressionProfile Balanced() { return {}; }
+	// For final builds, the smallest output at cost of much longer export
+	static zLibCompressionProfile Max() { return { 9, 9, Z_DEFAULT_STRATEGY }; }
+
+	bool operator==(const zLibCompressionProfile& other) const
+	{
+		return Level == other.Level && MemoryLevel == other.MemoryLevel && Strategy == other.Strategy;
+	}
+};
+
+// Receives compressed data in the same order as source data, returning False stops compression
+using zLibWriteFn = std::function<bool(pConstVoid compressedBuffer, u32 compressedSize)>;
+
+/**
+ * \brief Piece of source data in scatter-gather list, NULL data means range of zeroes.
+ */
+struct zLibSegment
+{
+	pConstVoid	Data;
+	u32			Size;
+};
+
 class zLibCompressor
 {
 	static constexpr u32 COMPRESS_BUFFER_SIZE = 0x1000;
+	static constexpr u32 ZERO_BUFFER_SIZE = 0x10000;
+
+	// Source for zero segments, deflate has to read input from memory
+	static inline const Bytef sm_Zeroes[ZERO_BUFFER_SIZE] = {};
 
 	zBuffer_t m_Buffer;
 	zStream_t m_Stream = {};
@@ -58,37 +106,37 @@ class zLibCompressor
 	bool      m_OwnBuffer;
 	bool      m_Started = false;
 
-	void Init()
+	void Init(const zLibCompressionProfile& profile)
 	{
 		int status = Z_DEFLATE_INIT2(&m_Stream,
-			ZLIB_COMPRESSION_LEVEL,
+			profile.Level,
 			Z_DEFLATED,
 			ZLIB_WINDOW_BITS,
-			ZLIB_MEMORY_LEVEL,
-			Z_DEFAULT_STRATEGY);
+			profile.MemoryLevel,
+			profile.Strategy);
 
 		AM_ASSERT(status >= 0, "zLibDecompressor() -> Init failed with status %i", status);
 	}
 public:
-	zLibCompressor(u32 bufferSize)
+	zLibCompressor(u32 bufferSize, const zLibCompressionProfile& profile = {})
 	{
 		m_Buffer = new Bytef[bufferSize];
 		m_BufferSize = bufferSize;
 		m_OwnBuffer = true;
 
-		Init();
+		Init(profile);
 	}
 
 	zLibCompressor() : zLibCompressor(COMPRESS_BUFFER_SIZE) {}
 
 	// Initializes compressor with user-specified temporary buffer where all compressed data will be written to.
-	zLibCompressor(pVoid buffer, u32 bufferSize)
+	zLibCompressor(pVoid buffer, u32 bufferSize, const zLibCompressionProfile& profile = {})
 	{
 		m_Buffer = static_cast<zBuffer_t>(buffer);
 		m_BufferSize = bufferSize;
 		m_OwnBuffer = false;
 
-		Init();
+		Init(profile);
 	}
 
 	~zLibCompressor()
@@ -98,6 +146,18 @@ public:
 		Z_DEFLATE_END(&m_Stream);
 	}
 
+	/**
+	 * \brief Primes compressor with preset dictionary, must be called before first Compress call.
+	 * Used to allow back-references into data that was compressed by another stream, see zLibParallelCompressor.
+	 */
+	void SetDictionary(pConstVoid dictionary, u32 dictionarySize)
+	{
+#ifndef ZLIB_NO_SET_DICTIONARY
+		int status = Z_DEFLATE_SET_DICTIONARY(&m_Stream, static_cast<const Bytef*>(dictionary), dictionarySize);
+		AM_ASSERT(status >= 0, "zLibCompressor::SetDictionary() -> Failed with status %i", status);
+#endif
+	}
+
 	/**
 	 * \brief Compresses data.
 	 *
@@ -131,6 +191,67 @@ public:
 		return done;
 	}
 
+	/**
+	 * \brief Compresses list of segments as single contiguous buffer, without gathering them in memory first.
+	 * Stream ends with sync flush, like Compress. Write function is invoked every time when internal buffer is full.
+	 * \return True if all data was compressed and written, False if write function failed.
+	 */
+	bool CompressSegments(const zLibSegment* segments, u32 segmentCount, const zLibWriteFn& writeFn)
+	{
+		m_Stream.next_out = m_Buffer;
+		m_Stream.avail_out = m_BufferSize;
+
+		auto deflateBuffered = [&](int flush)
+			{
+				do
+				{
+					if (m_Stream.avail_out == 0)
+					{
+						if (!writeFn(m_Buffer, m_BufferSize))
+							return false;
+						m_Stream.next_out = m_Buffer;
+						m_Stream.avail_out = m_BufferSize;
+					}
+
+					// Buffer error only means that no progress was possible, it is not fatal
+					int status = Z_DEFLATE(&m_Stream, flush);
+					AM_ASSERT(status >= 0 || status == Z_BUF_ERROR, "zLibCompressor::CompressSegments() -> Failed with status %i", status);
+				} while (m_Stream.avail_in != 0 || m_Stream.avail_out == 0);
+				return true;
+			};
+
+		for (u32 i = 0; i < segmentCount; i++)
+		{
+			const zLibSegment& segment = segments[i];
+			u32 offset = 0;
+			while (offset < segment.Size)
+			{
+				u32 size;
+				if (segment.Data)
+				{
+					size = segment.Size;
+					m_Stream.next_in = const_cast<zBuffer_t>(static_cast<const Bytef*>(segment.Data));
+				}
+				else
+				{
+					size = MIN(segment.Size - offset, ZERO_BUFFER_SIZE);
+					m_Stream.next_in = const_cast<zBuffer_t>(sm_Zeroes);
+				}
+				m_Stream.avail_in = size;
+				offset += size;
+
+				if (!deflateBuffered(Z_NO_FLUSH))
+					return false;
+			}
+		}
+
+		if (!deflateBuffered(Z_SYNC_FLUSH))
+			return false;
+
+		u32 compressedSize = m_BufferSize - m_Stream.avail_out;
+		return compressedSize == 0 || writeFn(m_Buffer, compressedSize);
+	}
+
 	void CompressAll(pVoid data, u32 dataSize, void writeFn(pVoid compressedBuffer, u32 compressedSize))
 	{
 		bool done = false;
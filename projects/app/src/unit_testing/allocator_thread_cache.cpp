@@ -0,0 +1,159 @@
+#ifdef AM_UNIT_TESTS
+
+#include "CppUnitTest.h"
+#include "am/system/timer.h"
+#include "rage/system/simpleallocator.h"
+
+#include <atomic>
+#include <barrier>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace unit_testing
+{
+	using namespace rageam;
+	using namespace rage;
+
+	TEST_CLASS(sysMemThreadCacheTests)
+	{
+		static constexpr u64 HEAP_SIZE = 256ull * 1024ull * 1024ull;
+		static constexpr u32 SLOT_COUNT = 2048;
+		static constexpr u32 SHORT_LIVED_SLOT_COUNT = 64;
+
+		struct Slot
+		{
+			u8* Block = nullptr;
+			u32 Size = 0;
+			u8  Pattern = 0;
+		};
+
+		struct StressResult
+		{
+			u64 ElapsedMs;
+			u32 CorruptedBlocks;
+		};
+
+		// Every thread keeps a set of slots and randomly replaces blocks in them. Sizes are mostly in smallocator
+		// range with occasional large blocks, most operations hit a few short lived slots, the rest live longer.
+		// Blocks left in slots are freed by the neighbour thread to exercise freeing blocks of other thread.
+		static StressResult RunStress(sysMemSimpleAllocator& allocator, u32 threadCount, u32 operationCount)
+		{
+			std::vector<std::vector<Slot>> threadSlots(threadCount, std::vector<Slot>(SLOT_COUNT));
+			std::atomic_uint corruptedBlocks = 0;
+			std::barrier barrier(threadCount);
+
+			auto freeSlot = [&](Slot& slot)
+				{
+					if (!slot.Block)
+						return;
+
+					if (slot.Block[0] != slot.Pattern || slot.Block[slot.Size - 1] != slot.Pattern)
+						++corruptedBlocks;
+
+					allocator.Free(slot.Block);
+					slot.Block = nullptr;
+				};
+
+			auto threadFn = [&](u32 threadIndex)
+				{
+					std::mt19937 rng(threadIndex + 1);
+					std::vector<Slot>& slots = threadSlots[threadIndex];
+					for (u32 i = 0; i < operationCount; i++)
+					{
+						u32 slotIndex = rng() % 4 != 0 ? rng() % SHORT_LIVED_SLOT_COUNT : rng() % SLOT_COUNT;
+						Slot& slot = slots[slotIndex];
+						if (slot.Block)
+						{
+							freeSlot(slot);
+							continue;
+						}
+
+						u32 size = rng() % 32 != 0 ? 1 + rng() % 128 : 129 + rng() % 4096;
+						slot.Block = static_cast<u8*>(allocator.Allocate(size));
+						slot.Size = size;
+						slot.Pattern = static_cast<u8>(rng());
+						memset(slot.Block, slot.Pattern, size);
+					}
+
+					barrier.arrive_and_wait();
+
+					for (Slot& slot : threadSlots[(threadIndex + 1) % threadCount])
+						freeSlot(slot);
+				};
+
+			Timer timer = Timer::StartNew();
+			std::vector<std::thread> threads;
+			for (u32 i = 0; i < threadCount; i++)
+				threads.emplace_back(threadFn, i);
+			for (std::thread& thread : threads)
+				thread.join();
+			timer.Stop();
+
+			return { timer.GetElapsedMilliseconds(), corruptedBlocks };
+		}
+
+	public:
+		// Thread caches are flushed on thread exit, all chunks must be released after that
+		TEST_METHOD(VerifyStressNoLeaks)
+		{
+			sysMemSimpleAllocator allocator(HEAP_SIZE);
+			Assert::IsTrue(allocator.GetUseThreadCache());
+
+			u64 memoryBefore = allocator.GetMemoryUsed();
+			StressResult result = RunStress(allocator, 8, 100000);
+			u64 memoryAfter = allocator.GetMemoryUsed();
+
+			allocator.SanityCheck();
+
+			sysMemThreadCacheStats stats = allocator.GetThreadCacheStats();
+			Assert::AreEqual(0u, result.CorruptedBlocks);
+			Assert::AreEqual(memoryBefore, memoryAfter);
+			Assert::AreEqual(0ll, stats.CachedBytes);
+			Assert::IsTrue(stats.AllocHits > 0 && stats.FreeHits > 0);
+		}
+
+		// Disabled size class must go through the locked path
+		TEST_METHOD(VerifyDisabledSizeClass)
+		{
+			sysMemSimpleAllocator allocator(HEAP_SIZE);
+			sysMemThreadCacheConfig config;
+			config.BatchSize[sysMemThreadCache::GetSizeClass(64)] = 0;
+			allocator.SetThreadCacheConfig(config);
+
+			u64 memoryBefore = allocator.GetMemoryUsed();
+			pVoid block = allocator.Allocate(64);
+			Assert::AreEqual(64ull, allocator.GetSize(block));
+			allocator.Free(block);
+			Assert::AreEqual(0ull, allocator.GetThreadCacheStats().AllocHits);
+			Assert::AreEqual(memoryBefore, allocator.GetMemoryUsed());
+		}
+
+		TEST_METHOD(BenchmarkStress)
+		{
+			static constexpr u32 OPERATION_COUNT = 1000000;
+
+			u32 maxThreadCount = std::max(std::thread::hardware_concurrency(), 1u);
+			for (u32 threadCount : { 1u, 4u, maxThreadCount })
+			{
+				u64 lockedTime;
+				{
+					sysMemSimpleAllocator allocator(HEAP_SIZE);
+					allocator.SetUseThreadCache(false);
+					lockedTime = RunStress(allocator, threadCount, OPERATION_COUNT).ElapsedMs;
+				}
+
+				sysMemSimpleAllocator allocator(HEAP_SIZE);
+				u64 cachedTime = RunStress(allocator, threadCount, OPERATION_COUNT).ElapsedMs;
+				sysMemThreadCacheStats stats = allocator.GetThreadCacheStats();
+
+				Logger::WriteMessage(String::FormatTemp(
+					"%u threads, %u operations each: Locked %llu ms, Thread cache %llu ms (Alloc hits %llu, Free hits %llu, Refills %llu, Drains %llu)\n",
+					threadCount, OPERATION_COUNT, lockedTime, cachedTime, stats.AllocHits, stats.FreeHits, stats.Refills, stats.Drains));
+			}
+		}
+	};
+}
+#endif
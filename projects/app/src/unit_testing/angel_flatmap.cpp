@@ -0,0 +1,278 @@
+#ifdef AM_UNIT_TESTS
+
+#include "CppUnitTest.h"
+#include "am/system/timer.h"
+#include "rage/atl/flatmap.h"
+
+#include <random>
+#include <unordered_set>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace rage;
+
+namespace Microsoft::VisualStudio::CppUnitTestFramework
+{
+	template<> std::wstring ToString<>(const atFlatMap<int>& set)
+	{
+		std::wstring string;
+
+		for (int value : set)
+		{
+			string += L" ";
+			string += std::to_wstring(value);
+		}
+		string += L" ";
+
+		return string;
+	}
+
+	template<> std::wstring ToString<>(const atFlatMapIterator<int>& it)
+	{
+		if (!it.HasValue())
+			return L"None";
+
+		return String::FormatTemp(L"{ %u }", it.GetValue());
+	}
+}
+
+namespace unit_testing
+{
+	using namespace rageam;
+
+	TEST_CLASS(atFlatMapTests)
+	{
+		// atMap slot count is 16 bit, keep benchmark size below it
+		static constexpr int BENCHMARK_COUNT = 60000;
+
+		// Maps all values to the same hash to verify that full key comparison resolves collisions
+		struct CollidingHashFn
+		{
+			u32 operator()(int) const { return 0xDEAD; }
+		};
+
+		// Random keys, sequential integers would be too easy for atMap because it uses identity hash
+		static std::vector<int> GenerateKeys(int count, u32 seed)
+		{
+			std::mt19937 rng(seed);
+			std::vector<int> keys;
+			keys.reserve(count);
+			std::unordered_set<int> unique;
+			while (static_cast<int>(keys.size()) < count)
+			{
+				int key = static_cast<int>(rng());
+				if (unique.insert(key).second)
+					keys.push_back(key);
+			}
+			return keys;
+		}
+
+	public:
+		TEST_METHOD(VerifyIterator)
+		{
+			atFlatMap<int> set;
+			atFlatMap<int> iteratedSet;
+
+			for (int i = 0; i < 4000; i++)
+				set.Insert(i);
+
+			for (int i : set)
+				iteratedSet.Insert(i);
+
+			Assert::AreEqual(4000u, set.GetNumUsedSlots());
+			Assert::AreEqual(set, iteratedSet);
+		}
+
+		// Inserts and removes random values, tables with many deleted slots must be rehashed in place
+		TEST_METHOD(VerifyMatchesReference)
+		{
+			atFlatMap<int> set;
+			std::unordered_set<int> reference;
+			std::mt19937 rng(42);
+
+			for (int i = 0; i < 200000; i++)
+			{
+				int value = static_cast<int>(rng() % 5000);
+				if (rng() % 3 == 0)
+				{
+					Assert::AreEqual(reference.contains(value), set.Contains(value));
+					if (reference.erase(value))
+						set.Remove(value);
+				}
+				else
+				{
+					reference.insert(value);
+					set.Insert(value);
+				}
+				Assert::AreEqual(static_cast<u32>(reference.size()), set.GetNumUsedSlots());
+			}
+
+			for (int value = 0; value < 5000; value++)
+				Assert::AreEqual(reference.contains(value), set.Contains(value));
+
+			u32 iteratedCount = 0;
+			for (int value : set)
+			{
+				Assert::IsTrue(reference.contains(value));
+				iteratedCount++;
+			}
+			Assert::AreEqual(static_cast<u32>(reference.size()), iteratedCount);
+		}
+
+		TEST_METHOD(VerifyFullKeyCollisions)
+		{
+			atFlatMap<int, CollidingHashFn, atFlatMapKeyEqualFn<int>> set;
+			for (int i = 0; i < 100; i++)
+				set.Insert(i);
+			set.Insert(50); // Must replace existing value
+
+			Assert::AreEqual(100u, set.GetNumUsedSlots());
+			for (int i = 0; i < 100; i++)
+				Assert::IsTrue(set.Contains(i));
+			Assert::IsFalse(set.Contains(100));
+
+			for (int i = 0; i < 100; i += 2)
+				set.Remove(i);
+
+			Assert::AreEqual(50u, set.GetNumUsedSlots());
+			for (int i = 0; i < 100; i++)
+				Assert::AreEqual(i % 2 != 0, set.Contains(i));
+		}
+
+		TEST_METHOD(VerifyDestructor)
+		{
+			sysMemAllocator* allocator = GetAllocator(ALLOC_TYPE_GENERAL);
+			u64 memoryBefore = allocator->GetMemoryUsed();
+			{
+				atFlatMap<std::shared_ptr<int[]>> set;
+
+				auto array1 = std::make_shared<int[]>(1000);
+				auto array2 = std::make_shared<int[]>(1000);
+				{
+					auto array3 = std::make_shared<int[]>(1000);
+					set.InsertAt(1, array3);
+				}
+				auto array3 = set.GetAt(1);
+
+				set.InsertAt(1, array1);
+				set.InsertAt(1, array2);
+				set.InsertAt(2, array1);
+				set.InsertAt(3, array2);
+				set.RemoveAt(2);
+				set.InsertAt(1, array3);
+
+				atFlatMap copy = set;
+				atFlatMap moved = std::move(copy);
+			}
+			u64 memoryAfter = allocator->GetMemoryUsed();
+
+			allocator->SanityCheck();
+
+			Assert::AreEqual(memoryBefore, memoryAfter);
+		}
+
+		TEST_METHOD(VerifyInitializerListComparison)
+		{
+			atFlatMap input = { 5, 5, 10, 2, 2, 3, 6, 6 };
+			atFlatMap expected = { 6, 3, 5, 10, 2 };
+
+			Assert::AreEqual(expected, input);
+		}
+
+		TEST_METHOD(VerifyIteratorFindAndRemove)
+		{
+			atFlatMap input = { 5, 10, 6 };
+			atFlatMap expected = { 5, 6 };
+
+			auto it = input.Find(10);
+			Assert::AreNotEqual(input.end(), it);
+			input.RemoveAtIterator(it);
+
+			Assert::AreEqual(expected, input);
+			Assert::AreEqual(input.end(), input.Find(10));
+		}
+
+		TEST_METHOD(VerifyCopying)
+		{
+			atFlatMap<int> input;
+			for (int i = 0; i < 1000; i++)
+				input.Insert(i);
+			for (int i = 0; i < 1000; i += 3)
+				input.Remove(i);
+
+			atFlatMap copy = input; // NOLINT(performance-unnecessary-copy-initialization)
+
+			Assert::AreEqual(input, copy);
+		}
+
+		TEST_METHOD(BenchmarkOperations)
+		{
+			// Second half of keys is never inserted, half of lookups miss
+			std::vector<int> allKeys = GenerateKeys(BENCHMARK_COUNT * 2, 1);
+			std::vector keys(allKeys.begin(), allKeys.begin() + BENCHMARK_COUNT);
+			std::vector missingKeys(allKeys.begin() + BENCHMARK_COUNT, allKeys.end());
+
+			// Measures insert, find, iterate and erase of the same set of keys
+			auto benchmark = [&](const char* name, auto& map, auto insert, auto find, auto erase)
+			{
+				Timer timer = Timer::StartNew();
+				for (int key : keys)
+					insert(map, key);
+				timer.Stop();
+				u64 insertTime = timer.GetElapsedMicroseconds();
+
+				int found = 0;
+				timer.Restart();
+				for (int i = 0; i < BENCHMARK_COUNT; i++)
+				{
+					found += find(map, keys[i]);
+					found += find(map, missingKeys[i]);
+				}
+				timer.Stop();
+				u64 findTime = timer.GetElapsedMicroseconds();
+				Assert::AreEqual(BENCHMARK_COUNT, found);
+
+				s64 sum = 0;
+				timer.Restart();
+				for (const auto& value : map)
+					sum += *reinterpret_cast<const int*>(&value);
+				timer.Stop();
+				u64 iterateTime = timer.GetElapsedMicroseconds();
+
+				timer.Restart();
+				for (int key : keys)
+					erase(map, key);
+				timer.Stop();
+				u64 eraseTime = timer.GetElapsedMicroseconds();
+
+				Logger::WriteMessage(String::FormatTemp(
+					"%s, %i values: Insert %llu us, Find %llu us, Iterate %llu us (%lli), Erase %llu us\n",
+					name, BENCHMARK_COUNT, insertTime, findTime, iterateTime, sum, eraseTime));
+			};
+
+			atMap<int> map;
+			benchmark("atMap", map,
+				[](atMap<int>& m, int key) { m.Insert(key); },
+				[](atMap<int>& m, int key) { return m.Contains(key) ? 1 : 0; },
+				[](atMap<int>& m, int key) { m.Remove(key); });
+
+			atFlatMap<int> flatMap;
+			benchmark("atFlatMap", flatMap,
+				[](atFlatMap<int>& m, int key) { m.Insert(key); },
+				[](atFlatMap<int>& m, int key) { return m.Contains(key) ? 1 : 0; },
+				[](atFlatMap<int>& m, int key) { m.Remove(key); });
+
+			atFlatMap<int, atMapHashFn<int>, atFlatMapKeyEqualFn<int>> flatMapFullKey;
+			benchmark("atFlatMap (full key)", flatMapFullKey,
+				[](auto& m, int key) { m.Insert(key); },
+				[](auto& m, int key) { return m.Contains(key) ? 1 : 0; },
+				[](auto& m, int key) { m.Remove(key); });
+
+			std::unordered_set<int> stdSet;
+			benchmark("std::unordered_set", stdSet,
+				[](std::unordered_set<int>& m, int key) { m.insert(key); },
+				[](std::unordered_set<int>& m, int key) { return m.contains(key) ? 1 : 0; },
+				[](std::unordered_set<int>& m, int key) { m.erase(key); });
+		}
+	};
+}
+#endif
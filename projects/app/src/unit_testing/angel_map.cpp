@@ -1,6 +1,7 @@
 #ifdef AM_UNIT_TESTS
 
 #include "CppUnitTest.h"
+#include "am/system/timer.h"
 #include "rage/atl/map.h"
 
 using namespace Microsoft::VisualStudio::CppUnitTestFramework;
@@ -211,6 +212,85 @@ namespace unit_testing
 
 			Assert::AreEqual(input, resized);
 		}
+
+		// Removed nodes must be reused and all blocks must be released on destroy
+		TEST_METHOD(VerifyPooledNodesNoLeaks)
+		{
+			using PooledMap = atMap<std::shared_ptr<int[]>, atMapHashFn<u32>, atMapPooledNodeAllocator>;
+
+			sysMemAllocator* allocator = GetAllocator(ALLOC_TYPE_GENERAL);
+			u64 memoryBefore = allocator->GetMemoryUsed();
+			{
+				PooledMap map;
+				auto array = std::make_shared<int[]>(1000);
+				for (u32 i = 0; i < 10000; i++)
+					map.InsertAt(i, array);
+				for (u32 i = 0; i < 10000; i += 2)
+					map.RemoveAt(i);
+				for (u32 i = 0; i < 10000; i += 2)
+					map.InsertAt(i, array);
+
+				PooledMap copy = map;
+				Assert::AreEqual(map.GetNumUsedSlots(), copy.GetNumUsedSlots());
+				for (u32 i = 0; i < 10000; i++)
+					Assert::IsTrue(copy.ContainsAt(i));
+
+				map.Clear();
+				Assert::AreEqual(10001l, array.use_count());
+				PooledMap moved = std::move(copy);
+			}
+			u64 memoryAfter = allocator->GetMemoryUsed();
+
+			allocator->SanityCheck();
+
+			Assert::AreEqual(memoryBefore, memoryAfter);
+		}
+
+		TEST_METHOD(BenchmarkPooledNodes)
+		{
+			// Used slot count is 16 bit
+			static constexpr u32 COUNT = 60000;
+
+			auto benchmark = [](const char* name, auto& map)
+			{
+				char buffer[32];
+				Timer timer = Timer::StartNew();
+				for (u32 i = 0; i < COUNT; i++)
+				{
+					sprintf_s(buffer, sizeof buffer, "entity_name_%u", i);
+					map.InsertAt(atStringHash(buffer), i);
+				}
+				timer.Stop();
+				u64 fillTime = timer.GetElapsedMicroseconds();
+
+				u64 sum = 0;
+				timer.Restart();
+				for (int pass = 0; pass < 4; pass++)
+				{
+					for (u32 i = 0; i < COUNT; i++)
+					{
+						sprintf_s(buffer, sizeof buffer, "entity_name_%u", i);
+						sum += *map.TryGetAt(atStringHash(buffer));
+					}
+				}
+				timer.Stop();
+				u64 lookupTime = timer.GetElapsedMicroseconds();
+
+				timer.Restart();
+				map.Destroy();
+				timer.Stop();
+				u64 destroyTime = timer.GetElapsedMicroseconds();
+
+				Logger::WriteMessage(String::FormatTemp("%s, %u values: Fill %llu us, Lookup %llu us (%llu), Destroy %llu us\n",
+					name, COUNT, fillTime, lookupTime, sum, destroyTime));
+			};
+
+			atMap<u32> heapMap;
+			benchmark("Heap nodes", heapMap);
+
+			atMap<u32, atMapHashFn<u32>, atMapPooledNodeAllocator> pooledMap;
+			benchmark("Pooled nodes", pooledMap);
+		}
 	};
 }
 #endif
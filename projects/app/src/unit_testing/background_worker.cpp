@@ -0,0 +1,202 @@
+#ifdef AM_UNIT_TESTS
+
+#include "CppUnitTest.h"
+#include "am/system/timer.h"
+#include "am/system/worker.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace unit_testing
+{
+	using namespace rageam;
+
+	TEST_CLASS(BackgroundWorkerTests)
+	{
+		static constexpr int THREAD_COUNT = 8;
+		static constexpr u32 THROUGHPUT_TASK_COUNT = 200000;
+		static constexpr u32 LATENCY_SAMPLE_COUNT = 2000;
+
+	public:
+		// Every thread waits for tasks scheduled on the same worker, with spinning wait this never finishes
+		TEST_METHOD(VerifyNestedWaitDoesNotDeadlock)
+		{
+			BackgroundWorker worker("Test", 2);
+			BackgroundWorker::Push(&worker);
+
+			std::atomic_int innerCount = 0;
+			Tasks outerTasks;
+			for (int i = 0; i < 4; i++)
+			{
+				outerTasks.Emplace(BackgroundWorker::Run([&]
+					{
+						Tasks innerTasks;
+						for (int k = 0; k < 16; k++)
+						{
+							innerTasks.Emplace(BackgroundWorker::Run([&]
+								{
+									++innerCount;
+									return true;
+								}));
+						}
+						return BackgroundWorker::WaitFor(innerTasks);
+					}));
+			}
+
+			Assert::IsTrue(BackgroundWorker::WaitFor(outerTasks));
+			Assert::AreEqual(4 * 16, innerCount.load());
+
+			BackgroundWorker::Pop();
+		}
+
+		TEST_METHOD(VerifyContinuation)
+		{
+			BackgroundWorker worker("Test", 2);
+			BackgroundWorker::Push(&worker);
+
+			std::atomic_int order = 0;
+			int firstOrder = -1;
+			int secondOrder = -1;
+			BackgroundTaskPtr first = BackgroundWorker::Run([&]
+				{
+					Sleep(10);
+					firstOrder = order++;
+					return false;
+				});
+			BackgroundTaskPtr second = BackgroundWorker::ContinueWith(first, [&]
+				{
+					secondOrder = order++;
+					return true;
+				});
+
+			second->Wait();
+			Assert::IsTrue(first->IsFinished());
+			Assert::IsFalse(first->IsSuccess()); // Continuation runs regardless of antecedent result
+			Assert::IsTrue(second->IsSuccess());
+			Assert::AreEqual(0, firstOrder);
+			Assert::AreEqual(1, secondOrder);
+
+			// Continuation of already finished task is scheduled immediately
+			BackgroundTaskPtr third = BackgroundWorker::ContinueWith(first, [] { return true; });
+			third->Wait();
+			Assert::IsTrue(third->IsSuccess());
+
+			BackgroundWorker::Pop();
+		}
+
+		TEST_METHOD(VerifyResultIsPreservedInNestedWait)
+		{
+			BackgroundWorker worker("Test", 1);
+			BackgroundWorker::Push(&worker);
+
+			BackgroundTaskPtr outer = BackgroundWorker::Run([]
+				{
+					int outerResult = 1;
+					BackgroundWorker::SetCurrentResult(outerResult);
+
+					// Single thread, inner task is executed by this thread while waiting
+					BackgroundTaskPtr inner = BackgroundWorker::Run([]
+						{
+							int innerResult = 2;
+							BackgroundWorker::SetCurrentResult(innerResult);
+							return true;
+						});
+					inner->Wait();
+					return inner->GetResult<int>() == 2;
+				});
+
+			outer->Wait();
+			Assert::IsTrue(outer->IsSuccess());
+			Assert::AreEqual(1, outer->GetResult<int>());
+
+			BackgroundWorker::Pop();
+		}
+
+		TEST_METHOD(BenchmarkTaskThroughputAndLatency)
+		{
+			BackgroundWorker worker("Test", THREAD_COUNT);
+			BackgroundWorker::Push(&worker);
+
+			// Throughput: many tiny tasks scheduled from outside thread
+			{
+				std::atomic_int counter = 0;
+				Tasks tasks;
+				tasks.Reserve(THROUGHPUT_TASK_COUNT);
+
+				Timer timer = Timer::StartNew();
+				for (u32 i = 0; i < THROUGHPUT_TASK_COUNT; i++)
+				{
+					tasks.Emplace(BackgroundWorker::Run([&]
+						{
+							++counter;
+							return true;
+						}));
+				}
+				BackgroundWorker::WaitFor(tasks);
+				timer.Stop();
+
+				Assert::AreEqual(static_cast<int>(THROUGHPUT_TASK_COUNT), counter.load());
+
+				double seconds = static_cast<double>(timer.GetElapsedMicroseconds()) / 1000000.0;
+				Logger::WriteMessage(String::FormatTemp("External submit: %u tasks in %llu ms, %.0f tasks/s\n",
+					THROUGHPUT_TASK_COUNT, timer.GetElapsedMilliseconds(), THROUGHPUT_TASK_COUNT / seconds));
+			}
+
+			// Throughput: tasks fanned out from worker threads, they're pushed to local deques and stolen
+			{
+				std::atomic_int counter = 0;
+				constexpr u32 fanOut = THROUGHPUT_TASK_COUNT / 100;
+
+				Timer timer = Timer::StartNew();
+				Tasks outerTasks;
+				for (u32 i = 0; i < 100; i++)
+				{
+					outerTasks.Emplace(BackgroundWorker::Run([&]
+						{
+							Tasks innerTasks;
+							innerTasks.Reserve(fanOut);
+							for (u32 k = 0; k < fanOut; k++)
+							{
+								innerTasks.Emplace(BackgroundWorker::Run([&]
+									{
+										++counter;
+										return true;
+									}));
+							}
+							return BackgroundWorker::WaitFor(innerTasks);
+						}));
+				}
+				BackgroundWorker::WaitFor(outerTasks);
+				timer.Stop();
+
+				Assert::AreEqual(static_cast<int>(THROUGHPUT_TASK_COUNT), counter.load());
+
+				double seconds = static_cast<double>(timer.GetElapsedMicroseconds()) / 1000000.0;
+				Logger::WriteMessage(String::FormatTemp("Nested submit:   %u tasks in %llu ms, %.0f tasks/s\n",
+					THROUGHPUT_TASK_COUNT, timer.GetElapsedMilliseconds(), THROUGHPUT_TASK_COUNT / seconds));
+			}
+
+			// Latency: time from submitting task on idle worker until it finishes
+			{
+				u64 totalMicroseconds = 0;
+				u64 maxMicroseconds = 0;
+				for (u32 i = 0; i < LATENCY_SAMPLE_COUNT; i++)
+				{
+					Timer timer = Timer::StartNew();
+					BackgroundTaskPtr task = BackgroundWorker::Run([] { return true; });
+					task->Wait();
+					timer.Stop();
+
+					u64 elapsed = timer.GetElapsedMicroseconds();
+					totalMicroseconds += elapsed;
+					maxMicroseconds = MAX(maxMicroseconds, elapsed);
+				}
+
+				Logger::WriteMessage(String::FormatTemp("Round-trip latency: avg %.2f us, max %llu us\n",
+					static_cast<double>(totalMicroseconds) / LATENCY_SAMPLE_COUNT, maxMicroseconds));
+			}
+
+			BackgroundWorker::Pop();
+		}
+	};
+}
+#endif
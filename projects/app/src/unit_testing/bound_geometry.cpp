@@ -0,0 +1,294 @@
+#ifdef AM_UNIT_TESTS
+
+#include "CppUnitTest.h"
+#include "am/system/timer.h"
+#include "am/types.h"
+#include "rage/math/math.h"
+#include "rage/physics/bounds/boundgeometry.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace unit_testing
+{
+	using namespace rageam;
+	using namespace rage;
+
+	TEST_CLASS(phBoundGeometryTests)
+	{
+		static constexpr int MAX_GRID_SIZE = 126; // 2 layers of 126x126 quads, 63504 triangles - close to 16 bit polygon index limit
+
+		// Exposes both versions of computations that have reference implementation
+		class TestBound : public phBoundGeometry
+		{
+		public:
+			using phBoundGeometry::phBoundGeometry;
+			using phBoundGeometry::SHRINK_GRID_MIN_POLYGONS;
+			using phBoundGeometry::TryShrinkByMargin;
+			using phBoundGeometry::TryShrinkByMarginBruteForce;
+			using phBoundGeometry::ComputeNeighbors;
+			using phBoundGeometry::ComputeNeighborsReference;
+			using phBoundGeometry::ComputeOctantMap;
+			using phBoundGeometry::ComputeOctantMapReference;
+			using phBoundGeometry::OctantMapDelete;
+		};
+
+		struct OctantMapCopy
+		{
+			bool     Exists;
+			u32      IndexCounts[phOctantMap::MAX_OCTANTS];
+			List<u32> Indices[phOctantMap::MAX_OCTANTS];
+		};
+
+		// Two layers of rough terrain placed close to each other, so large margins make them intersect
+		static amUPtr<TestBound> CreateLayeredTerrain(int gridSize, float layerGap = 0.3f)
+		{
+			AM_ASSERT(gridSize <= MAX_GRID_SIZE, "CreateLayeredTerrain() -> Grid is too large for single bound");
+
+			auto getHeight = [](int x, int y)
+				{
+					float height = sinf(static_cast<float>(x) * 0.31f) * 2.0f + cosf(static_cast<float>(y) * 0.23f) * 3.0f;
+					return height + static_cast<float>((x * 7919 + y * 104729) % 17) * 0.05f;
+				};
+
+			int verticesPerLayer = (gridSize + 1) * (gridSize + 1);
+			List<Vector3> vertices;
+			List<u16> indices;
+			spdAABB bb(S_MAX, S_MIN);
+			for (int layer = 0; layer < 2; layer++)
+			{
+				for (int y = 0; y <= gridSize; y++)
+				{
+					for (int x = 0; x <= gridSize; x++)
+					{
+						// Place bound away from the origin, like map collision
+						Vector3 vertex(
+							static_cast<float>(x) * 0.5f + 1000.0f,
+							static_cast<float>(y) * 0.5f - 300.0f,
+							getHeight(x, y) + static_cast<float>(layer) * layerGap);
+						vertices.Add(vertex);
+						bb = bb.AddPoint(Vec3V(vertex));
+					}
+				}
+
+				for (int y = 0; y < gridSize; y++)
+				{
+					for (int x = 0; x < gridSize; x++)
+					{
+						u16 v1 = static_cast<u16>(layer * verticesPerLayer + y * (gridSize + 1) + x);
+						u16 v2 = v1 + 1;
+						u16 v3 = static_cast<u16>(v1 + gridSize + 1);
+						u16 v4 = v3 + 1;
+						indices.Add(v1); indices.Add(v2); indices.Add(v3);
+						indices.Add(v2); indices.Add(v4); indices.Add(v3);
+					}
+				}
+			}
+			return std::make_unique<TestBound>(bb, vertices.begin(), indices.begin(), vertices.GetSize(), indices.GetSize());
+		}
+
+		// Sphere without poles, most of vertices lie in front of octant they face, so octant map is likely to overflow
+		static amUPtr<TestBound> CreateSphereBand(int segments)
+		{
+			int rings = segments / 2;
+			List<Vector3> vertices;
+			List<u16> indices;
+			spdAABB bb(S_MAX, S_MIN);
+			for (int ring = 0; ring <= rings; ring++)
+			{
+				float theta = 0.1f * PI + 0.8f * PI * static_cast<float>(ring) / static_cast<float>(rings);
+				for (int segment = 0; segment < segments; segment++)
+				{
+					float phi = 2.0f * PI * static_cast<float>(segment) / static_cast<float>(segments);
+					Vector3 vertex(sinf(theta) * cosf(phi) * 10.0f, sinf(theta) * sinf(phi) * 10.0f, cosf(theta) * 10.0f);
+					vertices.Add(vertex);
+					bb = bb.AddPoint(Vec3V(vertex));
+				}
+			}
+
+			for (int ring = 0; ring < rings; ring++)
+			{
+				for (int segment = 0; segment < segments; segment++)
+				{
+					u16 v1 = static_cast<u16>(ring * segments + segment);
+					u16 v2 = static_cast<u16>(ring * segments + (segment + 1) % segments);
+					u16 v3 = static_cast<u16>(v1 + segments);
+					u16 v4 = static_cast<u16>(v2 + segments);
+					indices.Add(v1); indices.Add(v3); indices.Add(v2);
+					indices.Add(v2); indices.Add(v3); indices.Add(v4);
+				}
+			}
+			return std::make_unique<TestBound>(bb, vertices.begin(), indices.begin(), vertices.GetSize(), indices.GetSize());
+		}
+
+		static List<phPolygon> CopyPolygons(const TestBound& bound)
+		{
+			List<phPolygon> polygons;
+			for (u32 i = 0; i < bound.GetPolygonCount(); i++)
+				polygons.Add(bound.GetPolygon(static_cast<u16>(i)));
+			return polygons;
+		}
+
+		static OctantMapCopy CopyOctantMap(const TestBound& bound)
+		{
+			OctantMapCopy copy = {};
+			phOctantMap* map = bound.GetOctantMap();
+			copy.Exists = map != nullptr;
+			if (!map)
+				return copy;
+
+			for (u32 i = 0; i < phOctantMap::MAX_OCTANTS; i++)
+			{
+				copy.IndexCounts[i] = map->IndexCounts[i];
+				for (u32 k = 0; k < map->IndexCounts[i]; k++)
+					copy.Indices[i].Add(map->Indices[i][k]);
+			}
+			return copy;
+		}
+
+	public:
+		// Grid must give exactly the same result as testing every vertex against every polygon
+		TEST_METHOD(VerifyGridMatchesBruteForce)
+		{
+			for (int gridSize : { 8, 24, 48 })
+			{
+				amUPtr<TestBound> bound = CreateLayeredTerrain(gridSize);
+				Assert::IsTrue(bound->GetPolygonCount() >= TestBound::SHRINK_GRID_MIN_POLYGONS);
+
+				u32 vertexCount = bound->GetVertexCount();
+				amUPtr<Vec3V[]> gridVertices = std::make_unique<Vec3V[]>(vertexCount);
+				amUPtr<Vec3V[]> bruteForceVertices = std::make_unique<Vec3V[]>(vertexCount);
+
+				u32 failedShrinks = 0;
+				for (float t : { 0.0f, 0.5f, 1.0f })
+				{
+					// The same sequence as in SetMarginAndShrink, but without stopping at the first success
+					for (float margin = 2.0f; margin > 0.001f; margin /= 2.0f)
+					{
+						bool gridResult = bound->TryShrinkByMargin(margin, t, gridVertices.get());
+						bool bruteForceResult = bound->TryShrinkByMarginBruteForce(margin, t, bruteForceVertices.get());
+						Assert::AreEqual(bruteForceResult, gridResult);
+						Assert::AreEqual(0, memcmp(gridVertices.get(), bruteForceVertices.get(), sizeof(Vec3V) * vertexCount));
+						if (!gridResult)
+							failedShrinks++;
+					}
+				}
+
+				// Make sure that both outcomes were actually tested
+				Assert::IsTrue(failedShrinks > 0);
+			}
+		}
+
+		TEST_METHOD(BenchmarkShrink)
+		{
+			static constexpr int BRUTE_FORCE_MAX_GRID_SIZE = 50; // Larger bounds take minutes with brute force
+
+			// Polygon indices are 16 bit, so larger triangle counts are split in multiple bounds
+			struct Case { u32 TriangleCount; int GridSize; int BoundCount; };
+			Case cases[] =
+			{
+				{ 1000, 16, 1 },
+				{ 10000, 50, 1 },
+				{ 100000, 112, 2 },
+				{ 500000, MAX_GRID_SIZE - 1, 8 },
+			};
+
+			for (const Case& benchmarkCase : cases)
+			{
+				amUPtr<TestBound> bound = CreateLayeredTerrain(benchmarkCase.GridSize);
+				amUPtr<Vec3V[]> shrunkVertices = std::make_unique<Vec3V[]>(bound->GetVertexCount());
+
+				Timer timer = Timer::StartNew();
+				for (int i = 0; i < benchmarkCase.BoundCount; i++)
+					bound->TryShrinkByMargin(PH_DEFAULT_MARGIN, 0.0f, shrunkVertices.get());
+				timer.Stop();
+				u64 gridTime = timer.GetElapsedMilliseconds();
+
+				if (benchmarkCase.GridSize > BRUTE_FORCE_MAX_GRID_SIZE)
+				{
+					Logger::WriteMessage(String::FormatTemp("%u triangles in %i bounds: Grid %llu ms\n",
+						benchmarkCase.TriangleCount, benchmarkCase.BoundCount, gridTime));
+					continue;
+				}
+
+				timer.Restart();
+				for (int i = 0; i < benchmarkCase.BoundCount; i++)
+					bound->TryShrinkByMarginBruteForce(PH_DEFAULT_MARGIN, 0.0f, shrunkVertices.get());
+				timer.Stop();
+				u64 bruteForceTime = timer.GetElapsedMilliseconds();
+
+				Logger::WriteMessage(String::FormatTemp("%u triangles in %i bounds: Grid %llu ms, Brute force %llu ms\n",
+					benchmarkCase.TriangleCount, benchmarkCase.BoundCount, gridTime, bruteForceTime));
+			}
+		}
+
+		TEST_METHOD(VerifyNeighborsMatchReference)
+		{
+			amUPtr<TestBound> bounds[] = { CreateLayeredTerrain(8), CreateLayeredTerrain(MAX_GRID_SIZE), CreateSphereBand(64) };
+			for (amUPtr<TestBound>& bound : bounds)
+			{
+				bound->ComputeNeighborsReference();
+				List<phPolygon> reference = CopyPolygons(*bound);
+
+				bound->ComputeNeighbors();
+				List<phPolygon> polygons = CopyPolygons(*bound);
+				Assert::AreEqual(0, memcmp(reference.begin(), polygons.begin(), sizeof(phPolygon) * reference.GetSize()));
+			}
+		}
+
+		TEST_METHOD(VerifyOctantMapMatchesReference)
+		{
+			// If octant map overflows (on sphere), both versions must give up on it
+			amUPtr<TestBound> bounds[] = { CreateLayeredTerrain(8), CreateLayeredTerrain(MAX_GRID_SIZE), CreateSphereBand(64) };
+			for (amUPtr<TestBound>& bound : bounds)
+			{
+				bound->OctantMapDelete();
+				bound->ComputeOctantMapReference();
+				OctantMapCopy reference = CopyOctantMap(*bound);
+
+				bound->OctantMapDelete();
+				bound->ComputeOctantMap();
+				OctantMapCopy octantMap = CopyOctantMap(*bound);
+
+				Assert::AreEqual(reference.Exists, octantMap.Exists);
+				if (!reference.Exists)
+					continue;
+
+				for (u32 i = 0; i < phOctantMap::MAX_OCTANTS; i++)
+				{
+					Assert::AreEqual(reference.IndexCounts[i], octantMap.IndexCounts[i]);
+					Assert::AreEqual(0, memcmp(reference.Indices[i].begin(), octantMap.Indices[i].begin(), sizeof(u32) * reference.IndexCounts[i]));
+				}
+			}
+		}
+
+		TEST_METHOD(BenchmarkNeighborsAndOctantMap)
+		{
+			amUPtr<TestBound> bound = CreateLayeredTerrain(MAX_GRID_SIZE);
+
+			Timer timer = Timer::StartNew();
+			bound->ComputeNeighborsReference();
+			timer.Stop();
+			u64 referenceTime = timer.GetElapsedMicroseconds();
+
+			timer.Restart();
+			bound->ComputeNeighbors();
+			timer.Stop();
+			Logger::WriteMessage(String::FormatTemp("Neighbors, %u polygons: Reference %llu us, Edge table %llu us\n",
+				bound->GetPolygonCount(), referenceTime, timer.GetElapsedMicroseconds()));
+
+			bound->OctantMapDelete();
+			timer.Restart();
+			bound->ComputeOctantMapReference();
+			timer.Stop();
+			referenceTime = timer.GetElapsedMicroseconds();
+
+			bound->OctantMapDelete();
+			timer.Restart();
+			bound->ComputeOctantMap();
+			timer.Stop();
+			Logger::WriteMessage(String::FormatTemp("Octant map, %u vertices: Reference %llu us, Single pass %llu us\n",
+				bound->GetVertexCount(), referenceTime, timer.GetElapsedMicroseconds()));
+		}
+	};
+}
+#endif
@@ -0,0 +1,123 @@
+#ifdef AM_UNIT_TESTS
+
+#include "CppUnitTest.h"
+#include "am/system/timer.h"
+#include "am/types.h"
+#include "rage/atl/datahash.h"
+
+#include <unordered_set>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace unit_testing
+{
+	using namespace rageam;
+	using namespace rage;
+
+	TEST_CLASS(atFastHashTests)
+	{
+		static constexpr u32 DATA_SIZE = 64 * 1024 * 1024; // Size of 4K RGBA texture
+		static constexpr u32 COLLISION_KEY_COUNT = 4000000;
+
+		static amUPtr<u8[]> GenerateData(u32 size)
+		{
+			amUPtr<u8[]> data = std::make_unique<u8[]>(size);
+			u64 seed = 0x1234;
+			for (u32 i = 0; i < size; i++)
+			{
+				seed = seed * 6364136223846793005 + 1442695040888963407;
+				data[i] = static_cast<u8>(seed >> 56);
+			}
+			return data;
+		}
+
+	public:
+		// SIMD implementation must match scalar one on every size, including stripe and block boundaries
+		TEST_METHOD(VerifySimdMatchesScalar)
+		{
+			amUPtr<u8[]> data = GenerateData(0x10000);
+			for (u32 size = 0; size <= 4200; size++)
+			{
+				for (u64 seed : { 0ull, 1ull, 0xDEADBEEFull })
+				{
+					Assert::AreEqual(atFastHash::ComputeScalar(data.get(), size, seed), atFastHash::Compute(data.get(), size, seed));
+				}
+			}
+			Assert::AreEqual(atFastHash::ComputeScalar(data.get(), 0x10000), atFastHash::Compute(data.get(), 0x10000));
+		}
+
+		TEST_METHOD(VerifyCollisionQuality)
+		{
+			// Sequential integers are the worst case for weak hashes
+			std::unordered_set<u64> hashes;
+			hashes.reserve(COLLISION_KEY_COUNT);
+			u32 collisionCount = 0;
+			for (u32 i = 0; i < COLLISION_KEY_COUNT; i++)
+			{
+				if (!hashes.insert(atDataHash64(&i, sizeof(u32))).second)
+					collisionCount++;
+			}
+			Assert::AreEqual(0u, collisionCount);
+
+			// Flipping any single input bit must flip about half of output bits
+			u8 block[200];
+			u64 seed = 0x5678;
+			for (u8& value : block)
+			{
+				seed = seed * 6364136223846793005 + 1442695040888963407;
+				value = static_cast<u8>(seed >> 56);
+			}
+			for (u32 size : { 1u, 4u, 16u, 64u, 65u, 200u })
+			{
+				u64 hash = atDataHash64(block, size);
+				u64 flippedBitCount = 0;
+				for (u32 bit = 0; bit < size * 8; bit++)
+				{
+					block[bit / 8] ^= 1 << bit % 8;
+					flippedBitCount += __popcnt64(hash ^ atDataHash64(block, size));
+					block[bit / 8] ^= 1 << bit % 8;
+				}
+				double averageFlipped = static_cast<double>(flippedBitCount) / (size * 8);
+				Assert::IsTrue(averageFlipped > 30.0 && averageFlipped < 34.0);
+			}
+
+			// Zero padding of short inputs must not collide with explicit zeros, swapping stripes must change hash
+			u8 zeros[128] = {};
+			Assert::AreNotEqual(atDataHash64(zeros, 3), atDataHash64(zeros, 4));
+			u8 stripes[128] = {};
+			stripes[0] = 1;
+			u64 hashA = atDataHash64(stripes, 128);
+			stripes[0] = 0;
+			stripes[64] = 1;
+			Assert::AreNotEqual(hashA, atDataHash64(stripes, 128));
+		}
+
+		TEST_METHOD(BenchmarkAgainstDataHash)
+		{
+			amUPtr<u8[]> data = GenerateData(DATA_SIZE);
+
+			Timer timer = Timer::StartNew();
+			u32 slowHash = atDataHash(data.get(), DATA_SIZE);
+			timer.Stop();
+			u64 slowTime = timer.GetElapsedMicroseconds();
+
+			timer.Restart();
+			u64 fastHash = atDataHash64(data.get(), DATA_SIZE);
+			timer.Stop();
+			u64 fastTime = timer.GetElapsedMicroseconds();
+
+			timer.Restart();
+			u64 scalarHash = atFastHash::ComputeScalar(data.get(), DATA_SIZE);
+			timer.Stop();
+			u64 scalarTime = timer.GetElapsedMicroseconds();
+
+			auto toGBs = [](u64 microseconds) { return static_cast<double>(DATA_SIZE) / 1024.0 / 1024.0 / 1024.0 / (static_cast<double>(microseconds) / 1000000.0); };
+			Logger::WriteMessage(String::FormatTemp("atDataHash:          %llu us, %.2f GB/s (%x)\n", slowTime, toGBs(slowTime), slowHash));
+			Logger::WriteMessage(String::FormatTemp("atDataHash64:        %llu us, %.2f GB/s (%llx)\n", fastTime, toGBs(fastTime), fastHash));
+			Logger::WriteMessage(String::FormatTemp("atDataHash64 scalar: %llu us, %.2f GB/s (%llx)\n", scalarTime, toGBs(scalarTime), scalarHash));
+
+			Assert::AreEqual(fastHash, scalarHash);
+		}
+	};
+}
+#endif
@@ -0,0 +1,229 @@
+#ifdef AM_UNIT_TESTS
+
+#include "CppUnitTest.h"
+#include "am/graphics/meshoptimizer.h"
+#include "am/system/timer.h"
+#include "rage/math/math.h"
+
+#include <algorithm>
+#include <array>
+#include <random>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace unit_testing
+{
+	using namespace rageam;
+	using namespace rageam::graphics;
+
+	TEST_CLASS(MeshOptimizerTests)
+	{
+		// Id is original vertex index, to verify that triangles remain the same after reordering
+		struct Vertex
+		{
+			float X, Y, Z;
+			u32   Id;
+		};
+
+		struct Mesh
+		{
+			std::vector<Vertex> Vertices;
+			std::vector<u16>    Indices;
+		};
+
+		using Triangle = std::array<u32, 3>;
+
+		static Mesh CreateGrid(u16 size)
+		{
+			Mesh mesh;
+			for (u16 y = 0; y <= size; y++)
+			{
+				for (u16 x = 0; x <= size; x++)
+					mesh.Vertices.push_back({ static_cast<float>(x), static_cast<float>(y), 0.0f, static_cast<u32>(mesh.Vertices.size()) });
+			}
+
+			for (u16 y = 0; y < size; y++)
+			{
+				for (u16 x = 0; x < size; x++)
+				{
+					u16 a = y * (size + 1) + x;
+					u16 b = a + 1;
+					u16 c = a + size + 1;
+					u16 d = c + 1;
+					mesh.Indices.insert(mesh.Indices.end(), { a, b, c, b, d, c });
+				}
+			}
+			return mesh;
+		}
+
+		static Mesh CreateSphere(u16 segments, u16 rings)
+		{
+			Mesh mesh;
+			for (u16 ring = 0; ring <= rings; ring++)
+			{
+				for (u16 segment = 0; segment <= segments; segment++)
+				{
+					float theta = rage::PI * static_cast<float>(ring) / static_cast<float>(rings);
+					float phi = rage::PI2 * static_cast<float>(segment) / static_cast<float>(segments);
+					mesh.Vertices.push_back({ sinf(theta) * cosf(phi), cosf(theta), sinf(theta) * sinf(phi), static_cast<u32>(mesh.Vertices.size()) });
+				}
+			}
+
+			for (u16 ring = 0; ring < rings; ring++)
+			{
+				for (u16 segment = 0; segment < segments; segment++)
+				{
+					u16 a = ring * (segments + 1) + segment;
+					u16 b = a + 1;
+					u16 c = a + segments + 1;
+					u16 d = c + 1;
+					mesh.Indices.insert(mesh.Indices.end(), { a, c, b, b, c, d });
+				}
+			}
+			return mesh;
+		}
+
+		// Simulates importer output with no locality at all, triangles and vertices are in random order
+		static Mesh Shuffle(Mesh mesh, u32 seed)
+		{
+			std::mt19937 rng(seed);
+
+			u32 triangleCount = static_cast<u32>(mesh.Indices.size() / 3);
+			std::vector<u32> triangleOrder(triangleCount);
+			for (u32 i = 0; i < triangleCount; i++)
+				triangleOrder[i] = i;
+			std::shuffle(triangleOrder.begin(), triangleOrder.end(), rng);
+
+			std::vector<u16> vertexOrder(mesh.Vertices.size());
+			for (u32 i = 0; i < vertexOrder.size(); i++)
+				vertexOrder[i] = static_cast<u16>(i);
+			std::shuffle(vertexOrder.begin(), vertexOrder.end(), rng);
+
+			Mesh shuffled;
+			shuffled.Vertices.resize(mesh.Vertices.size());
+			for (u32 i = 0; i < vertexOrder.size(); i++)
+				shuffled.Vertices[vertexOrder[i]] = mesh.Vertices[i];
+			for (u32 triangle : triangleOrder)
+			{
+				for (u32 k = 0; k < 3; k++)
+					shuffled.Indices.push_back(vertexOrder[mesh.Indices[triangle * 3 + k]]);
+			}
+			return shuffled;
+		}
+
+		// Sorted triangles in original vertex ids, rotated to start from the lowest id to keep winding
+		static std::vector<Triangle> GetTriangles(const Mesh& mesh)
+		{
+			std::vector<Triangle> triangles;
+			for (size_t i = 0; i < mesh.Indices.size(); i += 3)
+			{
+				Triangle triangle =
+				{
+					mesh.Vertices[mesh.Indices[i + 0]].Id,
+					mesh.Vertices[mesh.Indices[i + 1]].Id,
+					mesh.Vertices[mesh.Indices[i + 2]].Id,
+				};
+				while (triangle[0] > triangle[1] || triangle[0] > triangle[2])
+					std::rotate(triangle.begin(), triangle.begin() + 1, triangle.end());
+				triangles.push_back(triangle);
+			}
+			std::sort(triangles.begin(), triangles.end());
+			return triangles;
+		}
+
+		static u32 Optimize(Mesh& mesh, bool reorderTriangles)
+		{
+			u32 vertexCount = MeshOptimizer::Optimize(
+				reinterpret_cast<char*>(mesh.Vertices.data()), static_cast<u32>(mesh.Vertices.size()), sizeof(Vertex), 0,
+				mesh.Indices.data(), static_cast<u32>(mesh.Indices.size()), reorderTriangles);
+			mesh.Vertices.resize(vertexCount);
+			return vertexCount;
+		}
+
+		static VertexCacheStats Analyze(const Mesh& mesh)
+		{
+			return MeshOptimizer::AnalyzeVertexCache(
+				mesh.Indices.data(), static_cast<u32>(mesh.Indices.size()), static_cast<u32>(mesh.Vertices.size()));
+		}
+
+	public:
+		TEST_METHOD(VerifyTrianglesPreserved)
+		{
+			Mesh mesh = Shuffle(CreateSphere(64, 32), 1);
+			std::vector<Triangle> triangles = GetTriangles(mesh);
+
+			Optimize(mesh, true);
+
+			Assert::IsTrue(triangles == GetTriangles(mesh));
+		}
+
+		// Vertices must be in order of first use and unused ones must be removed
+		TEST_METHOD(VerifyVertexFetch)
+		{
+			Mesh mesh = Shuffle(CreateGrid(32), 2);
+			mesh.Vertices.push_back({ 100.0f, 100.0f, 100.0f, UINT32_MAX });
+
+			u32 vertexCount = Optimize(mesh, true);
+			Assert::AreEqual(33u * 33u, vertexCount);
+
+			u16 nextVertex = 0;
+			for (u16 index : mesh.Indices)
+			{
+				Assert::IsTrue(index <= nextVertex);
+				if (index == nextVertex)
+					nextVertex++;
+			}
+		}
+
+		// Triangle order must remain the same for alpha blended geometry
+		TEST_METHOD(VerifyTriangleOrderKept)
+		{
+			Mesh mesh = Shuffle(CreateGrid(16), 3);
+			Mesh optimized = mesh;
+
+			Optimize(optimized, false);
+
+			Assert::AreEqual(mesh.Indices.size(), optimized.Indices.size());
+			for (size_t i = 0; i < mesh.Indices.size(); i++)
+				Assert::AreEqual(mesh.Vertices[mesh.Indices[i]].Id, optimized.Vertices[optimized.Indices[i]].Id);
+		}
+
+		TEST_METHOD(VerifyCacheEfficiency)
+		{
+			Mesh mesh = Shuffle(CreateGrid(64), 4);
+			Optimize(mesh, true);
+
+			// Tipsify gets close to 0.6 on regular grid with cache size of 16, 0.5 is theoretical limit
+			VertexCacheStats stats = Analyze(mesh);
+			Assert::IsTrue(stats.ACMR < 0.7f);
+			Assert::IsTrue(stats.ATVR < 1.4f);
+		}
+
+		TEST_METHOD(BenchmarkSampleMeshes)
+		{
+			auto benchmark = [](ConstString name, Mesh mesh)
+				{
+					VertexCacheStats before = Analyze(mesh);
+
+					Timer timer = Timer::StartNew();
+					Optimize(mesh, true);
+					timer.Stop();
+
+					VertexCacheStats after = Analyze(mesh);
+
+					Logger::WriteMessage(String::FormatTemp(
+						"%s, %u triangles: ACMR %.3f -> %.3f, ATVR %.3f -> %.3f, %llu us\n",
+						name, static_cast<u32>(mesh.Indices.size() / 3), before.ACMR, after.ACMR, before.ATVR, after.ATVR,
+						timer.GetElapsedMicroseconds()));
+				};
+
+			// Close to 64k vertices, which is the most that single geometry can have
+			benchmark("Grid", CreateGrid(180));
+			benchmark("Grid (shuffled)", Shuffle(CreateGrid(180), 5));
+			benchmark("Sphere", CreateSphere(128, 64));
+			benchmark("Sphere (shuffled)", Shuffle(CreateSphere(128, 64), 6));
+		}
+	};
+}
+#endif
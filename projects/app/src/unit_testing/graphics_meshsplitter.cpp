@@ -0,0 +1,248 @@
+#ifdef AM_UNIT_TESTS
+
+#include "CppUnitTest.h"
+#include "am/graphics/meshsplitter.h"
+#include "am/system/timer.h"
+
+#include <algorithm>
+#include <array>
+#include <random>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace unit_testing
+{
+	using namespace rageam;
+	using namespace rageam::graphics;
+
+	TEST_CLASS(MeshSplitterTests)
+	{
+		// Id is original vertex index, to verify that chunks reconstruct source triangles;
+		// padding makes vertex as large as typical vertex with normal, tangent and two texcoords
+		struct Vertex
+		{
+			float X, Y, Z;
+			u32   Id;
+			float Padding[8];
+		};
+
+		struct Mesh
+		{
+			std::vector<Vertex> Vertices;
+			std::vector<u32>    Indices;
+		};
+
+		using Triangle = std::array<u32, 3>;
+
+		static Mesh CreateGrid(u32 size)
+		{
+			Mesh mesh;
+			for (u32 y = 0; y <= size; y++)
+			{
+				for (u32 x = 0; x <= size; x++)
+					mesh.Vertices.push_back({ static_cast<float>(x), static_cast<float>(y), 0.0f, static_cast<u32>(mesh.Vertices.size()) });
+			}
+
+			for (u32 y = 0; y < size; y++)
+			{
+				for (u32 x = 0; x < size; x++)
+				{
+					u32 a = y * (size + 1) + x;
+					u32 b = a + 1;
+					u32 c = a + size + 1;
+					u32 d = c + 1;
+					mesh.Indices.insert(mesh.Indices.end(), { a, b, c, b, d, c });
+				}
+			}
+			return mesh;
+		}
+
+		// Simulates importer output with no locality at all, triangles and vertices are in random order
+		static Mesh Shuffle(Mesh mesh, u32 seed)
+		{
+			std::mt19937 rng(seed);
+
+			u32 triangleCount = static_cast<u32>(mesh.Indices.size() / 3);
+			std::vector<u32> triangleOrder(triangleCount);
+			for (u32 i = 0; i < triangleCount; i++)
+				triangleOrder[i] = i;
+			std::shuffle(triangleOrder.begin(), triangleOrder.end(), rng);
+
+			std::vector<u32> vertexOrder(mesh.Vertices.size());
+			for (u32 i = 0; i < vertexOrder.size(); i++)
+				vertexOrder[i] = i;
+			std::shuffle(vertexOrder.begin(), vertexOrder.end(), rng);
+
+			Mesh shuffled;
+			shuffled.Vertices.resize(mesh.Vertices.size());
+			for (u32 i = 0; i < vertexOrder.size(); i++)
+				shuffled.Vertices[vertexOrder[i]] = mesh.Vertices[i];
+			for (u32 triangle : triangleOrder)
+			{
+				for (u32 k = 0; k < 3; k++)
+					shuffled.Indices.push_back(vertexOrder[mesh.Indices[triangle * 3 + k]]);
+			}
+			return shuffled;
+		}
+
+		static void SortTriangles(std::vector<Triangle>& triangles)
+		{
+			// Rotate to start from the lowest id to keep winding
+			for (Triangle& triangle : triangles)
+			{
+				while (triangle[0] > triangle[1] || triangle[0] > triangle[2])
+					std::rotate(triangle.begin(), triangle.begin() + 1, triangle.end());
+			}
+			std::sort(triangles.begin(), triangles.end());
+		}
+
+		static std::vector<Triangle> GetTriangles(const Mesh& mesh)
+		{
+			std::vector<Triangle> triangles;
+			for (size_t i = 0; i < mesh.Indices.size(); i += 3)
+			{
+				triangles.push_back({
+					mesh.Vertices[mesh.Indices[i + 0]].Id,
+					mesh.Vertices[mesh.Indices[i + 1]].Id,
+					mesh.Vertices[mesh.Indices[i + 2]].Id });
+			}
+			SortTriangles(triangles);
+			return triangles;
+		}
+
+		// Also verifies that every chunk fits in 16 bit indices and has no unused vertices
+		static std::vector<Triangle> GetTriangles(const rage::atArray<MeshChunk>& chunks, u32* outVertexCount = nullptr)
+		{
+			std::vector<Triangle> triangles;
+			u32 vertexCount = 0;
+			for (const MeshChunk& chunk : chunks)
+			{
+				Assert::IsTrue(chunk.VertexCount <= MeshSplitter::MAX_CHUNK_VERTICES);
+				Assert::AreEqual(0u, chunk.IndexCount % 3);
+
+				const Vertex* vertices = reinterpret_cast<const Vertex*>(chunk.Vertices.get());
+				std::vector<bool> used(chunk.VertexCount);
+				for (u32 i = 0; i < chunk.IndexCount; i += 3)
+				{
+					Triangle triangle;
+					for (u32 k = 0; k < 3; k++)
+					{
+						u16 index = chunk.Indices.get()[i + k];
+						Assert::IsTrue(index < chunk.VertexCount);
+						used[index] = true;
+						triangle[k] = vertices[index].Id;
+					}
+					triangles.push_back(triangle);
+				}
+				Assert::IsTrue(std::all_of(used.begin(), used.end(), [](bool value) { return value; }));
+				vertexCount += chunk.VertexCount;
+			}
+			SortTriangles(triangles);
+			if (outVertexCount) *outVertexCount = vertexCount;
+			return triangles;
+		}
+
+		static rage::atArray<MeshChunk> Split(MeshSplitter& splitter, const Mesh& mesh, bool spatial)
+		{
+			return splitter.Split(
+				reinterpret_cast<const char*>(mesh.Vertices.data()), static_cast<u32>(mesh.Vertices.size()), sizeof(Vertex),
+				spatial ? 0 : MeshSplitter::NO_POSITION, mesh.Indices.data(), static_cast<u32>(mesh.Indices.size()));
+		}
+
+	public:
+		TEST_CLASS_INITIALIZE(Init)
+		{
+			MeshSplitter::InitClass();
+		}
+
+		TEST_CLASS_CLEANUP(Shutdown)
+		{
+			MeshSplitter::ShutdownClass();
+		}
+
+		TEST_METHOD(VerifyChunksReconstructMesh)
+		{
+			MeshSplitter splitter;
+			for (const Mesh& mesh : { CreateGrid(8), CreateGrid(400), Shuffle(CreateGrid(400), 1) })
+			{
+				std::vector<Triangle> triangles = GetTriangles(mesh);
+				for (bool spatial : { true, false })
+				{
+					rage::atArray<MeshChunk> chunks = Split(splitter, mesh, spatial);
+					Assert::IsTrue(triangles == GetTriangles(chunks));
+				}
+			}
+		}
+
+		// Chunks are split spatially, so there must be only few vertices duplicated on chunk borders
+		TEST_METHOD(VerifySpatialSplit)
+		{
+			MeshSplitter splitter;
+			Mesh mesh = Shuffle(CreateGrid(400), 2);
+
+			u32 vertexCount;
+			rage::atArray<MeshChunk> chunks = Split(splitter, mesh, true);
+			GetTriangles(chunks, &vertexCount);
+
+			Assert::IsTrue(chunks.GetSize() <= 4);
+			Assert::IsTrue(static_cast<float>(vertexCount) / static_cast<float>(mesh.Vertices.size()) < 1.05f);
+		}
+
+		// Parallel split must produce exactly the same chunks as single-threaded one
+		TEST_METHOD(VerifyParallelMatchesSerial)
+		{
+			MeshSplitter splitter;
+			Mesh mesh = Shuffle(CreateGrid(1100), 3); // 2.4M triangles, large enough for multiple segments
+
+			MeshSplitter::ShutdownClass();
+			rage::atArray<MeshChunk> serialChunks = Split(splitter, mesh, true);
+			MeshSplitter::InitClass();
+			rage::atArray<MeshChunk> parallelChunks = Split(splitter, mesh, true);
+
+			Assert::AreEqual(serialChunks.GetSize(), parallelChunks.GetSize());
+			for (u16 i = 0; i < serialChunks.GetSize(); i++)
+			{
+				const MeshChunk& serial = serialChunks[i];
+				const MeshChunk& parallel = parallelChunks[i];
+				Assert::AreEqual(serial.VertexCount, parallel.VertexCount);
+				Assert::AreEqual(serial.IndexCount, parallel.IndexCount);
+				Assert::AreEqual(0, memcmp(serial.Vertices.get(), parallel.Vertices.get(), sizeof(Vertex) * serial.VertexCount));
+				Assert::AreEqual(0, memcmp(serial.Indices.get(), parallel.Indices.get(), sizeof(u16) * serial.IndexCount));
+			}
+		}
+
+		TEST_METHOD(BenchmarkLargeMesh)
+		{
+			MeshSplitter splitter;
+			auto benchmark = [&splitter](ConstString name, const Mesh& mesh, bool spatial)
+				{
+					// Second run reuses scratch buffers
+					for (int i = 0; i < 2; i++)
+					{
+						Timer timer = Timer::StartNew();
+						rage::atArray<MeshChunk> chunks = Split(splitter, mesh, spatial);
+						timer.Stop();
+
+						u32 vertexCount = 0;
+						for (const MeshChunk& chunk : chunks)
+							vertexCount += chunk.VertexCount;
+
+						Logger::WriteMessage(String::FormatTemp(
+							"%s, %u triangles: %u chunks, %.3f vertices per source vertex, %llu us\n",
+							name, static_cast<u32>(mesh.Indices.size() / 3), chunks.GetSize(),
+							static_cast<float>(vertexCount) / static_cast<float>(mesh.Vertices.size()), timer.GetElapsedMicroseconds()));
+					}
+				};
+
+			// Close to 5M triangles, typical for scanned asset
+			Mesh grid = CreateGrid(1600);
+			benchmark("Grid", grid, true);
+			benchmark("Grid (source order)", grid, false);
+			Mesh shuffledGrid = Shuffle(grid, 4);
+			benchmark("Grid (shuffled)", shuffledGrid, true);
+			benchmark("Grid (shuffled, source order)", shuffledGrid, false);
+		}
+	};
+}
+#endif
@@ -0,0 +1,271 @@
+#ifdef AM_UNIT_TESTS
+
+#include "CppUnitTest.h"
+#include "am/graphics/vertexbufferiterator.h"
+#include "am/graphics/vertexconvert.h"
+#include "am/system/timer.h"
+#include "rage/math/vec.h"
+
+#include <bit>
+#include <random>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace unit_testing
+{
+	using namespace rageam;
+	using namespace rageam::graphics;
+
+	TEST_CLASS(VertexConvertTests)
+	{
+		// Typical vertex with position, normal, color and texcoord
+		static constexpr u32 VERTEX_STRIDE = 36;
+		static constexpr u32 ATTRIBUTE_OFFSET = 12;
+		static constexpr u32 BENCHMARK_VERTEX_COUNT = 1000000;
+
+		// Random values in range slightly larger than normalized to test clamping, with special values at the beginning
+		static std::vector<float> GenerateFloats(u32 count, u32 seed)
+		{
+			std::mt19937 rng(seed);
+			std::uniform_real_distribution distribution(-1.5f, 1.5f);
+
+			std::vector<float> values(count);
+			for (float& value : values)
+				value = distribution(rng);
+
+			const float specials[] =
+			{
+				NAN, INFINITY, -INFINITY, 0.0f, -0.0f, 1.0f, -1.0f,
+				0.5f / 255.0f, 1.5f / 255.0f, 0.5f / 127.0f, -0.5f / 127.0f, 65504.0f, 65520.0f, 1e-7f, -6.1e-5f,
+			};
+			for (u32 i = 0; i < std::size(specials) && i < count; i++)
+				values[i] = specials[i];
+			return values;
+		}
+
+		// Converts floats from tightly packed array into strided vertex buffer with both kernel and scalar reference and compares output
+		template<typename TOut, typename TScalarFn>
+		static void VerifyKernel(DXGI_FORMAT inFormat, DXGI_FORMAT outFormat, u32 inComponents, TScalarFn scalarFn)
+		{
+			static constexpr u32 VERTEX_COUNT = 10007; // Not multiple of batch size to verify remainder
+
+			std::vector<float> input = GenerateFloats(VERTEX_COUNT * inComponents, 1);
+			std::vector<char> vertices(static_cast<size_t>(VERTEX_COUNT) * VERTEX_STRIDE);
+
+			VertexConvertFn convertFn = VertexConvert::Find(inFormat, outFormat);
+			Assert::IsTrue(convertFn != nullptr);
+			convertFn(reinterpret_cast<const char*>(input.data()), sizeof(float) * inComponents,
+				vertices.data() + ATTRIBUTE_OFFSET, VERTEX_STRIDE, VERTEX_COUNT);
+
+			VertexBufferRange<TOut> output(VertexBufferIterator<TOut>(vertices.data(), VERTEX_STRIDE, ATTRIBUTE_OFFSET), VERTEX_COUNT);
+			for (u32 i = 0; i < VERTEX_COUNT; i++)
+			{
+				TOut expected = scalarFn(input.data() + static_cast<size_t>(i) * inComponents);
+				Assert::IsTrue(memcmp(&expected, &output[i], sizeof(TOut)) == 0);
+			}
+		}
+
+	public:
+		// Every half value must be converted to float exactly
+		TEST_METHOD(VerifyHalfToFloat)
+		{
+			std::vector<u16> halves(UINT16_MAX + 1);
+			for (u32 i = 0; i < halves.size(); i++)
+				halves[i] = static_cast<u16>(i);
+
+			std::vector<float> floats(halves.size());
+			VertexConvert::Find(DXGI_FORMAT_R16_FLOAT, DXGI_FORMAT_R32_FLOAT)(
+				reinterpret_cast<const char*>(halves.data()), sizeof(u16),
+				reinterpret_cast<char*>(floats.data()), sizeof(float), static_cast<u32>(halves.size()));
+
+			for (u32 i = 0; i < halves.size(); i++)
+			{
+				float expected = VertexConvert::HalfToFloat(halves[i]);
+				if (std::isnan(expected))
+				{
+					Assert::IsTrue(std::isnan(floats[i]));
+					continue;
+				}
+				Assert::AreEqual(std::bit_cast<u32>(expected), std::bit_cast<u32>(floats[i]));
+
+				// And back without any loss
+				Assert::AreEqual(halves[i], VertexConvert::FloatToHalf(expected));
+			}
+		}
+
+		// Walks through all float exponents with large step in mantissa, covers subnormal halves, rounding and overflow
+		TEST_METHOD(VerifyFloatToHalf)
+		{
+			static constexpr u32 STEP = 997;
+
+			std::vector<u32> bits;
+			for (u64 i = 0; i <= UINT32_MAX; i += STEP)
+				bits.push_back(static_cast<u32>(i));
+
+			std::vector<u16> halves(bits.size());
+			VertexConvert::Find(DXGI_FORMAT_R32_FLOAT, DXGI_FORMAT_R16_FLOAT)(
+				reinterpret_cast<const char*>(bits.data()), sizeof(u32),
+				reinterpret_cast<char*>(halves.data()), sizeof(u16), static_cast<u32>(bits.size()));
+
+			for (u32 i = 0; i < bits.size(); i++)
+			{
+				float value = std::bit_cast<float>(bits[i]);
+				if (std::isnan(value))
+				{
+					Assert::IsTrue((halves[i] & 0x7C00) == 0x7C00 && (halves[i] & 0x3FF) != 0);
+					continue;
+				}
+				Assert::AreEqual(VertexConvert::FloatToHalf(value), halves[i]);
+			}
+
+			Assert::AreEqual<u16>(0x3C00, VertexConvert::FloatToHalf(1.0f));
+			Assert::AreEqual<u16>(0x7BFF, VertexConvert::FloatToHalf(65504.0f));
+			Assert::AreEqual<u16>(0x7C00, VertexConvert::FloatToHalf(65520.0f)); // Rounds to infinity
+			Assert::AreEqual<u16>(0x0001, VertexConvert::FloatToHalf(6e-8f));	   // Smallest subnormal
+			Assert::AreEqual<u16>(0x8000, VertexConvert::FloatToHalf(-0.0f));
+		}
+
+		TEST_METHOD(VerifyFloat2ToHalf2)
+		{
+			VerifyKernel<u32>(DXGI_FORMAT_R32G32_FLOAT, DXGI_FORMAT_R16G16_FLOAT, 2, [](const float* in)
+				{
+					return VertexConvert::FloatToHalf(in[0]) | static_cast<u32>(VertexConvert::FloatToHalf(in[1])) << 16;
+				});
+		}
+
+		TEST_METHOD(VerifyFloat4ToUnorm8)
+		{
+			VerifyKernel<u32>(DXGI_FORMAT_R32G32B32A32_FLOAT, DXGI_FORMAT_R8G8B8A8_UNORM, 4, [](const float* in)
+				{
+					u32 result = 0;
+					for (u32 i = 0; i < 4; i++)
+						result |= static_cast<u32>(VertexConvert::FloatToUnorm8(in[i])) << (i * 8);
+					return result;
+				});
+
+			Assert::AreEqual<u8>(0, VertexConvert::FloatToUnorm8(NAN));
+			Assert::AreEqual<u8>(255, VertexConvert::FloatToUnorm8(2.0f));
+			Assert::AreEqual<u8>(128, VertexConvert::FloatToUnorm8(0.5f));
+		}
+
+		TEST_METHOD(VerifyFloat3ToSnorm8)
+		{
+			VerifyKernel<u32>(DXGI_FORMAT_R32G32B32_FLOAT, DXGI_FORMAT_R8G8B8A8_SNORM, 3, [](const float* in)
+				{
+					u32 result = 0;
+					for (u32 i = 0; i < 3; i++)
+						result |= static_cast<u32>(VertexConvert::FloatToSnorm8(in[i])) << (i * 8);
+					return result;
+				});
+
+			Assert::AreEqual<u8>(0x81, VertexConvert::FloatToSnorm8(-1.0f));
+			Assert::AreEqual<u8>(0x7F, VertexConvert::FloatToSnorm8(1.0f));
+			Assert::AreEqual<u8>(0, VertexConvert::FloatToSnorm8(NAN));
+		}
+
+		TEST_METHOD(VerifyFloat3ToUnorm10)
+		{
+			VerifyKernel<u32>(DXGI_FORMAT_R32G32B32_FLOAT, DXGI_FORMAT_R10G10B10A2_UNORM, 3, [](const float* in)
+				{
+					return VertexConvert::PackNormalUnorm10(in[0], in[1], in[2]);
+				});
+
+			Assert::AreEqual(0x3FFu | 0x200u << 10 | 0u << 20, VertexConvert::PackNormalUnorm10(1.0f, 0.0f, -1.0f));
+		}
+
+		TEST_METHOD(VerifyUnorm8ToFloat4)
+		{
+			static constexpr u32 VERTEX_COUNT = 1029;
+
+			std::mt19937 rng(2);
+			std::vector<u32> colors(VERTEX_COUNT);
+			for (u32& color : colors)
+				color = rng();
+
+			std::vector<rage::Vector4> floats(VERTEX_COUNT);
+			VertexConvert::Find(DXGI_FORMAT_R8G8B8A8_UNORM, DXGI_FORMAT_R32G32B32A32_FLOAT)(
+				reinterpret_cast<const char*>(colors.data()), sizeof(u32),
+				reinterpret_cast<char*>(floats.data()), sizeof(rage::Vector4), VERTEX_COUNT);
+
+			for (u32 i = 0; i < VERTEX_COUNT; i++)
+			{
+				for (u32 k = 0; k < 4; k++)
+					Assert::AreEqual(static_cast<float>(colors[i] >> (k * 8) & 0xFF) / 255.0f, floats[i][k]);
+			}
+		}
+
+		TEST_METHOD(VerifyIterator)
+		{
+			std::vector<char> vertices(static_cast<size_t>(100) * VERTEX_STRIDE);
+			VertexBufferRange<u32> range(VertexBufferIterator<u32>(vertices.data(), VERTEX_STRIDE, ATTRIBUTE_OFFSET), 100);
+
+			u32 value = 0;
+			for (u32& attribute : range)
+				attribute = value++;
+
+			Assert::AreEqual<ptrdiff_t>(100, range.end() - range.begin());
+			for (u32 i = 0; i < 100; i++)
+			{
+				u32 attribute;
+				memcpy(&attribute, vertices.data() + static_cast<size_t>(i) * VERTEX_STRIDE + ATTRIBUTE_OFFSET, sizeof(u32));
+				Assert::AreEqual(i, attribute);
+			}
+
+			VertexBufferIterator<const u32> it(vertices.data(), VERTEX_STRIDE, ATTRIBUTE_OFFSET);
+			Assert::AreEqual(10u, it[10]);
+			Assert::AreEqual(15u, *(it + 15));
+			Assert::AreEqual(99u, *std::prev(range.end()));
+		}
+
+		// Kernels against per-vertex scalar conversion, same as VertexBufferEditor used to do
+		TEST_METHOD(BenchmarkKernels)
+		{
+			std::vector<float> input = GenerateFloats(BENCHMARK_VERTEX_COUNT * 4, 3);
+			std::vector<char> vertices(static_cast<size_t>(BENCHMARK_VERTEX_COUNT) * VERTEX_STRIDE);
+			char* output = vertices.data() + ATTRIBUTE_OFFSET;
+
+			auto benchmark = [&](ConstString name, DXGI_FORMAT inFormat, DXGI_FORMAT outFormat, u32 inComponents, auto scalarFn)
+				{
+					u32 inStride = sizeof(float) * inComponents;
+					const char* in = reinterpret_cast<const char*>(input.data());
+
+					Timer timer = Timer::StartNew();
+					for (u32 i = 0; i < BENCHMARK_VERTEX_COUNT; i++)
+						scalarFn(reinterpret_cast<const float*>(in + static_cast<size_t>(i) * inStride), output + static_cast<size_t>(i) * VERTEX_STRIDE);
+					timer.Stop();
+					u64 scalarTime = timer.GetElapsedMicroseconds();
+
+					timer.Restart();
+					VertexConvert::Find(inFormat, outFormat)(in, inStride, output, VERTEX_STRIDE, BENCHMARK_VERTEX_COUNT);
+					timer.Stop();
+
+					Logger::WriteMessage(String::FormatTemp("%s, %u vertices: Scalar %llu us, Kernel %llu us\n",
+						name, BENCHMARK_VERTEX_COUNT, scalarTime, timer.GetElapsedMicroseconds()));
+				};
+
+			benchmark("Float2 -> Half2", DXGI_FORMAT_R32G32_FLOAT, DXGI_FORMAT_R16G16_FLOAT, 2, [](const float* in, char* out)
+				{
+					u16* halves = reinterpret_cast<u16*>(out);
+					halves[0] = VertexConvert::FloatToHalf(in[0]);
+					halves[1] = VertexConvert::FloatToHalf(in[1]);
+				});
+			benchmark("Float4 -> UNORM8x4", DXGI_FORMAT_R32G32B32A32_FLOAT, DXGI_FORMAT_R8G8B8A8_UNORM, 4, [](const float* in, char* out)
+				{
+					for (u32 i = 0; i < 4; i++)
+						out[i] = static_cast<char>(VertexConvert::FloatToUnorm8(in[i]));
+				});
+			benchmark("Float3 -> SNORM8x4", DXGI_FORMAT_R32G32B32_FLOAT, DXGI_FORMAT_R8G8B8A8_SNORM, 3, [](const float* in, char* out)
+				{
+					for (u32 i = 0; i < 3; i++)
+						out[i] = static_cast<char>(VertexConvert::FloatToSnorm8(in[i]));
+					out[3] = 0;
+				});
+			benchmark("Float3 -> UNORM10x3", DXGI_FORMAT_R32G32B32_FLOAT, DXGI_FORMAT_R10G10B10A2_UNORM, 3, [](const float* in, char* out)
+				{
+					*reinterpret_cast<u32*>(out) = VertexConvert::PackNormalUnorm10(in[0], in[1], in[2]);
+				});
+		}
+	};
+}
+#endif
@@ -0,0 +1,160 @@
+#ifdef AM_UNIT_TESTS
+
+#include "CppUnitTest.h"
+#include "am/graphics/image/bc.h"
+#include "am/graphics/image/imagecache.h"
+#include "am/system/timer.h"
+#include "am/system/worker.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace unit_testing
+{
+	using namespace rageam;
+	using namespace rageam::graphics;
+
+	TEST_CLASS(ImageCompressorTests)
+	{
+		static constexpr int IMAGE_SIZE = 512;
+		static constexpr int BATCH_SIZE = 16; // Typical TXD of props
+
+		struct FormatEntry
+		{
+			ConstString Name;
+			BlockFormat Format;
+		};
+
+		static constexpr FormatEntry sm_Formats[] =
+		{
+			{ "BC1", BlockFormat_BC1 },
+			{ "BC3", BlockFormat_BC3 },
+			{ "BC4", BlockFormat_BC4 },
+			{ "BC5", BlockFormat_BC5 },
+			{ "BC7", BlockFormat_BC7 },
+		};
+
+		// Smooth gradients with some noise, close enough to real diffuse textures
+		static ImagePtr CreateImage(int size, u32 seed)
+		{
+			PixelDataOwner pixelData = PixelDataOwner::AllocateForImage(size, size, ImagePixelFormat_U32);
+			ColorU32* pixels = reinterpret_cast<ColorU32*>(pixelData.Data()->Bytes);
+			for (int y = 0; y < size; y++)
+			{
+				for (int x = 0; x < size; x++)
+				{
+					seed = seed * 1664525 + 1013904223;
+					ColorU32& pixel = pixels[y * size + x];
+					pixel.R = static_cast<u8>(x * 255 / size + (seed >> 29));
+					pixel.G = static_cast<u8>(y * 255 / size + (seed >> 30));
+					pixel.B = static_cast<u8>((x ^ y) & 0xFF);
+					pixel.A = static_cast<u8>(seed >> 24);
+				}
+			}
+			return ImageFactory::Create(pixelData, ImagePixelFormat_U32, size, size);
+		}
+
+		// Total number of 4x4 blocks in all mips
+		static u64 GetBlockCount(const ImagePtr& image)
+		{
+			u64 blockCount = 0;
+			ImageInfo info = image->GetInfo();
+			for (int i = 0; i < info.MipCount; i++)
+				blockCount += static_cast<u64>(info.Width >> i) / 4 * ((info.Height >> i) / 4);
+			return blockCount;
+		}
+
+		// Unique hash override makes sure that image is never taken from the cache
+		static void CompressBatch(ImagePtr* images, ImagePtr* results, int count, BlockFormat format, u32& hashOverride)
+		{
+			ImageCompressorRequest requests[BATCH_SIZE];
+			u32 hashes[BATCH_SIZE];
+			for (int i = 0; i < count; i++)
+			{
+				hashes[i] = hashOverride++;
+				requests[i].Image = images[i];
+				requests[i].Options.Format = format;
+				requests[i].PixelHashOverride = &hashes[i];
+			}
+			ImageCompressor::CompressBatch(requests, count);
+			for (int i = 0; i < count; i++)
+				results[i] = requests[i].Result;
+		}
+
+	public:
+		TEST_CLASS_INITIALIZE(Init)
+		{
+			ImageCompressor::InitClass();
+		}
+
+		TEST_CLASS_CLEANUP(Shutdown)
+		{
+			ImageCompressor::ShutdownClass();
+		}
+
+		// Work distribution must not affect compressed pixels
+		TEST_METHOD(VerifyTilesMatchRegions)
+		{
+			ImageCache cache;
+			u32 hashOverride = GetTickCount();
+
+			ImagePtr image = CreateImage(IMAGE_SIZE, 0xABCDEF);
+			for (const FormatEntry& entry : sm_Formats)
+			{
+				ImagePtr regionsResult;
+				ImagePtr tilesResult;
+
+				ImageCompressor::SetWorkMode(ImageCompressorWorkMode_Regions);
+				CompressBatch(&image, &regionsResult, 1, entry.Format, hashOverride);
+				ImageCompressor::SetWorkMode(ImageCompressorWorkMode_Tiles);
+				CompressBatch(&image, &tilesResult, 1, entry.Format, hashOverride);
+				cache.Clear();
+
+				Assert::IsNotNull(regionsResult.get());
+				Assert::IsNotNull(tilesResult.get());
+
+				ImageInfo info = tilesResult->GetInfo();
+				u32 size = ImageComputeTotalSizeWithMips(info.Width, info.Height, info.MipCount, info.PixelFormat);
+				Assert::AreEqual(0, memcmp(regionsResult->GetPixelDataBytes(), tilesResult->GetPixelDataBytes(), size));
+			}
+		}
+
+		TEST_METHOD(BenchmarkBlocksPerSecond)
+		{
+			ImageCache cache;
+			u32 hashOverride = GetTickCount();
+
+			ImagePtr images[BATCH_SIZE];
+			ImagePtr results[BATCH_SIZE];
+			for (int i = 0; i < BATCH_SIZE; i++)
+				images[i] = CreateImage(IMAGE_SIZE, i);
+
+			for (const FormatEntry& entry : sm_Formats)
+			{
+				// Regions, every image is compressed separately as it was done before
+				ImageCompressor::SetWorkMode(ImageCompressorWorkMode_Regions);
+				Timer timer = Timer::StartNew();
+				for (int i = 0; i < BATCH_SIZE; i++)
+					CompressBatch(&images[i], &results[i], 1, entry.Format, hashOverride);
+				timer.Stop();
+				u64 regionsTime = timer.GetElapsedMicroseconds();
+				cache.Clear();
+
+				u64 blockCount = GetBlockCount(results[0]) * BATCH_SIZE;
+
+				// Tiles, the whole batch is compressed at once
+				ImageCompressor::SetWorkMode(ImageCompressorWorkMode_Tiles);
+				timer.Restart();
+				CompressBatch(images, results, BATCH_SIZE, entry.Format, hashOverride);
+				timer.Stop();
+				u64 tilesTime = timer.GetElapsedMicroseconds();
+				cache.Clear();
+
+				Logger::WriteMessage(String::FormatTemp("%s: Regions %.0f blocks/s (%llu ms), Tiles %.0f blocks/s (%llu ms)\n",
+					entry.Name,
+					static_cast<double>(blockCount) / (static_cast<double>(regionsTime) / 1000000.0), regionsTime / 1000,
+					static_cast<double>(blockCount) / (static_cast<double>(tilesTime) / 1000000.0), tilesTime / 1000));
+			}
+		}
+	};
+}
+#endif
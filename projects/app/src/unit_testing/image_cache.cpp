@@ -0,0 +1,124 @@
+#ifdef AM_UNIT_TESTS
+
+#include "CppUnitTest.h"
+#include "am/graphics/image/imagecache.h"
+#include "am/system/timer.h"
+
+#include "imgui.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace unit_testing
+{
+	using namespace rageam;
+	using namespace rageam::graphics;
+
+	TEST_CLASS(ImageCacheTests)
+	{
+		static constexpr int IMAGE_SIZE = 256;
+		static constexpr u32 IMAGE_COUNT = 64;
+
+		static ImagePtr CreateImage(u32 seed)
+		{
+			PixelDataOwner pixelData = PixelDataOwner::AllocateForImage(IMAGE_SIZE, IMAGE_SIZE, ImagePixelFormat_U32);
+			u32* pixels = pixelData.Data()->RGBA;
+			for (int i = 0; i < IMAGE_SIZE * IMAGE_SIZE; i++)
+			{
+				seed = seed * 1664525 + 1013904223;
+				pixels[i] = seed;
+			}
+			return ImageFactory::Create(pixelData, ImagePixelFormat_U32, IMAGE_SIZE, IMAGE_SIZE);
+		}
+
+	public:
+		TEST_CLASS_INITIALIZE(Init)
+		{
+			// Cache uses ImGui time to track access of entries
+			ImGui::CreateContext();
+		}
+
+		TEST_CLASS_CLEANUP(Shutdown)
+		{
+			ImGui::DestroyContext();
+		}
+
+		// Entries flushed to pack on shutdown must be mapped back with the same pixels on the next startup
+		TEST_METHOD(VerifyPackPersistence)
+		{
+			ImagePtr images[IMAGE_COUNT];
+			u32 imageSize = IMAGE_SIZE * IMAGE_SIZE * 4;
+			for (u32 i = 0; i < IMAGE_COUNT; i++)
+				images[i] = CreateImage(i);
+
+			{
+				ImageCache cache;
+				cache.Clear();
+				for (u32 i = 0; i < IMAGE_COUNT; i++)
+					cache.Cache(images[i], i, imageSize, ImageCacheEntryFlags_StoreInFileSystem, Vec2S(1.0f, 0.5f));
+				Assert::AreEqual(IMAGE_COUNT, cache.GetState().ImageCountRam);
+			}
+
+			ImageCache cache;
+			ImageCacheState state = cache.GetState();
+			Assert::AreEqual(0u, state.ImageCountRam);
+			Assert::AreEqual(IMAGE_COUNT, state.ImageCountFs);
+			Assert::AreEqual(static_cast<u64>(IMAGE_COUNT) * imageSize, state.SizeFsUsed);
+
+			Timer timer = Timer::StartNew();
+			for (u32 i = 0; i < IMAGE_COUNT; i++)
+			{
+				Vec2S uv2;
+				ImagePtr image = cache.GetFromCache(i, &uv2);
+				Assert::IsNotNull(image.get());
+				Assert::AreEqual(0.5f, uv2.Y);
+
+				// Pixel data is mapped directly from pack
+				char* pixelData = image->GetPixelDataBytes();
+				Assert::AreEqual(0ull, reinterpret_cast<u64>(pixelData) % 64);
+				Assert::AreEqual(0, memcmp(images[i]->GetPixelDataBytes(), pixelData, imageSize));
+
+				// View is copy-on-write, changes must not reach the pack
+				pixelData[0] ^= 0xFF;
+			}
+			timer.Stop();
+			Logger::WriteMessage(String::FormatTemp("Mapped %u images in %llu us\n", IMAGE_COUNT, timer.GetElapsedMicroseconds()));
+
+			state = cache.GetState();
+			Assert::AreEqual(IMAGE_COUNT, state.ImageCountRam);
+			Assert::AreEqual(0u, state.ImageCountFs);
+
+			cache.Clear();
+			state = cache.GetState();
+			Assert::AreEqual(0u, state.ImageCountRam + state.ImageCountFs);
+			Assert::IsNull(cache.GetFromCache(0).get());
+		}
+
+		// Writes to mapped pixel data must never reach the pack
+		TEST_METHOD(VerifyMappedImagesAreCopyOnWrite)
+		{
+			ImagePtr image = CreateImage(0xC0FFEE);
+			u32 imageSize = IMAGE_SIZE * IMAGE_SIZE * 4;
+
+			{
+				ImageCache cache;
+				cache.Clear();
+				cache.Cache(image, 1, imageSize, ImageCacheEntryFlags_StoreInFileSystem, Vec2S(1.0f, 1.0f));
+			}
+
+			{
+				ImageCache cache;
+				ImagePtr mapped = cache.GetFromCache(1);
+				Assert::IsNotNull(mapped.get());
+				memset(mapped->GetPixelDataBytes(), 0, imageSize);
+			}
+
+			ImageCache cache;
+			ImagePtr mapped = cache.GetFromCache(1);
+			Assert::IsNotNull(mapped.get());
+			Assert::AreEqual(0, memcmp(image->GetPixelDataBytes(), mapped->GetPixelDataBytes(), imageSize));
+			mapped = nullptr;
+			cache.Clear();
+		}
+	};
+}
+#endif
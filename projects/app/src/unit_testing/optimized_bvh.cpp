@@ -0,0 +1,297 @@
+#ifdef AM_UNIT_TESTS
+
+#include "CppUnitTest.h"
+#include "am/system/timer.h"
+#include "am/types.h"
+#include "rage/physics/bounds/bvhbuilder.h"
+
+#include <algorithm>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace unit_testing
+{
+	using namespace rageam;
+	using namespace rage;
+
+	TEST_CLASS(phOptimizedBvhTests)
+	{
+		static constexpr int GRID_SIZE = 180;				// 180x180 quads, 64800 triangles - close to 16 bit primitive index limit
+		static constexpr int MAX_PRIMITIVES_PER_NODE = 4;	// The same as in phBoundBVH
+		static constexpr int QUERY_COUNT = 10000;
+
+		struct Triangle
+		{
+			Vec3V Vertices[3];
+		};
+
+		struct QueryStats
+		{
+			u64 NodeTests = 0;
+			u64 PrimitiveTests = 0;
+		};
+
+		// Rough terrain with some hills, like map collision
+		static List<Triangle> GenerateTerrain()
+		{
+			auto getVertex = [](int x, int y)
+				{
+					float height = sinf(static_cast<float>(x) * 0.11f) * 6.0f + cosf(static_cast<float>(y) * 0.07f) * 9.0f;
+					height += static_cast<float>((x * 7919 + y * 104729) % 17) * 0.1f;
+					return Vec3V(static_cast<float>(x), static_cast<float>(y), height);
+				};
+
+			List<Triangle> triangles;
+			for (int y = 0; y < GRID_SIZE; y++)
+			{
+				for (int x = 0; x < GRID_SIZE; x++)
+				{
+					triangles.Add({ getVertex(x, y), getVertex(x + 1, y), getVertex(x, y + 1) });
+					triangles.Add({ getVertex(x + 1, y), getVertex(x + 1, y + 1), getVertex(x, y + 1) });
+				}
+			}
+			return triangles;
+		}
+
+		// Quantizes triangles the same way as phBoundBVH::BuildBVH does
+		static List<phBvhPrimitiveData> CreatePrimitives(phOptimizedBvh& bvh, const List<Triangle>& triangles)
+		{
+			spdAABB bounds(S_MAX, S_MIN);
+			for (const Triangle& triangle : triangles)
+			{
+				for (const Vec3V& vertex : triangle.Vertices)
+					bounds = bounds.AddPoint(vertex);
+			}
+			bvh.SetExtents(bounds);
+
+			List<phBvhPrimitiveData> primitives;
+			primitives.Resize(triangles.GetSize());
+			for (u32 i = 0; i < triangles.GetSize(); i++)
+			{
+				const Triangle& triangle = triangles[i];
+				spdAABB bb(S_MAX, S_MIN);
+				for (const Vec3V& vertex : triangle.Vertices)
+					bb = bb.AddPoint(vertex);
+
+				phBvhPrimitiveData& primitive = primitives[i];
+				bvh.QuantizeMin(primitive.AABBMin, bb.Min);
+				bvh.QuantizeMax(primitive.AABBMax, bb.Max);
+				bvh.QuantizeClosest(primitive.Centroid, bb.Center());
+				primitive.PrimitiveIndex = static_cast<u16>(i);
+			}
+			return primitives;
+		}
+
+		// Stackless traversal with escape indices, the same way as the game does it
+		template<typename TOverlapFn>
+		static void Traverse(const phOptimizedBvh& bvh, const TOverlapFn& overlaps, QueryStats& stats, List<u16>* hitPrimitives = nullptr)
+		{
+			int index = 0;
+			while (index < bvh.GetNodeCount())
+			{
+				phOptimizedBvhNode& node = bvh.GetNode(index);
+				stats.NodeTests++;
+				bool hit = overlaps(bvh.GetNodeAABB(node));
+				if (node.IsLeafNode())
+				{
+					if (hit)
+					{
+						stats.PrimitiveTests += node.GetPrimitiveCount();
+						if (hitPrimitives)
+						{
+							for (int i = 0; i < node.GetPrimitiveCount(); i++)
+								hitPrimitives->Add(static_cast<u16>(node.GetPrimitiveIndex() + i));
+						}
+					}
+					index++;
+				}
+				else
+				{
+					index += hit ? 1 : node.GetEscapeIndex();
+				}
+			}
+		}
+
+		static bool RayIntersectsAABB(const Vec3V& origin, const Vec3V& invDir, const spdAABB& bb)
+		{
+			float tMin = 0.0f;
+			float tMax = FLT_MAX;
+			float o[3] = { origin.X(), origin.Y(), origin.Z() };
+			float d[3] = { invDir.X(), invDir.Y(), invDir.Z() };
+			float bbMin[3] = { bb.Min.X(), bb.Min.Y(), bb.Min.Z() };
+			float bbMax[3] = { bb.Max.X(), bb.Max.Y(), bb.Max.Z() };
+			for (int i = 0; i < 3; i++)
+			{
+				float t1 = (bbMin[i] - o[i]) * d[i];
+				float t2 = (bbMax[i] - o[i]) * d[i];
+				tMin = std::max(tMin, std::min(t1, t2));
+				tMax = std::min(tMax, std::max(t1, t2));
+			}
+			return tMin <= tMax;
+		}
+
+		static bool SphereIntersectsAABB(const Vec3V& center, float radius, const spdAABB& bb)
+		{
+			Vec3V closest = center.Max(bb.Min).Min(bb.Max);
+			Vec3V delta = closest - center;
+			float distanceSquared = delta.X() * delta.X() + delta.Y() * delta.Y() + delta.Z() * delta.Z();
+			return distanceSquared <= radius * radius;
+		}
+
+		// Random rays from above the terrain and random spheres on the terrain, deterministic for all builders
+		static void RunQueries(const phOptimizedBvh& bvh, QueryStats& rayStats, QueryStats& sphereStats)
+		{
+			u32 seed = 0xBEEF;
+			auto random = [&seed] { seed = seed * 1664525 + 1013904223; return static_cast<float>(seed >> 8) / static_cast<float>(1 << 24); };
+
+			for (int i = 0; i < QUERY_COUNT; i++)
+			{
+				Vec3V origin(random() * GRID_SIZE, random() * GRID_SIZE, 40.0f);
+				Vec3V dir(random() * 2.0f - 1.0f, random() * 2.0f - 1.0f, -0.5f - random());
+				Vec3V invDir(1.0f / dir.X(), 1.0f / dir.Y(), 1.0f / dir.Z());
+				Traverse(bvh, [&](const spdAABB& bb) { return RayIntersectsAABB(origin, invDir, bb); }, rayStats);
+
+				Vec3V center(random() * GRID_SIZE, random() * GRID_SIZE, random() * 10.0f);
+				float radius = 0.5f + random() * 3.0f;
+				Traverse(bvh, [&](const spdAABB& bb) { return SphereIntersectsAABB(center, radius, bb); }, sphereStats);
+			}
+		}
+
+	public:
+		TEST_CLASS_INITIALIZE(Init)
+		{
+			phBvhSahBuilder::InitClass();
+		}
+
+		TEST_CLASS_CLEANUP(Shutdown)
+		{
+			phBvhSahBuilder::ShutdownClass();
+		}
+
+		// Every primitive must be referenced by exactly one leaf and queries must not miss any primitive
+		TEST_METHOD(VerifySahTreeIsValid)
+		{
+			List<Triangle> triangles = GenerateTerrain();
+
+			phOptimizedBvh sahBvh;
+			List<phBvhPrimitiveData> sahPrimitives = CreatePrimitives(sahBvh, triangles);
+			sahBvh.BuildFromPrimitiveData(sahPrimitives.GetItems(), sahPrimitives.GetSize(), MAX_PRIMITIVES_PER_NODE, PH_BVH_BUILD_BINNED_SAH);
+
+			List<u16> referenceCounts;
+			referenceCounts.Resize(triangles.GetSize());
+			std::fill(referenceCounts.begin(), referenceCounts.end(), 0);
+			int nodeCount = 0;
+			sahBvh.IterateTree([&](phOptimizedBvhNode& node, int depth)
+				{
+					nodeCount++;
+					if (!node.IsLeafNode())
+						return;
+
+					Assert::IsTrue(node.GetPrimitiveCount() <= MAX_PRIMITIVES_PER_NODE);
+					for (int i = node.GetPrimitiveIndex(); i < node.GetPrimitiveIndex() + node.GetPrimitiveCount(); i++)
+					{
+						const phBvhPrimitiveData& primitive = sahPrimitives[i];
+						for (int k = 0; k < 3; k++)
+						{
+							Assert::IsTrue(primitive.AABBMin[k] >= node.AABBMin[k]);
+							Assert::IsTrue(primitive.AABBMax[k] <= node.AABBMax[k]);
+						}
+						referenceCounts[primitive.PrimitiveIndex]++;
+					}
+				});
+			Assert::AreEqual(sahBvh.GetNodeCount(), nodeCount);
+			for (u16 referenceCount : referenceCounts)
+				Assert::AreEqual(static_cast<u16>(1), referenceCount);
+
+			// Traversal must find every primitive that overlaps the query, the same as brute force does
+			u32 seed = 0xF00D;
+			auto random = [&seed] { seed = seed * 1664525 + 1013904223; return static_cast<float>(seed >> 8) / static_cast<float>(1 << 24); };
+			for (int i = 0; i < 200; i++)
+			{
+				Vec3V center(random() * GRID_SIZE, random() * GRID_SIZE, random() * 10.0f);
+				float radius = 0.5f + random() * 3.0f;
+				auto overlaps = [&](const spdAABB& bb) { return SphereIntersectsAABB(center, radius, bb); };
+				auto getPrimitiveAABB = [&](const phBvhPrimitiveData& primitive) { return spdAABB(sahBvh.UnQuantize(primitive.AABBMin), sahBvh.UnQuantize(primitive.AABBMax)); };
+
+				List<u16> expected;
+				for (const phBvhPrimitiveData& primitive : sahPrimitives)
+				{
+					if (overlaps(getPrimitiveAABB(primitive)))
+						expected.Add(primitive.PrimitiveIndex);
+				}
+
+				QueryStats stats;
+				List<u16> leafPrimitives;
+				Traverse(sahBvh, overlaps, stats, &leafPrimitives);
+				List<u16> found;
+				for (u16 index : leafPrimitives)
+				{
+					if (overlaps(getPrimitiveAABB(sahPrimitives[index])))
+						found.Add(sahPrimitives[index].PrimitiveIndex);
+				}
+
+				std::sort(expected.begin(), expected.end());
+				std::sort(found.begin(), found.end());
+				Assert::AreEqual(expected.GetSize(), found.GetSize());
+				Assert::IsTrue(std::equal(expected.begin(), expected.end(), found.begin()));
+			}
+		}
+
+		// Parallel build must produce exactly the same tree as single-threaded one
+		TEST_METHOD(VerifyParallelMatchesSerial)
+		{
+			List<Triangle> triangles = GenerateTerrain();
+
+			phBvhSahBuilder::ShutdownClass();
+			phOptimizedBvh serialBvh;
+			List<phBvhPrimitiveData> serialPrimitives = CreatePrimitives(serialBvh, triangles);
+			serialBvh.BuildFromPrimitiveData(serialPrimitives.GetItems(), serialPrimitives.GetSize(), MAX_PRIMITIVES_PER_NODE, PH_BVH_BUILD_BINNED_SAH);
+			phBvhSahBuilder::InitClass();
+
+			phOptimizedBvh parallelBvh;
+			List<phBvhPrimitiveData> parallelPrimitives = CreatePrimitives(parallelBvh, triangles);
+			parallelBvh.BuildFromPrimitiveData(parallelPrimitives.GetItems(), parallelPrimitives.GetSize(), MAX_PRIMITIVES_PER_NODE, PH_BVH_BUILD_BINNED_SAH);
+
+			Assert::AreEqual(serialBvh.GetNodeCount(), parallelBvh.GetNodeCount());
+			Assert::AreEqual(0, memcmp(&serialBvh.GetNode(0), &parallelBvh.GetNode(0), sizeof(phOptimizedBvhNode) * serialBvh.GetNodeCount()));
+			Assert::AreEqual(0, memcmp(serialPrimitives.GetItems(), parallelPrimitives.GetItems(), sizeof(phBvhPrimitiveData) * serialPrimitives.GetSize()));
+		}
+
+		TEST_METHOD(BenchmarkSahAgainstMedian)
+		{
+			List<Triangle> triangles = GenerateTerrain();
+
+			struct MethodEntry
+			{
+				ConstString      Name;
+				phBvhBuildMethod Method;
+			};
+			MethodEntry methods[] =
+			{
+				{ "Median",     PH_BVH_BUILD_MEDIAN },
+				{ "Binned SAH", PH_BVH_BUILD_BINNED_SAH },
+			};
+
+			Logger::WriteMessage(String::FormatTemp("%u primitives, %i queries\n", triangles.GetSize(), QUERY_COUNT));
+			for (const MethodEntry& entry : methods)
+			{
+				phOptimizedBvh bvh;
+				List<phBvhPrimitiveData> primitives = CreatePrimitives(bvh, triangles);
+
+				Timer timer = Timer::StartNew();
+				bvh.BuildFromPrimitiveData(primitives.GetItems(), primitives.GetSize(), MAX_PRIMITIVES_PER_NODE, entry.Method);
+				timer.Stop();
+
+				QueryStats rayStats, sphereStats;
+				RunQueries(bvh, rayStats, sphereStats);
+
+				Logger::WriteMessage(String::FormatTemp(
+					"%-10s: %llu ms, %i nodes, depth %i, ray: %.1f nodes %.1f primitives, sphere: %.1f nodes %.1f primitives\n",
+					entry.Name, timer.GetElapsedMilliseconds(), bvh.GetNodeCount(), bvh.ComputeDepth(),
+					static_cast<double>(rayStats.NodeTests) / QUERY_COUNT, static_cast<double>(rayStats.PrimitiveTests) / QUERY_COUNT,
+					static_cast<double>(sphereStats.NodeTests) / QUERY_COUNT, static_cast<double>(sphereStats.PrimitiveTests) / QUERY_COUNT));
+			}
+		}
+	};
+}
+#endif
@@ -0,0 +1,214 @@
+#ifdef AM_UNIT_TESTS
+
+#include "CppUnitTest.h"
+#include "am/system/timer.h"
+#include "am/types.h"
+#include "rage/paging/builder/builder.h"
+#include "rage/paging/compiler/packer.h"
+#include "rage/paging/resourceheader.h"
+#include "rage/system/systemheap.h"
+#include "rage/zlib/stream.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace unit_testing
+{
+	using namespace rage;
+	using namespace rageam;
+
+	TEST_CLASS(pgRscBuilderTests)
+	{
+		static constexpr u32 VERSION = 165;
+		static constexpr u32 RESOURCE_COUNT = 4; // Resources loaded at once in parallel benchmark
+
+		// Virtual chunks only, 1x8MB + 3x4MB
+		static datResourceInfo CreateInfo()
+		{
+			datPackedChunks pack = {};
+			pack.SizeShift = PG_MIN_SIZE_SHIFT + 6;
+			pack.BucketCounts[0] = 1;
+			pack.BucketCounts[1] = 3;
+
+			datResourceInfo info = {};
+			info.VirtualData = datResourceInfo::EncodeChunks(pack);
+			info.SetVersion(VERSION);
+			return info;
+		}
+
+		// Something that resembles resource data - vertex-like floats with repeating patterns and some noise
+		static amUPtr<char[]> GenerateData(u32 size, u32 seed)
+		{
+			amUPtr<char[]> data = std::make_unique<char[]>(size);
+			float* values = reinterpret_cast<float*>(data.get());
+			for (u32 i = 0; i < size / sizeof(float); i++)
+			{
+				seed = seed * 1664525 + 1013904223;
+				values[i] = static_cast<float>(i % 64) * 0.25f + static_cast<float>(seed >> 28);
+			}
+			return data;
+		}
+
+		static file::Path GetResourcePath(u32 index)
+		{
+			char tempPath[MAX_PATH];
+			GetTempPathA(MAX_PATH, tempPath);
+			return file::Path(tempPath) / String::FormatTemp("rageam_builder_test_%u.ydr", index);
+		}
+
+		// Writes header and chunks as single deflate stream, the same way as pgRscCompiler does
+		static void WriteResource(ConstString path, const datResourceInfo& info, const char* data, u32 size)
+		{
+			FILE* file;
+			Assert::AreEqual(0, fopen_s(&file, path, "wb"));
+
+			datResourceHeader header;
+			header.Magic = MAGIC_RSC;
+			header.Version = VERSION;
+			header.Info = info;
+			fwrite(&header, sizeof(datResourceHeader), 1, file);
+
+			zLibCompressor compressor;
+			bool done = false;
+			while (!done)
+			{
+				pVoid compressedBuffer;
+				u32   compressedSize;
+				done = compressor.Compress((pVoid)data, size, compressedBuffer, compressedSize);
+				fwrite(compressedBuffer, compressedSize, 1, file);
+			}
+			fclose(file);
+		}
+
+		static void VerifyAndFreeMap(datResourceMap& map, const char* data)
+		{
+			u64 offset = 0;
+			for (u32 i = 0; i < map.GetChunkCount(); i++)
+			{
+				datResourceChunk& chunk = map.Chunks[i];
+				Assert::AreEqual(0, memcmp(data + offset, chunk.GetAllocatedAddress(), chunk.Size));
+				offset += chunk.Size;
+				GetMultiAllocator()->Free(chunk.GetAllocatedAddress());
+			}
+		}
+
+		static bool LoadWithoutBuild(ConstString path, datResourceMap& map, bool readAhead)
+		{
+			datResourceInfo info;
+			fiDevice* device = fiDevice::GetDeviceImpl(path);
+			if (device->GetResourceInfo(path, info) != VERSION)
+				return false;
+			info.GenerateMap(map);
+			return pgRscBuilder::AllocateMap(map) && pgRscBuilder::ReadAndDecompressChunks(map, device, path, readAhead);
+		}
+
+	public:
+		TEST_CLASS_INITIALIZE(Init)
+		{
+			pgRscBuilder::InitClass();
+
+			datResourceInfo info = CreateInfo();
+			u32 size = info.ComputeVirtualSize();
+			for (u32 i = 0; i < RESOURCE_COUNT; i++)
+			{
+				amUPtr<char[]> data = GenerateData(size, i);
+				WriteResource(GetResourcePath(i), info, data.get(), size);
+			}
+		}
+
+		TEST_CLASS_CLEANUP(Shutdown)
+		{
+			for (u32 i = 0; i < RESOURCE_COUNT; i++)
+				DeleteFileA(GetResourcePath(i));
+
+			pgRscBuilder::ShutdownClass();
+		}
+
+		TEST_METHOD(VerifyReadAheadMatchesSequential)
+		{
+			u32 size = CreateInfo().ComputeVirtualSize();
+			amUPtr<char[]> data = GenerateData(size, 0);
+
+			datResourceMap sequentialMap;
+			Assert::IsTrue(LoadWithoutBuild(GetResourcePath(0), sequentialMap, false));
+			VerifyAndFreeMap(sequentialMap, data.get());
+
+			datResourceMap readAheadMap;
+			Assert::IsTrue(LoadWithoutBuild(GetResourcePath(0), readAheadMap, true));
+			VerifyAndFreeMap(readAheadMap, data.get());
+		}
+
+		TEST_METHOD(VerifyLoadBuildAsync)
+		{
+			datResourceMap maps[RESOURCE_COUNT];
+			datResourceInfo infos[RESOURCE_COUNT];
+			BackgroundTaskPtr tasks[RESOURCE_COUNT];
+			for (u32 i = 0; i < RESOURCE_COUNT; i++)
+			{
+				tasks[i] = pgRscBuilder::LoadBuildAsync(GetResourcePath(i), VERSION, maps[i], infos[i]);
+				Assert::IsNotNull(tasks[i].get());
+			}
+
+			u32 size = CreateInfo().ComputeVirtualSize();
+			for (u32 i = 0; i < RESOURCE_COUNT; i++)
+			{
+				tasks[i]->Wait();
+				Assert::IsTrue(tasks[i]->IsSuccess());
+				Assert::IsTrue(tasks[i]->GetResult<pgBase*>() == maps[i].MainChunk);
+
+				amUPtr<char[]> data = GenerateData(size, i);
+				VerifyAndFreeMap(maps[i], data.get());
+			}
+		}
+
+		TEST_METHOD(BenchmarkReadAhead)
+		{
+			u64 sizeMb = CreateInfo().ComputeVirtualSize() / (1024 * 1024);
+
+			// Single resource, read and inflate in turns vs overlapped
+			for (bool readAhead : { false, true })
+			{
+				datResourceMap map;
+				Timer timer = Timer::StartNew();
+				Assert::IsTrue(LoadWithoutBuild(GetResourcePath(0), map, readAhead));
+				timer.Stop();
+				for (datResourceChunk& chunk : map)
+					GetMultiAllocator()->Free(chunk.GetAllocatedAddress());
+
+				Logger::WriteMessage(String::FormatTemp("%s: %llu MB in %llu ms\n",
+					readAhead ? "Read ahead" : "Sequential", sizeMb, timer.GetElapsedMilliseconds()));
+			}
+
+			// Multiple resources, one after another vs all at once
+			datResourceMap maps[RESOURCE_COUNT];
+			datResourceInfo infos[RESOURCE_COUNT];
+			Timer timer = Timer::StartNew();
+			for (u32 i = 0; i < RESOURCE_COUNT; i++)
+				Assert::IsNotNull(pgRscBuilder::LoadBuild(GetResourcePath(i), VERSION, maps[i], infos[i]));
+			timer.Stop();
+			u64 sequentialTime = timer.GetElapsedMilliseconds();
+			for (datResourceMap& map : maps)
+			{
+				for (datResourceChunk& chunk : map)
+					GetMultiAllocator()->Free(chunk.GetAllocatedAddress());
+			}
+
+			BackgroundTaskPtr tasks[RESOURCE_COUNT];
+			timer.Restart();
+			for (u32 i = 0; i < RESOURCE_COUNT; i++)
+				tasks[i] = pgRscBuilder::LoadBuildAsync(GetResourcePath(i), VERSION, maps[i], infos[i]);
+			for (BackgroundTaskPtr& task : tasks)
+				task->Wait();
+			timer.Stop();
+			u64 asyncTime = timer.GetElapsedMilliseconds();
+			for (datResourceMap& map : maps)
+			{
+				for (datResourceChunk& chunk : map)
+					GetMultiAllocator()->Free(chunk.GetAllocatedAddress());
+			}
+
+			Logger::WriteMessage(String::FormatTemp("%u resources: LoadBuild %llu ms, LoadBuildAsync %llu ms\n",
+				RESOURCE_COUNT, sequentialTime, asyncTime));
+		}
+	};
+}
+#endif
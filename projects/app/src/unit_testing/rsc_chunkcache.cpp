@@ -0,0 +1,108 @@
+#ifdef AM_UNIT_TESTS
+
+#include "CppUnitTest.h"
+#include "am/types.h"
+#include "rage/paging/compiler/chunkcache.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace unit_testing
+{
+	using namespace rage;
+	using namespace rageam;
+
+	TEST_CLASS(pgRscChunkCacheTests)
+	{
+		static constexpr u32 CHUNK_SIZE = 0x40000; // 256KB
+		static constexpr u32 CHUNK_COUNT = 8;
+		static constexpr u32 DATA_SIZE = CHUNK_SIZE * CHUNK_COUNT;
+
+		static file::WPath GetCacheDirectory()
+		{
+			wchar_t tempPath[MAX_PATH];
+			GetTempPathW(MAX_PATH, tempPath);
+			return file::WPath(tempPath) / L"rageam_chunk_cache_test";
+		}
+
+		static amUPtr<char[]> GenerateData(u32 size)
+		{
+			amUPtr<char[]> data = std::make_unique<char[]>(size);
+			u32 seed = 0xBADF00D;
+			for (u32 i = 0; i < size; i++)
+			{
+				seed = seed * 1664525 + 1013904223;
+				data[i] = static_cast<char>((i % 97) + (seed >> 29));
+			}
+			return data;
+		}
+
+		// Writes all chunks the same way as pgRscWriter does
+		static List<char> CompressChunks(pgRscChunkCache& cache, const char* data)
+		{
+			List<char> result;
+			for (u32 i = 0; i < CHUNK_COUNT; i++)
+			{
+				u32 offset = i * CHUNK_SIZE;
+				bool success = cache.CompressChunk(data + offset, CHUNK_SIZE, data, offset, [&](pConstVoid compressedBuffer, u32 compressedSize)
+					{
+						for (u32 k = 0; k < compressedSize; k++)
+							result.Add(static_cast<const char*>(compressedBuffer)[k]);
+						return true;
+					});
+				Assert::IsTrue(success);
+			}
+			return result;
+		}
+
+		static void VerifyDecompressed(List<char>& compressed, const char* data)
+		{
+			amUPtr<char[]> decompressed = std::make_unique<char[]>(DATA_SIZE);
+			zLibDecompressor decompressor;
+			u32 remaining;
+			Assert::IsTrue(decompressor.Decompress(decompressed.get(), DATA_SIZE, compressed.GetItems(), compressed.GetSize(), remaining));
+			Assert::AreEqual(0, memcmp(data, decompressed.get(), DATA_SIZE));
+		}
+
+	public:
+		TEST_METHOD(VerifyCachedOutputIsIdentical)
+		{
+			pgRscChunkCache cache(GetCacheDirectory());
+			cache.Clear();
+
+			amUPtr<char[]> data = GenerateData(DATA_SIZE);
+
+			// Cold cache, everything is compressed
+			List<char> cold = CompressChunks(cache, data.get());
+			Assert::AreEqual(0u, cache.GetHitCount());
+			Assert::AreEqual(CHUNK_COUNT, cache.GetMissCount());
+			VerifyDecompressed(cold, data.get());
+
+			// Warm cache, nothing is compressed and output is byte-identical
+			cache.ResetStats();
+			List<char> warm = CompressChunks(cache, data.get());
+			Assert::AreEqual(CHUNK_COUNT, cache.GetHitCount());
+			Assert::AreEqual(0u, cache.GetMissCount());
+			Assert::AreEqual(cold.GetSize(), warm.GetSize());
+			Assert::AreEqual(0, memcmp(cold.GetItems(), warm.GetItems(), cold.GetSize()));
+
+			// Edit in the middle of chunk 3, its tail is not in the window of chunk 4 so only chunk 3 is recompressed
+			cache.ResetStats();
+			data[3 * CHUNK_SIZE + CHUNK_SIZE / 2] ^= 0x5A;
+			List<char> edited = CompressChunks(cache, data.get());
+			Assert::AreEqual(CHUNK_COUNT - 1, cache.GetHitCount());
+			Assert::AreEqual(1u, cache.GetMissCount());
+			VerifyDecompressed(edited, data.get());
+
+			// Edit at the end of chunk 5 changes dictionary of chunk 6, both are recompressed
+			cache.ResetStats();
+			data[6 * CHUNK_SIZE - 1] ^= 0x5A;
+			List<char> editedTail = CompressChunks(cache, data.get());
+			Assert::AreEqual(CHUNK_COUNT - 2, cache.GetHitCount());
+			Assert::AreEqual(2u, cache.GetMissCount());
+			VerifyDecompressed(editedTail, data.get());
+
+			cache.Clear();
+		}
+	};
+}
+#endif
@@ -0,0 +1,87 @@
+#ifdef AM_UNIT_TESTS
+
+#include "CppUnitTest.h"
+#include "rage/paging/compiler/packer.h"
+#include "rage/paging/compiler/snapshotallocator.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace unit_testing
+{
+	using namespace rage;
+
+	TEST_CLASS(pgRscPackerTests)
+	{
+		static constexpr u32 ALLOCATOR_SIZE = 64u * 1024u * 1024u;
+
+		// Synthetic block size distributions that mimic resources we export
+		struct AssetProfile
+		{
+			ConstString Name;
+			bool		IsVirtual;
+			u32			BlockCount;
+			u32			SmallMax;	// Structures, arrays of pointers
+			u32			MediumMax;	// Index / vertex arrays, bound polygons
+			u32			LargeMax;	// Texture pixel data, large vertex buffers
+			u32			LargeEvery;	// One of N blocks is large
+			u32			MediumEvery;
+		};
+
+		static constexpr AssetProfile sm_Profiles[] =
+		{
+			{ "Prop drawable (virtual)",		true,	 600, 256,  4096,   64 * 1024,  50, 4 },
+			{ "Prop drawable (physical)",		false,	  12, 256, 16384,  512 * 1024,   3, 2 },
+			{ "Vehicle drawable (virtual)",		true,	4000, 512,  8192,  192 * 1024,  80, 5 },
+			{ "Texture dictionary (physical)",	false,	  40, 256, 65536, 4096 * 1024,   2, 2 },
+			{ "Map collision (virtual)",		true,  12000, 128,  2048,  256 * 1024, 200, 6 },
+		};
+
+		static void FillAllocator(pgSnapshotAllocator& allocator, const AssetProfile& profile)
+		{
+			u32 seed = 0xC0FFEE;
+			auto next = [&seed](u32 max)
+				{
+					seed = seed * 1664525 + 1013904223;
+					return 16 + (seed >> 8) % max;
+				};
+
+			for (u32 i = 0; i < profile.BlockCount; i++)
+			{
+				u32 size;
+				if (i % profile.LargeEvery == 0)		size = next(profile.LargeMax);
+				else if (i % profile.MediumEvery == 0)	size = next(profile.MediumMax);
+				else									size = next(profile.SmallMax);
+				allocator.Allocate(size);
+			}
+		}
+
+		static u32 PackAndGetAllocatedSize(const pgSnapshotAllocator& allocator, ePackerStrategy strategy)
+		{
+			datPackedChunks pack;
+			pgRscPacker packer(allocator, 0, strategy);
+			Assert::IsTrue(packer.Pack(pack));
+			Assert::IsTrue(pack.ChunkCount <= PG_MAX_CHUNKS);
+			return pack.GetAllocatedSize();
+		}
+
+	public:
+		// Reports bytes saved by optimal packing on every profile, optimal packing must never be worse than greedy
+		TEST_METHOD(VerifyOptimalNotWorseThanGreedy)
+		{
+			for (const AssetProfile& profile : sm_Profiles)
+			{
+				pgSnapshotAllocator allocator(ALLOCATOR_SIZE, profile.IsVirtual);
+				FillAllocator(allocator, profile);
+
+				u32 greedySize = PackAndGetAllocatedSize(allocator, PACKER_STRATEGY_GREEDY);
+				u32 optimalSize = PackAndGetAllocatedSize(allocator, PACKER_STRATEGY_OPTIMAL);
+
+				Logger::WriteMessage(String::FormatTemp("%-32s Greedy: %#-10x Optimal: %#-10x Saved: %u bytes\n",
+					profile.Name, greedySize, optimalSize, greedySize - optimalSize));
+
+				Assert::IsTrue(optimalSize <= greedySize);
+			}
+		}
+	};
+}
+#endif
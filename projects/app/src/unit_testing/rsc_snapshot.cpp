@@ -0,0 +1,112 @@
+#ifdef AM_UNIT_TESTS
+
+#include "CppUnitTest.h"
+#include "am/system/timer.h"
+#include "rage/paging/compiler/snapshotallocator.h"
+
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace unit_testing
+{
+	using namespace rageam;
+	using namespace rage;
+
+	TEST_CLASS(pgSnapshotAllocatorTests)
+	{
+		static constexpr u32 ALLOCATOR_SIZE = 64u * 1024u * 1024u;
+		static constexpr u32 BLOCK_COUNT = 60000; // Block index is 16 bit
+		static constexpr u32 REF_COUNT = 1000000;
+		static constexpr u64 FIXUP_BLOCK_STRIDE = 0x10000;
+
+		struct Ref
+		{
+			char* Pointer;
+			u16   BlockIndex;
+			u32   Offset;
+		};
+
+		static u32 NextRandom(u32& seed)
+		{
+			seed = seed * 1664525 + 1013904223;
+			return seed >> 8;
+		}
+
+		// Allocates blocks of mixed size and references random addresses within them, mostly interior ones
+		static void FillAllocator(pgSnapshotAllocator& allocator, std::vector<Ref>& refs, u32 blockCount, u32 refCount)
+		{
+			u32 seed = 0xC0FFEE;
+			for (u32 i = 0; i < blockCount; i++)
+			{
+				u32 size = i % 50 == 0 ? 16 + NextRandom(seed) % 4096 : 16 + NextRandom(seed) % 256;
+				allocator.Allocate(size);
+			}
+
+			refs.resize(refCount);
+			for (Ref& ref : refs)
+			{
+				ref.BlockIndex = static_cast<u16>(NextRandom(seed) % blockCount);
+				u32 blockSize = allocator.GetBlockSize(ref.BlockIndex);
+				ref.Offset = NextRandom(seed) % 4 == 0 ? 0 : NextRandom(seed) % blockSize;
+				ref.Pointer = static_cast<char*>(allocator.GetBlock(ref.BlockIndex)) + ref.Offset;
+			}
+		}
+
+		static void FixupAndVerify(const pgSnapshotAllocator& allocator, const std::vector<Ref>& refs)
+		{
+			for (u16 i = 0; i < allocator.GetBlockCount(); i++)
+				allocator.FixupBlockReferences(i, FIXUP_BLOCK_STRIDE * (i + 1));
+
+			for (const Ref& ref : refs)
+			{
+				u64 expected = FIXUP_BLOCK_STRIDE * (ref.BlockIndex + 1) + ref.Offset;
+				Assert::AreEqual(expected, reinterpret_cast<u64>(ref.Pointer));
+			}
+		}
+
+	public:
+		TEST_METHOD(VerifyOffsetRefs)
+		{
+			pgSnapshotAllocator allocator(ALLOCATOR_SIZE, true);
+			std::vector<Ref> refs;
+			FillAllocator(allocator, refs, 1000, 20000);
+
+			// Block boundaries are the most likely place to go wrong
+			char* first = static_cast<char*>(allocator.GetBlock(0));
+			char* lastByte = first + allocator.GetBlockSize(0) - 1;
+			refs.push_back({ first, 0, 0 });
+			refs.push_back({ lastByte, 0, allocator.GetBlockSize(0) - 1 });
+
+			for (Ref& ref : refs)
+				allocator.AddRef(ref.Pointer);
+
+			FixupAndVerify(allocator, refs);
+		}
+
+		TEST_METHOD(BenchmarkOffsetRefs)
+		{
+			pgSnapshotAllocator allocator(ALLOCATOR_SIZE, true);
+			std::vector<Ref> refs;
+
+			Timer timer = Timer::StartNew();
+			FillAllocator(allocator, refs, BLOCK_COUNT, REF_COUNT);
+			timer.Stop();
+			u64 fillTime = timer.GetElapsedMilliseconds();
+
+			timer.Restart();
+			for (Ref& ref : refs)
+				allocator.AddRef(ref.Pointer);
+			timer.Stop();
+			u64 addRefTime = timer.GetElapsedMilliseconds();
+
+			timer.Restart();
+			FixupAndVerify(allocator, refs);
+			timer.Stop();
+
+			Logger::WriteMessage(String::FormatTemp("%u blocks, %u refs: Allocate %llu ms, AddRef %llu ms, Fixup %llu ms\n",
+				BLOCK_COUNT, REF_COUNT, fillTime, addRefTime, timer.GetElapsedMilliseconds()));
+		}
+	};
+}
+#endif
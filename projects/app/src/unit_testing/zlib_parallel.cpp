@@ -0,0 +1,270 @@
+#ifdef AM_UNIT_TESTS
+
+#include "CppUnitTest.h"
+#include "am/system/timer.h"
+#include "am/types.h"
+#include "rage/zlib/parallelstream.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace unit_testing
+{
+	using namespace rageam;
+
+	TEST_CLASS(zLibParallelCompressorTests)
+	{
+		static constexpr u32 DATA_SIZE = 64 * 1024 * 1024; // 64MB, about the size of large YDR physical segment
+
+		// Something that resembles resource data - vertex-like floats with repeating patterns and some noise
+		static amUPtr<char[]> GenerateData(u32 size)
+		{
+			amUPtr<char[]> data = std::make_unique<char[]>(size);
+			float* values = reinterpret_cast<float*>(data.get());
+			u32 seed = 0x12345678;
+			for (u32 i = 0; i < size / sizeof(float); i++)
+			{
+				seed = seed * 1664525 + 1013904223;
+				values[i] = static_cast<float>(i % 64) * 0.25f + static_cast<float>(seed >> 28);
+			}
+			return data;
+		}
+
+		static List<char> CompressSequential(const char* data, u32 size)
+		{
+			List<char> result;
+			zLibCompressor compressor;
+			bool done = false;
+			while (!done)
+			{
+				pVoid compressedBuffer;
+				u32   compressedSize;
+				done = compressor.Compress((pVoid)data, size, compressedBuffer, compressedSize);
+				for (u32 i = 0; i < compressedSize; i++)
+					result.Add(static_cast<char*>(compressedBuffer)[i]);
+			}
+			return result;
+		}
+
+		static List<char> CompressParallel(const char* data, u32 size)
+		{
+			List<char> result;
+			zLibParallelCompressor::CompressAll(data, size, [&](pConstVoid compressedBuffer, u32 compressedSize)
+				{
+					for (u32 i = 0; i < compressedSize; i++)
+						result.Add(static_cast<const char*>(compressedBuffer)[i]);
+					return true;
+				});
+			return result;
+		}
+
+		static bool Decompress(List<char>& compressed, char* out, u32 outSize)
+		{
+			zLibDecompressor decompressor;
+			u32 remaining;
+			return decompressor.Decompress(out, outSize, compressed.GetItems(), compressed.GetSize(), remaining);
+		}
+
+		// Splits data on blocks of random size with zero ranges in between, like snapshot blocks placed in chunks
+		static List<zLibSegment> CreateSegments(const char* data, u32 size, u32& outTotalSize)
+		{
+			List<zLibSegment> segments;
+			u32 seed = 0xABCDEF;
+			u32 offset = 0;
+			outTotalSize = 0;
+			while (offset < size)
+			{
+				seed = seed * 1664525 + 1013904223;
+				u32 blockSize = MIN(size - offset, 16 + (seed >> 8) % 0x40000);
+				segments.Add({ data + offset, blockSize });
+				offset += blockSize;
+				outTotalSize += blockSize;
+				if (seed % 3 == 0)
+				{
+					u32 paddingSize = (seed >> 4) % 0x2000;
+					segments.Add({ nullptr, paddingSize });
+					outTotalSize += paddingSize;
+				}
+			}
+			return segments;
+		}
+
+		static List<char> GatherSegments(const List<zLibSegment>& segments, u32 totalSize)
+		{
+			List<char> result;
+			result.Resize(totalSize);
+			u32 offset = 0;
+			for (const zLibSegment& segment : segments)
+			{
+				if (segment.Data)	memcpy(result.GetItems() + offset, segment.Data, segment.Size);
+				else				memset(result.GetItems() + offset, 0, segment.Size);
+				offset += segment.Size;
+			}
+			return result;
+		}
+
+		// Reference asset set - vertex buffers, index buffers and BC textures with zero padding in between, like packed resource chunks
+		static List<char> GenerateReferenceAssets()
+		{
+			static constexpr u32 PART_SIZE = DATA_SIZE / 4;
+
+			List<char> result;
+			result.Resize(DATA_SIZE);
+			char* data = result.GetItems();
+
+			amUPtr<char[]> vertices = GenerateData(PART_SIZE);
+			memcpy(data, vertices.get(), PART_SIZE);
+
+			// Triangle strips of regular grid
+			u16* indices = reinterpret_cast<u16*>(data + PART_SIZE);
+			for (u32 i = 0; i < PART_SIZE / sizeof(u16); i++)
+				indices[i] = static_cast<u16>(i / 3 + i % 3 + (i % 6 >= 3 ? 64 : 0));
+
+			// BC1 blocks, endpoints change slowly and selectors are noisy
+			u32* blocks = reinterpret_cast<u32*>(data + PART_SIZE * 2);
+			u32 seed = 0x9E3779B9;
+			for (u32 i = 0; i < PART_SIZE / sizeof(u32); i += 2)
+			{
+				seed = seed * 1664525 + 1013904223;
+				blocks[i] = (i / 512) * 0x00010001;
+				blocks[i + 1] = seed;
+			}
+
+			memset(data + PART_SIZE * 3, 0, PART_SIZE);
+			return result;
+		}
+
+	public:
+		TEST_METHOD(VerifyParallelRoundTrip)
+		{
+			zLibParallelCompressor::InitClass();
+
+			// Not multiple of slice size to test the last partial slice
+			u32 size = zLibParallelCompressor::SLICE_SIZE * 5 + 12345;
+			amUPtr<char[]> data = GenerateData(size);
+			List<char> compressed = CompressParallel(data.get(), size);
+
+			amUPtr<char[]> decompressed = std::make_unique<char[]>(size);
+			Assert::IsTrue(Decompress(compressed, decompressed.get(), size));
+			Assert::AreEqual(0, memcmp(data.get(), decompressed.get(), size));
+
+			zLibParallelCompressor::ShutdownClass();
+		}
+
+		// Scatter-gather compression must decompress to the same data as gathered buffer
+		TEST_METHOD(VerifySegmentsRoundTrip)
+		{
+			zLibParallelCompressor::InitClass();
+
+			amUPtr<char[]> data = GenerateData(DATA_SIZE / 4);
+			u32 totalSize;
+			List<zLibSegment> segments = CreateSegments(data.get(), DATA_SIZE / 4, totalSize);
+			List<char> gathered = GatherSegments(segments, totalSize);
+
+			auto compress = [&](bool parallel)
+				{
+					List<char> result;
+					auto writeFn = [&](pConstVoid compressedBuffer, u32 compressedSize)
+						{
+							for (u32 i = 0; i < compressedSize; i++)
+								result.Add(static_cast<const char*>(compressedBuffer)[i]);
+							return true;
+						};
+
+					bool success;
+					if (parallel)
+					{
+						success = zLibParallelCompressor::CompressSegments(segments.GetItems(), segments.GetSize(), writeFn);
+					}
+					else
+					{
+						zLibCompressor compressor;
+						success = compressor.CompressSegments(segments.GetItems(), segments.GetSize(), writeFn);
+					}
+					Assert::IsTrue(success);
+					return result;
+				};
+
+			for (bool parallel : { false, true })
+			{
+				List<char> compressed = compress(parallel);
+				amUPtr<char[]> decompressed = std::make_unique<char[]>(totalSize);
+				Assert::IsTrue(Decompress(compressed, decompressed.get(), totalSize));
+				Assert::AreEqual(0, memcmp(gathered.GetItems(), decompressed.get(), totalSize));
+			}
+
+			zLibParallelCompressor::ShutdownClass();
+		}
+
+		TEST_METHOD(BenchmarkParallelVsSequential)
+		{
+			zLibParallelCompressor::InitClass();
+
+			amUPtr<char[]> data = GenerateData(DATA_SIZE);
+
+			Timer timer = Timer::StartNew();
+			List<char> sequential = CompressSequential(data.get(), DATA_SIZE);
+			timer.Stop();
+			u64 sequentialTime = timer.GetElapsedMilliseconds();
+
+			timer.Restart();
+			List<char> parallel = CompressParallel(data.get(), DATA_SIZE);
+			timer.Stop();
+			u64 parallelTime = timer.GetElapsedMilliseconds();
+
+			Logger::WriteMessage(String::FormatTemp("Sequential: %llu ms, %u bytes\n", sequentialTime, sequential.GetSize()));
+			Logger::WriteMessage(String::FormatTemp("Parallel:   %llu ms, %u bytes\n", parallelTime, parallel.GetSize()));
+
+			amUPtr<char[]> decompressed = std::make_unique<char[]>(DATA_SIZE);
+			Assert::IsTrue(Decompress(parallel, decompressed.get(), DATA_SIZE));
+			Assert::AreEqual(0, memcmp(data.get(), decompressed.get(), DATA_SIZE));
+
+			zLibParallelCompressor::ShutdownClass();
+		}
+
+		TEST_METHOD(BenchmarkCompressionProfiles)
+		{
+			zLibParallelCompressor::InitClass();
+
+			struct ProfileEntry
+			{
+				ConstString				Name;
+				zLibCompressionProfile	Profile;
+			};
+			ProfileEntry profiles[] =
+			{
+				{ "Fast",     zLibCompressionProfile::Fast() },
+				{ "Balanced", zLibCompressionProfile::Balanced() },
+				{ "Max",      zLibCompressionProfile::Max() },
+			};
+
+			List<char> data = GenerateReferenceAssets();
+			amUPtr<char[]> decompressed = std::make_unique<char[]>(DATA_SIZE);
+
+			Logger::WriteMessage(String::FormatTemp("Backend: %s, %u MB\n", ZLIB_BACKEND_NAME, DATA_SIZE / (1024 * 1024)));
+			for (const ProfileEntry& entry : profiles)
+			{
+				List<char> compressed;
+				Timer timer = Timer::StartNew();
+				bool success = zLibParallelCompressor::CompressAll(data.GetItems(), DATA_SIZE, [&](pConstVoid compressedBuffer, u32 compressedSize)
+					{
+						u32 offset = compressed.GetSize();
+						compressed.Resize(offset + compressedSize);
+						memcpy(compressed.GetItems() + offset, compressedBuffer, compressedSize);
+						return true;
+					}, nullptr, 0, entry.Profile);
+				timer.Stop();
+				Assert::IsTrue(success);
+
+				Logger::WriteMessage(String::FormatTemp("%-8s (level %i): %llu ms, %u bytes, ratio %.2f%%\n",
+					entry.Name, entry.Profile.Level, timer.GetElapsedMilliseconds(), compressed.GetSize(),
+					static_cast<double>(compressed.GetSize()) / DATA_SIZE * 100.0));
+
+				Assert::IsTrue(Decompress(compressed, decompressed.get(), DATA_SIZE));
+				Assert::AreEqual(0, memcmp(data.GetItems(), decompressed.get(), DATA_SIZE));
+			}
+
+			zLibParallelCompressor::ShutdownClass();
+		}
+	};
+}
+#endif